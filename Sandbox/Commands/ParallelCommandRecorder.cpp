@@ -0,0 +1,98 @@
+#include "ParallelCommandRecorder.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace BadgerSandbox
+{
+  ParallelCommandRecorder::ParallelCommandRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, ThreadPool& threadPool, size_t minDrawsPerBuffer)
+	  : device(device)
+	  , threadPool(threadPool)
+	  , minDrawsPerBuffer(std::max<size_t>(minDrawsPerBuffer, 1))
+	  , frames(frameCount)
+	  , recorded(frameCount)
+  {
+	  const size_t slotCount = threadPool.Size() + 1;
+	  for (std::vector<Slot>& slots : frames)
+	  {
+		  for (size_t i = 0; i < slotCount; i++)
+		  {
+			  VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+			  commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			  commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+			  Slot slot = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+			  if (vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &slot.commandPool) != VK_SUCCESS)
+			  {
+				  DestroyPools();
+				  throw std::runtime_error("Could not create a command pool for parallel recording");
+			  }
+			  slots.push_back(slot);
+
+			  VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+			  commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			  commandBufferAllocateInfo.commandPool = slot.commandPool;
+			  commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			  commandBufferAllocateInfo.commandBufferCount = 1;
+			  if (vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &slots.back().commandBuffer) != VK_SUCCESS)
+			  {
+				  DestroyPools();
+				  throw std::runtime_error("Could not allocate a secondary command buffer for parallel recording");
+			  }
+		  }
+	  }
+  }
+
+  ParallelCommandRecorder::~ParallelCommandRecorder()
+  {
+	  DestroyPools();
+  }
+
+  void ParallelCommandRecorder::DestroyPools()
+  {
+	  // Destroying a pool frees the command buffers allocated from it
+	  for (std::vector<Slot>& slots : frames)
+	  {
+		  for (Slot& slot : slots)
+		  {
+			  vkDestroyCommandPool(device, slot.commandPool, nullptr);
+		  }
+		  slots.clear();
+	  }
+  }
+
+  const std::vector<VkCommandBuffer>& ParallelCommandRecorder::Record(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritance, size_t drawCount, const RecordRange& record)
+  {
+	  std::vector<Slot>& slots = frames[frame];
+	  const size_t bufferCount = std::max<size_t>(1, std::min(slots.size(), (drawCount + minDrawsPerBuffer - 1) / minDrawsPerBuffer));
+	  std::vector<VkCommandBuffer>& buffers = recorded[frame];
+	  buffers.assign(bufferCount, VK_NULL_HANDLE);
+
+	  // Range i is always recorded into slot i, whichever thread claims it, so each pool is reset and
+	  // recorded from by a single thread. Pools of unused slots keep their old commands, which are
+	  // not executed.
+	  threadPool.ParallelFor(bufferCount, [&](size_t i)
+	  {
+		  Slot& slot = slots[i];
+		  if (vkResetCommandPool(device, slot.commandPool, 0) != VK_SUCCESS)
+		  {
+			  throw std::runtime_error("Could not reset a command pool for parallel recording");
+		  }
+
+		  // Not one time submit, the buffers are executed again for as long as the draw list does not change
+		  VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+		  commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		  commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		  commandBufferBeginInfo.pInheritanceInfo = &inheritance;
+		  if (vkBeginCommandBuffer(slot.commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+		  {
+			  throw std::runtime_error("Could not begin a secondary command buffer");
+		  }
+		  record(slot.commandBuffer, drawCount * i / bufferCount, drawCount * (i + 1) / bufferCount);
+		  if (vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS)
+		  {
+			  throw std::runtime_error("Could not record a secondary command buffer");
+		  }
+		  buffers[i] = slot.commandBuffer;
+	  });
+	  return (buffers);
+  }
+}
\ No newline at end of file
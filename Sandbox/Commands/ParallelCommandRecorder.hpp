@@ -0,0 +1,55 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "ThreadPool.hpp"
+
+namespace BadgerSandbox
+{
+	/*
+	  Parallel command recorder
+	  Records a draw list into secondary command buffers on a thread pool. The list is split into contiguous ranges,
+	  one per slot, and each slot has a command pool of its own for every frame in flight, so a command pool is never
+	  used by two threads at once and a frame's pools can be reset while other frames are still executing. The
+	  primary command buffer executes the buffers of a frame in list order, inside its render pass.
+	*/
+	class ParallelCommandRecorder
+	{
+	private:
+	  struct Slot
+	  {
+		  VkCommandPool commandPool;
+		  VkCommandBuffer commandBuffer;
+	  };
+
+	  VkDevice device;
+	  ThreadPool& threadPool;
+	  size_t minDrawsPerBuffer;
+	  // Indexed by frame, then by slot
+	  std::vector<std::vector<Slot>> frames;
+	  std::vector<std::vector<VkCommandBuffer>> recorded;
+
+	  void DestroyPools();
+	public:
+		// Records the draws [begin, end) of the list into commandBuffer. It has begun and inherits the render pass but
+		// no other state, so pipelines, dynamic state, buffers and descriptor sets all have to be bound again.
+		using RecordRange = std::function<void(VkCommandBuffer commandBuffer, size_t begin, size_t end)>;
+
+		// One slot for every thread of threadPool and one for the thread calling Record. Ranges are at least
+		// minDrawsPerBuffer draws long, shorter lists use fewer secondary command buffers.
+		ParallelCommandRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, ThreadPool& threadPool, size_t minDrawsPerBuffer = 64);
+		~ParallelCommandRecorder();
+		ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+		ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+		size_t SlotCount() const { return frames.empty() ? 0 : frames[0].size(); }
+
+		// Resets the command pools of frame, whose previous submission must have completed, and records drawCount
+		// draws through record. Returns the secondary command buffers in draw order, they stay valid and can be
+		// executed again until frame is recorded the next time. The first exception thrown by record is rethrown.
+		const std::vector<VkCommandBuffer>& Record(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritance, size_t drawCount, const RecordRange& record);
+		// The secondary command buffers last recorded for frame, empty before the first Record.
+		const std::vector<VkCommandBuffer>& Recorded(uint32_t frame) const { return recorded[frame]; }
+	};
+}
\ No newline at end of file
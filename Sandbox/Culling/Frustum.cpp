@@ -0,0 +1,197 @@
+#include "Frustum.hpp"
+#include "SimdLane.hpp"
+#include <cmath>
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  // Elements scored per pass of the batch kernels; the scores stay on the stack.
+	  const size_t kClassifyBlock = 256;
+
+	  CullResult Classify(float outsideScore, float insideScore)
+	  {
+		  if (outsideScore < 0.0f)
+		  {
+			  return (CullResult::Outside);
+		  }
+		  return (insideScore >= 0.0f ? CullResult::Inside : CullResult::Intersecting);
+	  }
+
+	  // For every element i with center c and radius r (a sphere radius, or the projected half extent
+	  // of a box onto the plane normal) computes
+	  //   outside[i] = min over planes of (n.c + d + r): negative when the bounds are fully behind a plane,
+	  //   inside[i]  = min over planes of (n.c + d - r): non-negative when they are in front of all of them.
+	  // Spheres pass centers in a and radii in r; boxes pass their minimum corners in a and maximum
+	  // corners in b and are turned into center/extent form in registers.
+	  template <class L, bool Box>
+	  void ScoreRange(const Frustum& frustum, const float* const* a, const float* const* b, const float* r,
+	                  float* outside, float* inside, size_t begin, size_t end)
+	  {
+		  typename L::Type planes[Frustum::PlaneCount][4];
+		  typename L::Type absNormals[Frustum::PlaneCount][3];
+		  for (int p = 0; p < Frustum::PlaneCount; p++)
+		  {
+			  for (int k = 0; k < 4; k++)
+			  {
+				  planes[p][k] = L::Set(frustum.planes[p][k]);
+			  }
+			  for (int k = 0; k < 3; k++)
+			  {
+				  absNormals[p][k] = L::Set(std::fabs(frustum.planes[p][k]));
+			  }
+		  }
+
+		  const typename L::Type half = L::Set(0.5f);
+		  for (size_t i = begin; i < end; i += L::Width)
+		  {
+			  typename L::Type center[3];
+			  typename L::Type extent[3];
+			  typename L::Type radius = L::Set(0.0f);
+			  for (int k = 0; k < 3; k++)
+			  {
+				  center[k] = L::Load(a[k] + i);
+				  if (Box)
+				  {
+					  typename L::Type maximum = L::Load(b[k] + i);
+					  extent[k] = L::Mul(L::Sub(maximum, center[k]), half);
+					  center[k] = L::Mul(L::Add(maximum, center[k]), half);
+				  }
+			  }
+			  if (!Box)
+			  {
+				  radius = L::Load(r + i);
+			  }
+
+			  typename L::Type outsideScore = L::Set(INFINITY);
+			  typename L::Type insideScore = L::Set(INFINITY);
+			  for (int p = 0; p < Frustum::PlaneCount; p++)
+			  {
+				  typename L::Type distance = L::Add(L::Add(L::Mul(planes[p][0], center[0]), L::Mul(planes[p][1], center[1])),
+				                                     L::Add(L::Mul(planes[p][2], center[2]), planes[p][3]));
+				  if (Box)
+				  {
+					  radius = L::Add(L::Add(L::Mul(absNormals[p][0], extent[0]), L::Mul(absNormals[p][1], extent[1])),
+					                  L::Mul(absNormals[p][2], extent[2]));
+				  }
+				  outsideScore = L::Min(outsideScore, L::Add(distance, radius));
+				  insideScore = L::Min(insideScore, L::Sub(distance, radius));
+			  }
+			  L::Store(outside + i, outsideScore);
+			  L::Store(inside + i, insideScore);
+		  }
+	  }
+
+	  template <bool Box>
+	  void ClassifyBatch(const Frustum& frustum, const float* const* a, const float* const* b, const float* r,
+	                     size_t count, CullResult* out)
+	  {
+		  float outside[kClassifyBlock];
+		  float inside[kClassifyBlock];
+		  for (size_t first = 0; first < count; first += kClassifyBlock)
+		  {
+			  size_t n = count - first < kClassifyBlock ? count - first : kClassifyBlock;
+			  size_t bulk = n - n % detail::WideLane::Width;
+			  // Offsetting every stream by first keeps the scores block-relative.
+			  const float* blockA[3] = { a[0] + first, a[1] + first, a[2] + first };
+			  const float* blockB[3] = { nullptr, nullptr, nullptr };
+			  const float* blockR = nullptr;
+			  if (Box)
+			  {
+				  blockB[0] = b[0] + first;
+				  blockB[1] = b[1] + first;
+				  blockB[2] = b[2] + first;
+			  }
+			  else
+			  {
+				  blockR = r + first;
+			  }
+			  ScoreRange<detail::WideLane, Box>(frustum, blockA, blockB, blockR, outside, inside, 0, bulk);
+			  ScoreRange<detail::ScalarLane, Box>(frustum, blockA, blockB, blockR, outside, inside, bulk, n);
+			  for (size_t i = 0; i < n; i++)
+			  {
+				  out[first + i] = Classify(outside[i], inside[i]);
+			  }
+		  }
+	  }
+
+	  void NormalizePlane(float* plane)
+	  {
+		  float invLength = 1.0f / std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		  for (int k = 0; k < 4; k++)
+		  {
+			  plane[k] *= invLength;
+		  }
+	  }
+  }
+
+  Frustum::Frustum()
+  {
+	  for (int p = 0; p < PlaneCount; p++)
+	  {
+		  planes[p][0] = 0.0f;
+		  planes[p][1] = 0.0f;
+		  planes[p][2] = 0.0f;
+		  planes[p][3] = 1.0f;
+	  }
+  }
+
+  Frustum::Frustum(const Matrix4D& M, DepthRange depthRange)
+  : Frustum(M.Data(), depthRange)
+  {
+  }
+
+  // Gribb/Hartmann extraction: with r0..r3 the rows of the clip matrix, a point is inside when
+  // -w <= x <= w, -w <= y <= w and 0 (or -w) <= z <= w, which gives the planes below.
+  Frustum::Frustum(const float* m, DepthRange depthRange)
+  {
+	  for (int k = 0; k < 4; k++)
+	  {
+		  // Element (row i, column k) of a column-major matrix is m[k * 4 + i].
+		  float r0 = m[k * 4 + 0];
+		  float r1 = m[k * 4 + 1];
+		  float r2 = m[k * 4 + 2];
+		  float r3 = m[k * 4 + 3];
+		  planes[Left][k] = r3 + r0;
+		  planes[Right][k] = r3 - r0;
+		  planes[Bottom][k] = r3 + r1;
+		  planes[Top][k] = r3 - r1;
+		  planes[Near][k] = depthRange == DepthRange::ZeroToOne ? r2 : r3 + r2;
+		  planes[Far][k] = r3 - r2;
+	  }
+	  for (int p = 0; p < PlaneCount; p++)
+	  {
+		  NormalizePlane(planes[p]);
+	  }
+  }
+
+  CullResult Frustum::ClassifySphere(const Vector3D& center, float radius) const
+  {
+	  const float* a[3] = { &center.x, &center.y, &center.z };
+	  CullResult result;
+	  ClassifyBatch<false>(*this, a, nullptr, &radius, 1, &result);
+	  return (result);
+  }
+
+  CullResult Frustum::ClassifyAABB(const Vector3D& minimum, const Vector3D& maximum) const
+  {
+	  const float* a[3] = { &minimum.x, &minimum.y, &minimum.z };
+	  const float* b[3] = { &maximum.x, &maximum.y, &maximum.z };
+	  CullResult result;
+	  ClassifyBatch<true>(*this, a, b, nullptr, 1, &result);
+	  return (result);
+  }
+
+  void ClassifySpheres(const Frustum& frustum, const Vector3DArray& centers, const float* radii, CullResult* out)
+  {
+	  const float* a[3] = { centers.X(), centers.Y(), centers.Z() };
+	  ClassifyBatch<false>(frustum, a, nullptr, radii, centers.Size(), out);
+  }
+
+  void ClassifyAABBs(const Frustum& frustum, const Vector3DArray& minimums, const Vector3DArray& maximums, CullResult* out)
+  {
+	  const float* a[3] = { minimums.X(), minimums.Y(), minimums.Z() };
+	  const float* b[3] = { maximums.X(), maximums.Y(), maximums.Z() };
+	  ClassifyBatch<true>(frustum, a, b, nullptr, minimums.Size(), out);
+  }
+}
\ No newline at end of file
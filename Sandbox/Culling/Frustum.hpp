@@ -0,0 +1,56 @@
+#pragma once
+#include "Matrix4D.hpp"
+#include "Vector3DArray.hpp"
+#include <cstdint>
+
+namespace BadgerSandbox
+{
+	enum class CullResult : uint8_t
+	{
+		Outside = 0,
+		Intersecting = 1,
+		Inside = 2
+	};
+
+	// Clip-space depth convention of the projection the frustum is extracted from. Vulkan (and the
+	// Sandbox Perspective helpers) use ZeroToOne; glm::perspective without GLM_FORCE_DEPTH_ZERO_TO_ONE
+	// produces NegativeOneToOne.
+	enum class DepthRange
+	{
+		ZeroToOne,
+		NegativeOneToOne
+	};
+
+	// Six normalized planes (a, b, c, d) with a*x + b*y + c*z + d >= 0 on the inside. They live in
+	// whatever space the source matrix maps from: world space for a view-projection matrix, model
+	// space for a model-view-projection matrix.
+	class Frustum
+	{
+	public:
+		enum Plane
+		{
+			Left = 0,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			PlaneCount
+		};
+
+		float planes[PlaneCount][4];
+
+		Frustum();
+		explicit Frustum(const Matrix4D& M, DepthRange depthRange = DepthRange::ZeroToOne);
+		// m points at 16 floats in column-major order, e.g. glm::value_ptr of a glm::mat4.
+		explicit Frustum(const float* m, DepthRange depthRange = DepthRange::ZeroToOne);
+
+		CullResult ClassifySphere(const Vector3D& center, float radius) const;
+		CullResult ClassifyAABB(const Vector3D& minimum, const Vector3D& maximum) const;
+	};
+
+  // Batch classification. out receives one result per element; the work runs in SIMD lanes over the
+  // SoA streams, so thousands of bounds cost a handful of instructions each.
+  extern void ClassifySpheres(const Frustum& frustum, const Vector3DArray& centers, const float* radii, CullResult* out);
+  extern void ClassifyAABBs(const Frustum& frustum, const Vector3DArray& minimums, const Vector3DArray& maximums, CullResult* out);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "FrustumCuller.hpp"
+
+namespace BadgerSandbox
+{
+  void FrustumCuller::Clear()
+  {
+	  minimums.Resize(0);
+	  maximums.Resize(0);
+	  results.clear();
+	  indices.clear();
+	  ++visibilityVersion;
+  }
+
+  size_t FrustumCuller::Add(const void* key, const Vector3D& minimum, const Vector3D& maximum)
+  {
+	  auto existing = indices.find(key);
+	  if (existing != indices.end())
+	  {
+		  SetBounds(existing->second, minimum, maximum);
+		  return (existing->second);
+	  }
+	  size_t index = results.size();
+	  minimums.Resize(index + 1);
+	  maximums.Resize(index + 1);
+	  results.push_back(CullResult::Intersecting);
+	  indices[key] = index;
+	  SetBounds(index, minimum, maximum);
+	  ++visibilityVersion;
+	  return (index);
+  }
+
+  void FrustumCuller::SetBounds(size_t index, const Vector3D& minimum, const Vector3D& maximum)
+  {
+	  minimums.Set(index, minimum);
+	  maximums.Set(index, maximum);
+  }
+
+  size_t FrustumCuller::Cull(const Frustum& frustum)
+  {
+	  if (results.empty())
+	  {
+		  return (0);
+	  }
+	  classified.resize(results.size());
+	  ClassifyAABBs(frustum, minimums, maximums, classified.data());
+	  size_t visible = 0;
+	  bool changed = false;
+	  for (size_t i = 0; i < classified.size(); ++i)
+	  {
+		  visible += classified[i] != CullResult::Outside ? 1 : 0;
+		  changed |= (classified[i] == CullResult::Outside) != (results[i] == CullResult::Outside);
+	  }
+	  results.swap(classified);
+	  if (changed)
+	  {
+		  ++visibilityVersion;
+	  }
+	  return (visible);
+  }
+
+  bool FrustumCuller::IsVisible(const void* key) const
+  {
+	  auto it = indices.find(key);
+	  return (it == indices.end() || results[it->second] != CullResult::Outside);
+  }
+}
\ No newline at end of file
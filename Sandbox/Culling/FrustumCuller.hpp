@@ -0,0 +1,33 @@
+#pragma once
+#include "Frustum.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace BadgerSandbox
+{
+	// Bounds registry that samples fill once after loading and cull each frame before recording
+	// command buffers. Entries are keyed by an opaque pointer (a vkglTF::Primitive*, for example);
+	// keys that were never added are always reported visible.
+	class FrustumCuller
+	{
+	private:
+	  Vector3DArray minimums;
+	  Vector3DArray maximums;
+	  std::vector<CullResult> results;
+	  std::vector<CullResult> classified;
+	  std::unordered_map<const void*, size_t> indices;
+	  uint64_t visibilityVersion = 0;
+	public:
+		void Clear();
+		// Adding a key again moves its bounds and keeps its index.
+		size_t Add(const void* key, const Vector3D& minimum, const Vector3D& maximum);
+		void SetBounds(size_t index, const Vector3D& minimum, const Vector3D& maximum);
+		// Classifies every registered bounds against frustum in one batch and returns how many are visible.
+		size_t Cull(const Frustum& frustum);
+		bool IsVisible(const void* key) const;
+		size_t Size() const { return results.size(); }
+		// Changes whenever an entry is added or removed or Cull flips the visibility of one, so command buffers
+		// recorded against an older version have to be recorded again.
+		uint64_t VisibilityVersion() const { return visibilityVersion; }
+	};
+}
\ No newline at end of file
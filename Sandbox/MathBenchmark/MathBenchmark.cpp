@@ -0,0 +1,242 @@
+// Headless micro-benchmarks for the Sandbox math library, measured against glm.
+// Every case runs over an array of inputs at several batch sizes and reports ns/op and Mops/s,
+// so both the per-operation cost and the effect of the working set leaving the caches show up.
+#include "AffineTransform.hpp"
+#include "Matrix4D.hpp"
+#include "Matrix4DBatch.hpp"
+#include "Vector3DArray.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace BadgerSandbox
+{
+namespace
+{
+	// Results are folded into this so the optimizer cannot drop the measured work.
+	volatile float benchmarkSink = 0.0f;
+
+	const size_t kBatchSizes[] = { 16, 256, 4096, 65536 };
+	// Total operations per measurement; small batches are repeated until they reach it.
+	const size_t kOperationsPerSample = 1 << 22;
+	const int kSamples = 5;
+
+	struct BenchmarkInputs
+	{
+		std::vector<Matrix4D> badgerA;
+		std::vector<Matrix4D> badgerB;
+		std::vector<Vector4D> badgerV;
+		std::vector<Vector3D> badgerP;
+		std::vector<Vector3D> badgerQ;
+		std::vector<AffineTransform> badgerAffineA;
+		std::vector<AffineTransform> badgerAffineB;
+		Vector3DArray badgerPoints;
+
+		std::vector<glm::mat4> glmA;
+		std::vector<glm::mat4> glmB;
+		std::vector<glm::vec4> glmV;
+		std::vector<glm::vec3> glmP;
+		std::vector<glm::vec3> glmQ;
+	};
+
+	Matrix4D RandomAffine(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+		Matrix4D M;
+		for (int j = 0; j < 4; j++)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				M(i, j) = value(rng);
+			}
+		}
+		// Keep the matrices well conditioned so Inverse measures real work, not NaN propagation.
+		M(0, 0) += 5.0f;
+		M(1, 1) += 5.0f;
+		M(2, 2) += 5.0f;
+		return M;
+	}
+
+	glm::mat4 ToGlm(const Matrix4D& M)
+	{
+		glm::mat4 result;
+		memcpy(&result[0][0], M.Data(), sizeof(float) * 16);
+		return result;
+	}
+
+	void FillInputs(BenchmarkInputs& inputs, size_t count)
+	{
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+
+		inputs.badgerPoints.Resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			Matrix4D A = RandomAffine(rng);
+			Matrix4D B = RandomAffine(rng);
+			Vector3D p(value(rng), value(rng), value(rng));
+			Vector3D q(value(rng), value(rng), value(rng));
+
+			inputs.badgerA.push_back(A);
+			inputs.badgerB.push_back(B);
+			inputs.badgerV.push_back(Vector4D(p.x, p.y, p.z, 1.0f));
+			inputs.badgerP.push_back(p);
+			inputs.badgerQ.push_back(q);
+			inputs.badgerAffineA.push_back(AffineTransform(A));
+			inputs.badgerAffineB.push_back(AffineTransform(B));
+			inputs.badgerPoints.Set(i, p);
+
+			inputs.glmA.push_back(ToGlm(A));
+			inputs.glmB.push_back(ToGlm(B));
+			inputs.glmV.push_back(glm::vec4(p.x, p.y, p.z, 1.0f));
+			inputs.glmP.push_back(glm::vec3(p.x, p.y, p.z));
+			inputs.glmQ.push_back(glm::vec3(q.x, q.y, q.z));
+		}
+	}
+
+	// Runs kernel(batchSize) enough times to cover kOperationsPerSample operations and keeps the
+	// fastest of kSamples samples.
+	template <typename Kernel>
+	double MeasureNanosecondsPerOp(size_t batchSize, Kernel kernel)
+	{
+		size_t repetitions = kOperationsPerSample / batchSize;
+		if (repetitions == 0)
+		{
+			repetitions = 1;
+		}
+
+		double best = 0.0;
+		for (int sample = 0; sample < kSamples; sample++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (size_t r = 0; r < repetitions; r++)
+			{
+				benchmarkSink = benchmarkSink + kernel(batchSize);
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			double ns = std::chrono::duration<double, std::nano>(end - start).count() / double(repetitions * batchSize);
+			if (sample == 0 || ns < best)
+			{
+				best = ns;
+			}
+		}
+		return best;
+	}
+
+	template <typename BadgerKernel, typename GlmKernel>
+	void RunCase(const char* name, BadgerKernel badger, GlmKernel glmKernel)
+	{
+		for (size_t batchSize : kBatchSizes)
+		{
+			double badgerNs = MeasureNanosecondsPerOp(batchSize, badger);
+			double glmNs = MeasureNanosecondsPerOp(batchSize, glmKernel);
+			printf("%-15s %8zu %12.3f %12.1f %12.3f %12.1f %8.2fx\n",
+				name, batchSize,
+				badgerNs, 1000.0 / badgerNs,
+				glmNs, 1000.0 / glmNs,
+				glmNs / badgerNs);
+		}
+	}
+}
+}
+
+int main()
+{
+	using namespace BadgerSandbox;
+
+	const size_t maxBatch = kBatchSizes[sizeof(kBatchSizes) / sizeof(kBatchSizes[0]) - 1];
+	BenchmarkInputs in;
+	FillInputs(in, maxBatch);
+
+	std::vector<Matrix4D> badgerMatrices(maxBatch);
+	std::vector<glm::mat4> glmMatrices(maxBatch);
+	std::vector<glm::vec4> glmVectors(maxBatch);
+	Vector3DArray badgerPoints(maxBatch);
+	std::vector<glm::vec3> glmPoints(maxBatch);
+
+#if defined(BADGER_SANDBOX_SIMD_AVX)
+	const char* path = "AVX";
+#elif defined(BADGER_SANDBOX_SIMD_SSE)
+	const char* path = "SSE";
+#else
+	const char* path = "scalar";
+#endif
+	printf("BadgerSandbox math benchmark (%s kernels)\n", path);
+	printf("%-15s %8s %12s %12s %12s %12s %9s\n", "case", "batch", "badger ns/op", "badger Mop/s", "glm ns/op", "glm Mop/s", "speedup");
+
+	RunCase("mat*mat",
+		[&](size_t n) { for (size_t i = 0; i < n; i++) badgerMatrices[i] = in.badgerA[i] * in.badgerB[i]; return badgerMatrices[n - 1](0, 0); },
+		[&](size_t n) { for (size_t i = 0; i < n; i++) glmMatrices[i] = in.glmA[i] * in.glmB[i]; return glmMatrices[n - 1][0][0]; });
+
+	RunCase("mat*vec",
+		[&](size_t n) { float sum = 0.0f; for (size_t i = 0; i < n; i++) sum += (in.badgerA[i] * in.badgerV[i]).x; return sum; },
+		[&](size_t n) { float sum = 0.0f; for (size_t i = 0; i < n; i++) sum += (in.glmA[i] * in.glmV[i]).x; return sum; });
+
+	RunCase("inverse",
+		[&](size_t n) { for (size_t i = 0; i < n; i++) badgerMatrices[i] = Inverse(in.badgerA[i]); return badgerMatrices[n - 1](0, 0); },
+		[&](size_t n) { for (size_t i = 0; i < n; i++) glmMatrices[i] = glm::inverse(in.glmA[i]); return glmMatrices[n - 1][0][0]; });
+
+	// The inputs are affine, so these time AffineTransform against glm's general 4x4 paths.
+	std::vector<AffineTransform> badgerAffine(maxBatch);
+	RunCase("affine*affine",
+		[&](size_t n) { for (size_t i = 0; i < n; i++) badgerAffine[i] = in.badgerAffineA[i] * in.badgerAffineB[i]; return badgerAffine[n - 1].translation.x; },
+		[&](size_t n) { for (size_t i = 0; i < n; i++) glmMatrices[i] = in.glmA[i] * in.glmB[i]; return glmMatrices[n - 1][0][0]; });
+
+	RunCase("affine inverse",
+		[&](size_t n) { for (size_t i = 0; i < n; i++) badgerAffine[i] = Inverse(in.badgerAffineA[i]); return badgerAffine[n - 1].translation.x; },
+		[&](size_t n) { for (size_t i = 0; i < n; i++) glmMatrices[i] = glm::inverse(in.glmA[i]); return glmMatrices[n - 1][0][0]; });
+
+	RunCase("determinant",
+		[&](size_t n) { float sum = 0.0f; for (size_t i = 0; i < n; i++) sum += Determinant(in.badgerA[i]); return sum; },
+		[&](size_t n) { float sum = 0.0f; for (size_t i = 0; i < n; i++) sum += glm::determinant(in.glmA[i]); return sum; });
+
+	RunCase("normalize",
+		[&](size_t n) { float sum = 0.0f; for (size_t i = 0; i < n; i++) sum += Normalize(in.badgerP[i]).x; return sum; },
+		[&](size_t n) { float sum = 0.0f; for (size_t i = 0; i < n; i++) sum += glm::normalize(in.glmP[i]).x; return sum; });
+
+	RunCase("cross",
+		[&](size_t n) { float sum = 0.0f; for (size_t i = 0; i < n; i++) sum += Cross(in.badgerP[i], in.badgerQ[i]).x; return sum; },
+		[&](size_t n) { float sum = 0.0f; for (size_t i = 0; i < n; i++) sum += glm::cross(in.glmP[i], in.glmQ[i]).x; return sum; });
+
+	// Batch transform: the SoA kernel against the straightforward glm loop over an AoS array.
+	std::vector<Vector3DArray> batchPoints;
+	for (size_t batchSize : kBatchSizes)
+	{
+		Vector3DArray points(batchSize);
+		for (size_t i = 0; i < batchSize; i++)
+		{
+			points.Set(i, in.badgerPoints.Get(i));
+		}
+		batchPoints.push_back(points);
+	}
+	const Matrix4D& transform = in.badgerA[0];
+	const glm::mat4& glmTransform = in.glmA[0];
+	RunCase("batch xform",
+		[&](size_t n)
+		{
+			size_t b = 0;
+			while (kBatchSizes[b] != n)
+			{
+				b++;
+			}
+			TransformPoints(transform, batchPoints[b], badgerPoints);
+			return badgerPoints.X()[n - 1];
+		},
+		[&](size_t n)
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				glmPoints[i] = glm::vec3(glmTransform * glm::vec4(in.glmP[i], 1.0f));
+			}
+			return glmPoints[n - 1].x;
+		});
+
+	return 0;
+}
\ No newline at end of file
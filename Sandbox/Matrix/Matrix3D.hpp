@@ -9,22 +9,98 @@ namespace BadgerSandbox
 	private:
 	  float n[3][3];
 	public:
-		Matrix3D();
-		Matrix3D(float n00, float n01, float n02,
-		         float n10, float n11, float n12,
-				 float n20, float n21, float n22);
-		Matrix3D(const Vector3D& a, const Vector3D& b, const Vector3D& c);
-		float& operator ()(int i, int j);
-		const float& operator ()(int i, int j) const;
-		Vector3D& operator [](int j);
-		const Vector3D& operator [](int j) const;
-				 
+		constexpr Matrix3D()
+		: n{ { 1.0f, 0.0f, 0.0f },
+		     { 0.0f, 1.0f, 0.0f },
+		     { 0.0f, 0.0f, 1.0f } }
+		{
+		}
+
+		constexpr Matrix3D(float n00, float n01, float n02,
+		                   float n10, float n11, float n12,
+		                   float n20, float n21, float n22)
+		: n{ { n00, n10, n20 },
+		     { n01, n11, n21 },
+		     { n02, n12, n22 } }
+		{
+		}
+
+		constexpr Matrix3D(const Vector3D& a, const Vector3D& b, const Vector3D& c)
+		: n{ { a.x, a.y, a.z },
+		     { b.x, b.y, b.z },
+		     { c.x, c.y, c.z } }
+		{
+		}
+
+		constexpr float& operator ()(int i, int j)
+		{
+			return (n[j][i]);
+		}
+
+		constexpr const float& operator ()(int i, int j) const
+		{
+			return (n[j][i]);
+		}
+
+		Vector3D& operator [](int j)
+		{
+			return (*reinterpret_cast<Vector3D *>(n[j]));
+		}
+
+		const Vector3D& operator [](int j) const
+		{
+			return (*reinterpret_cast<const Vector3D *>(n[j]));
+		}
 	};
   
-  Matrix3D operator * (const Matrix3D& A, const Matrix3D& B);
-  Vector3D operator * (const Matrix3D& M, const Vector3D& v);
+  constexpr Matrix3D operator * (const Matrix3D& A, const Matrix3D& B)
+  {
+	  return(Matrix3D(A(0,0) * B(0,0) + A(0,1) * B(1,0) + A(0,2) * B(2, 0),
+	                  A(0,0) * B(0,1) + A(0,1) * B(1,1) + A(0,2) * B(2, 1),
+					  A(0,0) * B(0,2) + A(0,1) * B(1,2) + A(0,2) * B(2, 2),
+					  A(1,0) * B(0,0) + A(1,1) * B(1,0) + A(1,2) * B(2, 0),
+	                  A(1,0) * B(0,1) + A(1,1) * B(1,1) + A(1,2) * B(2, 1),
+					  A(1,0) * B(0,2) + A(1,1) * B(1,2) + A(1,2) * B(2, 2),
+					  A(2,0) * B(0,0) + A(2,1) * B(1,0) + A(2,2) * B(2, 0),
+	                  A(2,0) * B(0,1) + A(2,1) * B(1,1) + A(2,2) * B(2, 1),
+					  A(2,0) * B(0,2) + A(2,1) * B(1,2) + A(2,2) * B(2, 2)));
+  }
+  
+  constexpr Vector3D operator * (const Matrix3D& M, const Vector3D& v)
+  {
+	  return(Vector3D(M(0,0) * v.x + M(0,1) * v.y + M(0,2) * v.z,
+	                  M(1,0) * v.x + M(1,1) * v.y + M(1,2) * v.z,
+					  M(2,0) * v.x + M(2,1) * v.y + M(2,2) * v.z));
+  }
 
-  float Determinant(const Matrix3D& M);
-  Matrix3D Inverse(const Matrix3D& M);
+  constexpr Matrix3D Transpose(const Matrix3D& M)
+  {
+	  return (Matrix3D(M(0,0), M(1,0), M(2,0),
+	                   M(0,1), M(1,1), M(2,1),
+					   M(0,2), M(1,2), M(2,2)));
+  }
+  
+  constexpr float Determinant(const Matrix3D& M)
+  {
+	  return (M(0,0) * (M(1,1) * M(2,2) - M(1,2) * M(2,1))
+	        + M(0,1) * (M(1,2) * M(2,0) - M(1,0) * M(2,2))
+			+ M(0,2) * (M(1,0) * M(2,1) - M(1,1) * M(2,0)));
+  }
   
+  constexpr Matrix3D Inverse(const Matrix3D& M)
+  {
+	  const Vector3D a(M(0,0), M(1,0), M(2,0));
+	  const Vector3D b(M(0,1), M(1,1), M(2,1));
+	  const Vector3D c(M(0,2), M(1,2), M(2,2));
+	  
+	  const Vector3D r0 = Cross(b, c);
+	  const Vector3D r1 = Cross(c, a);
+	  const Vector3D r2 = Cross(a, b);
+	  
+	  const float invDet = 1.0F / Dot(r2, c);
+	  
+	  return (Matrix3D(r0.x * invDet, r0.y * invDet, r0.z * invDet,
+	                   r1.x * invDet, r1.y * invDet, r1.z * invDet,
+					   r2.x * invDet, r2.y * invDet, r2.z * invDet));
+  }
 }
\ No newline at end of file
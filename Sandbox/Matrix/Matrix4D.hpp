@@ -8,23 +8,313 @@ namespace BadgerSandbox
 	class Matrix4D
 	{
 	private:
-	  float n[4][4];
+	  // Each column is 16-byte aligned so the SIMD kernels can load it as one register.
+	  alignas(16) float n[4][4];
 	public:
-		Matrix4D();
-		Matrix4D(float n00, float n01, float n02, float n03,
-		         float n10, float n11, float n12, float n13,
-				 float n20, float n21, float n22, float n23,
-				 float n30, float n31, float n32, float n33);
-		Matrix4D(const Vector4D& a, const Vector4D& b, const Vector4D& c, const Vector4D& d);
-		float& operator ()(int i, int j);
-		const float& operator ()(int i, int j) const;
-		Vector4D& operator [](int j);
-		const Vector4D& operator [](int j) const;
+		constexpr Matrix4D()
+		: n{ { 1.0f, 0.0f, 0.0f, 0.0f },
+		     { 0.0f, 1.0f, 0.0f, 0.0f },
+		     { 0.0f, 0.0f, 1.0f, 0.0f },
+		     { 0.0f, 0.0f, 0.0f, 1.0f } }
+		{
+		}
+
+		constexpr Matrix4D(float n00, float n01, float n02, float n03,
+		                   float n10, float n11, float n12, float n13,
+		                   float n20, float n21, float n22, float n23,
+		                   float n30, float n31, float n32, float n33)
+		: n{ { n00, n10, n20, n30 },
+		     { n01, n11, n21, n31 },
+		     { n02, n12, n22, n32 },
+		     { n03, n13, n23, n33 } }
+		{
+		}
+
+		constexpr Matrix4D(const Vector4D& a, const Vector4D& b, const Vector4D& c, const Vector4D& d)
+		: n{ { a.x, a.y, a.z, a.w },
+		     { b.x, b.y, b.z, b.w },
+		     { c.x, c.y, c.z, c.w },
+		     { d.x, d.y, d.z, d.w } }
+		{
+		}
+
+		constexpr float& operator ()(int i, int j)
+		{
+			return (n[j][i]);
+		}
+
+		constexpr const float& operator ()(int i, int j) const
+		{
+			return (n[j][i]);
+		}
+
+		Vector4D& operator [](int j)
+		{
+			return (*reinterpret_cast<Vector4D *>(n[j]));
+		}
+
+		const Vector4D& operator [](int j) const
+		{
+			return (*reinterpret_cast<const Vector4D *>(n[j]));
+		}
+
 		float* Data() { return n[0]; }
+		const float* Data() const { return n[0]; }
 	};
-  Matrix4D operator * (const Matrix4D& A, const Matrix4D& B);
-  Vector4D operator * (const Matrix4D& M, const Vector4D& v);
-  float Determinant(const Matrix4D& M);
-  Matrix4D Inverse(const Matrix4D& M);
+
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+  namespace detail
+  {
+	  // Cross product of the xyz lanes; w lanes of 0 stay 0.
+	  inline __m128 Cross3(__m128 a, __m128 b)
+	  {
+		  __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		  __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		  __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+		  return (_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+	  }
+
+	  // Linear combination of the four columns of M, i.e. M * (x, y, z, w).
+	  inline __m128 Combine(const float* M, __m128 v)
+	  {
+		  __m128 r = _mm_mul_ps(_mm_load_ps(M), _mm_shuffle_ps(v, v, 0x00));
+		  r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(M + 4), _mm_shuffle_ps(v, v, 0x55)));
+		  r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(M + 8), _mm_shuffle_ps(v, v, 0xAA)));
+		  r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(M + 12), _mm_shuffle_ps(v, v, 0xFF)));
+		  return (r);
+	  }
+
+	  inline Vector4D Transform(const float* M, const Vector4D& v)
+	  {
+		  alignas(16) float r[4];
+		  _mm_store_ps(r, Combine(M, Load(v)));
+		  return (Vector4D(r[0], r[1], r[2], r[3]));
+	  }
+
+	  inline __m128 XYZMask()
+	  {
+		  return (_mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+	  }
+
+	  inline void Multiply(const float* a, const float* b, float* c)
+	  {
+#if defined(BADGER_SANDBOX_SIMD_AVX)
+		  // Two result columns per iteration: every A column is broadcast to both 128-bit lanes and
+		  // scaled by the matching element of the two B columns held in those lanes.
+		  __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a));
+		  __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 4));
+		  __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 8));
+		  __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 12));
+		  for (int j = 0; j < 16; j += 8)
+		  {
+			  __m256 bb = _mm256_load_ps(b + j);
+			  __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(bb, bb, 0x00));
+			  r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_shuffle_ps(bb, bb, 0x55)));
+			  r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_shuffle_ps(bb, bb, 0xAA)));
+			  r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_shuffle_ps(bb, bb, 0xFF)));
+			  _mm256_store_ps(c + j, r);
+		  }
+#else
+		  for (int j = 0; j < 16; j += 4)
+		  {
+			  _mm_store_ps(c + j, Combine(a, _mm_load_ps(b + j)));
+		  }
+#endif
+	  }
+
+	  inline void Transpose(const float* m, float* t)
+	  {
+		  __m128 c0 = _mm_load_ps(m);
+		  __m128 c1 = _mm_load_ps(m + 4);
+		  __m128 c2 = _mm_load_ps(m + 8);
+		  __m128 c3 = _mm_load_ps(m + 12);
+		  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		  _mm_store_ps(t, c0);
+		  _mm_store_ps(t + 4, c1);
+		  _mm_store_ps(t + 8, c2);
+		  _mm_store_ps(t + 12, c3);
+	  }
+
+	  // Lengyel's cross-product form: columns a, b, c, d (xyz) and bottom row x, y, z, w give
+	  // s = a x b, t = c x d, u = a*y - b*x, v = c*w - d*z and det = s.v + t.u.
+	  struct InverseTerms
+	  {
+		  __m128 a, b, c, d;
+		  __m128 x, y, z, w;
+		  __m128 s, t, u, v;
+	  };
+
+	  inline InverseTerms ComputeInverseTerms(const float* m)
+	  {
+		  InverseTerms r;
+		  __m128 mask = XYZMask();
+		  r.a = _mm_and_ps(_mm_load_ps(m), mask);
+		  r.b = _mm_and_ps(_mm_load_ps(m + 4), mask);
+		  r.c = _mm_and_ps(_mm_load_ps(m + 8), mask);
+		  r.d = _mm_and_ps(_mm_load_ps(m + 12), mask);
+		  r.x = _mm_set1_ps(m[3]);
+		  r.y = _mm_set1_ps(m[7]);
+		  r.z = _mm_set1_ps(m[11]);
+		  r.w = _mm_set1_ps(m[15]);
+		  r.s = Cross3(r.a, r.b);
+		  r.t = Cross3(r.c, r.d);
+		  r.u = _mm_sub_ps(_mm_mul_ps(r.a, r.y), _mm_mul_ps(r.b, r.x));
+		  r.v = _mm_sub_ps(_mm_mul_ps(r.c, r.w), _mm_mul_ps(r.d, r.z));
+		  return (r);
+	  }
+
+	  inline float Determinant(const float* m)
+	  {
+		  InverseTerms k = ComputeInverseTerms(m);
+		  return (HorizontalAdd(_mm_mul_ps(k.s, k.v)) + HorizontalAdd(_mm_mul_ps(k.t, k.u)));
+	  }
+
+	  inline void Inverse(const float* m, float* n)
+	  {
+		  InverseTerms k = ComputeInverseTerms(m);
+		  __m128 invDet = _mm_set1_ps(1.0F / (HorizontalAdd(_mm_mul_ps(k.s, k.v)) + HorizontalAdd(_mm_mul_ps(k.t, k.u))));
+		  __m128 s = _mm_mul_ps(k.s, invDet);
+		  __m128 t = _mm_mul_ps(k.t, invDet);
+		  __m128 u = _mm_mul_ps(k.u, invDet);
+		  __m128 v = _mm_mul_ps(k.v, invDet);
+
+		  __m128 r0 = _mm_add_ps(Cross3(k.b, v), _mm_mul_ps(t, k.y));
+		  __m128 r1 = _mm_sub_ps(Cross3(v, k.a), _mm_mul_ps(t, k.x));
+		  __m128 r2 = _mm_add_ps(Cross3(k.d, u), _mm_mul_ps(s, k.w));
+		  __m128 r3 = _mm_sub_ps(Cross3(u, k.c), _mm_mul_ps(s, k.z));
+
+		  // r0..r3 are the rows of the inverse with w = 0; transposing yields its columns and the
+		  // last column is filled in afterwards.
+		  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		  _mm_store_ps(n, r0);
+		  _mm_store_ps(n + 4, r1);
+		  _mm_store_ps(n + 8, r2);
+		  _mm_store_ps(n + 12, _mm_set_ps(HorizontalAdd(_mm_mul_ps(k.c, s)), -HorizontalAdd(_mm_mul_ps(k.d, s)),
+		                                  HorizontalAdd(_mm_mul_ps(k.a, t)), -HorizontalAdd(_mm_mul_ps(k.b, t))));
+	  }
+  }
+#endif
+
+  BADGER_SANDBOX_SIMD_CONSTEXPR Matrix4D operator * (const Matrix4D& A, const Matrix4D& B)
+  {
+	  Matrix4D C;
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  detail::Multiply(A.Data(), B.Data(), C.Data());
+		  return (C);
+	  }
+#endif
+	  for (int i = 0; i < 4; i++)
+	  {
+		  for (int j = 0; j < 4; j++)
+		  {
+			  C(i,j) = A(i,0) * B(0,j) + A(i,1) * B(1,j) + A(i,2) * B(2,j) + A(i,3) * B(3,j);
+		  }
+	  }
+	  return (C);
+  }
   
+  BADGER_SANDBOX_SIMD_CONSTEXPR Vector4D operator * (const Matrix4D& M, const Vector4D& v)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  return (detail::Transform(M.Data(), v));
+	  }
+#endif
+	  return(Vector4D(M(0,0) * v.x + M(0,1) * v.y + M(0,2) * v.z + M(0,3) * v.w,
+	                  M(1,0) * v.x + M(1,1) * v.y + M(1,2) * v.z + M(1,3) * v.w,
+					  M(2,0) * v.x + M(2,1) * v.y + M(2,2) * v.z + M(2,3) * v.w,
+					  M(3,0) * v.x + M(3,1) * v.y + M(3,2) * v.z + M(3,3) * v.w));
+  }
+
+  BADGER_SANDBOX_SIMD_CONSTEXPR Matrix4D Transpose(const Matrix4D& M)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  Matrix4D T;
+		  detail::Transpose(M.Data(), T.Data());
+		  return (T);
+	  }
+#endif
+	  return (Matrix4D(M(0,0), M(1,0), M(2,0), M(3,0),
+	                   M(0,1), M(1,1), M(2,1), M(3,1),
+					   M(0,2), M(1,2), M(2,2), M(3,2),
+					   M(0,3), M(1,3), M(2,3), M(3,3)));
+  }
+  
+  BADGER_SANDBOX_SIMD_CONSTEXPR float Determinant(const Matrix4D& M)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  return (detail::Determinant(M.Data()));
+	  }
+#endif
+    return(
+	M(0,0) * (
+	    M(1,1) * (M(2,2) * M(3,3) - M(2,3) * M(3,2)) 
+	  + M(1,2) * (M(2,3) * M(3,1) - M(2,1) * M(3,3))
+	  + M(1,3) * (M(2,1) * M(3,2) - M(2,2) * M(3,1)))
+	
+  - M(0,1) * (
+        M(1,0) * (M(2,2) * M(3,3) - M(2,3) * M(3,2))
+      + M(1,2) * (M(2,3) * M(3,0) - M(2,0) * M(3,3))
+	  + M(1,3) * (M(2,0) * M(3,2) - M(2,2) * M(3,0)))
+  
+  + M(0,2) * (
+        M(1,0) * (M(2,1) * M(3,3) - M(2,3) * M(3,1))
+      + M(1,1) * (M(2,3) * M(3,0) - M(2,0) * M(3,3))
+	  + M(1,3) * (M(2,0) * M(3,1) - M(2,1) * M(3,0)))
+  
+  - M(0,3) * (
+        M(1,0) * (M(2,1) * M(3,2) - M(2,2) * M(3,1))
+      + M(1,1) * (M(2,2) * M(3,0) - M(2,0) * M(3,2))
+	  + M(1,2) * (M(2,0) * M(3,1) - M(2,1) * M(3,0)))
+    );
+  }
+  
+  BADGER_SANDBOX_SIMD_CONSTEXPR Matrix4D Inverse(const Matrix4D& M)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  Matrix4D R;
+		  detail::Inverse(M.Data(), R.Data());
+		  return (R);
+	  }
+#endif
+	  const Vector3D a(M(0,0), M(1,0), M(2,0));
+	  const Vector3D b(M(0,1), M(1,1), M(2,1));
+	  const Vector3D c(M(0,2), M(1,2), M(2,2));
+	  const Vector3D d(M(0,3), M(1,3), M(2,3));
+	  
+	  const float x = M(3,0);
+	  const float y = M(3,1);
+	  const float z = M(3,2);
+	  const float w = M(3,3);
+
+      Vector3D s = Cross(a, b);
+	  Vector3D t = Cross(c, d);
+	  Vector3D u = a * y - b * x;
+	  Vector3D v = c * w - d * z; 
+	  
+	  const float invDet = 1.0F/ (Dot(s, v) + Dot(t, u));
+      s *= invDet;
+	  t *= invDet;
+	  u *= invDet;
+	  v *= invDet;
+
+      const Vector3D r0 = Cross(b, v) + t * y;
+	  const Vector3D r1 = Cross(v, a) - t * x;
+	  const Vector3D r2 = Cross(d, u) + s * w;
+	  const Vector3D r3 = Cross(u, c) - s * z; 
+	  
+	  return (Matrix4D(r0.x, r0.y, r0.z, -Dot(b, t),
+	                   r1.x, r1.y, r1.z,  Dot(a, t),
+ 					   r2.x, r2.y, r2.z, -Dot(d, s),
+					   r3.x, r3.y, r3.z, Dot(c, s))); 
+  }
 }
\ No newline at end of file
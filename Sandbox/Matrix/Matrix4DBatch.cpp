@@ -0,0 +1,55 @@
+#include "Matrix4DBatch.hpp"
+#include "SimdLane.hpp"
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  // Each matrix element is broadcast once, then every step handles Width elements of the streams.
+	  template <class L>
+	  void TransformRange(const Matrix4D& M, float w, const Vector3DArray& in, Vector3DArray& out, size_t begin, size_t end)
+	  {
+		  typename L::Type m[3][4];
+		  for (int i = 0; i < 3; i++)
+		  {
+			  for (int j = 0; j < 4; j++)
+			  {
+				  m[i][j] = L::Set(j == 3 ? M(i, j) * w : M(i, j));
+			  }
+		  }
+
+		  for (size_t k = begin; k < end; k += L::Width)
+		  {
+			  typename L::Type x = L::Load(in.X() + k);
+			  typename L::Type y = L::Load(in.Y() + k);
+			  typename L::Type z = L::Load(in.Z() + k);
+			  typename L::Type r[3];
+			  for (int i = 0; i < 3; i++)
+			  {
+				  r[i] = L::Add(L::Add(L::Mul(m[i][0], x), L::Mul(m[i][1], y)), L::Add(L::Mul(m[i][2], z), m[i][3]));
+			  }
+			  L::Store(out.X() + k, r[0]);
+			  L::Store(out.Y() + k, r[1]);
+			  L::Store(out.Z() + k, r[2]);
+		  }
+	  }
+
+	  void Transform(const Matrix4D& M, float w, const Vector3DArray& in, Vector3DArray& out)
+	  {
+		  out.Resize(in.Size());
+		  size_t bulk = in.Size() - in.Size() % detail::WideLane::Width;
+		  TransformRange<detail::WideLane>(M, w, in, out, 0, bulk);
+		  TransformRange<detail::ScalarLane>(M, w, in, out, bulk, in.Size());
+	  }
+  }
+
+  void TransformPoints(const Matrix4D& M, const Vector3DArray& in, Vector3DArray& out)
+  {
+	  Transform(M, 1.0F, in, out);
+  }
+
+  void TransformDirections(const Matrix4D& M, const Vector3DArray& in, Vector3DArray& out)
+  {
+	  Transform(M, 0.0F, in, out);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+#include "Matrix4D.hpp"
+#include "Vector3DArray.hpp"
+
+namespace BadgerSandbox
+{
+  // Transforms every element of in by M and writes the xyz result to out (resized to match; may alias in).
+  // Points use w = 1 and pick up the translation, directions use w = 0. No perspective divide is applied.
+  extern void TransformPoints(const Matrix4D& M, const Vector3DArray& in, Vector3DArray& out);
+  extern void TransformDirections(const Matrix4D& M, const Vector3DArray& in, Vector3DArray& out);
+}
\ No newline at end of file
@@ -0,0 +1,492 @@
+#include "DeviceMemoryAllocator.hpp"
+#include <algorithm>
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  // Slabs hold up to 64 slots, one bit each, and at most SlabBytes of them
+	  const VkDeviceSize SlabBytes = 256 * 1024;
+
+	  VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	  {
+		  return ((value + alignment - 1) / alignment * alignment);
+	  }
+
+	  uint32_t PopCount(uint64_t bits)
+	  {
+		  uint32_t count = 0;
+		  for (; bits != 0; bits &= bits - 1)
+		  {
+			  count++;
+		  }
+		  return (count);
+	  }
+
+	  uint32_t LowestBit(uint64_t bits)
+	  {
+		  uint32_t index = 0;
+		  while ((bits & 1) == 0)
+		  {
+			  bits >>= 1;
+			  index++;
+		  }
+		  return (index);
+	  }
+
+	  uint64_t SlotMask(uint32_t slotCount)
+	  {
+		  return (slotCount == 64 ? ~uint64_t(0) : (uint64_t(1) << slotCount) - 1);
+	  }
+
+	  void Fill(MemoryBlock& block, VkDeviceSize offset, VkDeviceSize size, void* userData, MemorySlab* slab, MemoryAllocation& allocation)
+	  {
+		  allocation.memory = block.memory;
+		  allocation.offset = offset;
+		  allocation.size = size;
+		  allocation.mapped = block.mapped != nullptr ? block.mapped + offset : nullptr;
+		  allocation.memoryType = block.memoryType;
+		  allocation.userData = userData;
+		  allocation.block = &block;
+		  allocation.slab = slab;
+	  }
+  }
+
+  DeviceMemoryAllocator::DeviceMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize)
+	  : device(device)
+  {
+	  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	  VkPhysicalDeviceProperties properties;
+	  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	  nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+	  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+	  {
+		  // Multiple of the largest slab so that slabs never strand the end of a block
+		  const VkDeviceSize heapShare = memoryProperties.memoryHeaps[i].size / 8 / SlabBytes * SlabBytes;
+		  blockSizes[i] = std::max(std::min(blockSize, heapShare), SlabBytes);
+	  }
+  }
+
+  DeviceMemoryAllocator::~DeviceMemoryAllocator()
+  {
+	  for (Pool& pool : pools)
+	  {
+		  for (auto& block : pool.blocks)
+		  {
+			  vkFreeMemory(device, block->memory, nullptr);
+		  }
+	  }
+  }
+
+  VkResult DeviceMemoryAllocator::CreateBlock(uint32_t poolIndex, VkDeviceSize size, bool dedicated, MemoryBlock*& block)
+  {
+	  const uint32_t memoryType = poolIndex / 2;
+	  VkMemoryAllocateInfo allocateInfo = {};
+	  allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	  allocateInfo.allocationSize = size;
+	  allocateInfo.memoryTypeIndex = memoryType;
+	  VkDeviceMemory memory = VK_NULL_HANDLE;
+	  VkResult result = vkAllocateMemory(device, &allocateInfo, nullptr, &memory);
+	  if (result != VK_SUCCESS)
+	  {
+		  return (result);
+	  }
+	  void* mapped = nullptr;
+	  if ((memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0)
+	  {
+		  result = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+		  if (result != VK_SUCCESS)
+		  {
+			  vkFreeMemory(device, memory, nullptr);
+			  return (result);
+		  }
+	  }
+
+	  std::unique_ptr<MemoryBlock> created(new MemoryBlock());
+	  created->memory = memory;
+	  created->size = size;
+	  created->mapped = static_cast<uint8_t*>(mapped);
+	  created->memoryType = memoryType;
+	  created->pool = poolIndex;
+	  created->dedicated = dedicated;
+	  created->usedBytes = 0;
+	  created->freeRanges[0] = size;
+	  block = created.get();
+	  pools[poolIndex].blocks.push_back(std::move(created));
+	  return (VK_SUCCESS);
+  }
+
+  void DeviceMemoryAllocator::ReleaseBlock(MemoryBlock* block)
+  {
+	  auto& blocks = pools[block->pool].blocks;
+	  auto found = std::find_if(blocks.begin(), blocks.end(), [block](const std::unique_ptr<MemoryBlock>& candidate) { return (candidate.get() == block); });
+	  // Freeing the memory unmaps it
+	  vkFreeMemory(device, block->memory, nullptr);
+	  blocks.erase(found);
+  }
+
+  void DeviceMemoryAllocator::ReleaseIfEmpty(MemoryBlock* block)
+  {
+	  if (!block->ranges.empty())
+	  {
+		  return;
+	  }
+	  if (!block->dedicated)
+	  {
+		  // Keep one empty block per pool around so that a free followed by an allocation doesn't hit the driver
+		  const auto& blocks = pools[block->pool].blocks;
+		  const bool otherEmpty = std::any_of(blocks.begin(), blocks.end(), [block](const std::unique_ptr<MemoryBlock>& candidate)
+		  {
+			  return (candidate.get() != block && !candidate->dedicated && candidate->ranges.empty());
+		  });
+		  if (!otherEmpty)
+		  {
+			  return;
+		  }
+	  }
+	  ReleaseBlock(block);
+  }
+
+  bool DeviceMemoryAllocator::AllocateRange(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+  {
+	  // Best fit, the free list of a block stays short as neighbouring ranges are merged
+	  auto best = block.freeRanges.end();
+	  for (auto range = block.freeRanges.begin(); range != block.freeRanges.end(); ++range)
+	  {
+		  const VkDeviceSize aligned = AlignUp(range->first, alignment);
+		  if (aligned + size <= range->first + range->second && (best == block.freeRanges.end() || range->second < best->second))
+		  {
+			  best = range;
+		  }
+	  }
+	  if (best == block.freeRanges.end())
+	  {
+		  return (false);
+	  }
+
+	  const VkDeviceSize begin = best->first;
+	  const VkDeviceSize end = best->first + best->second;
+	  offset = AlignUp(begin, alignment);
+	  block.freeRanges.erase(best);
+	  if (offset > begin)
+	  {
+		  block.freeRanges[begin] = offset - begin;
+	  }
+	  if (offset + size < end)
+	  {
+		  block.freeRanges[offset + size] = end - offset - size;
+	  }
+	  block.usedBytes += size;
+	  return (true);
+  }
+
+  void DeviceMemoryAllocator::FreeRange(MemoryBlock& block, VkDeviceSize offset)
+  {
+	  auto used = block.ranges.find(offset);
+	  VkDeviceSize begin = offset;
+	  VkDeviceSize end = offset + used->second.size;
+	  block.usedBytes -= used->second.size;
+	  block.ranges.erase(used);
+
+	  auto next = block.freeRanges.lower_bound(begin);
+	  if (next != block.freeRanges.end() && next->first == end)
+	  {
+		  end += next->second;
+		  next = block.freeRanges.erase(next);
+	  }
+	  if (next != block.freeRanges.begin())
+	  {
+		  auto previous = std::prev(next);
+		  if (previous->first + previous->second == begin)
+		  {
+			  begin = previous->first;
+			  block.freeRanges.erase(previous);
+		  }
+	  }
+	  block.freeRanges[begin] = end - begin;
+  }
+
+  VkResult DeviceMemoryAllocator::AllocateInPool(uint32_t poolIndex, VkDeviceSize size, VkDeviceSize alignment, MemoryBlock*& block, VkDeviceSize& offset)
+  {
+	  for (auto& candidate : pools[poolIndex].blocks)
+	  {
+		  if (!candidate->dedicated && AllocateRange(*candidate, size, alignment, offset))
+		  {
+			  block = candidate.get();
+			  return (VK_SUCCESS);
+		  }
+	  }
+	  const uint32_t heap = memoryProperties.memoryTypes[poolIndex / 2].heapIndex;
+	  VkResult result = CreateBlock(poolIndex, blockSizes[heap], false, block);
+	  if (result != VK_SUCCESS)
+	  {
+		  return (result);
+	  }
+	  AllocateRange(*block, size, alignment, offset);
+	  return (VK_SUCCESS);
+  }
+
+  VkResult DeviceMemoryAllocator::AllocateSlot(uint32_t poolIndex, uint32_t sizeClass, MemoryAllocation& allocation)
+  {
+	  auto& slabs = pools[poolIndex].slabs[sizeClass];
+	  const VkDeviceSize slotSize = VkDeviceSize(1) << (MinSlabClassShift + sizeClass);
+	  MemorySlab* slab = nullptr;
+	  for (auto& candidate : slabs)
+	  {
+		  if (candidate->freeSlots != 0)
+		  {
+			  slab = candidate.get();
+			  break;
+		  }
+	  }
+	  if (slab == nullptr)
+	  {
+		  const uint32_t slotCount = static_cast<uint32_t>(std::min<VkDeviceSize>(64, SlabBytes / slotSize));
+		  MemoryBlock* block = nullptr;
+		  VkDeviceSize offset = 0;
+		  // Aligned to the slot size, so every slot is aligned to it as well
+		  VkResult result = AllocateInPool(poolIndex, slotSize * slotCount, slotSize, block, offset);
+		  if (result != VK_SUCCESS)
+		  {
+			  return (result);
+		  }
+		  std::unique_ptr<MemorySlab> created(new MemorySlab{block, offset, sizeClass, slotCount, SlotMask(slotCount)});
+		  slab = created.get();
+		  block->ranges[offset] = MemoryBlock::Range{slotSize * slotCount, slotSize, nullptr, false, slab};
+		  slabs.push_back(std::move(created));
+	  }
+
+	  const uint32_t slot = LowestBit(slab->freeSlots);
+	  slab->freeSlots &= ~(uint64_t(1) << slot);
+	  Fill(*slab->block, slab->offset + slot * slotSize, allocation.size, allocation.userData, slab, allocation);
+	  return (VK_SUCCESS);
+  }
+
+  void DeviceMemoryAllocator::FreeSlot(const MemoryAllocation& allocation)
+  {
+	  MemorySlab* slab = allocation.slab;
+	  const VkDeviceSize slotSize = VkDeviceSize(1) << (MinSlabClassShift + slab->sizeClass);
+	  slab->freeSlots |= uint64_t(1) << ((allocation.offset - slab->offset) / slotSize);
+	  if (slab->freeSlots != SlotMask(slab->slotCount))
+	  {
+		  return;
+	  }
+
+	  // Empty slabs go back to their block right away, taking a range again doesn't involve the driver
+	  auto& slabs = pools[slab->block->pool].slabs[slab->sizeClass];
+	  MemoryBlock* block = slab->block;
+	  FreeRange(*block, slab->offset);
+	  slabs.erase(std::find_if(slabs.begin(), slabs.end(), [slab](const std::unique_ptr<MemorySlab>& candidate) { return (candidate.get() == slab); }));
+	  ReleaseIfEmpty(block);
+  }
+
+  VkResult DeviceMemoryAllocator::AllocateFromType(uint32_t memoryType, const VkMemoryRequirements& requirements, const MemoryRequest& request, MemoryAllocation& allocation)
+  {
+	  const uint32_t poolIndex = memoryType * 2 + (request.optimalTiling ? 1 : 0);
+	  const uint32_t heap = memoryProperties.memoryTypes[memoryType].heapIndex;
+	  const VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+	  allocation.size = requirements.size;
+	  allocation.userData = request.userData;
+
+	  const VkDeviceSize slotSize = std::max(requirements.size, alignment);
+	  if (!request.movable && slotSize <= MaxSlabClassSize)
+	  {
+		  uint32_t sizeClass = 0;
+		  while ((VkDeviceSize(1) << (MinSlabClassShift + sizeClass)) < slotSize)
+		  {
+			  sizeClass++;
+		  }
+		  return (AllocateSlot(poolIndex, sizeClass, allocation));
+	  }
+
+	  MemoryBlock* block = nullptr;
+	  VkDeviceSize offset = 0;
+	  if (requirements.size > blockSizes[heap] / 2)
+	  {
+		  VkResult result = CreateBlock(poolIndex, requirements.size, true, block);
+		  if (result != VK_SUCCESS)
+		  {
+			  return (result);
+		  }
+		  AllocateRange(*block, requirements.size, alignment, offset);
+	  }
+	  else
+	  {
+		  VkResult result = AllocateInPool(poolIndex, requirements.size, alignment, block, offset);
+		  if (result != VK_SUCCESS)
+		  {
+			  return (result);
+		  }
+	  }
+	  block->ranges[offset] = MemoryBlock::Range{requirements.size, alignment, request.userData, request.movable && !block->dedicated, nullptr};
+	  Fill(*block, offset, requirements.size, request.userData, nullptr, allocation);
+	  return (VK_SUCCESS);
+  }
+
+  VkResult DeviceMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, const MemoryRequest& request, MemoryAllocation& allocation)
+  {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+	  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	  {
+		  if ((requirements.memoryTypeBits & (1u << i)) == 0 ||
+			  (memoryProperties.memoryTypes[i].propertyFlags & request.properties) != request.properties)
+		  {
+			  continue;
+		  }
+		  result = AllocateFromType(i, requirements, request, allocation);
+		  if (result != VK_ERROR_OUT_OF_DEVICE_MEMORY && result != VK_ERROR_OUT_OF_HOST_MEMORY)
+		  {
+			  break;
+		  }
+	  }
+	  return (result);
+  }
+
+  void DeviceMemoryAllocator::Free(MemoryAllocation& allocation)
+  {
+	  if (allocation.block == nullptr)
+	  {
+		  return;
+	  }
+	  {
+		  std::lock_guard<std::mutex> lock(mutex);
+		  if (allocation.slab != nullptr)
+		  {
+			  FreeSlot(allocation);
+		  }
+		  else
+		  {
+			  FreeRange(*allocation.block, allocation.offset);
+			  ReleaseIfEmpty(allocation.block);
+		  }
+	  }
+	  allocation = MemoryAllocation();
+  }
+
+  VkResult DeviceMemoryAllocator::CreateBuffer(const VkBufferCreateInfo& createInfo, const MemoryRequest& request, VkBuffer& buffer, MemoryAllocation& allocation)
+  {
+	  VkResult result = vkCreateBuffer(device, &createInfo, nullptr, &buffer);
+	  if (result != VK_SUCCESS)
+	  {
+		  return (result);
+	  }
+	  VkMemoryRequirements requirements;
+	  vkGetBufferMemoryRequirements(device, buffer, &requirements);
+	  result = Allocate(requirements, request, allocation);
+	  if (result == VK_SUCCESS)
+	  {
+		  result = vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+	  }
+	  if (result != VK_SUCCESS)
+	  {
+		  DestroyBuffer(buffer, allocation);
+	  }
+	  return (result);
+  }
+
+  VkResult DeviceMemoryAllocator::CreateImage(const VkImageCreateInfo& createInfo, const MemoryRequest& request, VkImage& image, MemoryAllocation& allocation)
+  {
+	  VkResult result = vkCreateImage(device, &createInfo, nullptr, &image);
+	  if (result != VK_SUCCESS)
+	  {
+		  return (result);
+	  }
+	  VkMemoryRequirements requirements;
+	  vkGetImageMemoryRequirements(device, image, &requirements);
+	  MemoryRequest imageRequest = request;
+	  imageRequest.optimalTiling = createInfo.tiling == VK_IMAGE_TILING_OPTIMAL;
+	  result = Allocate(requirements, imageRequest, allocation);
+	  if (result == VK_SUCCESS)
+	  {
+		  result = vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+	  }
+	  if (result != VK_SUCCESS)
+	  {
+		  DestroyImage(image, allocation);
+	  }
+	  return (result);
+  }
+
+  void DeviceMemoryAllocator::DestroyBuffer(VkBuffer& buffer, MemoryAllocation& allocation)
+  {
+	  vkDestroyBuffer(device, buffer, nullptr);
+	  buffer = VK_NULL_HANDLE;
+	  Free(allocation);
+  }
+
+  void DeviceMemoryAllocator::DestroyImage(VkImage& image, MemoryAllocation& allocation)
+  {
+	  vkDestroyImage(device, image, nullptr);
+	  image = VK_NULL_HANDLE;
+	  Free(allocation);
+  }
+
+  void DeviceMemoryAllocator::Flush(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+  {
+	  if ((memoryProperties.memoryTypes[allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0)
+	  {
+		  return;
+	  }
+	  // Flushed ranges have to be aligned to nonCoherentAtomSize or end with the memory object
+	  const VkDeviceSize begin = (allocation.offset + offset) / nonCoherentAtomSize * nonCoherentAtomSize;
+	  const VkDeviceSize end = allocation.offset + (size == VK_WHOLE_SIZE ? allocation.size : offset + size);
+	  VkMappedMemoryRange range = {};
+	  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	  range.memory = allocation.memory;
+	  range.offset = begin;
+	  range.size = std::min(AlignUp(end, nonCoherentAtomSize), allocation.block->size) - begin;
+	  vkFlushMappedMemoryRanges(device, 1, &range);
+  }
+
+  void DeviceMemoryAllocator::AccumulateStats(uint32_t memoryType, MemoryStats& stats) const
+  {
+	  for (uint32_t tiling = 0; tiling < 2; tiling++)
+	  {
+		  for (const auto& block : pools[memoryType * 2 + tiling].blocks)
+		  {
+			  stats.deviceMemoryCount++;
+			  stats.dedicatedCount += block->dedicated ? 1 : 0;
+			  stats.reservedBytes += block->size;
+			  for (const auto& range : block->ranges)
+			  {
+				  if (range.second.slab != nullptr)
+				  {
+					  const MemorySlab& slab = *range.second.slab;
+					  const uint32_t usedSlots = slab.slotCount - PopCount(slab.freeSlots);
+					  stats.allocationCount += usedSlots;
+					  stats.usedBytes += usedSlots * (VkDeviceSize(1) << (MinSlabClassShift + slab.sizeClass));
+				  }
+				  else
+				  {
+					  stats.allocationCount++;
+					  stats.usedBytes += range.second.size;
+				  }
+			  }
+			  for (const auto& range : block->freeRanges)
+			  {
+				  stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+			  }
+		  }
+	  }
+  }
+
+  MemoryStats DeviceMemoryAllocator::GetStats() const
+  {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  MemoryStats stats;
+	  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	  {
+		  AccumulateStats(i, stats);
+	  }
+	  return (stats);
+  }
+
+  MemoryStats DeviceMemoryAllocator::GetStats(uint32_t memoryType) const
+  {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  MemoryStats stats;
+	  AccumulateStats(memoryType, stats);
+	  return (stats);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace BadgerSandbox
+{
+	struct MemoryBlock;
+	struct MemorySlab;
+
+	// A range of device memory bound to one buffer or image.
+	struct MemoryAllocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		// Address of offset in host visible memory, which stays mapped for as long as it is allocated
+		void* mapped = nullptr;
+		uint32_t memoryType = 0;
+		void* userData = nullptr;
+		MemoryBlock* block = nullptr;
+		MemorySlab* slab = nullptr;
+	};
+
+	struct MemoryRequest
+	{
+		VkMemoryPropertyFlags properties = 0;
+		// Images with VK_IMAGE_TILING_OPTIMAL. They get blocks of their own, so bufferImageGranularity never has to be
+		// respected between neighbours
+		bool optimalTiling = false;
+		// Marks the allocation as one a defragmentation pass may move. Movable allocations never take a size class slot,
+		// so each one owns a range of its block
+		bool movable = false;
+		// Handed back in MemoryAllocation, lets a defragmentation pass find the owner of an allocation
+		void* userData = nullptr;
+	};
+
+	struct MemoryStats
+	{
+		// Live vkAllocateMemory calls, blocks and dedicated allocations together
+		uint32_t deviceMemoryCount = 0;
+		uint32_t dedicatedCount = 0;
+		uint32_t allocationCount = 0;
+		VkDeviceSize reservedBytes = 0;
+		// Bytes handed out, rounded up to the size class or alignment they were allocated with
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize largestFreeRange = 0;
+	};
+
+	struct MemoryBlock
+	{
+		struct Range
+		{
+			VkDeviceSize size;
+			VkDeviceSize alignment;
+			void* userData;
+			bool movable;
+			MemorySlab* slab;
+		};
+
+		VkDeviceMemory memory;
+		VkDeviceSize size;
+		uint8_t* mapped;
+		uint32_t memoryType;
+		uint32_t pool;
+		bool dedicated;
+		VkDeviceSize usedBytes;
+		// Free ranges by offset, neighbours are always merged
+		std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+		// Allocations and slabs by offset, with the size, alignment and owner a defragmentation pass needs to move them
+		std::map<VkDeviceSize, Range> ranges;
+	};
+
+	// Equally sized slots of one size class, taken from a block as a single range.
+	struct MemorySlab
+	{
+		MemoryBlock* block;
+		VkDeviceSize offset;
+		uint32_t sizeClass;
+		uint32_t slotCount;
+		uint64_t freeSlots;
+	};
+
+	/*
+	  Device memory allocator
+	  Sub-allocates buffers and images from large device memory blocks instead of calling vkAllocateMemory for every
+	  resource, which is slow and bounded by maxMemoryAllocationCount. Every memory type has a heap of blocks for
+	  buffers and linear images and one for optimally tiled images. Requests of up to MaxSlabClassSize bytes take a
+	  slot of a power of two size class, larger ones the best fitting free range of a block, and ones larger than half
+	  a block get device memory of their own. Host visible blocks are mapped once, for their whole lifetime.
+	  Safe to use from several threads.
+	*/
+	class DeviceMemoryAllocator
+	{
+	private:
+	  static const uint32_t MinSlabClassShift = 8;
+	  static const uint32_t SlabClassCount = 9;
+
+	  struct Pool
+	  {
+		  std::vector<std::unique_ptr<MemoryBlock>> blocks;
+		  std::vector<std::unique_ptr<MemorySlab>> slabs[SlabClassCount];
+	  };
+
+	  VkDevice device;
+	  VkPhysicalDeviceMemoryProperties memoryProperties;
+	  VkDeviceSize nonCoherentAtomSize;
+	  VkDeviceSize blockSizes[VK_MAX_MEMORY_HEAPS];
+	  // Two pools per memory type, linear resources at 2 * type and optimally tiled images at 2 * type + 1
+	  Pool pools[VK_MAX_MEMORY_TYPES * 2];
+	  mutable std::mutex mutex;
+
+	  VkResult AllocateFromType(uint32_t memoryType, const VkMemoryRequirements& requirements, const MemoryRequest& request, MemoryAllocation& allocation);
+	  VkResult CreateBlock(uint32_t poolIndex, VkDeviceSize size, bool dedicated, MemoryBlock*& block);
+	  void ReleaseBlock(MemoryBlock* block);
+	  void ReleaseIfEmpty(MemoryBlock* block);
+	  bool AllocateRange(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	  VkResult AllocateInPool(uint32_t poolIndex, VkDeviceSize size, VkDeviceSize alignment, MemoryBlock*& block, VkDeviceSize& offset);
+	  void FreeRange(MemoryBlock& block, VkDeviceSize offset);
+	  VkResult AllocateSlot(uint32_t poolIndex, uint32_t sizeClass, MemoryAllocation& allocation);
+	  void FreeSlot(const MemoryAllocation& allocation);
+	  void AccumulateStats(uint32_t memoryType, MemoryStats& stats) const;
+	public:
+		static const VkDeviceSize MaxSlabClassSize = VkDeviceSize(1) << (MinSlabClassShift + SlabClassCount - 1);
+
+		// Blocks are blockSize bytes, or an eighth of their heap on small heaps.
+		DeviceMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize = 64 * 1024 * 1024);
+		// Every allocation must have been freed.
+		~DeviceMemoryAllocator();
+		DeviceMemoryAllocator(const DeviceMemoryAllocator&) = delete;
+		DeviceMemoryAllocator& operator=(const DeviceMemoryAllocator&) = delete;
+
+		// Allocates from the first memory type allowed by requirements that has all of request.properties, moving on to
+		// the next one when a heap is out of memory. VK_ERROR_FEATURE_NOT_PRESENT means no memory type qualifies.
+		VkResult Allocate(const VkMemoryRequirements& requirements, const MemoryRequest& request, MemoryAllocation& allocation);
+		void Free(MemoryAllocation& allocation);
+
+		// Create the resource and bind it to a new allocation. Images take optimalTiling from their create info.
+		VkResult CreateBuffer(const VkBufferCreateInfo& createInfo, const MemoryRequest& request, VkBuffer& buffer, MemoryAllocation& allocation);
+		VkResult CreateImage(const VkImageCreateInfo& createInfo, const MemoryRequest& request, VkImage& image, MemoryAllocation& allocation);
+		void DestroyBuffer(VkBuffer& buffer, MemoryAllocation& allocation);
+		void DestroyImage(VkImage& image, MemoryAllocation& allocation);
+
+		// Makes host writes to [offset, offset + size) of the allocation visible, nothing to do for host coherent memory.
+		void Flush(const MemoryAllocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		MemoryStats GetStats() const;
+		MemoryStats GetStats(uint32_t memoryType) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "GeometryPool.hpp"
+#include <iterator>
+#include <stdexcept>
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  VkBufferCreateInfo GeometryBufferCreateInfo(VkDeviceSize size, VkBufferUsageFlags usage)
+	  {
+		  VkBufferCreateInfo bufferCreateInfo = {};
+		  bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		  bufferCreateInfo.size = size;
+		  // Filled by transfers from staging memory
+		  bufferCreateInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		  bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		  return (bufferCreateInfo);
+	  }
+  }
+
+  GeometryPool::GeometryPool(DeviceMemoryAllocator& memoryAllocator, uint32_t vertexStride, uint32_t positionStride, uint32_t vertexCapacity, uint32_t indexCapacity)
+	  : memoryAllocator(memoryAllocator)
+	  , vertexStride(vertexStride)
+	  , positionStride(positionStride)
+	  , vertexBuffer(VK_NULL_HANDLE)
+	  , positionBuffer(VK_NULL_HANDLE)
+	  , indexBuffer(VK_NULL_HANDLE)
+  {
+	  MemoryRequest memoryRequest;
+	  memoryRequest.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	  VkResult result = memoryAllocator.CreateBuffer(GeometryBufferCreateInfo(VkDeviceSize(vertexCapacity) * vertexStride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT),
+		  memoryRequest, vertexBuffer, vertexMemory);
+	  if (result == VK_SUCCESS && positionStride > 0)
+	  {
+		  result = memoryAllocator.CreateBuffer(GeometryBufferCreateInfo(VkDeviceSize(vertexCapacity) * positionStride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT),
+			  memoryRequest, positionBuffer, positionMemory);
+	  }
+	  if (result == VK_SUCCESS)
+	  {
+		  result = memoryAllocator.CreateBuffer(GeometryBufferCreateInfo(VkDeviceSize(indexCapacity) * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT),
+			  memoryRequest, indexBuffer, indexMemory);
+	  }
+	  if (result != VK_SUCCESS)
+	  {
+		  DestroyBuffers();
+		  throw std::runtime_error("Could not create the geometry pool buffers");
+	  }
+	  freeVertices[0] = vertexCapacity;
+	  freeIndices[0] = indexCapacity;
+  }
+
+  GeometryPool::~GeometryPool()
+  {
+	  DestroyBuffers();
+  }
+
+  void GeometryPool::DestroyBuffers()
+  {
+	  VkBuffer* buffers[3] = {&vertexBuffer, &positionBuffer, &indexBuffer};
+	  MemoryAllocation* allocations[3] = {&vertexMemory, &positionMemory, &indexMemory};
+	  for (size_t i = 0; i < 3; i++)
+	  {
+		  if (*buffers[i] != VK_NULL_HANDLE)
+		  {
+			  memoryAllocator.DestroyBuffer(*buffers[i], *allocations[i]);
+		  }
+	  }
+  }
+
+  bool GeometryPool::AllocateRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t count, uint32_t& first)
+  {
+	  auto best = freeRanges.end();
+	  for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range)
+	  {
+		  if (range->second >= count && (best == freeRanges.end() || range->second < best->second))
+		  {
+			  best = range;
+		  }
+	  }
+	  if (best == freeRanges.end())
+	  {
+		  return (false);
+	  }
+
+	  first = best->first;
+	  const uint32_t remaining = best->second - count;
+	  freeRanges.erase(best);
+	  if (remaining > 0)
+	  {
+		  freeRanges[first + count] = remaining;
+	  }
+	  return (true);
+  }
+
+  void GeometryPool::FreeRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t first, uint32_t count)
+  {
+	  uint32_t begin = first;
+	  uint32_t end = first + count;
+	  auto next = freeRanges.lower_bound(begin);
+	  if (next != freeRanges.end() && next->first == end)
+	  {
+		  end += next->second;
+		  next = freeRanges.erase(next);
+	  }
+	  if (next != freeRanges.begin())
+	  {
+		  auto previous = std::prev(next);
+		  if (previous->first + previous->second == begin)
+		  {
+			  begin = previous->first;
+			  freeRanges.erase(previous);
+		  }
+	  }
+	  freeRanges[begin] = end - begin;
+  }
+
+  bool GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount, GeometryRange& range)
+  {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  GeometryRange allocated;
+	  allocated.vertexCount = vertexCount;
+	  allocated.indexCount = indexCount;
+	  // Empty ranges take no space, so freeing them has nothing to return either
+	  if (vertexCount > 0 && !AllocateRange(freeVertices, vertexCount, allocated.firstVertex))
+	  {
+		  return (false);
+	  }
+	  if (indexCount > 0 && !AllocateRange(freeIndices, indexCount, allocated.firstIndex))
+	  {
+		  if (vertexCount > 0)
+		  {
+			  FreeRange(freeVertices, allocated.firstVertex, vertexCount);
+		  }
+		  return (false);
+	  }
+	  range = allocated;
+	  return (true);
+  }
+
+  void GeometryPool::Free(GeometryRange& range)
+  {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  if (range.vertexCount > 0)
+	  {
+		  FreeRange(freeVertices, range.firstVertex, range.vertexCount);
+	  }
+	  if (range.indexCount > 0)
+	  {
+		  FreeRange(freeIndices, range.firstIndex, range.indexCount);
+	  }
+	  range = GeometryRange{};
+  }
+}
\ No newline at end of file
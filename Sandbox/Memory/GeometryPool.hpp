@@ -0,0 +1,65 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include "DeviceMemoryAllocator.hpp"
+
+namespace BadgerSandbox
+{
+	// The vertices and indices of one model in a GeometryPool. Its indices stay relative to its first vertex, which
+	// its draws pass as vertexOffset.
+	struct GeometryRange
+	{
+		uint32_t firstVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+	};
+
+	/*
+	  Geometry pool
+	  Device local vertex, position and index buffers that models sub-allocate ranges of instead of creating buffers
+	  of their own, so the draws of every model in the pool follow a single bind and can share an indirect buffer.
+	  Ranges are counted in elements: a vertex takes vertexStride bytes of the vertex buffer and positionStride bytes
+	  of the position buffer, which is only created when positionStride is not 0, and indices are 32 bit. They are
+	  handed out best fit from free lists whose neighbours are always merged. Safe to use from several threads.
+	*/
+	class GeometryPool
+	{
+	private:
+	  DeviceMemoryAllocator& memoryAllocator;
+	  uint32_t vertexStride;
+	  uint32_t positionStride;
+	  VkBuffer vertexBuffer;
+	  MemoryAllocation vertexMemory;
+	  VkBuffer positionBuffer;
+	  MemoryAllocation positionMemory;
+	  VkBuffer indexBuffer;
+	  MemoryAllocation indexMemory;
+	  // Free ranges by first element
+	  std::map<uint32_t, uint32_t> freeVertices;
+	  std::map<uint32_t, uint32_t> freeIndices;
+	  std::mutex mutex;
+
+	  static bool AllocateRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t count, uint32_t& first);
+	  static void FreeRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t first, uint32_t count);
+	  void DestroyBuffers();
+	public:
+		GeometryPool(DeviceMemoryAllocator& memoryAllocator, uint32_t vertexStride, uint32_t positionStride, uint32_t vertexCapacity, uint32_t indexCapacity);
+		// The device must no longer read the buffers, the models left in the pool with them.
+		~GeometryPool();
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		// Reserves vertexCount vertices and indexCount indices, fails without reserving either when one of them does not fit.
+		bool Allocate(uint32_t vertexCount, uint32_t indexCount, GeometryRange& range);
+		void Free(GeometryRange& range);
+
+		uint32_t VertexStride() const { return vertexStride; }
+		uint32_t PositionStride() const { return positionStride; }
+		VkBuffer VertexBuffer() const { return vertexBuffer; }
+		VkBuffer PositionBuffer() const { return positionBuffer; }
+		VkBuffer IndexBuffer() const { return indexBuffer; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "StagingRing.hpp"
+#include <stdexcept>
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	  {
+		  return ((value + alignment - 1) / alignment * alignment);
+	  }
+  }
+
+  StagingRing::StagingRing(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize capacity)
+	  : device(device)
+	  , buffer(VK_NULL_HANDLE)
+	  , memory(VK_NULL_HANDLE)
+	  , mapped(nullptr)
+	  , capacity(capacity)
+	  , head(0)
+	  , nextBatch(1)
+  {
+	  VkBufferCreateInfo bufferCreateInfo = {};
+	  bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	  bufferCreateInfo.size = capacity;
+	  bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	  bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	  if (vkCreateBuffer(device, &bufferCreateInfo, nullptr, &buffer) != VK_SUCCESS)
+	  {
+		  throw std::runtime_error("Could not create the staging ring buffer");
+	  }
+
+	  VkMemoryRequirements requirements;
+	  vkGetBufferMemoryRequirements(device, buffer, &requirements);
+	  VkPhysicalDeviceMemoryProperties memoryProperties;
+	  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	  const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	  uint32_t memoryType = UINT32_MAX;
+	  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount && memoryType == UINT32_MAX; i++)
+	  {
+		  if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		  {
+			  memoryType = i;
+		  }
+	  }
+
+	  VkMemoryAllocateInfo allocateInfo = {};
+	  allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	  allocateInfo.allocationSize = requirements.size;
+	  allocateInfo.memoryTypeIndex = memoryType;
+	  void* data = nullptr;
+	  if (memoryType == UINT32_MAX || vkAllocateMemory(device, &allocateInfo, nullptr, &memory) != VK_SUCCESS ||
+		  vkBindBufferMemory(device, buffer, memory, 0) != VK_SUCCESS || vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS)
+	  {
+		  vkDestroyBuffer(device, buffer, nullptr);
+		  vkFreeMemory(device, memory, nullptr);
+		  throw std::runtime_error("Could not allocate the staging ring memory");
+	  }
+	  mapped = static_cast<uint8_t*>(data);
+  }
+
+  StagingRing::~StagingRing()
+  {
+	  for (auto& batch : batches)
+	  {
+		  if (batch.second.fence != VK_NULL_HANDLE)
+		  {
+			  vkWaitForFences(device, 1, &batch.second.fence, VK_TRUE, UINT64_MAX);
+			  vkDestroyFence(device, batch.second.fence, nullptr);
+		  }
+	  }
+	  for (VkFence fence : freeFences)
+	  {
+		  vkDestroyFence(device, fence, nullptr);
+	  }
+	  vkUnmapMemory(device, memory);
+	  vkDestroyBuffer(device, buffer, nullptr);
+	  vkFreeMemory(device, memory, nullptr);
+  }
+
+  bool StagingRing::IsRetired(uint64_t batch)
+  {
+	  auto state = batches.find(batch);
+	  if (state == batches.end())
+	  {
+		  return (true);
+	  }
+	  if (state->second.fence == VK_NULL_HANDLE || vkGetFenceStatus(device, state->second.fence) != VK_SUCCESS)
+	  {
+		  return (false);
+	  }
+	  Retire(batch);
+	  return (true);
+  }
+
+  void StagingRing::Retire(uint64_t batch)
+  {
+	  auto state = batches.find(batch);
+	  if (state == batches.end())
+	  {
+		  return;
+	  }
+	  // Pooled fences stay signalled until they are reused, see Wait
+	  if (state->second.fence != VK_NULL_HANDLE)
+	  {
+		  freeFences.push_back(state->second.fence);
+	  }
+	  batches.erase(state);
+  }
+
+  void StagingRing::Reclaim()
+  {
+	  while (!spans.empty() && IsRetired(spans.front().batch))
+	  {
+		  spans.pop_front();
+	  }
+	  if (spans.empty())
+	  {
+		  head = 0;
+	  }
+  }
+
+  bool StagingRing::TryAllocate(uint64_t batch, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+  {
+	  // Live spans cover [tail, head), possibly wrapping past the end of the buffer
+	  const VkDeviceSize tail = spans.empty() ? head : spans.front().begin;
+	  const VkDeviceSize aligned = AlignUp(head, alignment);
+	  if (spans.empty() || head > tail)
+	  {
+		  if (aligned + size <= capacity)
+		  {
+			  offset = aligned;
+		  }
+		  else if (size <= tail)
+		  {
+			  // Wrap, the end of the buffer is held by this batch so the tail passes it when the batch retires
+			  if (head < capacity)
+			  {
+				  spans.push_back({head, capacity, batch});
+			  }
+			  offset = 0;
+		  }
+		  else
+		  {
+			  return (false);
+		  }
+	  }
+	  else if (head < tail && aligned + size <= tail)
+	  {
+		  offset = aligned;
+	  }
+	  else
+	  {
+		  return (false);
+	  }
+	  spans.push_back({offset == aligned ? head : 0, offset + size, batch});
+	  head = offset + size;
+	  return (true);
+  }
+
+  bool StagingRing::Allocate(StagingBatch& batch, VkDeviceSize size, VkDeviceSize alignment, StagingRegion& region)
+  {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  if (size > capacity)
+	  {
+		  return (false);
+	  }
+	  if (size == 0)
+	  {
+		  // Nothing to copy, a full ring has head == tail and would otherwise never fit it
+		  region.buffer = buffer;
+		  region.offset = 0;
+		  region.size = 0;
+		  region.data = mapped;
+		  return (true);
+	  }
+	  if (batch.id == 0)
+	  {
+		  batch.id = nextBatch++;
+		  batches[batch.id] = BatchState{};
+	  }
+	  Reclaim();
+	  VkDeviceSize offset = 0;
+	  while (!TryAllocate(batch.id, size, alignment, offset))
+	  {
+		  // Wait for the oldest batch if it has been submitted, one still being filled may be waiting on this call
+		  auto oldest = batches.find(spans.front().batch);
+		  if (oldest == batches.end() || oldest->second.fence == VK_NULL_HANDLE)
+		  {
+			  return (false);
+		  }
+		  vkWaitForFences(device, 1, &oldest->second.fence, VK_TRUE, UINT64_MAX);
+		  Reclaim();
+	  }
+	  region.buffer = buffer;
+	  region.offset = offset;
+	  region.size = size;
+	  region.data = mapped + offset;
+	  return (true);
+  }
+
+  void StagingRing::Submit(StagingBatch& batch, VkQueue queue, VkCommandBuffer commandBuffer, std::mutex* queueMutex)
+  {
+	  VkFence fence = VK_NULL_HANDLE;
+	  {
+		  std::lock_guard<std::mutex> lock(mutex);
+		  if (batch.id == 0)
+		  {
+			  batch.id = nextBatch++;
+		  }
+		  if (freeFences.empty())
+		  {
+			  VkFenceCreateInfo fenceCreateInfo = {};
+			  fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			  if (vkCreateFence(device, &fenceCreateInfo, nullptr, &fence) != VK_SUCCESS)
+			  {
+				  throw std::runtime_error("Could not create a staging ring fence");
+			  }
+		  }
+		  else
+		  {
+			  fence = freeFences.back();
+			  freeFences.pop_back();
+			  vkResetFences(device, 1, &fence);
+		  }
+	  }
+
+	  VkSubmitInfo submitInfo = {};
+	  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	  submitInfo.commandBufferCount = 1;
+	  submitInfo.pCommandBuffers = &commandBuffer;
+	  VkResult result;
+	  if (queueMutex != nullptr)
+	  {
+		  std::lock_guard<std::mutex> queueLock(*queueMutex);
+		  result = vkQueueSubmit(queue, 1, &submitInfo, fence);
+	  }
+	  else
+	  {
+		  result = vkQueueSubmit(queue, 1, &submitInfo, fence);
+	  }
+
+	  std::lock_guard<std::mutex> lock(mutex);
+	  if (result != VK_SUCCESS)
+	  {
+		  freeFences.push_back(fence);
+		  throw std::runtime_error("Could not submit a staging ring batch");
+	  }
+	  batches[batch.id].fence = fence;
+  }
+
+  void StagingRing::Abandon(StagingBatch& batch)
+  {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  Retire(batch.id);
+	  Reclaim();
+  }
+
+  bool StagingRing::IsComplete(const StagingBatch& batch)
+  {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  auto state = batches.find(batch.id);
+	  return (state == batches.end() || (state->second.fence != VK_NULL_HANDLE && IsRetired(batch.id)));
+  }
+
+  void StagingRing::Wait(const StagingBatch& batch)
+  {
+	  VkFence fence = VK_NULL_HANDLE;
+	  {
+		  std::lock_guard<std::mutex> lock(mutex);
+		  auto state = batches.find(batch.id);
+		  if (state == batches.end() || state->second.fence == VK_NULL_HANDLE)
+		  {
+			  return;
+		  }
+		  fence = state->second.fence;
+	  }
+	  // Waited on unlocked so other threads keep allocating. Another thread may retire the batch meanwhile, the
+	  // fence is then only reset when a later submission takes it over, which this at worst waits for as well
+	  vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+	  std::lock_guard<std::mutex> lock(mutex);
+	  IsRetired(batch.id);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace BadgerSandbox
+{
+	// Regions of a StagingRing read by one submission. A batch is filled and submitted by one thread and
+	// submitted at most once, a new upload starts with a new batch.
+	struct StagingBatch
+	{
+		uint64_t id = 0;
+	};
+
+	struct StagingRegion
+	{
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		void* data;
+	};
+
+	/*
+	  Staging ring
+	  One persistently mapped, host coherent transfer source buffer that uploads sub-allocate from instead of
+	  creating and freeing a staging buffer each. Space is handed out in allocation order and reclaimed in the
+	  same order once the fence of the submission that read it has signalled, so many small uploads can share
+	  a batch and a single vkQueueSubmit. Safe to use from several threads, each with batches of its own.
+	*/
+	class StagingRing
+	{
+	private:
+	  struct Span
+	  {
+		  VkDeviceSize begin;
+		  VkDeviceSize end;
+		  uint64_t batch;
+	  };
+	  struct BatchState
+	  {
+		  VkFence fence = VK_NULL_HANDLE;
+	  };
+
+	  VkDevice device;
+	  VkBuffer buffer;
+	  VkDeviceMemory memory;
+	  uint8_t* mapped;
+	  VkDeviceSize capacity;
+	  VkDeviceSize head;
+	  std::deque<Span> spans;
+	  // Batches whose regions may still be read, submitted ones have a fence
+	  std::unordered_map<uint64_t, BatchState> batches;
+	  std::vector<VkFence> freeFences;
+	  uint64_t nextBatch;
+	  std::mutex mutex;
+
+	  bool TryAllocate(uint64_t batch, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	  bool IsRetired(uint64_t batch);
+	  void Retire(uint64_t batch);
+	  void Reclaim();
+	public:
+		StagingRing(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize capacity);
+		// Waits for every submitted batch.
+		~StagingRing();
+		StagingRing(const StagingRing&) = delete;
+		StagingRing& operator=(const StagingRing&) = delete;
+
+		VkDeviceSize Capacity() const { return capacity; }
+
+		// Reserves size bytes at a multiple of alignment for batch. Waits for submitted batches to retire when the
+		// ring is full but never for ones still being filled, so it fails instead when those hold the space: submit
+		// batch and continue in a new one, or use a buffer of your own for uploads larger than Capacity(). A size of 0 always succeeds with an empty region.
+		bool Allocate(StagingBatch& batch, VkDeviceSize size, VkDeviceSize alignment, StagingRegion& region);
+		// Submits commandBuffer, which reads the regions of batch, to queue. Holds queueMutex, if any, while doing so.
+		void Submit(StagingBatch& batch, VkQueue queue, VkCommandBuffer commandBuffer, std::mutex* queueMutex = nullptr);
+		// Returns the space of a batch that will not be submitted.
+		void Abandon(StagingBatch& batch);
+
+		// Whether the submission of batch has completed. Batches that allocated nothing are complete, ones not
+		// submitted yet are not.
+		bool IsComplete(const StagingBatch& batch);
+		// Waits for the submission of batch, returns at once for a batch that has not been submitted.
+		void Wait(const StagingBatch& batch);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "MeshCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  const char Magic[8] = { 'B', 'G', 'R', 'M', 'E', 'S', 'H', '\0' };
+	  const uint32_t Version = 1;
+	  const uint64_t Prime = 1099511628211ull;
+
+	  size_t AlignUp(size_t value, size_t alignment)
+	  {
+		  return ((value + alignment - 1) / alignment * alignment);
+	  }
+
+	  // Unique per process and thread, so writers baking the same cache at once never share a temporary file
+	  std::string TemporaryPath(const std::string& path)
+	  {
+#if defined(_WIN32)
+		  const unsigned long process = static_cast<unsigned long>(GetCurrentProcessId());
+#else
+		  const unsigned long process = static_cast<unsigned long>(getpid());
+#endif
+		  const size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+		  return (path + "." + std::to_string(process) + "." + std::to_string(thread) + ".tmp");
+	  }
+  }
+
+  MappedFile::MappedFile()
+	  : data(nullptr)
+	  , size(0)
+#if defined(_WIN32)
+	  , fileHandle(INVALID_HANDLE_VALUE)
+	  , mappingHandle(nullptr)
+#endif
+  {
+  }
+
+  MappedFile::~MappedFile()
+  {
+	  Close();
+  }
+
+#if defined(_WIN32)
+  bool MappedFile::Open(const std::string& path)
+  {
+	  Close();
+	  fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	  LARGE_INTEGER fileSize;
+	  if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	  {
+		  Close();
+		  return (false);
+	  }
+	  mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	  if (mappingHandle == nullptr)
+	  {
+		  Close();
+		  return (false);
+	  }
+	  data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	  if (data == nullptr)
+	  {
+		  Close();
+		  return (false);
+	  }
+	  size = static_cast<size_t>(fileSize.QuadPart);
+	  return (true);
+  }
+
+  void MappedFile::Close()
+  {
+	  if (data != nullptr)
+	  {
+		  UnmapViewOfFile(data);
+	  }
+	  if (mappingHandle != nullptr)
+	  {
+		  CloseHandle(mappingHandle);
+	  }
+	  if (fileHandle != INVALID_HANDLE_VALUE)
+	  {
+		  CloseHandle(fileHandle);
+	  }
+	  data = nullptr;
+	  size = 0;
+	  mappingHandle = nullptr;
+	  fileHandle = INVALID_HANDLE_VALUE;
+  }
+#else
+  bool MappedFile::Open(const std::string& path)
+  {
+	  Close();
+	  int descriptor = open(path.c_str(), O_RDONLY);
+	  if (descriptor < 0)
+	  {
+		  return (false);
+	  }
+	  struct stat status;
+	  if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+	  {
+		  close(descriptor);
+		  return (false);
+	  }
+	  void* mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	  // The mapping keeps the file referenced after the descriptor is closed
+	  close(descriptor);
+	  if (mapping == MAP_FAILED)
+	  {
+		  return (false);
+	  }
+	  data = static_cast<const uint8_t*>(mapping);
+	  size = static_cast<size_t>(status.st_size);
+	  return (true);
+  }
+
+  void MappedFile::Close()
+  {
+	  if (data != nullptr)
+	  {
+		  munmap(const_cast<uint8_t*>(data), size);
+	  }
+	  data = nullptr;
+	  size = 0;
+  }
+#endif
+
+  uint64_t HashBytes(const void* bytes, size_t count, uint64_t hash)
+  {
+	  const uint8_t* source = static_cast<const uint8_t*>(bytes);
+	  size_t i = 0;
+	  for (; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t))
+	  {
+		  uint64_t word;
+		  memcpy(&word, source + i, sizeof(word));
+		  hash = (hash ^ word) * Prime;
+	  }
+	  for (; i < count; i++)
+	  {
+		  hash = (hash ^ source[i]) * Prime;
+	  }
+	  return (hash);
+  }
+
+  bool HashFile(const std::string& path, uint64_t& hash)
+  {
+	  std::ifstream file(path, std::ios::binary);
+	  if (!file)
+	  {
+		  return (false);
+	  }
+	  // A multiple of 8 so chunk boundaries do not change the result
+	  std::vector<char> chunk(1 << 20);
+	  while (file)
+	  {
+		  file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		  hash = HashBytes(chunk.data(), static_cast<size_t>(file.gcount()), hash);
+	  }
+	  return (file.eof());
+  }
+
+  void MeshCacheWriter::Add(uint32_t id, const void* data, size_t size)
+  {
+	  sections.push_back({ id, data, size });
+  }
+
+  bool MeshCacheWriter::Write(const std::string& path, uint64_t sourceHash, uint64_t key) const
+  {
+	  MeshCacheHeader header = {};
+	  memcpy(header.magic, Magic, sizeof(Magic));
+	  header.version = Version;
+	  header.sectionCount = static_cast<uint32_t>(sections.size());
+	  header.sourceHash = sourceHash;
+	  header.key = key;
+
+	  std::vector<MeshCacheSection> table(sections.size());
+	  size_t offset = AlignUp(sizeof(MeshCacheHeader) + table.size() * sizeof(MeshCacheSection), SectionAlignment);
+	  for (size_t i = 0; i < sections.size(); i++)
+	  {
+		  table[i] = { sections[i].id, 0, offset, sections[i].size };
+		  offset = AlignUp(offset + sections[i].size, SectionAlignment);
+	  }
+
+	  const std::string temporaryPath = TemporaryPath(path);
+	  {
+		  std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		  if (!file)
+		  {
+			  return (false);
+		  }
+		  const char padding[SectionAlignment] = {};
+		  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		  file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(MeshCacheSection)));
+		  size_t position = sizeof(header) + table.size() * sizeof(MeshCacheSection);
+		  for (size_t i = 0; i < sections.size(); i++)
+		  {
+			  file.write(padding, static_cast<std::streamsize>(table[i].offset - position));
+			  file.write(static_cast<const char*>(sections[i].data), static_cast<std::streamsize>(sections[i].size));
+			  position = static_cast<size_t>(table[i].offset) + sections[i].size;
+		  }
+		  if (!file)
+		  {
+			  file.close();
+			  std::remove(temporaryPath.c_str());
+			  return (false);
+		  }
+	  }
+#if defined(_WIN32)
+	  const bool replaced = MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	  const bool replaced = std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+	  if (!replaced)
+	  {
+		  std::remove(temporaryPath.c_str());
+	  }
+	  return (replaced);
+  }
+
+  MeshCacheReader::MeshCacheReader()
+	  : data(nullptr)
+	  , header(nullptr)
+	  , sections(nullptr)
+  {
+  }
+
+  bool MeshCacheReader::Open(const uint8_t* bytes, size_t size)
+  {
+	  data = nullptr;
+	  header = nullptr;
+	  sections = nullptr;
+	  if (bytes == nullptr || size < sizeof(MeshCacheHeader))
+	  {
+		  return (false);
+	  }
+	  const MeshCacheHeader* candidate = reinterpret_cast<const MeshCacheHeader*>(bytes);
+	  if (memcmp(candidate->magic, Magic, sizeof(Magic)) != 0 || candidate->version != Version)
+	  {
+		  return (false);
+	  }
+	  const size_t tableEnd = sizeof(MeshCacheHeader) + static_cast<size_t>(candidate->sectionCount) * sizeof(MeshCacheSection);
+	  if (candidate->sectionCount > (size - sizeof(MeshCacheHeader)) / sizeof(MeshCacheSection))
+	  {
+		  return (false);
+	  }
+	  const MeshCacheSection* table = reinterpret_cast<const MeshCacheSection*>(bytes + sizeof(MeshCacheHeader));
+	  for (uint32_t i = 0; i < candidate->sectionCount; i++)
+	  {
+		  if (table[i].offset < tableEnd || table[i].offset > size || table[i].size > size - table[i].offset ||
+			  (table[i].offset % MeshCacheWriter::SectionAlignment) != 0)
+		  {
+			  return (false);
+		  }
+	  }
+	  data = bytes;
+	  header = candidate;
+	  sections = table;
+	  return (true);
+  }
+
+  bool MeshCacheReader::Get(uint32_t id, const void*& bytes, size_t& size) const
+  {
+	  bytes = nullptr;
+	  size = 0;
+	  if (header == nullptr)
+	  {
+		  return (false);
+	  }
+	  for (uint32_t i = 0; i < header->sectionCount; i++)
+	  {
+		  if (sections[i].id == id)
+		  {
+			  bytes = data + sections[i].offset;
+			  size = static_cast<size_t>(sections[i].size);
+			  break;
+		  }
+	  }
+	  return (true);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BadgerSandbox
+{
+	// Read-only memory mapping of a whole file. The mapping lives until Close or destruction.
+	class MappedFile
+	{
+	private:
+	  const uint8_t* data;
+	  size_t size;
+#if defined(_WIN32)
+	  void* fileHandle;
+	  void* mappingHandle;
+#endif
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& path);
+		void Close();
+		const uint8_t* Data() const { return data; }
+		size_t Size() const { return size; }
+	};
+
+	// FNV-1a over 64-bit words, chained through hash so several buffers or files can be combined.
+	uint64_t HashBytes(const void* bytes, size_t count, uint64_t hash = 14695981039346656037ull);
+	// Folds the contents of the file at path into hash. Returns false if the file cannot be read.
+	bool HashFile(const std::string& path, uint64_t& hash);
+
+	/*
+	  Mesh cache container
+	  A header, a table of sections and the section payloads, each aligned to SectionAlignment so
+	  arrays of vectors and matrices can be read in place from a mapped file. sourceHash identifies
+	  the files the cache was baked from and key the settings of the baker; callers compare both and
+	  rebake on a mismatch. What the sections hold is up to the caller.
+	*/
+	struct MeshCacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t sectionCount;
+		uint64_t sourceHash;
+		uint64_t key;
+	};
+
+	struct MeshCacheSection
+	{
+		uint32_t id;
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	class MeshCacheWriter
+	{
+	private:
+	  struct Pending
+	  {
+		  uint32_t id;
+		  const void* data;
+		  size_t size;
+	  };
+	  std::vector<Pending> sections;
+	public:
+		static const size_t SectionAlignment = 16;
+
+		// data is only referenced and must stay valid until Write returns.
+		void Add(uint32_t id, const void* data, size_t size);
+
+		template <typename T>
+		void Add(uint32_t id, const std::vector<T>& values)
+		{
+			Add(id, values.data(), values.size() * sizeof(T));
+		}
+
+		// Writes to a temporary file that replaces path once complete, so readers never map a partial cache.
+		bool Write(const std::string& path, uint64_t sourceHash, uint64_t key) const;
+	};
+
+	class MeshCacheReader
+	{
+	private:
+	  const uint8_t* data;
+	  const MeshCacheHeader* header;
+	  const MeshCacheSection* sections;
+	public:
+		MeshCacheReader();
+
+		// Validates the header and that every section lies inside [bytes, bytes + size).
+		bool Open(const uint8_t* bytes, size_t size);
+		uint64_t SourceHash() const { return header->sourceHash; }
+		uint64_t Key() const { return header->key; }
+
+		// Missing sections read as empty.
+		bool Get(uint32_t id, const void*& bytes, size_t& size) const;
+
+		// Fails if the section size is not a whole number of T.
+		template <typename T>
+		bool Get(uint32_t id, const T*& values, size_t& count) const
+		{
+			const void* bytes = nullptr;
+			size_t size = 0;
+			if (!Get(id, bytes, size) || (size % sizeof(T)) != 0)
+			{
+				return (false);
+			}
+			values = static_cast<const T*>(bytes);
+			count = size / sizeof(T);
+			return (true);
+		}
+	};
+}
\ No newline at end of file
@@ -1,11 +1,1988 @@
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <array>
 #include "WindowFactory.hpp"
+#include "MultithreadedModels.hpp"
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "VulkanglTFModel.hpp"
+#include "FrustumCuller.hpp"
+
+namespace BadgerSandbox
+{
+	vkglTF::Model NyotenguModel;
+	// The shaders only read positions and normals, so the model is stored without skin attributes
+	const vkglTF::VertexLayout NyotenguVertexLayout = vkglTF::VertexLayout::CompactStatic;
+
+	// One draw per primitive of every instance, grouped by instance so the descriptor set is only bound again
+	// when the instance changes. The culler is keyed by the address of each draw.
+	struct ModelDraw
+	{
+		uint32_t instance;
+		const vkglTF::Primitive* primitive;
+	};
+	std::vector<ModelDraw> ModelDraws;
+	FrustumCuller ModelCuller;
+	// Whole instances for the instanced mode, keyed by the address of their model matrix
+	FrustumCuller InstanceCuller;
+
+	// An entry of the GPU driven mode's draw list, laid out like DrawData in CullDraws.comp
+	struct GpuDrawData
+	{
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t instance;
+		int32_t vertexOffset;
+	};
+
+	// Push constants of CullDraws.comp
+	struct CullingConstants
+	{
+		float planes[Frustum::PlaneCount][4];
+		uint32_t drawCount;
+	};
+
+	// local_size_x of CullDraws.comp
+	const uint32_t CullGroupSize = 64;
+
+	std::vector<char> ReadShaderFile(const std::string& path)
+	{
+		std::ifstream shaderIs(path, std::ios::binary | std::ios::ate);
+		if (shaderIs.fail())
+		{
+			throw std::runtime_error("COULD NOT OPEN FILE");
+		}
+		std::vector<char> shaderBuffer(static_cast<size_t>(shaderIs.tellg()));
+		shaderIs.seekg(0, std::ios::beg);
+		shaderIs.read(shaderBuffer.data(), shaderBuffer.size());
+		return shaderBuffer;
+	}
+
+	void MultithreadedModels::CreateInstance()
+	{
+		VkApplicationInfo appInfo{};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "Badger Sandbox";
+		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.pEngineName = "No Engine";
+		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.apiVersion = VK_API_VERSION_1_0;
+
+		VkInstanceCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		createInfo.pApplicationInfo = &appInfo;
+
+		uint32_t availableExtensionsCount = 0;
+		if ((vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionsCount, nullptr) != VK_SUCCESS) ||
+			(availableExtensionsCount == 0))
+		{
+			throw std::runtime_error("No extensions available");
+		}
+
+		availableExtensions.resize(availableExtensionsCount);
+		if (vkEnumerateInstanceExtensionProperties(nullptr, &availableExtensionsCount, &availableExtensions[0]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Error occurred during instance extensions enumeration!");
+		}
+
+		for (uint32_t i = 0; i < availableExtensionsCount; i++)
+		{
+			std::string currentExtension(availableExtensions[i].extensionName);
+			if (requestedExtensions.find(currentExtension) != requestedExtensions.end())
+				requestedExtensions[currentExtension] = true;
+		}
+
+		std::vector<const char*> confirmedExtensionNames;
+		for (const auto& item : requestedExtensions)
+		{
+			if (!item.second)
+			{
+				std::string errorMessage("Required Extension " + item.first + " not found");
+				throw std::runtime_error(errorMessage.c_str());
+			}
+			else
+			{
+				confirmedExtensionNames.push_back(item.first.c_str());
+			}
+		}
+
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(confirmedExtensionNames.size());
+		createInfo.ppEnabledExtensionNames = confirmedExtensionNames.data();
+
+		const std::vector<const char*> validationLayers =
+		{
+		  "VK_LAYER_KHRONOS_validation"
+		};
+
+		createInfo.enabledLayerCount = validationLayers.size();
+		createInfo.ppEnabledLayerNames = validationLayers.data();
+		createInfo.pNext = nullptr;
+
+		instance.Reset(createInfo);
+	}
+
+	void MultithreadedModels::CreateSurface()
+	{
+		window->GetVulkanSurfaceFromWindow(instance.Get(), &surface);
+	}
+
+	void MultithreadedModels::CreateLogicalDevice()
+	{
+		uint32_t numDevices = 0;
+		if ((vkEnumeratePhysicalDevices(instance.Get(), &numDevices, nullptr) != VK_SUCCESS) ||
+			(numDevices == 0))
+		{
+			throw std::runtime_error("Couldn't get a Physical Device");
+		}
+
+		std::vector<VkPhysicalDevice> physicalDevices(numDevices);
+		if (vkEnumeratePhysicalDevices(instance.Get(), &numDevices, physicalDevices.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Error occurred during physical devices enumeration!");
+		}
+
+		std::vector<VkPhysicalDeviceProperties> deviceProperties{};
+		std::vector<VkPhysicalDeviceFeatures> deviceFeatures{};
+		deviceProperties.resize(physicalDevices.size());
+		deviceFeatures.resize(physicalDevices.size());
+		for (uint32_t i = 0; i < physicalDevices.size(); i++)
+		{
+			vkGetPhysicalDeviceProperties(physicalDevices[i], &deviceProperties[i]);
+			vkGetPhysicalDeviceFeatures(physicalDevices[i], &deviceFeatures[i]);
+		}
+
+		for (uint32_t i = 0; i < physicalDevices.size(); i++)
+		{
+			uint32_t queueFamiliesCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevices[i], &queueFamiliesCount, nullptr);
+			if (queueFamiliesCount == 0)
+			{
+				std::cout << "Physical device " << physicalDevices[i] << " doesn't have any queue families!" << std::endl;
+				continue;
+			}
+
+			std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamiliesCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevices[i], &queueFamiliesCount, &queueFamilyProperties[0]);
+			for (uint32_t j = 0; j < queueFamiliesCount; ++j)
+			{
+				VkBool32 queuePresentSupport = false;
+				vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevices[i], j, surface, &queuePresentSupport);
+
+				if ((queueFamilyProperties[i].queueCount > 0) &&
+					(queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+					queuePresentSupport)
+				{
+					suitablePhysicalDeviceIndex = i;
+					suitableQueueFamilyIndex = j;
+					break;
+				}
+			}
+		}
+
+		if (suitablePhysicalDeviceIndex == 0xFFFFFFFF || suitableQueueFamilyIndex == 0xFFFFFFFF)
+		{
+			throw std::runtime_error("Didn't find a physical device with queues that support graphics and presentation");
+		}
+
+		selectedPhysicalDevice = physicalDevices[suitablePhysicalDeviceIndex];
+
+		std::vector<float> queuePriorities = { 1.0f };
+
+		VkDeviceQueueCreateInfo queueCreateInfo = {
+		  VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,     // VkStructureType              sType
+		  nullptr,                                        // const void                  *pNext
+		  0,                                              // VkDeviceQueueCreateFlags     flags
+		  suitableQueueFamilyIndex,                       // uint32_t                     queueFamilyIndex
+		  static_cast<uint32_t>(queuePriorities.size()),  // uint32_t                     queueCount
+		  &queuePriorities[0]                             // const float                 *pQueuePriorities
+		};
+
+		VkPhysicalDeviceFeatures enabledFeatures = {};
+		enabledFeatures.fillModeNonSolid = deviceFeatures[suitablePhysicalDeviceIndex].fillModeNonSolid;
+		enabledFeatures.wideLines = deviceFeatures[suitablePhysicalDeviceIndex].wideLines;
+		// The GPU driven mode selects the instance of each indirect draw through firstInstance and, where
+		// multiDrawIndirect is available, issues all of them with a single call
+		enabledFeatures.drawIndirectFirstInstance = deviceFeatures[suitablePhysicalDeviceIndex].drawIndirectFirstInstance;
+		enabledFeatures.multiDrawIndirect = deviceFeatures[suitablePhysicalDeviceIndex].multiDrawIndirect;
+		gpuDrivenSupported = enabledFeatures.drawIndirectFirstInstance == VK_TRUE;
+		maxDrawIndirectCount = enabledFeatures.multiDrawIndirect ? deviceProperties[suitablePhysicalDeviceIndex].limits.maxDrawIndirectCount : 1;
+
+		std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+		VkDeviceCreateInfo deviceCreateInfo = {
+		  VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,           // VkStructureType                    sType
+		  nullptr,                                        // const void                        *pNext
+		  0,                                              // VkDeviceCreateFlags                flags
+		  1,                                              // uint32_t                           queueCreateInfoCount
+		  &queueCreateInfo,                               // const VkDeviceQueueCreateInfo     *pQueueCreateInfos
+		  0,                                              // uint32_t                           enabledLayerCount
+		  nullptr,                                        // const char * const                *ppEnabledLayerNames
+		  deviceExtensions.size(),                        // uint32_t                           enabledExtensionCount
+		  deviceExtensions.data(),                        // const char * const                *ppEnabledExtensionNames
+		  &enabledFeatures                                         // const VkPhysicalDeviceFeatures    *pEnabledFeatures
+		};
+
+		device.Reset(selectedPhysicalDevice, deviceCreateInfo);
+
+		vkGetDeviceQueue(device.Get(), suitableQueueFamilyIndex, 0, &queue);
+	}
+
+	void MultithreadedModels::CreateSemaphores()
+	{
+		VkSemaphoreCreateInfo semaphoreCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,      // VkStructureType          sType
+		  nullptr,                                      // const void*              pNext
+		  0                                             // VkSemaphoreCreateFlags   flags
+		};
+
+		imageAvailable.resize(renderResourcesCount);
+		renderingFinished.resize(renderResourcesCount);
+
+		for (size_t i = 0; i < renderResourcesCount; i++)
+		{
+			imageAvailable[i].Reset(device.Get(), semaphoreCreateInfo);
+			renderingFinished[i].Reset(device.Get(), semaphoreCreateInfo);
+		}
+	}
+
+	void MultithreadedModels::CreateFences()
+	{
+		VkFenceCreateInfo fenceCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,              // VkStructureType                sType
+		  nullptr,                                          // const void                    *pNext
+		  VK_FENCE_CREATE_SIGNALED_BIT                      // VkFenceCreateFlags             flags
+		};
+
+		fences.resize(renderResourcesCount);
+
+		for (size_t i = 0; i < renderResourcesCount; ++i)
+		{
+			if (vkCreateFence(device.Get(), &fenceCreateInfo, nullptr, &fences[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Couldn't create a fence");
+			}
+		}
+	}
+
+	void MultithreadedModels::CreateSwapchain()
+	{
+		VkSurfaceCapabilitiesKHR surfaceCapabilities;
+		if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(selectedPhysicalDevice, surface, &surfaceCapabilities) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Could not check presentation surface capabilities");
+		}
+
+		uint32_t formatsCount;
+		if ((vkGetPhysicalDeviceSurfaceFormatsKHR(selectedPhysicalDevice, surface, &formatsCount, nullptr) != VK_SUCCESS) ||
+			(formatsCount == 0))
+		{
+			throw std::runtime_error("Couldn't get the number Device Surface Formats");
+		}
+
+		std::vector<VkSurfaceFormatKHR> surfaceFormats(formatsCount);
+		if (vkGetPhysicalDeviceSurfaceFormatsKHR(selectedPhysicalDevice, surface, &formatsCount, surfaceFormats.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Couldn't get the Device Surface Formats");
+		}
+
+		uint32_t presentModesCount;
+		if ((vkGetPhysicalDeviceSurfacePresentModesKHR(selectedPhysicalDevice, surface, &presentModesCount, nullptr) != VK_SUCCESS) ||
+			(presentModesCount == 0))
+		{
+			throw std::runtime_error("Couldn't get the Presentation Modes count");
+		}
+
+		std::vector<VkPresentModeKHR> presentModes(presentModesCount);
+		if (vkGetPhysicalDeviceSurfacePresentModesKHR(selectedPhysicalDevice, surface, &presentModesCount, presentModes.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Couldn't get the Presentation Modes count");
+		}
+
+		uint32_t imageCount = surfaceCapabilities.minImageCount + 1;
+		if ((surfaceCapabilities.maxImageCount > 0) &&
+			(imageCount > surfaceCapabilities.maxImageCount))
+		{
+			imageCount = surfaceCapabilities.maxImageCount;
+		}
+
+		// Check if list contains most widely used R8 G8 B8 A8 format
+		// with nonlinear color space
+		for (VkSurfaceFormatKHR& sf : surfaceFormats)
+		{
+			if (sf.format == VK_FORMAT_B8G8R8A8_SRGB)
+			{
+				selectedSurfaceFormat = sf;
+				break;
+			}
+		}
+		if (selectedSurfaceFormat.format != VK_FORMAT_B8G8R8A8_SRGB)
+		{
+			std::cout << "Found an undefined format, forcing BGRA8888 UNORM";
+			selectedSurfaceFormat.format = VK_FORMAT_B8G8R8A8_SRGB;
+			selectedSurfaceFormat.colorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
+		}
+
+		// Special value of surface extent is width == height == 0xFFFFFFFF
+		// If this is so we define the size by ourselves but it must fit within defined confines
+		if (surfaceCapabilities.currentExtent.width == 0xFFFFFFFF)
+		{
+			std::array<uint32_t, 2> windowSize { 0, 0};
+			windowSize = window->GetWindowSize();
+			swapchainExtent.width = windowSize[0];
+			swapchainExtent.height = windowSize[1];
+			if (swapchainExtent.width < surfaceCapabilities.minImageExtent.width) {
+				swapchainExtent.width = surfaceCapabilities.minImageExtent.width;
+			}
+			if (swapchainExtent.height < surfaceCapabilities.minImageExtent.height) {
+				swapchainExtent.height = surfaceCapabilities.minImageExtent.height;
+			}
+			if (swapchainExtent.width > surfaceCapabilities.maxImageExtent.width) {
+				swapchainExtent.width = surfaceCapabilities.maxImageExtent.width;
+			}
+			if (swapchainExtent.height > surfaceCapabilities.maxImageExtent.height) {
+				swapchainExtent.height = surfaceCapabilities.maxImageExtent.height;
+			}
+		}
+		else
+		{
+			swapchainExtent = surfaceCapabilities.currentExtent;
+		}
+
+		// Color attachment flag must always be supported
+		// We can define other usage flags but we always need to check if they are supported
+		VkImageUsageFlags supportedUsageFlags{};
+		if (surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+		{
+			supportedUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		}
+
+		// Sometimes images must be transformed before they are presented (i.e. due to device's orienation
+		// being other than default orientation)
+		// If the specified transform is other than current transform, presentation engine will transform image
+		// during presentation operation; this operation may hit performance on some platforms
+		// Here we don't want any transformations to occur so if the identity transform is supported use it
+		// otherwise just use the same transform as current transform
+		VkSurfaceTransformFlagBitsKHR surfaceTransform{};
+		if (surfaceCapabilities.supportedTransforms & VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
+		{
+			surfaceTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+		}
+		else
+		{
+			surfaceTransform = surfaceCapabilities.currentTransform;
+		}
+
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		for (VkPresentModeKHR& pm : presentModes)
+		{
+			if (pm == VK_PRESENT_MODE_MAILBOX_KHR)
+			{
+				presentMode = pm;
+			}
+		}
+		if (presentMode != VK_PRESENT_MODE_MAILBOX_KHR)
+		{
+			std::cout << "MAILBOX present mode is not available, forcing FIFO as present mode" << std::endl;
+			presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		}
+
+		VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE;
+
+		VkSwapchainCreateInfoKHR swapchainCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,  // VkStructureType                sType
+		  nullptr,                                      // const void                    *pNext
+		  0,                                            // VkSwapchainCreateFlagsKHR      flags
+		  surface,                                      // VkSurfaceKHR                   surface
+		  imageCount,                                   // uint32_t                       minImageCount
+		  selectedSurfaceFormat.format,                 // VkFormat                       imageFormat
+		  selectedSurfaceFormat.colorSpace,             // VkColorSpaceKHR                imageColorSpace
+		  swapchainExtent,                              // VkExtent2D                     imageExtent
+		  1,                                            // uint32_t                       imageArrayLayers
+		  supportedUsageFlags,                          // VkImageUsageFlags              imageUsage
+		  VK_SHARING_MODE_EXCLUSIVE,                    // VkSharingMode                  imageSharingMode
+		  0,                                            // uint32_t                       queueFamilyIndexCount
+		  nullptr,                                      // const uint32_t                *pQueueFamilyIndices
+		  surfaceTransform,                             // VkSurfaceTransformFlagBitsKHR  preTransform
+		  VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,            // VkCompositeAlphaFlagBitsKHR    compositeAlpha
+		  presentMode,                                  // VkPresentModeKHR               presentMode
+		  VK_TRUE,                                      // VkBool32                       clipped
+		  oldSwapChain                                  // VkSwapchainKHR                 oldSwapchain
+		};
+
+		swapchain.Reset(device.Get(), swapchainCreateInfo);
+
+		if (oldSwapChain != VK_NULL_HANDLE)
+		{
+			vkDestroySwapchainKHR(device.Get(), oldSwapChain, nullptr);
+		}
+	}
+
+	void MultithreadedModels::CreateRenderPass()
+	{
+		std::array<VkAttachmentDescription, 2> attachmentDescriptions
+		{ {
+		 {
+			0,                                   // VkAttachmentDescriptionFlags   flags
+			selectedSurfaceFormat.format,        // VkFormat                       format
+			VK_SAMPLE_COUNT_1_BIT,               // VkSampleCountFlagBits          samples
+			VK_ATTACHMENT_LOAD_OP_CLEAR,         // VkAttachmentLoadOp             loadOp
+			VK_ATTACHMENT_STORE_OP_STORE,        // VkAttachmentStoreOp            storeOp
+			VK_ATTACHMENT_LOAD_OP_DONT_CARE,     // VkAttachmentLoadOp             stencilLoadOp
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,    // VkAttachmentStoreOp            stencilStoreOp
+			VK_IMAGE_LAYOUT_UNDEFINED,           // VkImageLayout                  initialLayout;
+			VK_IMAGE_LAYOUT_PRESENT_SRC_KHR      // VkImageLayout                  finalLayout
+		 },
+		 {
+		   0,                                   // VkAttachmentDescriptionFlags   flags
+		   FindDepthFormat(),                   // VkFormat                       format
+		   VK_SAMPLE_COUNT_1_BIT,               // VkSampleCountFlagBits          samples
+		   VK_ATTACHMENT_LOAD_OP_CLEAR,         // VkAttachmentLoadOp             loadOp
+		   VK_ATTACHMENT_STORE_OP_DONT_CARE,    // VkAttachmentStoreOp            storeOp
+		   VK_ATTACHMENT_LOAD_OP_DONT_CARE,     // VkAttachmentLoadOp             stencilLoadOp
+		   VK_ATTACHMENT_STORE_OP_DONT_CARE,    // VkAttachmentStoreOp            stencilStoreOp
+		   VK_IMAGE_LAYOUT_UNDEFINED,           // VkImageLayout                  initialLayout;
+		   VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL      // VkImageLayout                  finalLayout
+		 }
+		} };
+
+		std::array<VkAttachmentReference, 2> attachmentReferences
+		{ {
+		  {
+			0,                                          // uint32_t                       attachment
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL    // VkImageLayout                  layout
+		  },
+		  {
+			1,                                                 // uint32_t                       attachment
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL   // VkImageLayout                  layout
+		  }
+		} };
+
+		std::array<VkSubpassDescription, 1> subpassesDescriptions
+		{
+		  {
+			0,                                          // VkSubpassDescriptionFlags      flags
+			VK_PIPELINE_BIND_POINT_GRAPHICS,            // VkPipelineBindPoint            pipelineBindPoint
+			0,                                          // uint32_t                       inputAttachmentCount
+			nullptr,                                    // const VkAttachmentReference   *pInputAttachments
+			1,                                          // uint32_t                       colorAttachmentCount
+			&attachmentReferences[0],                   // const VkAttachmentReference   *pColorAttachments
+			nullptr,                                    // const VkAttachmentReference   *pResolveAttachments
+			&attachmentReferences[1],                   // const VkAttachmentReference   *pDepthStencilAttachment
+			0,                                          // uint32_t                       preserveAttachmentCount
+			nullptr                                     // const uint32_t*                pPreserveAttachments
+		  }
+		};
+
+		std::vector<VkSubpassDependency> dependencies =
+		{
+		  {
+			VK_SUBPASS_EXTERNAL,                            // uint32_t                       srcSubpass
+			0,                                              // uint32_t                       dstSubpass
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,           // VkPipelineStageFlags           srcStageMask
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,           // VkPipelineStageFlags           dstStageMask
+			0,                      // VkAccessFlags                  srcAccessMask
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,                   // VkAccessFlags                  dstAccessMask
+			VK_DEPENDENCY_BY_REGION_BIT                     // VkDependencyFlags              dependencyFlags
+		  },
+		};
+
+		VkRenderPassCreateInfo renderPassCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,    // VkStructureType                sType
+		  nullptr,                                      // const void                    *pNext                                           
+		  0,                                            // VkRenderPassCreateFlags        flags
+		  attachmentDescriptions.size(),                // uint32_t                       attachmentCount
+		  attachmentDescriptions.data(),                // const VkAttachmentDescription *pAttachments
+		  subpassesDescriptions.size(),                 // uint32_t                       subpassCount
+		  subpassesDescriptions.data(),                 // const VkSubpassDescription    *pSubpasses
+		  dependencies.size(),                          // uint32_t                       dependencyCount
+		  dependencies.data()                           // const VkSubpassDependency     *pDependencies
+		};
+
+		renderPass.Reset(device.Get(), renderPassCreateInfo);
+	}
+
+	void MultithreadedModels::CreateSwapchainImageViews()
+	{
+		uint32_t numberOfSwapchainImages = 0;
+		swapchain.GetSwapchainImagesKHR(&numberOfSwapchainImages, nullptr);
+		std::vector<VkImage> swapchainImages(numberOfSwapchainImages);
+		swapchain.GetSwapchainImagesKHR(&numberOfSwapchainImages, swapchainImages.data());
+		swapchainImageViews.resize(numberOfSwapchainImages);
+
+		for (uint32_t i = 0; i < numberOfSwapchainImages; i++)
+		{
+			VkImageViewCreateInfo imageViewCreateInfo = {
+				VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,   // VkStructureType                sType
+				nullptr,                                    // const void                    *pNext
+				0,                                          // VkImageViewCreateFlags         flags
+				swapchainImages[i],                         // VkImage                        image
+				VK_IMAGE_VIEW_TYPE_2D,                      // VkImageViewType                viewType
+				selectedSurfaceFormat.format,               // VkFormat                       format
+				{                                           // VkComponentMapping             components
+				  VK_COMPONENT_SWIZZLE_IDENTITY,              // VkComponentSwizzle             r
+				  VK_COMPONENT_SWIZZLE_IDENTITY,              // VkComponentSwizzle             g
+				  VK_COMPONENT_SWIZZLE_IDENTITY,              // VkComponentSwizzle             b
+				  VK_COMPONENT_SWIZZLE_IDENTITY               // VkComponentSwizzle             a
+				},
+				{                                           // VkImageSubresourceRange        subresourceRange
+				  VK_IMAGE_ASPECT_COLOR_BIT,                  // VkImageAspectFlags             aspectMask
+				  0,                                          // uint32_t                       baseMipLevel
+				  1,                                          // uint32_t                       levelCount
+				  0,                                          // uint32_t                       baseArrayLayer
+				  1                                           // uint32_t                       layerCount
+				}
+			};
+			swapchainImageViews[i].Reset(device.Get(), imageViewCreateInfo);
+		}
+	}
+
+	void MultithreadedModels::CreateMemoryAllocator()
+	{
+		memoryAllocator.reset(new DeviceMemoryAllocator(selectedPhysicalDevice, device.Get()));
+	}
+
+	/*
+	  Took this function from VulkanTutorial:
+	  https://vulkan-tutorial.com/
+	*/
+	void MultithreadedModels::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = width;
+		imageInfo.extent.height = height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = tiling;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateImage(imageInfo, memoryRequest, image, imageMemory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create image!");
+		}
+	}
+
+	/*
+	  Took this function from VulkanTutorial:
+	  https://vulkan-tutorial.com/
+	*/
+	VkImageView MultithreadedModels::CreateImageViewVulkanTutorial(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = aspectFlags;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkImageView imageView;
+		if (vkCreateImageView(device.Get(), &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create texture image view!");
+		}
+		return imageView;
+	}
+
+	/*
+	  Took this function from VulkanTutorial:
+	  https://vulkan-tutorial.com/
+	*/
+	VkFormat MultithreadedModels::FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
+	{
+		for (VkFormat format : candidates)
+		{
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(selectedPhysicalDevice, format, &props);
+
+			if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features)
+			{
+				return format;
+			}
+			else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features)
+			{
+				return format;
+			}
+		}
+		throw std::runtime_error("failed to find supported format!");
+	}
+
+	/*
+	  Took this function from VulkanTutorial:
+	  https://vulkan-tutorial.com/
+	*/
+	VkFormat MultithreadedModels::FindDepthFormat()
+	{
+		return FindSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		);
+	}
+
+	/*
+	  Took this function from VulkanTutorial:
+	  https://vulkan-tutorial.com/
+	*/
+	void MultithreadedModels::CreateDepthImage()
+	{
+		VkFormat depthFormat = FindDepthFormat();
+		CreateImageVulkanTutorial(swapchainExtent.width, swapchainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
+		depthImageView = CreateImageViewVulkanTutorial(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+	}
+
+	void MultithreadedModels::DestroyDepthImage()
+	{
+		vkDestroyImageView(device.Get(), depthImageView, nullptr);
+		depthImageView = VK_NULL_HANDLE;
+		memoryAllocator->DestroyImage(depthImage, depthImageMemory);
+	}
+
+	void MultithreadedModels::CreateGraphicsCommandsBuffers()
+	{
+		VkCommandPoolCreateInfo commandPoolCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,           // VkStructureType                sType
+		  nullptr,                                              // const void                    *pNext
+		  VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT |
+		  VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,                 // VkCommandPoolCreateFlags       flags
+		  suitableQueueFamilyIndex                              // uint32_t                       queueFamilyIndex
+		};
+
+		graphicsCommandPool.Reset(device.Get(), commandPoolCreateInfo);
+
+		VkCommandBufferAllocateInfo commandBufferAllocateInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, // VkStructureType                sType
+		  nullptr,                                        // const void                    *pNext
+		  graphicsCommandPool.Get(),                      // VkCommandPool                  commandPool
+		  VK_COMMAND_BUFFER_LEVEL_PRIMARY,                // VkCommandBufferLevel           level
+		  renderResourcesCount                            // uint32_t                       bufferCount
+		};
+
+		graphicsCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
+
+		recordedSceneVersions.assign(renderResourcesCount, UINT64_MAX);
+
+		VkCommandBufferBeginInfo graphicsCommandBufferBeginInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,    // VkStructureType                        sType
+		  nullptr,                                        // const void                            *pNext
+		  VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,   // VkCommandBufferUsageFlags              flags
+		  nullptr                                         // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
+		};
+
+		VkImageSubresourceRange imageSubresourceRange = {
+		  VK_IMAGE_ASPECT_COLOR_BIT,                      // VkImageAspectFlags             aspectMask
+		  0,                                              // uint32_t                       baseMipLevel
+		  1,                                              // uint32_t                       levelCount
+		  0,                                              // uint32_t                       baseArrayLayer
+		  1                                               // uint32_t                       layerCount
+		};
+
+		VkClearValue clearValue = {
+		  { 1.0f, 0.8f, 0.4f, 0.0f },                     // VkClearColorValue              color
+		};
+	}
+
+	void MultithreadedModels::CreateDescriptorSetLayout()
+	{
+		std::array<VkDescriptorSetLayoutBinding, 2>  layoutBindings{};
+		// Every instance has its own matrices in the same buffer, picked with a dynamic offset
+		layoutBindings[0].binding = 0;
+		layoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		layoutBindings[0].descriptorCount = 1;
+		layoutBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		layoutBindings[1].binding = 1;
+		layoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		layoutBindings[1].descriptorCount = 1;
+		layoutBindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,  // VkStructureType                      sType
+		  nullptr,                                              // const void                          *pNext
+		  0,                                                    // VkDescriptorSetLayoutCreateFlags     flags
+		  layoutBindings.size(),                                                    // uint32_t                             bindingCount
+		  layoutBindings.data()                                       // const VkDescriptorSetLayoutBinding  *pBindings
+		};
+
+		RapidVulkan::CheckError(vkCreateDescriptorSetLayout(device.Get(), &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout));
+
+		// The instanced pipeline only needs the camera, its model matrices come from the instance buffer
+		layoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		RapidVulkan::CheckError(vkCreateDescriptorSetLayout(device.Get(), &descriptorSetLayoutCreateInfo, nullptr, &instancedDescriptorSetLayout));
+
+		// The culling pass reads the draw list and writes the indirect draws
+		for (VkDescriptorSetLayoutBinding& layoutBinding : layoutBindings)
+		{
+			layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+		RapidVulkan::CheckError(vkCreateDescriptorSetLayout(device.Get(), &descriptorSetLayoutCreateInfo, nullptr, &cullDescriptorSetLayout));
+	}
+
+	void MultithreadedModels::CreateDescriptorPool()
+	{
+		std::array<VkDescriptorPoolSize, 3> poolSizes =
+		{{
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, static_cast<uint32_t>(renderResourcesCount) },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, static_cast<uint32_t>(renderResourcesCount * 3) },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32_t>(renderResourcesCount * 2) }
+		}};
+		VkDescriptorPoolCreateInfo descriptorPoolCI{};
+		descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolCI.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		descriptorPoolCI.pPoolSizes = poolSizes.data();
+		descriptorPoolCI.maxSets = renderResourcesCount * 3;
+
+		RapidVulkan::CheckError(vkCreateDescriptorPool(device.Get(), &descriptorPoolCI, nullptr, &dPool));
+	}
+
+	void MultithreadedModels::AllocateDescriptorSet()
+	{
+		descriptorSets.resize(renderResourcesCount);
+		VkDescriptorSetAllocateInfo descriptorSetAllocateInfo =
+		{
+		  VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, // VkStructureType                sType
+		  nullptr,                                        // const void                    *pNext
+		  dPool,                                          // VkDescriptorPool               descriptorPool
+		  1,                                              // uint32_t                       descriptorSetCount
+		  &descriptorSetLayout                            // const VkDescriptorSetLayout   *pSetLayouts
+		};
+		for (uint32_t i = 0; i < renderResourcesCount; i++)
+		{
+			RapidVulkan::CheckError(vkAllocateDescriptorSets(device.Get(), &descriptorSetAllocateInfo, &descriptorSets[i]));
+		}
+
+		instancedDescriptorSets.resize(renderResourcesCount);
+		descriptorSetAllocateInfo.pSetLayouts = &instancedDescriptorSetLayout;
+		for (uint32_t i = 0; i < renderResourcesCount; i++)
+		{
+			RapidVulkan::CheckError(vkAllocateDescriptorSets(device.Get(), &descriptorSetAllocateInfo, &instancedDescriptorSets[i]));
+		}
+
+		cullDescriptorSets.resize(renderResourcesCount);
+		descriptorSetAllocateInfo.pSetLayouts = &cullDescriptorSetLayout;
+		for (uint32_t i = 0; i < renderResourcesCount; i++)
+		{
+			RapidVulkan::CheckError(vkAllocateDescriptorSets(device.Get(), &descriptorSetAllocateInfo, &cullDescriptorSets[i]));
+		}
+	}
+
+	void MultithreadedModels::CreateBuffer(VkBuffer& buffer, MemoryAllocation& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties)
+	{
+		VkBufferCreateInfo createInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		createInfo.usage = usage;
+		createInfo.size = size;
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		createInfo.queueFamilyIndexCount = 0;
+		createInfo.pQueueFamilyIndices = nullptr;
+
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateBuffer(createInfo, memoryRequest, buffer, memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate buffer memory!");
+		}
+
+		// Host visible memory stays mapped, so we can write on it as needed.
+		*mappedMemory = memory.mapped;
+	}
+
+	void MultithreadedModels::CreateUniformBuffers()
+	{
+		// Matrix uniform buffers hold the normal, model view and MVP matrices of every instance. Dynamic
+		// offsets have to be multiples of minUniformBufferOffsetAlignment, so each instance gets a padded slot.
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(selectedPhysicalDevice, &deviceProperties);
+		const VkDeviceSize alignment = std::max<VkDeviceSize>(deviceProperties.limits.minUniformBufferOffsetAlignment, 1);
+		const VkDeviceSize matricesSize = sizeof(glm::mat4) * 3;
+		instanceUniformStride = (matricesSize + alignment - 1) / alignment * alignment;
+
+		matrixUniformBuffers.resize(renderResourcesCount);
+		VkDeviceSize bufferSize = instanceUniformStride * gridSize * gridSize;
+		for (auto& uBuffer : matrixUniformBuffers)
+		{
+			CreateBuffer(uBuffer.buffer, uBuffer.memory, &uBuffer.mapped, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, bufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			uBuffer.decriptor.buffer = uBuffer.buffer;
+			uBuffer.decriptor.offset = 0;
+			uBuffer.decriptor.range = matricesSize;
+		}
+
+		// View and projection matrices of the instanced pipeline
+		cameraUniformBuffers.resize(renderResourcesCount);
+		bufferSize = sizeof(glm::mat4) * 2;
+		for (auto& uBuffer : cameraUniformBuffers)
+		{
+			CreateBuffer(uBuffer.buffer, uBuffer.memory, &uBuffer.mapped, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, bufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			uBuffer.decriptor.buffer = uBuffer.buffer;
+			uBuffer.decriptor.offset = 0;
+			uBuffer.decriptor.range = bufferSize;
+		}
+
+		lightUniformBuffer.resize(renderResourcesCount);
+		bufferSize = sizeof(glm::vec4) * 2;
+		for (auto& uBuffer : lightUniformBuffer)
+		{
+			CreateBuffer(uBuffer.buffer, uBuffer.memory, &uBuffer.mapped, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, bufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			uBuffer.decriptor.buffer = uBuffer.buffer;
+			uBuffer.decriptor.offset = 0;
+			uBuffer.decriptor.range = bufferSize;
+		}
+
+	}
+
+	void MultithreadedModels::UpdateDescriptorSet()
+	{
+		for (uint32_t i = 0; i < renderResourcesCount; i++)
+		{
+			std::array<VkWriteDescriptorSet, 2> writeDescriptorSets{};
+
+			writeDescriptorSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSets[0].dstSet = descriptorSets[i];
+			writeDescriptorSets[0].dstBinding = 0;
+			writeDescriptorSets[0].descriptorCount = 1;
+			writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			writeDescriptorSets[0].pBufferInfo = &(matrixUniformBuffers[i].decriptor);
+
+			writeDescriptorSets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSets[1].dstSet = descriptorSets[i];
+			writeDescriptorSets[1].dstBinding = 1;
+			writeDescriptorSets[1].descriptorCount = 1;
+			writeDescriptorSets[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			writeDescriptorSets[1].pBufferInfo = &(lightUniformBuffer[i].decriptor);
+
+			vkUpdateDescriptorSets(device.Get(), writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+
+			writeDescriptorSets[0].dstSet = instancedDescriptorSets[i];
+			writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			writeDescriptorSets[0].pBufferInfo = &(cameraUniformBuffers[i].decriptor);
+			writeDescriptorSets[1].dstSet = instancedDescriptorSets[i];
+
+			vkUpdateDescriptorSets(device.Get(), writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+		}
+	}
+
+	void MultithreadedModels::CreateInstanceBuffers()
+	{
+		instanceBuffers.resize(renderResourcesCount);
+		for (auto& iBuffer : instanceBuffers)
+		{
+			CreateBuffer(iBuffer.buffer, iBuffer.memory, &iBuffer.mapped, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(vkglTF::Model::InstanceData) * gridSize * gridSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		}
+	}
+
+	// The draw list is only known once the model is loaded, so these are created after CreateDrawList.
+	void MultithreadedModels::CreateGpuDrivenBuffers()
+	{
+		// vkCmdDrawIndexedIndirect only covers indexed draws
+		std::vector<GpuDrawData> drawData;
+		for (const ModelDraw& draw : ModelDraws)
+		{
+			if (!draw.primitive->hasIndices)
+			{
+				continue;
+			}
+			GpuDrawData data = {};
+			if (draw.primitive->bb.valid)
+			{
+				glm::vec3 translation(modelMatrices[draw.instance][3]);
+				data.boundsMin = glm::vec4(draw.primitive->bb.min + translation, 1.0f);
+				data.boundsMax = glm::vec4(draw.primitive->bb.max + translation, 1.0f);
+			}
+			else
+			{
+				// Never culled, like the primitives without bounds in the other modes
+				data.boundsMin = glm::vec4(-FLT_MAX);
+				data.boundsMax = glm::vec4(FLT_MAX);
+			}
+			data.firstIndex = draw.primitive->firstIndex;
+			data.indexCount = draw.primitive->indexCount;
+			data.instance = draw.instance;
+			data.vertexOffset = draw.primitive->vertexOffset;
+			drawData.push_back(data);
+		}
+		gpuDrawCount = static_cast<uint32_t>(drawData.size());
+
+		// Written once, so both stay in host visible memory instead of going through a staging copy
+		VkDeviceSize bufferSize = sizeof(GpuDrawData) * std::max<size_t>(drawData.size(), 1);
+		CreateBuffer(drawDataBuffer.buffer, drawDataBuffer.memory, &drawDataBuffer.mapped, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, bufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		if (!drawData.empty())
+		{
+			std::memcpy(drawDataBuffer.mapped, drawData.data(), drawData.size() * sizeof(GpuDrawData));
+		}
+
+		bufferSize = sizeof(vkglTF::Model::InstanceData) * modelMatrices.size();
+		CreateBuffer(gridInstanceBuffer.buffer, gridInstanceBuffer.memory, &gridInstanceBuffer.mapped, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, bufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		vkglTF::Model::InstanceData* instanceData = static_cast<vkglTF::Model::InstanceData*>(gridInstanceBuffer.mapped);
+		for (size_t i = 0; i < modelMatrices.size(); i++)
+		{
+			instanceData[i].model = modelMatrices[i];
+		}
+
+		indirectBuffers.resize(renderResourcesCount);
+		bufferSize = sizeof(VkDrawIndexedIndirectCommand) * std::max<size_t>(drawData.size(), 1);
+		for (uint32_t i = 0; i < renderResourcesCount; i++)
+		{
+			vertexBuffer& iBuffer = indirectBuffers[i];
+			CreateBuffer(iBuffer.buffer, iBuffer.memory, &iBuffer.mapped, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, bufferSize, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			std::array<VkDescriptorBufferInfo, 2> bufferInfos =
+			{{
+				{ drawDataBuffer.buffer, 0, VK_WHOLE_SIZE },
+				{ iBuffer.buffer, 0, VK_WHOLE_SIZE }
+			}};
+			std::array<VkWriteDescriptorSet, 2> writeDescriptorSets{};
+			for (uint32_t binding = 0; binding < writeDescriptorSets.size(); binding++)
+			{
+				writeDescriptorSets[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writeDescriptorSets[binding].dstSet = cullDescriptorSets[i];
+				writeDescriptorSets[binding].dstBinding = binding;
+				writeDescriptorSets[binding].descriptorCount = 1;
+				writeDescriptorSets[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writeDescriptorSets[binding].pBufferInfo = &bufferInfos[binding];
+			}
+			vkUpdateDescriptorSets(device.Get(), writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+		}
+	}
+
+	void MultithreadedModels::CreateCullPipeline()
+	{
+		// Builds without glslc may not have the culling shader, the GPU driven draws are turned off then
+		const std::string cullShaderPath(std::string(MULTITHREADED_MODELS_PROJECT_SHADERS) + "CullDraws.spv");
+		if (!std::ifstream(cullShaderPath, std::ios::binary).good())
+		{
+			gpuDrivenSupported = false;
+			return;
+		}
+		std::vector<char> cullShaderBuffer = ReadShaderFile(cullShaderPath);
+		VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
+		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		shaderModuleCreateInfo.codeSize = cullShaderBuffer.size();
+		shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(cullShaderBuffer.data());
+		cullShaderModule.Reset(device.Get(), shaderModuleCreateInfo);
+
+		VkPushConstantRange pushConstantRange =
+		{
+		  VK_SHADER_STAGE_COMPUTE_BIT,                    // VkShaderStageFlags             stageFlags
+		  0,                                              // uint32_t                       offset
+		  sizeof(CullingConstants)                        // uint32_t                       size
+		};
+
+		VkPipelineLayoutCreateInfo layoutCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,  // VkStructureType                sType
+		  nullptr,                                        // const void                    *pNext
+		  0,                                              // VkPipelineLayoutCreateFlags    flags
+		  1,                                              // uint32_t                       setLayoutCount
+		  &cullDescriptorSetLayout,                       // const VkDescriptorSetLayout   *pSetLayouts
+		  1,                                              // uint32_t                       pushConstantRangeCount
+		  &pushConstantRange                              // const VkPushConstantRange     *pPushConstantRanges
+		};
+		RapidVulkan::CheckError(vkCreatePipelineLayout(device.Get(), &layoutCreateInfo, nullptr, &cullPipelineLayout));
+
+		VkComputePipelineCreateInfo pipelineCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,             // VkStructureType                                sType
+		  nullptr,                                                    // const void                                    *pNext
+		  0,                                                          // VkPipelineCreateFlags                          flags
+		  {
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,      // VkStructureType                                sType
+			nullptr,                                                  // const void                                    *pNext
+			0,                                                        // VkPipelineShaderStageCreateFlags               flags
+			VK_SHADER_STAGE_COMPUTE_BIT,                              // VkShaderStageFlagBits                          stage
+			cullShaderModule.Get(),                                   // VkShaderModule                                 module
+			"main",                                                   // const char                                    *pName
+			nullptr                                                   // const VkSpecializationInfo                    *pSpecializationInfo
+		  },
+		  cullPipelineLayout,                                         // VkPipelineLayout                               layout
+		  VK_NULL_HANDLE,                                             // VkPipeline                                     basePipelineHandle
+		  -1                                                          // int32_t                                        basePipelineIndex
+		};
+		cullPipeline.Reset(device.Get(), VK_NULL_HANDLE, pipelineCreateInfo);
+	}
+
+	void MultithreadedModels::CreateGraphicsPipeline()
+	{
+		std::string vertexShaderPath(std::string(MULTITHREADED_MODELS_PROJECT_CONTENT) + "vert.spv");
+		std::ifstream vertexShaderIs(vertexShaderPath, std::ios::binary);
+
+		if (vertexShaderIs.fail())
+		{
+			throw std::runtime_error("COULD NOT OPEN FILE");
+		}
+		std::streampos begin, end;
+		begin = vertexShaderIs.tellg();
+		vertexShaderIs.seekg(0, std::ios::end);
+		end = vertexShaderIs.tellg();
+		std::vector<char> vertexShaderBuffer(static_cast<size_t>(end - begin));
+		vertexShaderIs.seekg(0, std::ios::beg);
+		vertexShaderIs.read(&vertexShaderBuffer[0], end - begin);
+		vertexShaderIs.close();
+
+		VkShaderModuleCreateInfo shaderModuleCreateInfo;
+		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		shaderModuleCreateInfo.pNext = nullptr;
+		shaderModuleCreateInfo.flags = 0;
+		shaderModuleCreateInfo.codeSize = vertexShaderBuffer.size();
+		shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(vertexShaderBuffer.data());
+
+		vertexShaderModule.Reset(device.Get(), shaderModuleCreateInfo);
+
+		// Rubric 3: The program reads data from a file
+		std::string fragmentShaderPath(std::string(MULTITHREADED_MODELS_PROJECT_CONTENT) + "frag.spv");
+		std::ifstream fragmentShaderIs(fragmentShaderPath, std::ios::binary);
+
+		if (fragmentShaderIs.fail())
+		{
+			throw std::runtime_error("COULD NOT OPEN FILE");
+		}
+
+		begin = fragmentShaderIs.tellg();
+		fragmentShaderIs.seekg(0, std::ios::end);
+		end = fragmentShaderIs.tellg();
+		std::vector<char> fragmentShaderBuffer(static_cast<size_t>(end - begin));
+		fragmentShaderIs.seekg(0, std::ios::beg);
+		fragmentShaderIs.read(&fragmentShaderBuffer[0], end - begin);
+		fragmentShaderIs.close();
+
+		shaderModuleCreateInfo.codeSize = fragmentShaderBuffer.size();
+		shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(fragmentShaderBuffer.data());
+
+		fragmentShaderModule.Reset(device.Get(), shaderModuleCreateInfo);
+
+		std::vector<VkPipelineShaderStageCreateInfo> shaderStageCreateInfos =
+		{
+		  {
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,        // VkStructureType                                sType
+			nullptr,                                                    // const void                                    *pNext
+			0,                                                          // VkPipelineShaderStageCreateFlags               flags
+			VK_SHADER_STAGE_VERTEX_BIT,                                 // VkShaderStageFlagBits                          stage
+			vertexShaderModule.Get(),                                   // VkShaderModule                                 module
+			"main",                                                     // const char                                    *pName
+			nullptr                                                     // const VkSpecializationInfo                    *pSpecializationInfo  // Fragment shader
+		  },
+		  {
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,        // VkStructureType                                sType
+			nullptr,                                                    // const void                                    *pNext
+			0,                                                          // VkPipelineShaderStageCreateFlags               flags
+			VK_SHADER_STAGE_FRAGMENT_BIT,                               // VkShaderStageFlagBits                          stage
+			fragmentShaderModule.Get(),                                 // VkShaderModule                                 module
+			"main",                                                     // const char                                    *pName
+			nullptr                                                     // const VkSpecializationInfo                    *pSpecializationInfo
+		  }
+		};
+
+		// Matches the buffers Model::bindBuffers binds for the model's vertex streams
+		std::vector<VkVertexInputBindingDescription> vertexInputBindingDescriptions = vkglTF::Model::getVertexInputBindings(NyotenguVertexLayout, NyotenguModel.vertexStreams);
+
+		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions = vkglTF::Model::getVertexInputAttributes(NyotenguVertexLayout, NyotenguModel.vertexStreams);
+
+		VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {
+		  VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,      // VkStructureType                                sType
+		  nullptr,                                                        // const void                                    *pNext
+		  0,                                                              // VkPipelineVertexInputStateCreateFlags          flags;
+		  vertexInputBindingDescriptions.size(),                          // uint32_t                                       vertexBindingDescriptionCount
+		  vertexInputBindingDescriptions.data(),                          // const VkVertexInputBindingDescription         *pVertexBindingDescriptions
+		  vertexAttributeDescriptions.size(),                             // uint32_t                                       vertexAttributeDescriptionCount
+		  vertexAttributeDescriptions.data()                              // const VkVertexInputAttributeDescription       *pVertexAttributeDescriptions
+		};
+
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,  // VkStructureType                                sType
+		  nullptr,                                                      // const void                                    *pNext
+		  0,                                                            // VkPipelineInputAssemblyStateCreateFlags        flags
+		  VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,                          // VkPrimitiveTopology                            topology
+		  VK_FALSE                                                      // VkBool32                                       primitiveRestartEnable
+		};
+
+		VkPipelineViewportStateCreateInfo viewportStateCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,        // VkStructureType                                sType
+		  nullptr,                                                      // const void                                    *pNext
+		  0,                                                            // VkPipelineViewportStateCreateFlags             flags
+		  1,                                                            // uint32_t                                       viewportCount
+		  nullptr,                                                      // const VkViewport                              *pViewports
+		  1,                                                            // uint32_t                                       scissorCount
+		  nullptr                                                       // const VkRect2D                                *pScissors
+		};
+
+		std::array<VkDynamicState, 2> dynamicStates =
+		{
+		  VK_DYNAMIC_STATE_VIEWPORT,
+		  VK_DYNAMIC_STATE_SCISSOR,
+		};
+
+		VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,         // VkStructureType                                sType
+		  nullptr,                                                      // const void                                    *pNext
+		  0,                                                            // VkPipelineDynamicStateCreateFlags              flags
+		  static_cast<uint32_t>(dynamicStates.size()),                  // uint32_t                                       dynamicStateCount
+		  dynamicStates.data()                                          // const VkDynamicState                          *pDynamicStates
+		};
+
+		VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,   // VkStructureType                                sType
+		  nullptr,                                                      // const void                                    *pNext
+		  0,                                                            // VkPipelineRasterizationStateCreateFlags        flags
+		  VK_FALSE,                                                     // VkBool32                                       depthClampEnable
+		  VK_FALSE,                                                     // VkBool32                                       rasterizerDiscardEnable
+		  VK_POLYGON_MODE_FILL,                                         // VkPolygonMode                                  polygonMode
+		  VK_CULL_MODE_BACK_BIT,                                            // VkCullModeFlags                                cullMode
+		  VK_FRONT_FACE_COUNTER_CLOCKWISE,                              // VkFrontFace                                    frontFace
+		  VK_FALSE,                                                     // VkBool32                                       depthBiasEnable
+		  0.0f,                                                         // float                                          depthBiasConstantFactor
+		  0.0f,                                                         // float                                          depthBiasClamp
+		  0.0f,                                                         // float                                          depthBiasSlopeFactor
+		  2.0f                                                          // float                                          lineWidth
+		};
+
+		VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,     // VkStructureType                                sType
+		  nullptr,                                                      // const void                                    *pNext
+		  0,                                                            // VkPipelineMultisampleStateCreateFlags          flags
+		  VK_SAMPLE_COUNT_1_BIT,                                        // VkSampleCountFlagBits                          rasterizationSamples
+		  VK_FALSE,                                                     // VkBool32                                       sampleShadingEnable
+		  1.0f,                                                         // float                                          minSampleShading
+		  nullptr,                                                      // const VkSampleMask                            *pSampleMask
+		  VK_FALSE,                                                     // VkBool32                                       alphaToCoverageEnable
+		  VK_FALSE                                                      // VkBool32                                       alphaToOneEnable
+		};
+
+		VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo =
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+			nullptr,
+			0,
+			VK_TRUE,
+			VK_TRUE,
+			VK_COMPARE_OP_LESS,
+			VK_FALSE,
+			VK_FALSE,
+		};
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachmentState =
+		{
+		  VK_FALSE,                                                     // VkBool32                                       blendEnable
+		  VK_BLEND_FACTOR_ONE,                                          // VkBlendFactor                                  srcColorBlendFactor
+		  VK_BLEND_FACTOR_ZERO,                                         // VkBlendFactor                                  dstColorBlendFactor
+		  VK_BLEND_OP_ADD,                                              // VkBlendOp                                      colorBlendOp
+		  VK_BLEND_FACTOR_ONE,                                          // VkBlendFactor                                  srcAlphaBlendFactor
+		  VK_BLEND_FACTOR_ZERO,                                         // VkBlendFactor                                  dstAlphaBlendFactor
+		  VK_BLEND_OP_ADD,                                              // VkBlendOp                                      alphaBlendOp
+		  VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |         // VkColorComponentFlags                          colorWriteMask
+		  VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+		};
+
+		VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,     // VkStructureType                                sType
+		  nullptr,                                                      // const void                                    *pNext
+		  0,                                                            // VkPipelineColorBlendStateCreateFlags           flags
+		  VK_FALSE,                                                     // VkBool32                                       logicOpEnable
+		  VK_LOGIC_OP_COPY,                                             // VkLogicOp                                      logicOp
+		  1,                                                            // uint32_t                                       attachmentCount
+		  &colorBlendAttachmentState,                                  // const VkPipelineColorBlendAttachmentState     *pAttachments
+		  { 0.0f, 0.0f, 0.0f, 0.0f }                                    // float                                          blendConstants[4]
+		};
+
+		// Pipeline layout
+		const std::vector<VkDescriptorSetLayout> setLayouts = { descriptorSetLayout };
+
+		VkPipelineLayoutCreateInfo layoutCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,  // VkStructureType                sType
+		  nullptr,                                        // const void                    *pNext
+		  0,                                              // VkPipelineLayoutCreateFlags    flags
+		  setLayouts.size(),                              // uint32_t                       setLayoutCount
+		  setLayouts.data(),                              // const VkDescriptorSetLayout   *pSetLayouts
+		  0,                                              // uint32_t                       pushConstantRangeCount
+		  nullptr                                         // const VkPushConstantRange     *pPushConstantRanges
+		};
+
+		if (vkCreatePipelineLayout(device.Get(), &layoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			std::cout << "Couldn't create a Pipeline Layout" << std::endl;
+		}
+
+		VkGraphicsPipelineCreateInfo pipelineCreateInfo =
+		{
+		  VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,              // VkStructureType                                sType
+		  nullptr,                                                      // const void                                    *pNext
+		  0,                                                            // VkPipelineCreateFlags                          flags
+		  static_cast<uint32_t>(shaderStageCreateInfos.size()),         // uint32_t                                       stageCount
+		  shaderStageCreateInfos.data(),                                // const VkPipelineShaderStageCreateInfo         *pStages
+		  &vertexInputStateCreateInfo,                                  // const VkPipelineVertexInputStateCreateInfo    *pVertexInputState;
+		  &inputAssemblyStateCreateInfo,                                // const VkPipelineInputAssemblyStateCreateInfo  *pInputAssemblyState
+		  nullptr,                                                      // const VkPipelineTessellationStateCreateInfo   *pTessellationState
+		  &viewportStateCreateInfo,                                     // const VkPipelineViewportStateCreateInfo       *pViewportState
+		  &rasterizationStateCreateInfo,                                // const VkPipelineRasterizationStateCreateInfo  *pRasterizationState
+		  &multisampleStateCreateInfo,                                  // const VkPipelineMultisampleStateCreateInfo    *pMultisampleState
+		  &depthStencilCreateInfo,                                                      // const VkPipelineDepthStencilStateCreateInfo   *pDepthStencilState
+		  &colorBlendStateCreateInfo,                                   // const VkPipelineColorBlendStateCreateInfo     *pColorBlendState
+		  &dynamicStateCreateInfo,                                      // const VkPipelineDynamicStateCreateInfo        *pDynamicState
+		  pipelineLayout,                                               // VkPipelineLayout                               layout
+		  renderPass.Get(),                                             // VkRenderPass                                   renderPass
+		  0,                                                            // uint32_t                                       subpass
+		  VK_NULL_HANDLE,                                               // VkPipeline                                     basePipelineHandle
+		  -1                                                            // int32_t                                        basePipelineIndex
+		};
+		VkPipelineCache newCache = VK_NULL_HANDLE;
+		graphicsPipeline.Reset(device.Get(), newCache, pipelineCreateInfo);
+
+		// The instanced pipeline shares every other state, it swaps the vertex shader and adds the per instance stream.
+		// The GPU driven draws use it as well, both are turned off when the build has no instanced vertex shader.
+		const std::string instancedVertexShaderPath(std::string(MULTITHREADED_MODELS_PROJECT_SHADERS) + "InstancedVert.spv");
+		instancedSupported = std::ifstream(instancedVertexShaderPath, std::ios::binary).good();
+		if (!instancedSupported)
+		{
+			gpuDrivenSupported = false;
+			return;
+		}
+		std::vector<char> instancedVertexShaderBuffer = ReadShaderFile(instancedVertexShaderPath);
+		shaderModuleCreateInfo.codeSize = instancedVertexShaderBuffer.size();
+		shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(instancedVertexShaderBuffer.data());
+		instancedVertexShaderModule.Reset(device.Get(), shaderModuleCreateInfo);
+		shaderStageCreateInfos[0].module = instancedVertexShaderModule.Get();
+
+		const uint32_t instanceBinding = vkglTF::Model::getInstanceBinding(NyotenguModel.vertexStreams);
+		vertexInputBindingDescriptions.push_back(vkglTF::Model::getInstanceInputBinding(instanceBinding));
+		std::vector<VkVertexInputAttributeDescription> instanceAttributeDescriptions = vkglTF::Model::getInstanceInputAttributes(instanceBinding);
+		vertexAttributeDescriptions.insert(vertexAttributeDescriptions.end(), instanceAttributeDescriptions.begin(), instanceAttributeDescriptions.end());
+		vertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexInputBindingDescriptions.size());
+		vertexInputStateCreateInfo.pVertexBindingDescriptions = vertexInputBindingDescriptions.data();
+		vertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributeDescriptions.size());
+		vertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexAttributeDescriptions.data();
+
+		layoutCreateInfo.pSetLayouts = &instancedDescriptorSetLayout;
+		if (vkCreatePipelineLayout(device.Get(), &layoutCreateInfo, nullptr, &instancedPipelineLayout) != VK_SUCCESS)
+		{
+			std::cout << "Couldn't create a Pipeline Layout" << std::endl;
+		}
+		pipelineCreateInfo.layout = instancedPipelineLayout;
+		instancedGraphicsPipeline.Reset(device.Get(), newCache, pipelineCreateInfo);
+	}
+
+	void MultithreadedModels::CreateFramebuffers()
+	{
+		framebuffers.resize(swapchainImageViews.size());
+		for (size_t i = 0; i < swapchainImageViews.size(); ++i)
+		{
+			std::array<VkImageView, 2> attachments =
+			{
+					swapchainImageViews[i].Get(),
+					depthImageView
+			};
+			VkFramebufferCreateInfo framebufferCreateInfo =
+			{
+			  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
+			  nullptr,                                        // const void                    *pNext
+			  0,                                              // VkFramebufferCreateFlags       flags
+			  renderPass.Get(),                               // VkRenderPass                   renderPass
+			  attachments.size(),                             // uint32_t                       attachmentCount
+			  attachments.data(),                             // const VkImageView             *pAttachments
+			  swapchainExtent.width,                          // uint32_t                       width
+			  swapchainExtent.height,                         // uint32_t                       height
+			  1                                               // uint32_t                       layers
+			};
+
+			framebuffers[i].Reset(device.Get(), framebufferCreateInfo);
+		}
+	}
+
+	void MultithreadedModels::RecreateSwapchain()
+	{
+		std::array<uint32_t, 2> windowSize = window->GetWindowSize();
+		if ((windowSize[0] == 0) || (windowSize[1] == 0))
+		{
+			// Minimized, there is nothing to present to until the window comes back
+			return;
+		}
+
+		vkDeviceWaitIdle(device.Get());
+		framebuffers.clear();
+		DestroyDepthImage();
+		swapchainImageViews.clear();
+		swapchain.Reset();
+
+		CreateSwapchain();
+		CreateSwapchainImageViews();
+		CreateDepthImage();
+		CreateFramebuffers();
+		++swapchainVersion;
+	}
+
+	void MultithreadedModels::CreateDrawList()
+	{
+		modelMatrices.clear();
+		const float gridOffset = (gridSize - 1) * instanceSpacing * 0.5f;
+		for (uint32_t z = 0; z < gridSize; z++)
+		{
+			for (uint32_t x = 0; x < gridSize; x++)
+			{
+				glm::vec3 translation(x * instanceSpacing - gridOffset, 0.0f, z * instanceSpacing - gridOffset);
+				modelMatrices.push_back(glm::translate(glm::mat4(1.0f), translation));
+			}
+		}
+
+		ModelDraws.clear();
+		for (uint32_t instance = 0; instance < modelMatrices.size(); instance++)
+		{
+			for (const vkglTF::Node* node : NyotenguModel.linearNodes)
+			{
+				if (!node->mesh)
+				{
+					continue;
+				}
+				for (const vkglTF::Primitive* primitive : node->mesh->primitives)
+				{
+					ModelDraws.push_back({ instance, primitive });
+				}
+			}
+		}
+
+		// Instances are only translated, so their world space bounds are the model space ones moved by the
+		// translation and never have to be updated. ModelDraws is not resized again, which keeps the keys valid.
+		ModelCuller.Clear();
+		for (const ModelDraw& draw : ModelDraws)
+		{
+			if (!draw.primitive->bb.valid)
+			{
+				continue;
+			}
+			glm::vec3 translation(modelMatrices[draw.instance][3]);
+			glm::vec3 minimum = draw.primitive->bb.min + translation;
+			glm::vec3 maximum = draw.primitive->bb.max + translation;
+			ModelCuller.Add(&draw, Vector3D(minimum.x, minimum.y, minimum.z), Vector3D(maximum.x, maximum.y, maximum.z));
+		}
+		visibleDraws.reserve(ModelDraws.size());
+
+		// Instances are culled as a whole in the instanced mode, by the bounds of everything the model draws
+		glm::vec3 modelMinimum(FLT_MAX);
+		glm::vec3 modelMaximum(-FLT_MAX);
+		for (const vkglTF::Node* node : NyotenguModel.linearNodes)
+		{
+			if (!node->mesh)
+			{
+				continue;
+			}
+			for (const vkglTF::Primitive* primitive : node->mesh->primitives)
+			{
+				if (primitive->bb.valid)
+				{
+					modelMinimum = glm::min(modelMinimum, primitive->bb.min);
+					modelMaximum = glm::max(modelMaximum, primitive->bb.max);
+				}
+			}
+		}
+		InstanceCuller.Clear();
+		if (modelMinimum.x <= modelMaximum.x)
+		{
+			for (const glm::mat4& modelMatrix : modelMatrices)
+			{
+				glm::vec3 minimum = modelMinimum + glm::vec3(modelMatrix[3]);
+				glm::vec3 maximum = modelMaximum + glm::vec3(modelMatrix[3]);
+				InstanceCuller.Add(&modelMatrix, Vector3D(minimum.x, minimum.y, minimum.z), Vector3D(maximum.x, maximum.y, maximum.z));
+			}
+		}
+	}
+
+	void MultithreadedModels::CreateCommandRecorder()
+	{
+		commandRecorder.reset(new ParallelCommandRecorder(device.Get(), suitableQueueFamilyIndex, static_cast<uint32_t>(renderResourcesCount), recordingThreads));
+	}
+
+	void MultithreadedModels::SetViewportAndScissor(VkCommandBuffer commandBuffer)
+	{
+		VkViewport viewport =
+		{
+		  0.0f,                                               // float                                  x
+		  0.0f,                                               // float                                  y
+		  static_cast<float>(swapchainExtent.width),          // float                                  width
+		  static_cast<float>(swapchainExtent.height),         // float                                  height
+		  0.0f,                                               // float                                  minDepth
+		  1.0f                                                // float                                  maxDepth
+		};
+
+		VkRect2D scissor = {
+		  {                                                   // VkOffset2D                             offset
+			0,                                                  // int32_t                                x
+			0                                                   // int32_t                                y
+		  },
+		  {                                                   // VkExtent2D                             extent
+			swapchainExtent.width,                              // uint32_t                               width
+			swapchainExtent.height                             // uint32_t                               height
+		  }
+		};
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	// Called from the recording threads, each with a command buffer of its own. Only reads state that does not
+	// change while ParallelCommandRecorder::Record runs.
+	void MultithreadedModels::RecordDraws(VkCommandBuffer commandBuffer, const size_t& resourceIndex, size_t begin, size_t end)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.Get());
+
+		SetViewportAndScissor(commandBuffer);
+
+		// Binds the position stream too when the model splits it out, and the geometry pool buffers when it has one
+		NyotenguModel.bindBuffers(commandBuffer);
+
+		uint32_t boundInstance = UINT32_MAX;
+		for (size_t i = begin; i < end; i++)
+		{
+			const ModelDraw& draw = ModelDraws[visibleDraws[i]];
+			if (draw.instance != boundInstance)
+			{
+				uint32_t dynamicOffset = static_cast<uint32_t>(draw.instance * instanceUniformStride);
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
+					&(descriptorSets[resourceIndex]), 1, &dynamicOffset);
+				boundInstance = draw.instance;
+			}
+			if (draw.primitive->hasIndices)
+			{
+				vkCmdDrawIndexed(commandBuffer, draw.primitive->indexCount, 1, draw.primitive->firstIndex, draw.primitive->vertexOffset, 0);
+			}
+			else
+			{
+				vkCmdDraw(commandBuffer, draw.primitive->vertexCount, 1, static_cast<uint32_t>(draw.primitive->vertexOffset), 0);
+			}
+		}
+	}
+
+	void MultithreadedModels::RecordInstancedDraws(VkCommandBuffer commandBuffer, const size_t& resourceIndex)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedGraphicsPipeline.Get());
+		SetViewportAndScissor(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout, 0, 1,
+			&(instancedDescriptorSets[resourceIndex]), 0, nullptr);
+		NyotenguModel.drawInstanced(commandBuffer, instanceBuffers[resourceIndex].buffer, 0, visibleInstanceCount);
+	}
+
+	void MultithreadedModels::RecordGpuDrivenDraws(VkCommandBuffer commandBuffer, const size_t& resourceIndex)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedGraphicsPipeline.Get());
+		SetViewportAndScissor(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout, 0, 1,
+			&(instancedDescriptorSets[resourceIndex]), 0, nullptr);
+		NyotenguModel.bindBuffers(commandBuffer);
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, vkglTF::Model::getInstanceBinding(NyotenguModel.vertexStreams), 1, &gridInstanceBuffer.buffer, &offset);
+
+		// Culled draws have no instances, so every draw is issued whatever the camera sees and this is only
+		// recorded again when the swapchain or the draw mode change
+		const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		for (uint32_t first = 0; first < gpuDrawCount; first += maxDrawIndirectCount)
+		{
+			uint32_t count = std::min(maxDrawIndirectCount, gpuDrawCount - first);
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffers[resourceIndex].buffer, first * stride, count, stride);
+		}
+	}
+
+	// Recorded into the primary command buffer every frame, before the render pass the indirect draws are issued in.
+	void MultithreadedModels::RecordDrawCulling(VkCommandBuffer commandBuffer, const size_t& resourceIndex, const Frustum& frustum)
+	{
+		if (gpuDrawCount == 0)
+		{
+			return;
+		}
+		CullingConstants constants;
+		std::memcpy(constants.planes, frustum.planes, sizeof(constants.planes));
+		constants.drawCount = gpuDrawCount;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline.Get());
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1,
+			&(cullDescriptorSets[resourceIndex]), 0, nullptr);
+		vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(commandBuffer, (gpuDrawCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+		VkBufferMemoryBarrier bufferMemoryBarrier =
+		{
+		  VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,            // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  VK_ACCESS_SHADER_WRITE_BIT,                         // VkAccessFlags                          srcAccessMask
+		  VK_ACCESS_INDIRECT_COMMAND_READ_BIT,                // VkAccessFlags                          dstAccessMask
+		  VK_QUEUE_FAMILY_IGNORED,                            // uint32_t                               srcQueueFamilyIndex
+		  VK_QUEUE_FAMILY_IGNORED,                            // uint32_t                               dstQueueFamilyIndex
+		  indirectBuffers[resourceIndex].buffer,              // VkBuffer                               buffer
+		  0,                                                  // VkDeviceSize                           offset
+		  VK_WHOLE_SIZE                                       // VkDeviceSize                           size
+		};
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0,
+			0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+	}
+
+	void MultithreadedModels::RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex)
+	{
+		VkCommandBufferBeginInfo commandBufferBeginInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,        // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,        // VkCommandBufferUsageFlags              flags
+		  nullptr                                             // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
+		};
+		std::vector<VkCommandBuffer> commandBuffers = graphicsCommandBuffers.Get();
+		vkBeginCommandBuffer(commandBuffers[resourceIndex], &commandBufferBeginInfo);
+
+		VkImageSubresourceRange image_subresource_range =
+		{
+		  VK_IMAGE_ASPECT_COLOR_BIT,                          // VkImageAspectFlags                     aspectMask
+		  0,                                                  // uint32_t                               baseMipLevel
+		  1,                                                  // uint32_t                               levelCount
+		  0,                                                  // uint32_t                               baseArrayLayer
+		  1                                                   // uint32_t                               layerCount
+		};
+
+		std::array<VkClearValue, 2> clearValues{};
+		clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
+		clearValues[1].depthStencil = { 1.0f, 0 };
+
+		VkRenderPassBeginInfo renderPassBeginInfo =
+		{
+		  VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,           // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  renderPass.Get(),                                   // VkRenderPass                           renderPass
+		  framebuffers[imageIndex].Get(),                     // VkFramebuffer                          framebuffer
+		  {                                                   // VkRect2D                               renderArea
+			{                                                 // VkOffset2D                             offset
+			  0,                                              // int32_t                                x
+			  0                                               // int32_t                                y
+			},
+			swapchainExtent,                                  // VkExtent2D                             extent;
+		  },
+		  clearValues.size(),                                                  // uint32_t                               clearValueCount
+		  clearValues.data()                                         // const VkClearValue                    *pClearValues
+		};
+
+		// Update UBOs
+		viewMatrix = glm::lookAt(eyeLocation, eyeDirection, up);
+		projectionMatrix = glm::perspective(glm::radians(70.0f), 1920.0f / 1080.0f, 0.1f, 100.0f);
+		projectionMatrix[1][1] *= -1;
+
+		// The registered bounds are in world space, so they are culled against the view projection frustum.
+		glm::mat4 viewProjectionMatrix = projectionMatrix * viewMatrix;
+		Frustum frustum(glm::value_ptr(viewProjectionMatrix));
+		if (drawMode != DrawMode::ParallelRecorded)
+		{
+			if (drawMode == DrawMode::Instanced)
+			{
+				// The visible instances are packed at the front of the instance buffer, in grid order, so the
+				// recorded draws stay valid for as long as the same instances are visible
+				InstanceCuller.Cull(frustum);
+				vkglTF::Model::InstanceData* instanceData = static_cast<vkglTF::Model::InstanceData*>(instanceBuffers[resourceIndex].mapped);
+				visibleInstanceCount = 0;
+				for (const glm::mat4& modelMatrix : modelMatrices)
+				{
+					if (InstanceCuller.IsVisible(&modelMatrix))
+					{
+						instanceData[visibleInstanceCount++].model = modelMatrix;
+					}
+				}
+			}
+
+			float* memory = (float*)cameraUniformBuffers[resourceIndex].mapped;
+			memcpy((void*)memory, glm::value_ptr(viewMatrix), sizeof(glm::mat4));
+			memory += sizeof(glm::mat4) / sizeof(float);
+			memcpy((void*)memory, glm::value_ptr(projectionMatrix), sizeof(glm::mat4));
+		}
+		else
+		{
+			ModelCuller.Cull(frustum);
+			uint8_t* instanceMemory = static_cast<uint8_t*>(matrixUniformBuffers[resourceIndex].mapped);
+			for (size_t i = 0; i < modelMatrices.size(); i++)
+			{
+				glm::mat4 modelViewMatrix = viewMatrix * modelMatrices[i];
+				glm::mat4 MVPMatrix = projectionMatrix * modelViewMatrix;
+				float* memory = reinterpret_cast<float*>(instanceMemory + i * instanceUniformStride);
+				memcpy((void*)memory, glm::value_ptr(modelViewMatrix), sizeof(glm::mat4));
+				memory += sizeof(glm::mat4) / sizeof(float);
+				memcpy((void*)memory, glm::value_ptr(modelViewMatrix), sizeof(glm::mat4));
+				memory += sizeof(glm::mat4) / sizeof(float);
+				memcpy((void*)memory, glm::value_ptr(MVPMatrix), sizeof(glm::mat4));
+			}
+		}
+
+		glm::vec4 lightPosition = viewMatrix * glm::vec4(0.0f, 1.75f, 1.0f, 1.0f);
+		glm::vec4 lightIntensity = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		float* memory = (float*)lightUniformBuffer[resourceIndex].mapped;
+		memcpy((void*)memory, glm::value_ptr(lightPosition), sizeof(glm::vec4));
+		memory += sizeof(glm::vec4) / sizeof(float);
+		memcpy((void*)memory, glm::value_ptr(lightIntensity), sizeof(glm::vec4));
+
+		// The draws are only recorded again when culling, the draw mode or a new swapchain changed them. They are split
+		// across the recording threads, each recording a secondary command buffer from a pool of its own.
+		uint64_t sceneVersion = swapchainVersion + drawModeVersion + ModelCuller.VisibilityVersion() + InstanceCuller.VisibilityVersion();
+		if (recordedSceneVersions[resourceIndex] != sceneVersion)
+		{
+			VkCommandBufferInheritanceInfo inheritanceInfo =
+			{
+			  VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,  // VkStructureType                        sType
+			  nullptr,                                            // const void                            *pNext
+			  renderPass.Get(),                                   // VkRenderPass                           renderPass
+			  0,                                                  // uint32_t                               subpass
+			  VK_NULL_HANDLE,                                     // VkFramebuffer                          framebuffer
+			  VK_FALSE,                                           // VkBool32                               occlusionQueryEnable
+			  0,                                                  // VkQueryControlFlags                    queryFlags
+			  0                                                   // VkQueryPipelineStatisticFlags          pipelineStatistics
+			};
+
+			if (drawMode == DrawMode::Instanced)
+			{
+				// One draw per primitive leaves nothing to split, the recorder takes it as a single range
+				commandRecorder->Record(static_cast<uint32_t>(resourceIndex), inheritanceInfo, 1,
+					[this, &resourceIndex](VkCommandBuffer commandBuffer, size_t begin, size_t end)
+					{
+						RecordInstancedDraws(commandBuffer, resourceIndex);
+					});
+			}
+			else if (drawMode == DrawMode::GpuDriven)
+			{
+				commandRecorder->Record(static_cast<uint32_t>(resourceIndex), inheritanceInfo, 1,
+					[this, &resourceIndex](VkCommandBuffer commandBuffer, size_t begin, size_t end)
+					{
+						RecordGpuDrivenDraws(commandBuffer, resourceIndex);
+					});
+			}
+			else
+			{
+				visibleDraws.clear();
+				for (uint32_t i = 0; i < ModelDraws.size(); i++)
+				{
+					if (ModelCuller.IsVisible(&ModelDraws[i]))
+					{
+						visibleDraws.push_back(i);
+					}
+				}
+
+				commandRecorder->Record(static_cast<uint32_t>(resourceIndex), inheritanceInfo, visibleDraws.size(),
+					[this, &resourceIndex](VkCommandBuffer commandBuffer, size_t begin, size_t end)
+					{
+						RecordDraws(commandBuffer, resourceIndex, begin, end);
+					});
+			}
+			recordedSceneVersions[resourceIndex] = sceneVersion;
+		}
+
+		if (drawMode == DrawMode::GpuDriven)
+		{
+			RecordDrawCulling(commandBuffers[resourceIndex], resourceIndex, frustum);
+		}
+
+		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		const std::vector<VkCommandBuffer>& sceneCommandBuffers = commandRecorder->Recorded(static_cast<uint32_t>(resourceIndex));
+		vkCmdExecuteCommands(commandBuffers[resourceIndex], static_cast<uint32_t>(sceneCommandBuffers.size()), sceneCommandBuffers.data());
+		vkCmdEndRenderPass(commandBuffers[resourceIndex]);
+
+		if (vkEndCommandBuffer(commandBuffers[resourceIndex]) != VK_SUCCESS)
+		{
+			std::cout << "Could not record command buffer!" << std::endl;
+		}
+	}
+
+	void MultithreadedModels::Draw()
+	{
+		static size_t resourceIndex = 0;
+		uint32_t imageIndex;
+
+		if (vkWaitForFences(device.Get(), 1, &fences[resourceIndex], VK_FALSE, 1000000000) != VK_SUCCESS)
+		{
+			std::cout << "Waiting for fence takes too long!" << std::endl;
+		}
+
+		VkResult result = vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// The fence stays signaled, nothing was submitted for this resource
+			RecreateSwapchain();
+			return;
+		}
+		vkResetFences(device.Get(), 1, &fences[resourceIndex]);
+		RecordJustInTimeCommandBuffers(resourceIndex, imageIndex);
+
+		std::vector<VkCommandBuffer> commandBuffers = graphicsCommandBuffers.Get();
+
+		VkPipelineStageFlags waitDstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		VkSubmitInfo submitInfo =
+		{
+		  VK_STRUCTURE_TYPE_SUBMIT_INFO,                     // VkStructureType              sType
+		  nullptr,                                           // const void                  *pNext
+		  1,                                                 // uint32_t                     waitSemaphoreCount
+		  imageAvailable[resourceIndex].GetPointer(),        // const VkSemaphore           *pWaitSemaphores
+		  &waitDstStageMask,                                 // const VkPipelineStageFlags  *pWaitDstStageMask;
+		  1,                                                 // uint32_t                     commandBufferCount
+		  &commandBuffers[resourceIndex],                    // const VkCommandBuffer       *pCommandBuffers
+		  1,                                                 // uint32_t                     signalSemaphoreCount
+		  renderingFinished[resourceIndex].GetPointer()                  // const VkSemaphore           *pSignalSemaphores
+		};
+
+		if (vkQueueSubmit(queue, 1, &submitInfo, fences[resourceIndex]) != VK_SUCCESS)
+		{
+			std::cout << "Error while submitting queue" << std::endl;
+		}
+
+		VkPresentInfoKHR presentInfo =
+		{
+		  VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,                     // VkStructureType              sType
+		  nullptr,                                                // const void                  *pNext
+		  1,                                                      // uint32_t                     waitSemaphoreCount
+		  renderingFinished[resourceIndex].GetPointer(),          // const VkSemaphore           *pWaitSemaphores
+		  1,                                                      // uint32_t                     swapchainCount
+		  swapchain.GetPointer(),                                 // const VkSwapchainKHR        *pSwapchains
+		  &imageIndex,                                            // const uint32_t              *pImageIndices
+		  nullptr                                                 // VkResult                    *pResults
+		};
+
+		result = vkQueuePresentKHR(queue, &presentInfo);
+
+		resourceIndex = (resourceIndex + 1) % renderResourcesCount;
+
+		if ((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR))
+		{
+			RecreateSwapchain();
+		}
+	}
+
+	void MultithreadedModels::NextDrawMode()
+	{
+		switch (drawMode)
+		{
+		case DrawMode::ParallelRecorded:
+			if (instancedSupported)
+			{
+				drawMode = DrawMode::Instanced;
+				std::cout << "Instanced draws" << std::endl;
+				break;
+			}
+			std::cout << "Instanced and GPU driven draws need InstancedVert.spv, skipping them" << std::endl;
+			drawMode = DrawMode::ParallelRecorded;
+			std::cout << "Parallel recorded draws" << std::endl;
+			break;
+		case DrawMode::Instanced:
+			if (gpuDrivenSupported)
+			{
+				drawMode = DrawMode::GpuDriven;
+				std::cout << "GPU driven draws" << std::endl;
+				break;
+			}
+			std::cout << "GPU driven draws need drawIndirectFirstInstance and CullDraws.spv, skipping them" << std::endl;
+			// Fall through
+		default:
+			drawMode = DrawMode::ParallelRecorded;
+			std::cout << "Parallel recorded draws" << std::endl;
+			break;
+		}
+		++drawModeVersion;
+	}
+
+	void MultithreadedModels::RotateHorizontal(float angle)
+	{
+		//Rotation left means rotating around my up vector
+		glm::vec3 forward = glm::normalize(eyeLocation - eyeDirection);
+		glm::vec3 left = glm::cross(glm::normalize(up), forward);
+		glm::vec3 actualUp = glm::cross(forward, left);
+		glm::mat3 rotation = glm::rotate(glm::mat4(1.0f), angle, actualUp);
+		eyeLocation = rotation * eyeLocation;
+	}
+
+	void MultithreadedModels::RotateVertical(float angle)
+	{
+		//Rotation up, means rotation around my left or right vector
+		// I need to define where left is, based on the current eye position:
+		glm::vec3 forward = glm::normalize(eyeLocation - eyeDirection);
+		glm::vec3 left = glm::cross(glm::normalize(up), forward);
+		glm::mat3 rotation = glm::rotate(glm::mat4(1.0f), angle, left);
+		eyeLocation = rotation * eyeLocation;
+		/*
+		forward = glm::normalize(eyeLocation - eyeDirection);
+		left = glm::cross(glm::normalize(up), forward);
+		glm::vec3 actualUp = glm::cross(forward, left);
+		up = actualUp;
+		*/
+	}
+
+	MultithreadedModels::MultithreadedModels()
+		: renderResourcesCount(3)
+		, swapchainVersion(0)
+		, instanceUniformStride(0)
+		, visibleInstanceCount(0)
+		, gpuDrawCount(0)
+		, instancedSupported(false)
+		, gpuDrivenSupported(false)
+		, maxDrawIndirectCount(1)
+		, drawMode(DrawMode::ParallelRecorded)
+		, drawModeVersion(0)
+		, gridSize(16)
+		, instanceSpacing(1.5f)
+		, suitablePhysicalDeviceIndex(0xFFFFFFFF)
+		, suitableQueueFamilyIndex(0xFFFFFFFF)
+		, up(0.0f, 1.0f, 0.0f)
+        , eyeLocation(0.0f, 9.0f, 14.0f)
+	    , eyeDirection(0.0f, 0.0f, 0.0f)
+	    , initialUp(0.0f, 1.0f, 0.0f)
+	    , initialEyeLocation(0.0f, 0.0f, 2.0f)
+	    , initialEyeDirection(0.0f, 0.0f, 0.0f)
+	{
+		WindowFactory windowFactory;
+		window = windowFactory.Create(std::array<uint32_t, 2>{1920, 1080}, std::array<uint32_t, 2>{0, 0}, std::string{ "Multithreaded Models" });
+		presentationExtensions = window->GetWindowExtensions();
+		for (const auto& extension : presentationExtensions)
+		{
+			requestedExtensions[extension] = false;
+		}
+
+		try
+		{
+			CreateInstance();
+			CreateSurface();
+			CreateLogicalDevice();
+			CreateMemoryAllocator();
+			CreateSemaphores();
+			CreateFences();
+			CreateSwapchain();
+			CreateRenderPass();
+			CreateSwapchainImageViews();
+			CreateDepthImage();
+			CreateFramebuffers();
+			CreateGraphicsCommandsBuffers();
+			CreateCommandRecorder();
+			CreateDescriptorSetLayout();
+			CreateDescriptorPool();
+			AllocateDescriptorSet();
+			CreateUniformBuffers();
+			CreateInstanceBuffers();
+			UpdateDescriptorSet();
+			CreateGraphicsPipeline();
+			CreateCullPipeline();
+			std::string modelPath(std::string(MULTITHREADED_MODELS_PROJECT_CONTENT) + "Nyotengu.gltf");
+			NyotenguModel.vertexLayout = NyotenguVertexLayout;
+			NyotenguModel.loadFromFile(modelPath, selectedPhysicalDevice, device.Get(), *memoryAllocator, queue, graphicsCommandPool.Get(), 1.0f);
+			CreateDrawList();
+			CreateGpuDrivenBuffers();
+		}
+		catch (std::exception& e)
+		{
+			std::cout << e.what() << std::endl;
+		}
+	}
+
+	MultithreadedModels::~MultithreadedModels()
+	{
+		// The recorded secondary command buffers may still be executing
+		vkDeviceWaitIdle(device.Get());
+	}
+}
+
+int pressDirection = 0;
+bool switchDrawMode = false;
+
+void KeyCallBack(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	switch (key)
+	{
+	  case GLFW_KEY_RIGHT: 
+		  if (action == GLFW_PRESS)
+		  {
+			  std::cout << "Pressed Right" << std::endl;
+			  pressDirection = 1;
+		  }
+		  break;
+	  case GLFW_KEY_LEFT:
+		  if (action == GLFW_PRESS)
+		  {
+			  std::cout << "Pressed Left" << std::endl;
+			  pressDirection = 2;
+		  }
+		  break;
+	  case GLFW_KEY_UP:
+		  if (action == GLFW_PRESS)
+		  {
+			  std::cout << "Pressed Up" << std::endl;
+			  pressDirection = 3;
+		  }
+		  break;
+	  case GLFW_KEY_DOWN:
+		  if (action == GLFW_PRESS)
+		  {
+			  std::cout << "Pressed Down" << std::endl;
+			  pressDirection = 4;
+		  }
+		  break;
+	  case GLFW_KEY_M:
+		  if (action == GLFW_PRESS)
+		  {
+			  switchDrawMode = true;
+		  }
+		  break;
+	  default: break;
+	}
+}
 
 int main()
 {
-    std::cout << "Hello World!" << std::endl;
-    BadgerSandbox::WindowFactory windowFactory;
-    windowFactory.Allocate(std::array<uint32_t, 2>{1280, 720}, std::array<uint32_t, 2>{0, 0});
+    std::cout << "Multithreaded Models!" << std::endl;
+    BadgerSandbox::MultithreadedModels multithreadedModels;
+	// TODO: This is a horrible hack, create a service that propagates window events
+	glfwSetKeyCallback((GLFWwindow*)multithreadedModels.window->GetNativeWindow(), KeyCallBack);
+	std::cout << "Press M to switch between parallel recorded, instanced and GPU driven draws" << std::endl;
+	while (!multithreadedModels.window->ShouldWindowClose())
+	{
+		if (switchDrawMode)
+		{
+			switchDrawMode = false;
+			multithreadedModels.NextDrawMode();
+		}
+		switch (pressDirection)
+		{
+		case 1:
+			pressDirection = 0;
+			multithreadedModels.RotateHorizontal(glm::radians(5.0f));
+		break;
+		case 2:
+			pressDirection = 0;
+			multithreadedModels.RotateHorizontal(glm::radians(-5.0f));
+			break;
+		case 3:
+			pressDirection = 0;
+			multithreadedModels.RotateVertical(glm::radians(5.0f));
+			break;
+		case 4:
+			pressDirection = 0;
+			multithreadedModels.RotateVertical(glm::radians(-5.0f));
+			break;
+		default: break;
+
+		}
+		multithreadedModels.Draw();
+	}
     return 0;
-}
+}
\ No newline at end of file
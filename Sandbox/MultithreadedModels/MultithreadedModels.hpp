@@ -0,0 +1,225 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <RapidVulkan/Instance.hpp>
+#include <RapidVulkan/Device.hpp>
+#include <RapidVulkan/SwapchainKHR.hpp>
+#include <RapidVulkan/RenderPass.hpp>
+#include <RapidVulkan/ImageView.hpp>
+#include <RapidVulkan/Framebuffer.hpp>
+#include <RapidVulkan/Semaphore.hpp>
+#include <RapidVulkan/ShaderModule.hpp>
+#include <RapidVulkan/GraphicsPipeline.hpp>
+#include <RapidVulkan/ComputePipeline.hpp>
+#include <RapidVulkan/CommandPool.hpp>
+#include <RapidVulkan/CommandBuffers.hpp>
+#include "IWindow.hpp"
+#include "DeviceMemoryAllocator.hpp"
+#include "ThreadPool.hpp"
+#include "ParallelCommandRecorder.hpp"
+#include "Frustum.hpp"
+
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace BadgerSandbox
+{
+    struct uniformBuffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocation memory;
+        VkDescriptorBufferInfo decriptor = {};
+        void* mapped = nullptr;
+    };
+
+    struct vertexBuffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocation memory;
+        void* mapped = nullptr;
+    };
+
+    enum class DrawMode
+    {
+        // Every visible primitive of every instance is a draw, recorded across the recording threads
+        ParallelRecorded,
+        // Whole instances are culled and the visible ones drawn with a single draw per primitive
+        Instanced,
+        // A compute pass culls every primitive of every instance into an indirect draw buffer
+        GpuDriven
+    };
+
+    // Draws a grid of model instances in one of the DrawModes, switched at run time.
+	class MultithreadedModels
+	{
+	private:
+		std::vector<std::string> presentationExtensions;
+        std::unordered_map<std::string, bool> requestedExtensions;
+        std::vector<VkExtensionProperties> availableExtensions;
+
+        RapidVulkan::Instance instance;
+        uint32_t suitablePhysicalDeviceIndex;
+        VkPhysicalDevice selectedPhysicalDevice;
+
+        RapidVulkan::Device device;
+        uint32_t suitableQueueFamilyIndex;
+        VkQueue queue;
+        // Buffers and images are sub-allocated from here. Declared after the device so it releases its memory
+        // before the device is destroyed.
+        std::unique_ptr<DeviceMemoryAllocator> memoryAllocator;
+        ThreadPool recordingThreads;
+        // Owns a command pool per frame and recording thread, so it is declared after the device as well
+        std::unique_ptr<ParallelCommandRecorder> commandRecorder;
+
+        VkSurfaceKHR surface;
+        VkSurfaceFormatKHR selectedSurfaceFormat;
+        VkExtent2D swapchainExtent;
+        RapidVulkan::SwapchainKHR swapchain;
+
+        RapidVulkan::RenderPass renderPass;
+        std::vector<RapidVulkan::ImageView> swapchainImageViews;
+        // One per swapchain image, only rebuilt when the swapchain is
+        std::vector<RapidVulkan::Framebuffer> framebuffers;
+        // Bumped whenever the swapchain is recreated
+        uint64_t swapchainVersion;
+
+        std::vector<RapidVulkan::Semaphore> imageAvailable;
+        std::vector<RapidVulkan::Semaphore> renderingFinished;
+
+        RapidVulkan::ShaderModule vertexShaderModule;
+        RapidVulkan::ShaderModule fragmentShaderModule;
+        RapidVulkan::ShaderModule instancedVertexShaderModule;
+        RapidVulkan::ShaderModule cullShaderModule;
+
+        VkDescriptorSetLayout descriptorSetLayout;
+        std::vector<VkDescriptorSet> descriptorSets;
+
+        RapidVulkan::GraphicsPipeline graphicsPipeline;
+        // Reads the model matrices from instanceBuffers and the camera from cameraUniformBuffers
+        RapidVulkan::GraphicsPipeline instancedGraphicsPipeline;
+        VkDescriptorSetLayout instancedDescriptorSetLayout;
+        std::vector<VkDescriptorSet> instancedDescriptorSets;
+        VkPipelineLayout instancedPipelineLayout;
+        // Writes a VkDrawIndexedIndirectCommand for every entry of drawDataBuffer into the frame's indirect buffer
+        RapidVulkan::ComputePipeline cullPipeline;
+        VkDescriptorSetLayout cullDescriptorSetLayout;
+        std::vector<VkDescriptorSet> cullDescriptorSets;
+        VkPipelineLayout cullPipelineLayout;
+
+        RapidVulkan::CommandPool graphicsCommandPool;
+        RapidVulkan::CommandBuffers graphicsCommandBuffers;
+        // The scene draws of each render resource are recorded by commandRecorder and executed from the
+        // primary command buffer every frame until the culling results or the swapchain change
+        std::vector<uint64_t> recordedSceneVersions;
+        // Indices into the draw list of the draws that passed culling, in draw list order
+        std::vector<uint32_t> visibleDraws;
+
+        const size_t renderResourcesCount;
+        std::vector<VkFence> fences;
+
+        VkImage depthImage;
+        MemoryAllocation depthImageMemory;
+        VkImageView depthImageView;
+
+        VkDescriptorSetLayout dsLayout;
+        VkDescriptorPool dPool;
+        VkDescriptorSet ds;
+        VkPipelineLayout pipelineLayout;
+
+        // The matrices of every instance, one slot of instanceUniformStride bytes each, selected with a
+        // dynamic offset when binding the descriptor set
+        std::vector<uniformBuffer> matrixUniformBuffers;
+        std::vector<uniformBuffer> lightUniformBuffer;
+        VkDeviceSize instanceUniformStride;
+        std::vector<uniformBuffer> cameraUniformBuffers;
+        // The model matrices of the visible instances, packed at the front
+        std::vector<vertexBuffer> instanceBuffers;
+        uint32_t visibleInstanceCount;
+
+        // Bounds, index range and instance of every indexed draw of the draw list, for the GPU driven mode
+        vertexBuffer drawDataBuffer;
+        uint32_t gpuDrawCount;
+        std::vector<vertexBuffer> indirectBuffers;
+        // The model matrices of every instance, the indirect draws select theirs through firstInstance
+        vertexBuffer gridInstanceBuffer;
+        // Needs InstancedVert.spv, which builds without glslc may not have
+        bool instancedSupported;
+        // Needs drawIndirectFirstInstance, multiDrawIndirect only saves draw calls, and CullDraws.spv
+        bool gpuDrivenSupported;
+        uint32_t maxDrawIndirectCount;
+
+        DrawMode drawMode;
+        // Bumped whenever the draw mode changes
+        uint64_t drawModeVersion;
+
+        // Instances are laid out on a gridSize by gridSize square in the XZ plane
+        const uint32_t gridSize;
+        const float instanceSpacing;
+        std::vector<glm::mat4> modelMatrices;
+
+        glm::mat4 viewMatrix;
+        glm::mat4 projectionMatrix;
+
+        glm::vec3 up;
+        glm::vec3 eyeLocation;
+        glm::vec3 eyeDirection;
+
+        glm::vec3 initialUp;
+        glm::vec3 initialEyeLocation;
+        glm::vec3 initialEyeDirection;
+
+        void AllocateDescriptorSet();
+        void CreateCommandRecorder();
+        void CreateDrawList();
+        void CreateDepthImage();
+        void DestroyDepthImage();
+        void CreateDescriptorPool();
+        void CreateDescriptorSetLayout();
+        void CreateFences();
+        void CreateGraphicsCommandsBuffers();
+        void CreateGraphicsPipeline();
+        void CreateImageView(const VkImage& image, VkImageView& imageView);
+        VkImageView CreateImageViewVulkanTutorial(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory);
+        void CreateInstance();
+        void CreateFramebuffers();
+        void CreateLogicalDevice();
+        void CreateMemoryAllocator();
+        void CreateRenderPass();
+        void CreateSemaphores();
+        void CreateSurface();
+        void CreateSwapchain();
+        void CreateSwapchainImageViews();
+        VkFormat FindDepthFormat();
+        VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex);
+        void RecordDraws(VkCommandBuffer commandBuffer, const size_t& resourceIndex, size_t begin, size_t end);
+        void RecordInstancedDraws(VkCommandBuffer commandBuffer, const size_t& resourceIndex);
+        void RecordGpuDrivenDraws(VkCommandBuffer commandBuffer, const size_t& resourceIndex);
+        void RecordDrawCulling(VkCommandBuffer commandBuffer, const size_t& resourceIndex, const Frustum& frustum);
+        void SetViewportAndScissor(VkCommandBuffer commandBuffer);
+        void RecreateSwapchain();
+        void CreateBuffer(VkBuffer &buffer, MemoryAllocation& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties);
+        void CreateUniformBuffers();
+        void CreateInstanceBuffers();
+        void CreateGpuDrivenBuffers();
+        void CreateCullPipeline();
+        void UpdateDescriptorSet();
+	public:
+        std::shared_ptr<IWindow> window;
+        MultithreadedModels();
+		~MultithreadedModels();
+        void Draw();
+        void RotateHorizontal(float angle);
+        void RotateVertical(float angle);
+        void NextDrawMode();
+	};
+	
+
+  }
\ No newline at end of file
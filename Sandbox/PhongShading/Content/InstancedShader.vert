@@ -0,0 +1,29 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+// Per instance, read from a VK_VERTEX_INPUT_RATE_INSTANCE buffer. Locations 6 to 9, after every vertex layout's attributes
+layout(location = 6) in mat4 inModel;
+
+layout(std140, binding = 0) uniform UBO
+{
+  mat4 view;
+  mat4 projection;
+}
+g_camera;
+
+out gl_PerVertex
+{
+  vec4 gl_Position;
+};
+
+layout(location = 0) out vec3 fragmentPosition;
+layout(location = 1) out vec3 normal;
+
+void main() 
+{
+	mat4 modelView = g_camera.view * inModel;
+	normal =  normalize(mat3(modelView) * inNormal);
+    fragmentPosition = vec3(modelView * vec4(inPosition, 1.0));
+	gl_Position = g_camera.projection * (modelView * vec4(inPosition, 1.0));
+}
\ No newline at end of file
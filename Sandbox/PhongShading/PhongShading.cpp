@@ -7,32 +7,62 @@
 #include <GLFW/glfw3.h>
 
 #include "VulkanglTFModel.hpp"
+#include "FrustumCuller.hpp"
 
 namespace BadgerSandbox
 {
 	vkglTF::Model NyotenguModel;
+	// The shaders only read positions and normals, so the model is stored without skin attributes
+	const vkglTF::VertexLayout NyotenguVertexLayout = vkglTF::VertexLayout::CompactStatic;
+	FrustumCuller NyotenguCuller;
 
-	void RenderNode(const vkglTF::Node& node, uint32_t cbIndex, VkCommandBuffer cmdBuffer, VkPipelineLayout pipelineLayout)
+	// Registers the model-space bounds of every primitive so they can be culled before recording.
+	void RegisterPrimitiveBounds(const vkglTF::Model& model, FrustumCuller& culler)
+	{
+		culler.Clear();
+		for (const vkglTF::Node* node : model.linearNodes)
+		{
+			if (!node->mesh)
+			{
+				continue;
+			}
+			for (const vkglTF::Primitive* primitive : node->mesh->primitives)
+			{
+				if (primitive->bb.valid)
+				{
+					culler.Add(primitive,
+						Vector3D(primitive->bb.min.x, primitive->bb.min.y, primitive->bb.min.z),
+						Vector3D(primitive->bb.max.x, primitive->bb.max.y, primitive->bb.max.z));
+				}
+			}
+		}
+	}
+
+	void RenderNode(const vkglTF::Node& node, uint32_t cbIndex, VkCommandBuffer cmdBuffer, VkPipelineLayout pipelineLayout, const FrustumCuller& culler)
 	{
 		if (node.mesh)
 		{
 			// Render mesh primitives
 			for (vkglTF::Primitive* primitive : node.mesh->primitives)
 			{
+				if (!culler.IsVisible(primitive))
+				{
+					continue;
+				}
 				if (primitive->hasIndices)
 				{
-					vkCmdDrawIndexed(cmdBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+					vkCmdDrawIndexed(cmdBuffer, primitive->indexCount, 1, primitive->firstIndex, primitive->vertexOffset, 0);
 				}
 				else
 				{
-					vkCmdDraw(cmdBuffer, primitive->vertexCount, 1, 0, 0);
+					vkCmdDraw(cmdBuffer, primitive->vertexCount, 1, static_cast<uint32_t>(primitive->vertexOffset), 0);
 				}
 			}
 
 		};
 		for (auto child : node.children)
 		{
-			RenderNode(*child, cbIndex, cmdBuffer, pipelineLayout);
+			RenderNode(*child, cbIndex, cmdBuffer, pipelineLayout, culler);
 		}
 	}
 
@@ -512,31 +542,16 @@ namespace BadgerSandbox
 		}
 	}
 
-	/*
-  Took this function from VulkanTutorial:
-  https://vulkan-tutorial.com/
-*/
-	uint32_t PhongShading::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	void PhongShading::CreateMemoryAllocator()
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memProperties);
-
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-		{
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-			{
-				return i;
-			}
-		}
-
-		throw std::runtime_error("failed to find suitable memory type!");
+		memoryAllocator.reset(new DeviceMemoryAllocator(selectedPhysicalDevice, device.Get()));
 	}
 
 	/*
 	  Took this function from VulkanTutorial:
 	  https://vulkan-tutorial.com/
 	*/
-	void PhongShading::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	void PhongShading::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -553,23 +568,11 @@ namespace BadgerSandbox
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkCreateImage(device.Get(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateImage(imageInfo, memoryRequest, image, imageMemory) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image!");
 		}
-
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device.Get(), image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device.Get(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate image memory!");
-		}
-
-		vkBindImageMemory(device.Get(), image, imageMemory, 0);
 	}
 
 	/*
@@ -644,6 +647,13 @@ namespace BadgerSandbox
 		depthImageView = CreateImageViewVulkanTutorial(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 	}
 
+	void PhongShading::DestroyDepthImage()
+	{
+		vkDestroyImageView(device.Get(), depthImageView, nullptr);
+		depthImageView = VK_NULL_HANDLE;
+		memoryAllocator->DestroyImage(depthImage, depthImageMemory);
+	}
+
 	void PhongShading::CreateGraphicsCommandsBuffers()
 	{
 		VkCommandPoolCreateInfo commandPoolCreateInfo =
@@ -668,6 +678,10 @@ namespace BadgerSandbox
 
 		graphicsCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
 
+		commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		sceneCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
+		recordedSceneVersions.assign(renderResourcesCount, UINT64_MAX);
+
 		VkCommandBufferBeginInfo graphicsCommandBufferBeginInfo =
 		{
 		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,    // VkStructureType                        sType
@@ -687,8 +701,6 @@ namespace BadgerSandbox
 		VkClearValue clearValue = {
 		  { 1.0f, 0.8f, 0.4f, 0.0f },                     // VkClearColorValue              color
 		};
-
-		framebuffers.resize(renderResourcesCount);
 	}
 
 	void PhongShading::CreateDescriptorSetLayout()
@@ -747,7 +759,7 @@ namespace BadgerSandbox
 		}
 	}
 
-	void PhongShading::CreateBuffer(VkBuffer& buffer, VkDeviceMemory& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties)
+	void PhongShading::CreateBuffer(VkBuffer& buffer, MemoryAllocation& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties)
 	{
 		VkBufferCreateInfo createInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 		createInfo.usage = usage;
@@ -756,25 +768,15 @@ namespace BadgerSandbox
 		createInfo.queueFamilyIndexCount = 0;
 		createInfo.pQueueFamilyIndices = nullptr;
 
-		vkCreateBuffer(device.Get(), &createInfo, nullptr, &buffer);
-
-		VkMemoryRequirements memoryRequirements;
-		vkGetBufferMemoryRequirements(device.Get(), buffer, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocationInfo{};
-		allocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocationInfo.allocationSize = memoryRequirements.size;
-		allocationInfo.memoryTypeIndex = FindMemoryType(memoryRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device.Get(), &allocationInfo, nullptr, &memory) != VK_SUCCESS) 
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateBuffer(createInfo, memoryRequest, buffer, memory) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to allocate buffer memory!");
 		}
 
-		vkBindBufferMemory(device.Get(), buffer, memory, 0);
-
-     	// Map the buffer so we can write on it as needed.
-		vkMapMemory(device.Get(), memory, 0, allocationInfo.allocationSize, 0, mappedMemory);
+		// Host visible memory stays mapped, so we can write on it as needed.
+		*mappedMemory = memory.mapped;
 	}
 
 	void PhongShading::CreateUniformBuffers()
@@ -845,16 +847,7 @@ namespace BadgerSandbox
 		{
 			CreateBuffer(vBuffer.buffer, vBuffer.memory, &vBuffer.mapped, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(vertexData), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 			std::memcpy(vBuffer.mapped, vertexData, sizeof(vertexData));
-			VkMappedMemoryRange flushRange =
-			{
-			  VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,            // VkStructureType        sType
-			  nullptr,                                          // const void            *pNext
-			  vBuffer.memory,                                   // VkDeviceMemory         memory
-			  0,                                                // VkDeviceSize           offset
-			  VK_WHOLE_SIZE                                     // VkDeviceSize           size
-			};
-			vkFlushMappedMemoryRanges(device.Get(), 1, &flushRange);
-			vkUnmapMemory(device.Get(), vBuffer.memory);
+			memoryAllocator->Flush(vBuffer.memory);
 		}
 	}
 
@@ -933,20 +926,12 @@ namespace BadgerSandbox
 		{
 		  {
 			0,                                                          // uint32_t                                       binding
-			sizeof(vkglTF::Model::Vertex),                              // uint32_t                                       stride
+			vkglTF::Model::getVertexStride(NyotenguVertexLayout),       // uint32_t                                       stride
 			VK_VERTEX_INPUT_RATE_VERTEX                                 // VkVertexInputRate                              inputRate
 		  }
 		};
 
-		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions =
-		{
-		  {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
-		  {1, 0, VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3},
-		  {2, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 6},
-		  {3, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 8},
-		  {4, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 10},
-		  {5, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 14}
-		};
+		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions = vkglTF::Model::getVertexInputAttributes(NyotenguVertexLayout);
 
 		VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {
 		  VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,      // VkStructureType                                sType
@@ -1106,30 +1091,124 @@ namespace BadgerSandbox
 		graphicsPipeline.Reset(device.Get(), newCache, pipelineCreateInfo);
 	}
 
-	void PhongShading::CreateJustInTimeFramebuffer(RapidVulkan::Framebuffer& framebuffer, const RapidVulkan::ImageView& imageView)
+	void PhongShading::CreateFramebuffers()
+	{
+		framebuffers.resize(swapchainImageViews.size());
+		for (size_t i = 0; i < swapchainImageViews.size(); ++i)
+		{
+			std::array<VkImageView, 2> attachments =
+			{
+					swapchainImageViews[i].Get(),
+					depthImageView
+			};
+			VkFramebufferCreateInfo framebufferCreateInfo =
+			{
+			  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
+			  nullptr,                                        // const void                    *pNext
+			  0,                                              // VkFramebufferCreateFlags       flags
+			  renderPass.Get(),                               // VkRenderPass                   renderPass
+			  attachments.size(),                             // uint32_t                       attachmentCount
+			  attachments.data(),                             // const VkImageView             *pAttachments
+			  swapchainExtent.width,                          // uint32_t                       width
+			  swapchainExtent.height,                         // uint32_t                       height
+			  1                                               // uint32_t                       layers
+			};
+
+			framebuffers[i].Reset(device.Get(), framebufferCreateInfo);
+		}
+	}
+
+	void PhongShading::RecreateSwapchain()
+	{
+		std::array<uint32_t, 2> windowSize = window->GetWindowSize();
+		if ((windowSize[0] == 0) || (windowSize[1] == 0))
+		{
+			// Minimized, there is nothing to present to until the window comes back
+			return;
+		}
+
+		vkDeviceWaitIdle(device.Get());
+		framebuffers.clear();
+		DestroyDepthImage();
+		swapchainImageViews.clear();
+		swapchain.Reset();
+
+		CreateSwapchain();
+		CreateSwapchainImageViews();
+		CreateDepthImage();
+		CreateFramebuffers();
+		++swapchainVersion;
+	}
+
+	void PhongShading::RecordSceneCommandBuffer(const size_t& resourceIndex)
 	{
-		std::array<VkImageView, 2> attachments =
+		VkCommandBufferInheritanceInfo inheritanceInfo =
 		{
-				imageView.Get(),
-				depthImageView
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,  // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  renderPass.Get(),                                   // VkRenderPass                           renderPass
+		  0,                                                  // uint32_t                               subpass
+		  VK_NULL_HANDLE,                                     // VkFramebuffer                          framebuffer
+		  VK_FALSE,                                           // VkBool32                               occlusionQueryEnable
+		  0,                                                  // VkQueryControlFlags                    queryFlags
+		  0                                                   // VkQueryPipelineStatisticFlags          pipelineStatistics
 		};
-		VkFramebufferCreateInfo framebufferCreateInfo =
+		VkCommandBufferBeginInfo commandBufferBeginInfo =
 		{
-		  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
-		  nullptr,                                        // const void                    *pNext
-		  0,                                              // VkFramebufferCreateFlags       flags
-		  renderPass.Get(),                               // VkRenderPass                   renderPass
-		  attachments.size(),                             // uint32_t                       attachmentCount
-		  attachments.data(),                             // const VkImageView             *pAttachments
-		  swapchainExtent.width,                          // uint32_t                       width
-		  swapchainExtent.height,                         // uint32_t                       height
-		  1                                               // uint32_t                       layers
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,        // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,   // VkCommandBufferUsageFlags              flags
+		  &inheritanceInfo                                    // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
 		};
+		VkCommandBuffer commandBuffer = sceneCommandBuffers[resourceIndex];
+		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.Get());
 
-		framebuffer.Reset(device.Get(), framebufferCreateInfo);
+		VkViewport viewport =
+		{
+		  0.0f,                                               // float                                  x
+		  0.0f,                                               // float                                  y
+		  static_cast<float>(swapchainExtent.width),          // float                                  width
+		  static_cast<float>(swapchainExtent.height),         // float                                  height
+		  0.0f,                                               // float                                  minDepth
+		  1.0f                                                // float                                  maxDepth
+		};
+
+		VkRect2D scissor = {
+		  {                                                   // VkOffset2D                             offset
+			0,                                                  // int32_t                                x
+			0                                                   // int32_t                                y
+		  },
+		  {                                                   // VkExtent2D                             extent
+			swapchainExtent.width,                              // uint32_t                               width
+			swapchainExtent.height                             // uint32_t                               height
+		  }
+		};
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		
+		VkDeviceSize offset = 0;
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
+			&(descriptorSets[resourceIndex]), 0, nullptr);
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &NyotenguModel.vertices.buffer, &offset);
+		if (NyotenguModel.indices.buffer != VK_NULL_HANDLE)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, NyotenguModel.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+		}
+		for (auto node : NyotenguModel.nodes)
+		{
+			RenderNode(*node, resourceIndex, commandBuffer, pipelineLayout, NyotenguCuller);
+		}
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			std::cout << "Could not record scene command buffer!" << std::endl;
+		}
 	}
 
-	void PhongShading::RecordJustInTimeCommandBuffers(const size_t& resourceIndex)
+	void PhongShading::RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex)
 	{
 		VkCommandBufferBeginInfo commandBufferBeginInfo =
 		{
@@ -1159,7 +1238,7 @@ namespace BadgerSandbox
 		  VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,           // VkStructureType                        sType
 		  nullptr,                                            // const void                            *pNext
 		  renderPass.Get(),                                   // VkRenderPass                           renderPass
-		  framebuffers[resourceIndex].Get(),                  // VkFramebuffer                          framebuffer
+		  framebuffers[imageIndex].Get(),                     // VkFramebuffer                          framebuffer
 		  {                                                   // VkRect2D                               renderArea
 			{                                                 // VkOffset2D                             offset
 			  0,                                              // int32_t                                x
@@ -1182,6 +1261,9 @@ namespace BadgerSandbox
 		MVPMatrix = projectionMatrix * viewMatrix * modelMatrix;
 		normalMatrix = modelViewMatrix;
 
+		// The vertex shader applies MVPMatrix to the raw vertex positions, so its frustum is in model space.
+		NyotenguCuller.Cull(Frustum(glm::value_ptr(MVPMatrix)));
+
 		uniformBuffer currentUniformBuffer = matrixUniformBuffers[resourceIndex];
 		float* memory = (float*)currentUniformBuffer.mapped;
 		memcpy((void*)memory, glm::value_ptr(normalMatrix), sizeof(glm::mat4));
@@ -1198,49 +1280,17 @@ namespace BadgerSandbox
 		memory += sizeof(glm::vec4) / sizeof(float);
 		memcpy((void*)memory, glm::value_ptr(lightIntensity), sizeof(glm::mat4));
 
-		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		vkCmdBindPipeline(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.Get());
-
-		VkViewport viewport =
+		// The scene is only recorded again when culling or a new swapchain changed what it draws
+		uint64_t sceneVersion = swapchainVersion + NyotenguCuller.VisibilityVersion();
+		if (recordedSceneVersions[resourceIndex] != sceneVersion)
 		{
-		  0.0f,                                               // float                                  x
-		  0.0f,                                               // float                                  y
-		  static_cast<float>(swapchainExtent.width),          // float                                  width
-		  static_cast<float>(swapchainExtent.height),         // float                                  height
-		  0.0f,                                               // float                                  minDepth
-		  1.0f                                                // float                                  maxDepth
-		};
-
-		VkRect2D scissor = {
-		  {                                                   // VkOffset2D                             offset
-			0,                                                  // int32_t                                x
-			0                                                   // int32_t                                y
-		  },
-		  {                                                   // VkExtent2D                             extent
-			swapchainExtent.width,                              // uint32_t                               width
-			swapchainExtent.height                             // uint32_t                               height
-		  }
-		};
-
-		vkCmdSetViewport(commandBuffers[resourceIndex], 0, 1, &viewport);
-		vkCmdSetScissor(commandBuffers[resourceIndex], 0, 1, &scissor);
-		
-		VkDeviceSize offset = 0;
-		vkCmdBindDescriptorSets(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
-			&(descriptorSets[resourceIndex]), 0, nullptr);
-		vkCmdBindVertexBuffers(commandBuffers[resourceIndex], 0, 1, &NyotenguModel.vertices.buffer, &offset);
-		if (NyotenguModel.indices.buffer != VK_NULL_HANDLE)
-		{
-			vkCmdBindIndexBuffer(commandBuffers[resourceIndex], NyotenguModel.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			RecordSceneCommandBuffer(resourceIndex);
+			recordedSceneVersions[resourceIndex] = sceneVersion;
 		}
-		for (auto node : NyotenguModel.nodes)
-		{
-			RenderNode(*node, resourceIndex, commandBuffers[resourceIndex], pipelineLayout);
-		}
-		
-		
 
+		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		VkCommandBuffer sceneCommandBuffer = sceneCommandBuffers[resourceIndex];
+		vkCmdExecuteCommands(commandBuffers[resourceIndex], 1, &sceneCommandBuffer);
 		vkCmdEndRenderPass(commandBuffers[resourceIndex]);
 
 		if (vkEndCommandBuffer(commandBuffers[resourceIndex]) != VK_SUCCESS)
@@ -1258,11 +1308,16 @@ namespace BadgerSandbox
 		{
 			std::cout << "Waiting for fence takes too long!" << std::endl;
 		}
-		vkResetFences(device.Get(), 1, &fences[resourceIndex]);
 
-		vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
-		CreateJustInTimeFramebuffer(framebuffers[resourceIndex], swapchainImageViews[imageIndex]);
-		RecordJustInTimeCommandBuffers(resourceIndex);
+		VkResult result = vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// The fence stays signaled, nothing was submitted for this resource
+			RecreateSwapchain();
+			return;
+		}
+		vkResetFences(device.Get(), 1, &fences[resourceIndex]);
+		RecordJustInTimeCommandBuffers(resourceIndex, imageIndex);
 
 		std::vector<VkCommandBuffer> commandBuffers = graphicsCommandBuffers.Get();
 
@@ -1297,9 +1352,14 @@ namespace BadgerSandbox
 		  nullptr                                                 // VkResult                    *pResults
 		};
 
-		vkQueuePresentKHR(queue, &presentInfo);
+		result = vkQueuePresentKHR(queue, &presentInfo);
 
 		resourceIndex = (resourceIndex + 1) % renderResourcesCount;
+
+		if ((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR))
+		{
+			RecreateSwapchain();
+		}
 	}
 
 	void PhongShading::RotateHorizontal(float angle)
@@ -1330,6 +1390,7 @@ namespace BadgerSandbox
 
 	PhongShading::PhongShading()
 		: renderResourcesCount(3)
+		, swapchainVersion(0)
 		, suitablePhysicalDeviceIndex(0xFFFFFFFF)
 		, suitableQueueFamilyIndex(0xFFFFFFFF)
 		, up(0.0f, 1.0f, 0.0f)
@@ -1338,12 +1399,6 @@ namespace BadgerSandbox
 	    , initialUp(0.0f, 1.0f, 0.0f)
 	    , initialEyeLocation(0.0f, 0.0f, 2.0f)
 	    , initialEyeDirection(0.0f, 0.0f, 0.0f)
-		, leftPlane({0, 0, 0, 0})
-		, rightPlane({ 0, 0, 0, 0 })
-		, bottomPlane({ 0, 0, 0, 0 })
-		, topPlane({ 0, 0, 0, 0 })
-		, nearPlane({ 0, 0, 0, 0 })
-		, farPlane({ 0, 0, 0, 0 })
 	{
 		WindowFactory windowFactory;
 		window = windowFactory.Create(std::array<uint32_t, 2>{1920, 1080}, std::array<uint32_t, 2>{0, 0}, std::string{ "Vector Testing" });
@@ -1358,12 +1413,14 @@ namespace BadgerSandbox
 			CreateInstance();
 			CreateSurface();
 			CreateLogicalDevice();
+			CreateMemoryAllocator();
 			CreateSemaphores();
 			CreateFences();
 			CreateSwapchain();
 			CreateRenderPass();
 			CreateSwapchainImageViews();
 			CreateDepthImage();
+			CreateFramebuffers();
 			CreateGraphicsCommandsBuffers();
 			CreateDescriptorSetLayout();
 			CreateDescriptorPool();
@@ -1373,7 +1430,9 @@ namespace BadgerSandbox
 			CreateVertexBuffer();
 			CreateGraphicsPipeline();
 			std::string modelPath(std::string(PHONG_PROJECT_CONTENT) + "Nyotengu.gltf");
-			NyotenguModel.loadFromFile(modelPath, selectedPhysicalDevice, device.Get(), queue, graphicsCommandPool.Get(), 1.0f);
+			NyotenguModel.vertexLayout = NyotenguVertexLayout;
+			NyotenguModel.loadFromFile(modelPath, selectedPhysicalDevice, device.Get(), *memoryAllocator, queue, graphicsCommandPool.Get(), 1.0f);
+			RegisterPrimitiveBounds(NyotenguModel, NyotenguCuller);
 		}
 		catch (std::exception& e)
 		{
@@ -17,6 +17,7 @@
 #include <RapidVulkan/CommandPool.hpp>
 #include <RapidVulkan/CommandBuffers.hpp>
 #include "IWindow.hpp"
+#include "DeviceMemoryAllocator.hpp"
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -28,7 +29,7 @@ namespace BadgerSandbox
     struct uniformBuffer
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocation memory;
         VkDescriptorBufferInfo decriptor = {};
         void* mapped = nullptr;
     };
@@ -36,7 +37,7 @@ namespace BadgerSandbox
     struct vertexBuffer
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocation memory;
         void* mapped = nullptr;
     };
 
@@ -55,6 +56,9 @@ namespace BadgerSandbox
         RapidVulkan::Device device;
         uint32_t suitableQueueFamilyIndex;
         VkQueue queue;
+        // Buffers and images are sub-allocated from here. Declared after the device so it releases its memory
+        // before the device is destroyed.
+        std::unique_ptr<DeviceMemoryAllocator> memoryAllocator;
 
         VkSurfaceKHR surface;
         VkSurfaceFormatKHR selectedSurfaceFormat;
@@ -63,7 +67,10 @@ namespace BadgerSandbox
 
         RapidVulkan::RenderPass renderPass;
         std::vector<RapidVulkan::ImageView> swapchainImageViews;
+        // One per swapchain image, only rebuilt when the swapchain is
         std::vector<RapidVulkan::Framebuffer> framebuffers;
+        // Bumped whenever the swapchain is recreated
+        uint64_t swapchainVersion;
 
         std::vector<RapidVulkan::Semaphore> imageAvailable;
         std::vector<RapidVulkan::Semaphore> renderingFinished;
@@ -78,6 +85,10 @@ namespace BadgerSandbox
 
         RapidVulkan::CommandPool graphicsCommandPool;
         RapidVulkan::CommandBuffers graphicsCommandBuffers;
+        // The scene draws of each render resource, recorded once and executed from the primary command buffer
+        // every frame until the culling results or the swapchain change
+        RapidVulkan::CommandBuffers sceneCommandBuffers;
+        std::vector<uint64_t> recordedSceneVersions;
 
         std::vector<vertexBuffer> vertexBuffers;
 
@@ -85,7 +96,7 @@ namespace BadgerSandbox
         std::vector<VkFence> fences;
 
         VkImage depthImage;
-        VkDeviceMemory depthImageMemory;
+        MemoryAllocation depthImageMemory;
         VkImageView depthImageView;
 
         VkDescriptorSetLayout dsLayout;
@@ -113,17 +124,9 @@ namespace BadgerSandbox
         glm::vec3 initialEyeLocation;
         glm::vec3 initialEyeDirection;
 
-        std::array<float, 4> leftPlane;
-        std::array<float, 4> rightPlane;
-        
-        std::array<float, 4> bottomPlane;
-        std::array<float, 4> topPlane;
-
-        std::array<float, 4> nearPlane;
-        std::array<float, 4> farPlane;
-
         void AllocateDescriptorSet();
         void CreateDepthImage();
+        void DestroyDepthImage();
         void CreateDescriptorPool();
         void CreateDescriptorSetLayout();
         void CreateFences();
@@ -131,20 +134,22 @@ namespace BadgerSandbox
         void CreateGraphicsPipeline();
         void CreateImageView(const VkImage& image, VkImageView& imageView);
         VkImageView CreateImageViewVulkanTutorial(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory);
         void CreateInstance();
-        void CreateJustInTimeFramebuffer(RapidVulkan::Framebuffer& framebuffer, const RapidVulkan::ImageView& imageView);
+        void CreateFramebuffers();
         void CreateLogicalDevice();
+        void CreateMemoryAllocator();
         void CreateRenderPass();
         void CreateSemaphores();
         void CreateSurface();
         void CreateSwapchain();
         void CreateSwapchainImageViews();
         VkFormat FindDepthFormat();
-        uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex);
-        void CreateBuffer(VkBuffer &buffer, VkDeviceMemory& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties);
+        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex);
+        void RecordSceneCommandBuffer(const size_t& resourceIndex);
+        void RecreateSwapchain();
+        void CreateBuffer(VkBuffer &buffer, MemoryAllocation& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties);
         void CreateUniformBuffers();
         void CreateVertexBuffer();
         void UpdateDescriptorSet();
@@ -1,7 +1,6 @@
 #version 450
 
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
 
 layout(std140, binding = 0) uniform UBO
 {
@@ -1,17 +1,26 @@
 #include <fstream>
 #include <iostream>
 #include <array>
+#include <chrono>
 #include "WindowFactory.hpp"
 #include "ShadowMapping.hpp"
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
 #include "VulkanglTFModel.hpp"
+#include "FrustumCuller.hpp"
 
 namespace BadgerSandbox
 {
 	vkglTF::Model NyotenguModel;
 	vkglTF::Model NyotenguModel_Ground;
+	// Both models are drawn with the same pipelines and none of the shaders read skin attributes
+	const vkglTF::VertexLayout SceneVertexLayout = vkglTF::VertexLayout::CompactStatic;
+	// The shadow pass reads positions only, so it fetches them from their own tightly packed stream.
+	const vkglTF::VertexStreams SceneVertexStreams = vkglTF::VertexStreams::Split;
+	// The shadow pass culls against the light frustum, the final pass against the camera frustum.
+	FrustumCuller NyotenguShadowCuller;
+	FrustumCuller NyotenguGroundCuller;
 
 	// Depth bias (and slope) are used to avoid shadowing artifacts
 // Constant depth bias factor (always applied)
@@ -19,27 +28,69 @@ namespace BadgerSandbox
 	// Slope depth bias factor, applied depending on polygon's slope
 	float depthBiasSlope = 3.5f;
 
-	void RenderNode(const vkglTF::Node& node, uint32_t cbIndex, VkCommandBuffer cmdBuffer, VkPipelineLayout pipelineLayout)
+	// Registers the model-space bounds of every primitive so they can be culled before recording.
+	void RegisterPrimitiveBounds(const vkglTF::Model& model, FrustumCuller& culler)
+	{
+		culler.Clear();
+		for (const vkglTF::Node* node : model.linearNodes)
+		{
+			if (!node->mesh)
+			{
+				continue;
+			}
+			for (const vkglTF::Primitive* primitive : node->mesh->primitives)
+			{
+				if (primitive->bb.valid)
+				{
+					culler.Add(primitive,
+						Vector3D(primitive->bb.min.x, primitive->bb.min.y, primitive->bb.min.z),
+						Vector3D(primitive->bb.max.x, primitive->bb.max.y, primitive->bb.max.z));
+				}
+			}
+		}
+	}
+
+	// Returns whether a streamed model can be drawn, registering its bounds on the first frame its upload
+	// is seen complete.
+	bool PollStreamedModel(vkglTF::Model& model, FrustumCuller& culler)
+	{
+		if (model.uploadComplete)
+		{
+			return true;
+		}
+		if (!model.pollUpload())
+		{
+			return false;
+		}
+		RegisterPrimitiveBounds(model, culler);
+		return true;
+	}
+
+	void RenderNode(const vkglTF::Node& node, uint32_t cbIndex, VkCommandBuffer cmdBuffer, VkPipelineLayout pipelineLayout, const FrustumCuller& culler)
 	{
 		if (node.mesh)
 		{
 			// Render mesh primitives
 			for (vkglTF::Primitive* primitive : node.mesh->primitives)
 			{
+				if (!culler.IsVisible(primitive))
+				{
+					continue;
+				}
 				if (primitive->hasIndices)
 				{
-					vkCmdDrawIndexed(cmdBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+					vkCmdDrawIndexed(cmdBuffer, primitive->indexCount, 1, primitive->firstIndex, primitive->vertexOffset, 0);
 				}
 				else
 				{
-					vkCmdDraw(cmdBuffer, primitive->vertexCount, 1, 0, 0);
+					vkCmdDraw(cmdBuffer, primitive->vertexCount, 1, static_cast<uint32_t>(primitive->vertexOffset), 0);
 				}
 			}
 
 		};
 		for (auto child : node.children)
 		{
-			RenderNode(*child, cbIndex, cmdBuffer, pipelineLayout);
+			RenderNode(*child, cbIndex, cmdBuffer, pipelineLayout, culler);
 		}
 	}
 
@@ -599,31 +650,25 @@ namespace BadgerSandbox
 		}
 	}
 
-	/*
-  Took this function from VulkanTutorial:
-  https://vulkan-tutorial.com/
-*/
-	uint32_t ShadowMapping::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	void ShadowMapping::CreateMemoryAllocator()
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memProperties);
-
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-		{
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-			{
-				return i;
-			}
-		}
+		memoryAllocator.reset(new DeviceMemoryAllocator(selectedPhysicalDevice, device.Get()));
+	}
 
-		throw std::runtime_error("failed to find suitable memory type!");
+	// Both models have a little under 100K vertices and indices each
+	void ShadowMapping::CreateGeometryPool()
+	{
+		const uint32_t vertexCapacity = 512 * 1024;
+		const uint32_t indexCapacity = 512 * 1024;
+		geometryPool.reset(new GeometryPool(*memoryAllocator, vkglTF::Model::getVertexBufferStride(SceneVertexLayout, SceneVertexStreams),
+			vkglTF::Model::getPositionBufferStride(SceneVertexStreams), vertexCapacity, indexCapacity));
 	}
 
 	/*
 	  Took this function from VulkanTutorial:
 	  https://vulkan-tutorial.com/
 	*/
-	void ShadowMapping::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	void ShadowMapping::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -640,23 +685,11 @@ namespace BadgerSandbox
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkCreateImage(device.Get(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateImage(imageInfo, memoryRequest, image, imageMemory) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image!");
 		}
-
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device.Get(), image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device.Get(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate image memory!");
-		}
-
-		vkBindImageMemory(device.Get(), image, imageMemory, 0);
 	}
 
 	/*
@@ -731,6 +764,13 @@ namespace BadgerSandbox
 		finalPass.depthImageView = CreateImageViewVulkanTutorial(finalPass.depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 	}
 
+	void ShadowMapping::DestroyDepthImage()
+	{
+		vkDestroyImageView(device.Get(), finalPass.depthImageView, nullptr);
+		finalPass.depthImageView = VK_NULL_HANDLE;
+		memoryAllocator->DestroyImage(finalPass.depthImage, finalPass.depthImageMemory);
+	}
+
 	void ShadowMapping::CreateShadowDepthImage()
 	{
 		shadowImages.resize(renderResourcesCount);
@@ -797,6 +837,12 @@ namespace BadgerSandbox
 
 		graphicsCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
 
+		commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		shadowSceneCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
+		sceneCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
+		recordedShadowSceneVersions.assign(renderResourcesCount, UINT64_MAX);
+		recordedSceneVersions.assign(renderResourcesCount, UINT64_MAX);
+
 		VkCommandBufferBeginInfo graphicsCommandBufferBeginInfo =
 		{
 		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,    // VkStructureType                        sType
@@ -816,8 +862,6 @@ namespace BadgerSandbox
 		VkClearValue clearValue = {
 		  { 1.0f, 0.8f, 0.4f, 0.0f },                     // VkClearColorValue              color
 		};
-
-		framebuffers.resize(renderResourcesCount);
 	}
 
 	void ShadowMapping::CreateDescriptorSetLayout()
@@ -944,7 +988,7 @@ namespace BadgerSandbox
 		}
 	}
 
-	void ShadowMapping::CreateBuffer(VkBuffer& buffer, VkDeviceMemory& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties)
+	void ShadowMapping::CreateBuffer(VkBuffer& buffer, MemoryAllocation& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties)
 	{
 		VkBufferCreateInfo createInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 		createInfo.usage = usage;
@@ -953,25 +997,15 @@ namespace BadgerSandbox
 		createInfo.queueFamilyIndexCount = 0;
 		createInfo.pQueueFamilyIndices = nullptr;
 
-		vkCreateBuffer(device.Get(), &createInfo, nullptr, &buffer);
-
-		VkMemoryRequirements memoryRequirements;
-		vkGetBufferMemoryRequirements(device.Get(), buffer, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocationInfo{};
-		allocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocationInfo.allocationSize = memoryRequirements.size;
-		allocationInfo.memoryTypeIndex = FindMemoryType(memoryRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device.Get(), &allocationInfo, nullptr, &memory) != VK_SUCCESS) 
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateBuffer(createInfo, memoryRequest, buffer, memory) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to allocate buffer memory!");
 		}
 
-		vkBindBufferMemory(device.Get(), buffer, memory, 0);
-
-     	// Map the buffer so we can write on it as needed.
-		vkMapMemory(device.Get(), memory, 0, allocationInfo.allocationSize, 0, mappedMemory);
+		// Host visible memory stays mapped, so we can write on it as needed.
+		*mappedMemory = memory.mapped;
 	}
 
 	void ShadowMapping::CreateUniformBuffers()
@@ -1131,24 +1165,9 @@ namespace BadgerSandbox
 		  }
 		};
 
-		std::vector<VkVertexInputBindingDescription> vertexInputBindingDescriptions =
-		{
-		  {
-			0,                                                          // uint32_t                                       binding
-			sizeof(vkglTF::Model::Vertex),                              // uint32_t                                       stride
-			VK_VERTEX_INPUT_RATE_VERTEX                                 // VkVertexInputRate                              inputRate
-		  }
-		};
+		std::vector<VkVertexInputBindingDescription> vertexInputBindingDescriptions = vkglTF::Model::getVertexInputBindings(SceneVertexLayout, SceneVertexStreams);
 
-		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions =
-		{
-		  {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
-		  {1, 0, VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3},
-		  {2, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 6},
-		  {3, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 8},
-		  {4, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 10},
-		  {5, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 14}
-		};
+		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions = vkglTF::Model::getVertexInputAttributes(SceneVertexLayout, SceneVertexStreams);
 
 		VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {
 		  VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,      // VkStructureType                                sType
@@ -1310,7 +1329,7 @@ namespace BadgerSandbox
 
 	void ShadowMapping::CreateShadowPipeline()
 	{
-		std::string vertexShaderPath(std::string(SHADOW_MAPPING_PROJECT_CONTENT) + "ShadowVert.spv");
+		std::string vertexShaderPath(std::string(SHADOW_MAPPING_PROJECT_SHADERS) + "ShadowVert.spv");
 		std::ifstream vertexShaderIs(vertexShaderPath, std::ios::binary);
 
 		if (vertexShaderIs.fail())
@@ -1348,24 +1367,9 @@ namespace BadgerSandbox
 		  }
 		};
 
-		std::vector<VkVertexInputBindingDescription> vertexInputBindingDescriptions =
-		{
-		  {
-			0,                                                          // uint32_t                                       binding
-			sizeof(vkglTF::Model::Vertex),                              // uint32_t                                       stride
-			VK_VERTEX_INPUT_RATE_VERTEX                                 // VkVertexInputRate                              inputRate
-		  }
-		};
+		std::vector<VkVertexInputBindingDescription> vertexInputBindingDescriptions = vkglTF::Model::getDepthInputBindings(SceneVertexLayout, SceneVertexStreams);
 
-		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions =
-		{
-		  {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
-		  {1, 0, VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3},
-		  {2, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 6},
-		  {3, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 8},
-		  {4, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 10},
-		  {5, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 14}
-		};
+		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions = vkglTF::Model::getDepthInputAttributes();
 
 		VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {
 		  VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,      // VkStructureType                                sType
@@ -1517,49 +1521,218 @@ namespace BadgerSandbox
 		shadowPass.graphicsPipeline.Reset(device.Get(), newCache, pipelineCreateInfo);
 	}
 
-	void ShadowMapping::CreateJustInTimeFramebuffer(RapidVulkan::Framebuffer& framebuffer, const RapidVulkan::ImageView& imageView)
+	void ShadowMapping::CreateFramebuffers()
+	{
+		framebuffers.resize(swapchainImageViews.size());
+		for (size_t i = 0; i < swapchainImageViews.size(); ++i)
+		{
+			std::array<VkImageView, 2> attachments =
+			{
+					swapchainImageViews[i].Get(),
+					finalPass.depthImageView
+			};
+			VkFramebufferCreateInfo framebufferCreateInfo =
+			{
+			  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
+			  nullptr,                                        // const void                    *pNext
+			  0,                                              // VkFramebufferCreateFlags       flags
+			  renderPass.Get(),                               // VkRenderPass                   renderPass
+			  attachments.size(),                             // uint32_t                       attachmentCount
+			  attachments.data(),                             // const VkImageView             *pAttachments
+			  swapchainExtent.width,                          // uint32_t                       width
+			  swapchainExtent.height,                         // uint32_t                       height
+			  1                                               // uint32_t                       layers
+			};
+
+			framebuffers[i].Reset(device.Get(), framebufferCreateInfo);
+		}
+	}
+
+	void ShadowMapping::CreateShadowFramebuffers()
+	{
+		for (auto& image : shadowImages)
+		{
+			VkImageView attachment = image.imageView;
+			VkFramebufferCreateInfo framebufferCreateInfo =
+			{
+			  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
+			  nullptr,                                        // const void                    *pNext
+			  0,                                              // VkFramebufferCreateFlags       flags
+			  shadowRenderPass.Get(),                         // VkRenderPass                   renderPass
+			  1,                                              // uint32_t                       attachmentCount
+			  &attachment,                                    // const VkImageView             *pAttachments
+			  1024,                                           // uint32_t                       width
+			  1024,                                           // uint32_t                       height
+			  1                                               // uint32_t                       layers
+			};
+
+			image.framebuffer.Reset(device.Get(), framebufferCreateInfo);
+		}
+	}
+
+	void ShadowMapping::RecreateSwapchain()
 	{
-		std::array<VkImageView, 2> attachments =
+		std::array<uint32_t, 2> windowSize = window->GetWindowSize();
+		if ((windowSize[0] == 0) || (windowSize[1] == 0))
+		{
+			// Minimized, there is nothing to present to until the window comes back
+			return;
+		}
+
 		{
-				imageView.Get(),
-				finalPass.depthImageView
+			std::lock_guard<std::mutex> queueLock(queueMutex);
+			vkDeviceWaitIdle(device.Get());
+		}
+		framebuffers.clear();
+		DestroyDepthImage();
+		swapchainImageViews.clear();
+		swapchain.Reset();
+
+		CreateSwapchain();
+		CreateSwapchainImageViews();
+		CreateDepthImage();
+		CreateFramebuffers();
+		++swapchainVersion;
+	}
+
+	void ShadowMapping::RecordShadowSceneCommandBuffer(const size_t& resourceIndex)
+	{
+		VkCommandBufferInheritanceInfo inheritanceInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,  // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  shadowRenderPass.Get(),                             // VkRenderPass                           renderPass
+		  0,                                                  // uint32_t                               subpass
+		  VK_NULL_HANDLE,                                     // VkFramebuffer                          framebuffer
+		  VK_FALSE,                                           // VkBool32                               occlusionQueryEnable
+		  0,                                                  // VkQueryControlFlags                    queryFlags
+		  0                                                   // VkQueryPipelineStatisticFlags          pipelineStatistics
 		};
-		VkFramebufferCreateInfo framebufferCreateInfo =
+		VkCommandBufferBeginInfo commandBufferBeginInfo =
 		{
-		  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
-		  nullptr,                                        // const void                    *pNext
-		  0,                                              // VkFramebufferCreateFlags       flags
-		  renderPass.Get(),                               // VkRenderPass                   renderPass
-		  attachments.size(),                             // uint32_t                       attachmentCount
-		  attachments.data(),                             // const VkImageView             *pAttachments
-		  swapchainExtent.width,                          // uint32_t                       width
-		  swapchainExtent.height,                         // uint32_t                       height
-		  1                                               // uint32_t                       layers
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,        // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,   // VkCommandBufferUsageFlags              flags
+		  &inheritanceInfo                                    // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
 		};
+		VkCommandBuffer commandBuffer = shadowSceneCommandBuffers[resourceIndex];
+		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowPass.graphicsPipeline.Get());
 
-		framebuffer.Reset(device.Get(), framebufferCreateInfo);
+		VkViewport shadowViewport =
+		{
+		  0.0f,                                               // float                                  x
+		  0.0f,                                               // float                                  y
+		  1024.0f,                                            // float                                  width
+		  1024.0f,                                            // float                                  height
+		  0.0f,                                               // float                                  minDepth
+		  1.0f                                                // float                                  maxDepth
+		};
+
+		VkRect2D shadowScissor = {
+		  {                                                   // VkOffset2D                             offset
+			0,                                                  // int32_t                                x
+			0                                                   // int32_t                                y
+		  },
+		  {                                                   // VkExtent2D                             extent
+			1024,                                             // uint32_t                               width
+			1024                                              // uint32_t                               height
+		  }
+		};
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &shadowViewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &shadowScissor);
+		vkCmdSetDepthBias(
+			commandBuffer,
+			depthBiasConstant,
+			0.0f,
+			depthBiasSlope);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowPass.pipelineLayout, 0, 1,
+			&(shadowPass.descriptorSets[resourceIndex]), 0, nullptr);
+		if (NyotenguModel.uploadComplete)
+		{
+			NyotenguModel.bindBuffers(commandBuffer, true);
+			for (auto node : NyotenguModel.nodes)
+			{
+				RenderNode(*node, resourceIndex, commandBuffer, shadowPass.pipelineLayout, NyotenguShadowCuller);
+			}
+		}
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			std::cout << "Could not record shadow scene command buffer!" << std::endl;
+		}
 	}
 
-	void ShadowMapping::CreateJustInTimeShadowFramebuffer(RapidVulkan::Framebuffer& framebuffer, const VkImageView& imageView)
+	void ShadowMapping::RecordSceneCommandBuffer(const size_t& resourceIndex)
 	{
-		VkImageView attachment = imageView;
-		VkFramebufferCreateInfo framebufferCreateInfo =
+		VkCommandBufferInheritanceInfo inheritanceInfo =
 		{
-		  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
-		  nullptr,                                        // const void                    *pNext
-		  0,                                              // VkFramebufferCreateFlags       flags
-		  shadowRenderPass.Get(),                               // VkRenderPass                   renderPass
-		  1,                                              // uint32_t                       attachmentCount
-		  &attachment,                                    // const VkImageView             *pAttachments
-		  1024,                          // uint32_t                       width
-		  1024,                         // uint32_t                       height
-		  1                                               // uint32_t                       layers
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,  // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  renderPass.Get(),                                   // VkRenderPass                           renderPass
+		  0,                                                  // uint32_t                               subpass
+		  VK_NULL_HANDLE,                                     // VkFramebuffer                          framebuffer
+		  VK_FALSE,                                           // VkBool32                               occlusionQueryEnable
+		  0,                                                  // VkQueryControlFlags                    queryFlags
+		  0                                                   // VkQueryPipelineStatisticFlags          pipelineStatistics
+		};
+		VkCommandBufferBeginInfo commandBufferBeginInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,        // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,   // VkCommandBufferUsageFlags              flags
+		  &inheritanceInfo                                    // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
+		};
+		VkCommandBuffer commandBuffer = sceneCommandBuffers[resourceIndex];
+		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, finalPass.graphicsPipeline.Get());
+
+		VkViewport viewport =
+		{
+		  0.0f,                                               // float                                  x
+		  0.0f,                                               // float                                  y
+		  static_cast<float>(swapchainExtent.width),          // float                                  width
+		  static_cast<float>(swapchainExtent.height),         // float                                  height
+		  0.0f,                                               // float                                  minDepth
+		  1.0f                                                // float                                  maxDepth
+		};
+
+		VkRect2D scissor = {
+		  {                                                   // VkOffset2D                             offset
+			0,                                                  // int32_t                                x
+			0                                                   // int32_t                                y
+		  },
+		  {                                                   // VkExtent2D                             extent
+			swapchainExtent.width,                              // uint32_t                               width
+			swapchainExtent.height                             // uint32_t                               height
+		  }
 		};
 
-		framebuffer.Reset(device.Get(), framebufferCreateInfo);
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, finalPass.pipelineLayout, 0, 1,
+			&(finalPass.descriptorSets[resourceIndex]), 0, nullptr);
+		if (NyotenguModel_Ground.uploadComplete)
+		{
+			NyotenguModel_Ground.bindBuffers(commandBuffer);
+			for (auto node : NyotenguModel_Ground.nodes)
+			{
+				RenderNode(*node, resourceIndex, commandBuffer, finalPass.pipelineLayout, NyotenguGroundCuller);
+			}
+		}
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			std::cout << "Could not record scene command buffer!" << std::endl;
+		}
 	}
 
-	void ShadowMapping::RecordJustInTimeCommandBuffers(const size_t& resourceIndex)
+	void ShadowMapping::RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex)
 	{
 		VkCommandBufferBeginInfo commandBufferBeginInfo =
 		{
@@ -1594,6 +1767,10 @@ namespace BadgerSandbox
 		  shadowClearValues.data()                                  // const VkClearValue                    *pClearValues
 		};
 
+		// A model whose upload just completed registers its bounds here, which has both passes recorded again
+		PollStreamedModel(NyotenguModel, NyotenguShadowCuller);
+		PollStreamedModel(NyotenguModel_Ground, NyotenguGroundCuller);
+
 		// Update UBOs
 		shadowPass.modelMatrix = glm::mat4(1.0f);
 		shadowPass.viewMatrix = glm::lookAt(/*shadowPass.eyeLocation*/glm::vec3(2.0f, 4.75f, 2.0f), shadowPass.eyeDirection, shadowPass.up);
@@ -1602,6 +1779,7 @@ namespace BadgerSandbox
 
 		shadowPass.modelViewMatrix = shadowPass.viewMatrix * shadowPass.modelMatrix;
 		shadowPass.MVPMatrix = shadowPass.projectionMatrix * shadowPass.viewMatrix * shadowPass.modelMatrix;
+		NyotenguShadowCuller.Cull(Frustum(glm::value_ptr(shadowPass.MVPMatrix)));
 		shadowPass.normalMatrix = shadowPass.modelViewMatrix;
 
 		uniformBuffer currentShadowUniformBuffer = shadowPass.matrixUniformBuffers[resourceIndex];
@@ -1612,51 +1790,17 @@ namespace BadgerSandbox
 		memory += sizeof(glm::mat4) / sizeof(float);
 		memcpy((void*)memory, glm::value_ptr(shadowPass.MVPMatrix), sizeof(glm::mat4));
 
-		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &shadowRenderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		vkCmdBindPipeline(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowPass.graphicsPipeline.Get());
-
-		VkViewport shadowViewport =
-		{
-		  0.0f,                                               // float                                  x
-		  0.0f,                                               // float                                  y
-		  1024.0f,                                            // float                                  width
-		  1024.0f,                                            // float                                  height
-		  0.0f,                                               // float                                  minDepth
-		  1.0f                                                // float                                  maxDepth
-		};
-
-		VkRect2D shadowScissor = {
-		  {                                                   // VkOffset2D                             offset
-			0,                                                  // int32_t                                x
-			0                                                   // int32_t                                y
-		  },
-		  {                                                   // VkExtent2D                             extent
-			1024,                                             // uint32_t                               width
-			1024                                              // uint32_t                               height
-		  }
-		};
-
-		vkCmdSetViewport(commandBuffers[resourceIndex], 0, 1, &shadowViewport);
-		vkCmdSetScissor(commandBuffers[resourceIndex], 0, 1, &shadowScissor);
-		vkCmdSetDepthBias(
-			commandBuffers[resourceIndex],
-			depthBiasConstant,
-			0.0f,
-			depthBiasSlope);
-
-		VkDeviceSize offset = 0;
-		vkCmdBindDescriptorSets(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowPass.pipelineLayout, 0, 1,
-			&(shadowPass.descriptorSets[resourceIndex]), 0, nullptr);
-		vkCmdBindVertexBuffers(commandBuffers[resourceIndex], 0, 1, &NyotenguModel.vertices.buffer, &offset);
-		if (NyotenguModel.indices.buffer != VK_NULL_HANDLE)
-		{
-			vkCmdBindIndexBuffer(commandBuffers[resourceIndex], NyotenguModel.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
-		}
-		for (auto node : NyotenguModel.nodes)
+		// The passes are only recorded again when culling, a streamed model or a new swapchain changed what they draw
+		uint64_t shadowSceneVersion = NyotenguShadowCuller.VisibilityVersion();
+		if (recordedShadowSceneVersions[resourceIndex] != shadowSceneVersion)
 		{
-			RenderNode(*node, resourceIndex, commandBuffers[resourceIndex], shadowPass.pipelineLayout);
+			RecordShadowSceneCommandBuffer(resourceIndex);
+			recordedShadowSceneVersions[resourceIndex] = shadowSceneVersion;
 		}
+
+		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &shadowRenderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		VkCommandBuffer shadowSceneCommandBuffer = shadowSceneCommandBuffers[resourceIndex];
+		vkCmdExecuteCommands(commandBuffers[resourceIndex], 1, &shadowSceneCommandBuffer);
 		vkCmdEndRenderPass(commandBuffers[resourceIndex]);
 
 		VkImageSubresourceRange imageSubresourceRange =
@@ -1691,7 +1835,7 @@ namespace BadgerSandbox
 		  VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,           // VkStructureType                        sType
 		  nullptr,                                            // const void                            *pNext
 		  renderPass.Get(),                                   // VkRenderPass                           renderPass
-		  framebuffers[resourceIndex].Get(),                  // VkFramebuffer                          framebuffer
+		  framebuffers[imageIndex].Get(),                     // VkFramebuffer                          framebuffer
 		  {                                                   // VkRect2D                               renderArea
 			{                                                 // VkOffset2D                             offset
 			  0,                                              // int32_t                                x
@@ -1712,6 +1856,7 @@ namespace BadgerSandbox
 		
 		finalPass.modelViewMatrix = finalPass.viewMatrix * finalPass.modelMatrix;
 		finalPass.MVPMatrix = finalPass.projectionMatrix * finalPass.viewMatrix * finalPass.modelMatrix;
+		NyotenguGroundCuller.Cull(Frustum(glm::value_ptr(finalPass.MVPMatrix)));
 		finalPass.normalMatrix = finalPass.modelViewMatrix;
 
 		uniformBuffer currentUniformBuffer = finalPass.matrixUniformBuffers[resourceIndex];
@@ -1732,49 +1877,16 @@ namespace BadgerSandbox
 		memory += sizeof(glm::vec4) / sizeof(float);
 		memcpy((void*)memory, glm::value_ptr(lightIntensity), sizeof(glm::mat4));
 
-		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		vkCmdBindPipeline(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, finalPass.graphicsPipeline.Get());
-
-		VkViewport viewport =
+		uint64_t sceneVersion = swapchainVersion + NyotenguGroundCuller.VisibilityVersion();
+		if (recordedSceneVersions[resourceIndex] != sceneVersion)
 		{
-		  0.0f,                                               // float                                  x
-		  0.0f,                                               // float                                  y
-		  static_cast<float>(swapchainExtent.width),          // float                                  width
-		  static_cast<float>(swapchainExtent.height),         // float                                  height
-		  0.0f,                                               // float                                  minDepth
-		  1.0f                                                // float                                  maxDepth
-		};
-
-		VkRect2D scissor = {
-		  {                                                   // VkOffset2D                             offset
-			0,                                                  // int32_t                                x
-			0                                                   // int32_t                                y
-		  },
-		  {                                                   // VkExtent2D                             extent
-			swapchainExtent.width,                              // uint32_t                               width
-			swapchainExtent.height                             // uint32_t                               height
-		  }
-		};
-
-		vkCmdSetViewport(commandBuffers[resourceIndex], 0, 1, &viewport);
-		vkCmdSetScissor(commandBuffers[resourceIndex], 0, 1, &scissor);
-		
-		offset = 0;
-		vkCmdBindDescriptorSets(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, finalPass.pipelineLayout, 0, 1,
-			&(finalPass.descriptorSets[resourceIndex]), 0, nullptr);
-		vkCmdBindVertexBuffers(commandBuffers[resourceIndex], 0, 1, &NyotenguModel_Ground.vertices.buffer, &offset);
-		if (NyotenguModel_Ground.indices.buffer != VK_NULL_HANDLE)
-		{
-			vkCmdBindIndexBuffer(commandBuffers[resourceIndex], NyotenguModel_Ground.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
-		}
-		for (auto node : NyotenguModel_Ground.nodes)
-		{
-			RenderNode(*node, resourceIndex, commandBuffers[resourceIndex], finalPass.pipelineLayout);
+			RecordSceneCommandBuffer(resourceIndex);
+			recordedSceneVersions[resourceIndex] = sceneVersion;
 		}
-		
-		
 
+		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		VkCommandBuffer sceneCommandBuffer = sceneCommandBuffers[resourceIndex];
+		vkCmdExecuteCommands(commandBuffers[resourceIndex], 1, &sceneCommandBuffer);
 		vkCmdEndRenderPass(commandBuffers[resourceIndex]);
 
 		if (vkEndCommandBuffer(commandBuffers[resourceIndex]) != VK_SUCCESS)
@@ -1797,16 +1909,32 @@ namespace BadgerSandbox
 		{
 			std::cout << "Waiting for fence takes too long!" << std::endl;
 		}
-		vkResetFences(device.Get(), 1, &fences[resourceIndex]);
-
-
-
 
+		// Report the models that failed to stream in, the others are picked up while recording
+		for (auto& load : modelLoads)
+		{
+			if (load.valid() && load.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			{
+				try
+				{
+					load.get();
+				}
+				catch (std::exception& e)
+				{
+					std::cout << e.what() << std::endl;
+				}
+			}
+		}
 
-		vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
-		CreateJustInTimeFramebuffer(framebuffers[resourceIndex], swapchainImageViews[imageIndex]);
-		CreateJustInTimeShadowFramebuffer(shadowImages[resourceIndex].framebuffer, shadowImages[resourceIndex].imageView);
-		RecordJustInTimeCommandBuffers(resourceIndex);
+		VkResult result = vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// The fence stays signaled, nothing was submitted for this resource
+			RecreateSwapchain();
+			return;
+		}
+		vkResetFences(device.Get(), 1, &fences[resourceIndex]);
+		RecordJustInTimeCommandBuffers(resourceIndex, imageIndex);
 
 		std::vector<VkCommandBuffer> commandBuffers = graphicsCommandBuffers.Get();
 
@@ -1824,6 +1952,8 @@ namespace BadgerSandbox
 		  renderingFinished[resourceIndex].GetPointer()                  // const VkSemaphore           *pSignalSemaphores
 		};
 
+		// The streaming workers submit their uploads to the same queue
+		std::unique_lock<std::mutex> queueLock(queueMutex);
 		if (vkQueueSubmit(queue, 1, &submitInfo, fences[resourceIndex]) != VK_SUCCESS)
 		{
 			std::cout << "Error while submitting queue" << std::endl;
@@ -1841,9 +1971,15 @@ namespace BadgerSandbox
 		  nullptr                                                 // VkResult                    *pResults
 		};
 
-		vkQueuePresentKHR(queue, &presentInfo);
+		result = vkQueuePresentKHR(queue, &presentInfo);
+		queueLock.unlock();
 
 		resourceIndex = (resourceIndex + 1) % renderResourcesCount;
+
+		if ((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR))
+		{
+			RecreateSwapchain();
+		}
 	}
 
 	void ShadowMapping::RotateHorizontal(float angle)
@@ -1876,6 +2012,7 @@ namespace BadgerSandbox
 		: renderResourcesCount(3)
 		, suitablePhysicalDeviceIndex(0xFFFFFFFF)
 		, suitableQueueFamilyIndex(0xFFFFFFFF)
+		, swapchainVersion(0)
 
 	{
 		WindowFactory windowFactory;
@@ -1903,6 +2040,8 @@ namespace BadgerSandbox
 			CreateInstance();
 			CreateSurface();
 			CreateLogicalDevice();
+			CreateMemoryAllocator();
+			CreateGeometryPool();
 			CreateSemaphores();
 			CreateFences();
 			CreateSwapchain();
@@ -1912,6 +2051,8 @@ namespace BadgerSandbox
 			CreateDepthImage();
 			CreateShadowDepthImage();
 			CreateShadowDepthImageSampler();
+			CreateFramebuffers();
+			CreateShadowFramebuffers();
 			CreateGraphicsCommandsBuffers();
 			CreateDescriptorSetLayout();
 			CreateShadowDescriptorSetLayout();
@@ -1926,9 +2067,24 @@ namespace BadgerSandbox
 			CreateGraphicsPipeline();
 			CreateShadowPipeline();
 			std::string modelPath(std::string(SHADOW_MAPPING_PROJECT_CONTENT) + "Nyotengu.gltf");
-			NyotenguModel.loadFromFile(modelPath, selectedPhysicalDevice, device.Get(), queue, graphicsCommandPool.Get(), 1.0f);
+			NyotenguModel.vertexLayout = SceneVertexLayout;
+			NyotenguModel_Ground.vertexLayout = SceneVertexLayout;
+			NyotenguModel.vertexStreams = SceneVertexStreams;
+			NyotenguModel_Ground.vertexStreams = SceneVertexStreams;
+			NyotenguModel.geometryPool = geometryPool.get();
+			NyotenguModel_Ground.geometryPool = geometryPool.get();
 			std::string modelPath2(std::string(SHADOW_MAPPING_PROJECT_CONTENT) + "NyotenguGround.gltf");
-			NyotenguModel_Ground.loadFromFile(modelPath2, selectedPhysicalDevice, device.Get(), queue, graphicsCommandPool.Get(), 1.0f);
+			// The models stream in on the loader pool, so the first frame does not wait for them. Each one is
+			// drawn from the first frame its upload fence has signalled.
+			vkglTF::setDevice(selectedPhysicalDevice, device.Get(), *memoryAllocator);
+			modelLoads.push_back(loaderPool.Submit([this, modelPath]()
+			{
+				NyotenguModel.streamFromFile(modelPath, queue, queueMutex, suitableQueueFamilyIndex, 1.0f);
+			}));
+			modelLoads.push_back(loaderPool.Submit([this, modelPath2]()
+			{
+				NyotenguModel_Ground.streamFromFile(modelPath2, queue, queueMutex, suitableQueueFamilyIndex, 1.0f);
+			}));
 		}
 		catch (std::exception& e)
 		{
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -17,6 +19,9 @@
 #include <RapidVulkan/CommandPool.hpp>
 #include <RapidVulkan/CommandBuffers.hpp>
 #include "IWindow.hpp"
+#include "DeviceMemoryAllocator.hpp"
+#include "GeometryPool.hpp"
+#include "ThreadPool.hpp"
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -28,7 +33,7 @@ namespace BadgerSandbox
     struct uniformBuffer
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocation memory;
         VkDescriptorBufferInfo decriptor = {};
         void* mapped = nullptr;
     };
@@ -36,7 +41,7 @@ namespace BadgerSandbox
     struct vertexBuffer
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocation memory;
         void* mapped = nullptr;
     };
 
@@ -51,7 +56,7 @@ namespace BadgerSandbox
         RapidVulkan::GraphicsPipeline graphicsPipeline;
 
         VkImage depthImage;
-        VkDeviceMemory depthImageMemory;
+        MemoryAllocation depthImageMemory;
         VkImageView depthImageView;
 
         VkDescriptorSetLayout dsLayout;
@@ -84,7 +89,7 @@ namespace BadgerSandbox
     struct shadowImage
     {
         VkImage image;
-        VkDeviceMemory imageMemory;
+        MemoryAllocation imageMemory;
         VkImageView imageView;
         RapidVulkan::Framebuffer framebuffer;
         VkDescriptorImageInfo descriptorImageInfo;
@@ -106,6 +111,13 @@ namespace BadgerSandbox
         RapidVulkan::Device device;
         uint32_t suitableQueueFamilyIndex;
         VkQueue queue;
+        // Guards queue, which the frame loop and the model streaming workers submit to
+        std::mutex queueMutex;
+        // Buffers and images, the models' included, are sub-allocated from here. Declared after the device so it
+        // releases its memory before the device is destroyed.
+        std::unique_ptr<DeviceMemoryAllocator> memoryAllocator;
+        // Vertices and indices of both models, so a pass binds them once whichever models it draws
+        std::unique_ptr<GeometryPool> geometryPool;
 
         VkSurfaceKHR surface;
         VkSurfaceFormatKHR selectedSurfaceFormat;
@@ -114,13 +126,22 @@ namespace BadgerSandbox
 
         RapidVulkan::RenderPass renderPass;
         std::vector<RapidVulkan::ImageView> swapchainImageViews;
+        // One per swapchain image, only rebuilt when the swapchain is
         std::vector<RapidVulkan::Framebuffer> framebuffers;
+        // Bumped whenever the swapchain is recreated
+        uint64_t swapchainVersion;
 
         std::vector<RapidVulkan::Semaphore> imageAvailable;
         std::vector<RapidVulkan::Semaphore> renderingFinished;
 
         RapidVulkan::CommandPool graphicsCommandPool;
         RapidVulkan::CommandBuffers graphicsCommandBuffers;
+        // The draws of both passes for each render resource, recorded once and executed from the primary command
+        // buffer every frame until the culling results, the streamed models or the swapchain change
+        RapidVulkan::CommandBuffers shadowSceneCommandBuffers;
+        RapidVulkan::CommandBuffers sceneCommandBuffers;
+        std::vector<uint64_t> recordedShadowSceneVersions;
+        std::vector<uint64_t> recordedSceneVersions;
         
         const uint32_t renderResourcesCount;
         std::vector<VkFence> fences;
@@ -134,11 +155,16 @@ namespace BadgerSandbox
         RapidVulkan::RenderPass shadowRenderPass;
         renderPassResources shadowPass;
         std::vector<shadowImage> shadowImages;
-        
+
+        // Models are decoded and uploaded here while Draw keeps presenting. Declared after the device and
+        // queue mutex so the workers are joined before those are destroyed.
+        std::vector<std::future<void>> modelLoads;
+        ThreadPool loaderPool;
 
         void AllocateDescriptorSet();
         void AllocateShadowDescriptorSet();
         void CreateDepthImage();
+        void DestroyDepthImage();
         void CreateShadowDepthImage();
         void CreateShadowDepthImageSampler();
         void CreateDescriptorPool();
@@ -151,11 +177,13 @@ namespace BadgerSandbox
         void CreateShadowPipeline();
         void CreateImageView(const VkImage& image, VkImageView& imageView);
         VkImageView CreateImageViewVulkanTutorial(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory);
         void CreateInstance();
-        void CreateJustInTimeFramebuffer(RapidVulkan::Framebuffer& framebuffer, const RapidVulkan::ImageView& imageView);
-        void CreateJustInTimeShadowFramebuffer(RapidVulkan::Framebuffer& framebuffer, const VkImageView& imageView);
+        void CreateFramebuffers();
+        void CreateShadowFramebuffers();
         void CreateLogicalDevice();
+        void CreateMemoryAllocator();
+        void CreateGeometryPool();
         void CreateRenderPass();
         void CreateShadowRenderPass();
         void CreateSemaphores();
@@ -163,11 +191,13 @@ namespace BadgerSandbox
         void CreateSwapchain();
         void CreateSwapchainImageViews();
         VkFormat FindDepthFormat();
-        uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex);
+        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex);
         void RecordJustInTimeShadowCommandBuffers(const size_t& resourceIndex);
-        void CreateBuffer(VkBuffer &buffer, VkDeviceMemory& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties);
+        void RecordShadowSceneCommandBuffer(const size_t& resourceIndex);
+        void RecordSceneCommandBuffer(const size_t& resourceIndex);
+        void RecreateSwapchain();
+        void CreateBuffer(VkBuffer &buffer, MemoryAllocation& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties);
         void CreateUniformBuffers();
         void CreateShadowUniformBuffers();
         void UpdateDescriptorSet();
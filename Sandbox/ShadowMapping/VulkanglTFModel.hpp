@@ -9,10 +9,16 @@
 #pragma once
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <string>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <mutex>
 
 #include "vulkan/vulkan.h"
 
@@ -20,6 +26,7 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
@@ -31,6 +38,10 @@
 #define STBI_MSC_SECURE_CRT
 #include "tiny_gltf.h"
 #include <RapidVulkan/Check.hpp>
+#include "DeviceMemoryAllocator.hpp"
+#include "GeometryPool.hpp"
+#include "MeshCache.hpp"
+#include "AffineTransform.hpp"
 
 // Changing this value here also requires changing it in the vertex shader
 constexpr uint32_t MAX_NUM_JOINTS = 512u;
@@ -40,9 +51,29 @@ namespace vkglTF
     VkPhysicalDevice gltfPhysicalDevice;
     VkDevice gltfLogicalDevice;
     VkPhysicalDeviceMemoryProperties glTFMemoryProperties;
+    // Every buffer the loader creates takes its memory from here
+    BadgerSandbox::DeviceMemoryAllocator* gltfMemoryAllocator = nullptr;
     VkCommandPool gltfCommandPool;
 	  struct Node;
 
+  // glTF node, joint and inverse bind matrices are affine, so skinning composes them as 3x4 transforms
+  inline BadgerSandbox::AffineTransform toAffineTransform(const glm::mat4& m)
+  {
+    return BadgerSandbox::AffineTransform(BadgerSandbox::Matrix3D(BadgerSandbox::Vector3D(m[0][0], m[0][1], m[0][2]),
+                                                                  BadgerSandbox::Vector3D(m[1][0], m[1][1], m[1][2]),
+                                                                  BadgerSandbox::Vector3D(m[2][0], m[2][1], m[2][2])),
+                                          BadgerSandbox::Vector3D(m[3][0], m[3][1], m[3][2]));
+  }
+
+  inline glm::mat4 toMat4(const BadgerSandbox::AffineTransform& a)
+  {
+    const BadgerSandbox::Matrix3D& l = a.linear;
+    return glm::mat4(glm::vec4(l(0, 0), l(1, 0), l(2, 0), 0.0f),
+                     glm::vec4(l(0, 1), l(1, 1), l(2, 1), 0.0f),
+                     glm::vec4(l(0, 2), l(1, 2), l(2, 2), 0.0f),
+                     glm::vec4(a.translation.x, a.translation.y, a.translation.z, 1.0f));
+  }
+
   struct BoundingBox
   {
     glm::vec3 min;
@@ -112,56 +143,44 @@ namespace vkglTF
     }
 
     VkResult createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer* buffer,
-        VkDeviceMemory* memory, void* data = nullptr)
+        BadgerSandbox::MemoryAllocation* memory, void* data = nullptr)
     {
-        // Create the buffer handle
+        // Create the buffer handle and bind it to memory of a memory type that fits the properties
         VkBufferCreateInfo bufferCreateInfo{};
         bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferCreateInfo.usage = usageFlags;
         bufferCreateInfo.size = size;
         bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        RapidVulkan::CheckError(vkCreateBuffer(gltfLogicalDevice, &bufferCreateInfo, nullptr, buffer));
-
-        // Create the memory backing up the buffer handle
-        VkMemoryRequirements memReqs;
-        VkMemoryAllocateInfo memAlloc{};
-        memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        vkGetBufferMemoryRequirements(gltfLogicalDevice, *buffer, &memReqs);
-        memAlloc.allocationSize = memReqs.size;
-        // Find a memory type index that fits the properties of the buffer
-        memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-        RapidVulkan::CheckError(vkAllocateMemory(gltfLogicalDevice, &memAlloc, nullptr, memory));
-
-        // If a pointer to the buffer data has been passed, map the buffer and copy over the data
+        BadgerSandbox::MemoryRequest memoryRequest;
+        memoryRequest.properties = memoryPropertyFlags;
+        RapidVulkan::CheckError(gltfMemoryAllocator->CreateBuffer(bufferCreateInfo, memoryRequest, *buffer, *memory));
+
+        // If a pointer to the buffer data has been passed, copy it over, host visible memory is always mapped
         if (data != nullptr)
         {
-            void* mapped;
-            RapidVulkan::CheckError(vkMapMemory(gltfLogicalDevice, *memory, 0, size, 0, &mapped));
-            memcpy(mapped, data, size);
-            // If host coherency hasn't been requested, do a manual flush to make writes visible
-            if ((memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
-            {
-                VkMappedMemoryRange mappedRange{};
-                mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-                mappedRange.memory = *memory;
-                mappedRange.offset = 0;
-                mappedRange.size = size;
-                vkFlushMappedMemoryRanges(gltfLogicalDevice, 1, &mappedRange);
-            }
-            vkUnmapMemory(gltfLogicalDevice, *memory);
+            memcpy(memory->mapped, data, size);
+            // Does nothing if host coherency has been requested
+            gltfMemoryAllocator->Flush(*memory, 0, size);
         }
 
-        // Attach the memory to the buffer object
-        RapidVulkan::CheckError(vkBindBufferMemory(gltfLogicalDevice, *buffer, *memory, 0));
-
         return VK_SUCCESS;
     }
 
-    VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level, bool begin = false)
+    // Sets the device the loader creates its resources on. loadFromFile calls this itself, streamed
+    // loads need it to have been called before any of them starts.
+    void setDevice(VkPhysicalDevice physicalDevice, VkDevice device, BadgerSandbox::DeviceMemoryAllocator& memoryAllocator)
+    {
+        gltfPhysicalDevice = physicalDevice;
+        gltfLogicalDevice = device;
+        gltfMemoryAllocator = &memoryAllocator;
+        vkGetPhysicalDeviceMemoryProperties(gltfPhysicalDevice, &glTFMemoryProperties);
+    }
+
+    VkCommandBuffer createCommandBuffer(VkCommandPool commandPool, VkCommandBufferLevel level, bool begin = false)
     {
         VkCommandBufferAllocateInfo cmdBufAllocateInfo{};
         cmdBufAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        cmdBufAllocateInfo.commandPool = gltfCommandPool;
+        cmdBufAllocateInfo.commandPool = commandPool;
         cmdBufAllocateInfo.level = level;
         cmdBufAllocateInfo.commandBufferCount = 1;
 
@@ -179,6 +198,11 @@ namespace vkglTF
         return cmdBuffer;
     }
 
+    VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level, bool begin = false)
+    {
+        return createCommandBuffer(gltfCommandPool, level, begin);
+    }
+
     void beginCommandBuffer(VkCommandBuffer commandBuffer)
     {
         VkCommandBufferBeginInfo commandBufferBI{};
@@ -224,6 +248,8 @@ namespace vkglTF
     uint32_t indexCount;
     uint32_t vertexCount;
     bool hasIndices;
+    // First vertex of the model's range in its GeometryPool, the indices are relative to it
+    int32_t vertexOffset = 0;
 
     BoundingBox bb;
 
@@ -256,7 +282,7 @@ namespace vkglTF
     struct UniformBuffer
     {
       VkBuffer buffer;
-      VkDeviceMemory memory;
+      BadgerSandbox::MemoryAllocation memory;
       VkDescriptorBufferInfo descriptor;
       VkDescriptorSet descriptorSet;
       void* mapped;
@@ -269,6 +295,9 @@ namespace vkglTF
       float jointcount{0};
     } uniformBlock;
 
+    // Affine inverse of uniformBlock.matrix, only recomputed when the owning node moves
+    BadgerSandbox::AffineTransform inverseTransform;
+
     Mesh(glm::mat4 matrix)
     {
       this->uniformBlock.matrix = matrix;
@@ -276,14 +305,13 @@ namespace vkglTF
       RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(uniformBlock),
                                                    &uniformBuffer.buffer, &uniformBuffer.memory, &uniformBlock));
-      RapidVulkan::CheckError(vkMapMemory(gltfLogicalDevice, uniformBuffer.memory, 0, sizeof(uniformBlock), 0, &uniformBuffer.mapped));
+      uniformBuffer.mapped = uniformBuffer.memory.mapped;
       uniformBuffer.descriptor = {uniformBuffer.buffer, 0, sizeof(uniformBlock)};
     };
 
     ~Mesh()
     {
-      vkDestroyBuffer(gltfLogicalDevice, uniformBuffer.buffer, nullptr);
-      vkFreeMemory(gltfLogicalDevice, uniformBuffer.memory, nullptr);
+      gltfMemoryAllocator->DestroyBuffer(uniformBuffer.buffer, uniformBuffer.memory);
       for (Primitive* p : primitives)
         delete p;
     }
@@ -294,6 +322,21 @@ namespace vkglTF
       bb.max = max;
       bb.valid = true;
     }
+
+    // Mesh BB from BBs of primitives
+    void updateBoundingBox()
+    {
+      for (auto p : primitives)
+      {
+        if (p->bb.valid && !bb.valid)
+        {
+          bb = p->bb;
+          bb.valid = true;
+        }
+        bb.min = glm::min(bb.min, p->bb.min);
+        bb.max = glm::max(bb.max, p->bb.max);
+      }
+    }
   };
 
   /*
@@ -304,7 +347,36 @@ namespace vkglTF
     std::string name;
     Node* skeletonRoot = nullptr;
     std::vector<glm::mat4> inverseBindMatrices;
+    // inverseBindMatrices as affine transforms, filled once the skin's joints are resolved
+    std::vector<BadgerSandbox::AffineTransform> inverseBindTransforms;
     std::vector<Node*> joints;
+    // Scene graph slot of each joint, used to read cached world matrices
+    std::vector<uint32_t> jointIndices;
+  };
+
+  /*
+    Flattened scene hierarchy
+    Nodes are stored depth first, so every parent precedes its children and world matrices can be
+    propagated in a single linear pass. Only nodes whose local transform was marked dirty, and the
+    subtrees below them, are recomputed.
+  */
+  struct SceneGraph
+  {
+    std::vector<Node*> nodes;
+    std::vector<int32_t> parents;
+    std::vector<glm::mat4> localMatrices;
+    std::vector<glm::mat4> worldMatrices;
+    // Local transform changed since the last update
+    std::vector<uint8_t> dirty;
+    // World matrix was recomputed by the last update
+    std::vector<uint8_t> changed;
+    size_t firstDirty = 0;
+
+    void build(const std::vector<Node*>& roots);
+    void markDirty(const Node* node);
+    void markAllDirty();
+    void update();
+    void clear();
   };
 
   /*
@@ -325,51 +397,30 @@ namespace vkglTF
     glm::quat rotation{};
     BoundingBox bvh;
     BoundingBox aabb;
+    SceneGraph* graph = nullptr;
+    uint32_t graphIndex = 0;
 
     glm::mat4 localMatrix()
     {
       return glm::translate(glm::mat4(1.0f), translation) * glm::mat4(rotation) * glm::scale(glm::mat4(1.0f), scale) * matrix;
     }
 
-    glm::mat4 getMatrix()
+    glm::mat4 getMatrix();
+
+    // Uploads the world matrix of an unskinned mesh. Skinned meshes are updated by Model::updateSkin, from the
+    // cached joint world matrices and the mesh's cached inverse transform.
+    void updateMesh()
     {
-      glm::mat4 m = localMatrix();
-      vkglTF::Node* p = parent;
-      while (p)
+      if (mesh && !skin)
       {
-        m = p->localMatrix() * m;
-        p = p->parent;
+        glm::mat4 m = getMatrix();
+        memcpy(mesh->uniformBuffer.mapped, &m, sizeof(glm::mat4));
       }
-      return m;
     }
 
     void update()
     {
-      if (mesh)
-      {
-        glm::mat4 m = getMatrix();
-        if (skin)
-        {
-          mesh->uniformBlock.matrix = m;
-          // Update join matrices
-          glm::mat4 inverseTransform = glm::inverse(m);
-          size_t numJoints = std::min((uint32_t)skin->joints.size(), MAX_NUM_JOINTS);
-          for (size_t i = 0; i < numJoints; i++)
-          {
-            vkglTF::Node* jointNode = skin->joints[i];
-            glm::mat4 jointMat = jointNode->getMatrix() * skin->inverseBindMatrices[i];
-            jointMat = inverseTransform * jointMat;
-            mesh->uniformBlock.jointMatrix[i] = jointMat;
-          }
-          mesh->uniformBlock.jointcount = (float)numJoints;
-          memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
-        }
-        else
-        {
-          memcpy(mesh->uniformBuffer.mapped, &m, sizeof(glm::mat4));
-        }
-      }
-
+      updateMesh();
       for (auto& child : children)
       {
         child->update();
@@ -389,6 +440,97 @@ namespace vkglTF
     }
   };
 
+  inline void SceneGraph::build(const std::vector<Node*>& roots)
+  {
+    clear();
+    std::vector<Node*> stack(roots.rbegin(), roots.rend());
+    while (!stack.empty())
+    {
+      Node* node = stack.back();
+      stack.pop_back();
+      node->graph = this;
+      node->graphIndex = static_cast<uint32_t>(nodes.size());
+      nodes.push_back(node);
+      parents.push_back(node->parent ? static_cast<int32_t>(node->parent->graphIndex) : -1);
+      for (auto child = node->children.rbegin(); child != node->children.rend(); ++child)
+      {
+        stack.push_back(*child);
+      }
+    }
+    localMatrices.resize(nodes.size());
+    worldMatrices.resize(nodes.size());
+    dirty.resize(nodes.size());
+    changed.resize(nodes.size());
+    markAllDirty();
+  }
+
+  inline void SceneGraph::markDirty(const Node* node)
+  {
+    dirty[node->graphIndex] = 1;
+    firstDirty = std::min(firstDirty, static_cast<size_t>(node->graphIndex));
+  }
+
+  inline void SceneGraph::markAllDirty()
+  {
+    std::fill(dirty.begin(), dirty.end(), uint8_t(1));
+    firstDirty = 0;
+  }
+
+  inline void SceneGraph::update()
+  {
+    // Nothing before the first dirty node can change, parents always precede their children
+    const size_t count = nodes.size();
+    const size_t first = std::min(firstDirty, count);
+    std::fill(changed.begin(), changed.begin() + first, uint8_t(0));
+    for (size_t i = first; i < count; i++)
+    {
+      const int32_t parent = parents[i];
+      const bool parentChanged = parent >= 0 && changed[parent];
+      if (dirty[i])
+      {
+        localMatrices[i] = nodes[i]->localMatrix();
+      }
+      changed[i] = dirty[i] || parentChanged;
+      if (changed[i])
+      {
+        worldMatrices[i] = parent >= 0 ? worldMatrices[parent] * localMatrices[i] : localMatrices[i];
+      }
+      dirty[i] = 0;
+    }
+    firstDirty = count;
+  }
+
+  inline void SceneGraph::clear()
+  {
+    for (Node* node : nodes)
+    {
+      node->graph = nullptr;
+    }
+    nodes.clear();
+    parents.clear();
+    localMatrices.clear();
+    worldMatrices.clear();
+    dirty.clear();
+    changed.clear();
+    firstDirty = 0;
+  }
+
+  inline glm::mat4 Node::getMatrix()
+  {
+    if (graph)
+    {
+      return graph->worldMatrices[graphIndex];
+    }
+    glm::mat4 m = localMatrix();
+    vkglTF::Node* p = parent;
+    while (p)
+    {
+      m = p->localMatrix() * m;
+      p = p->parent;
+    }
+    return m;
+  }
+
   /*
     glTF animation channel
   */
@@ -403,6 +545,8 @@ namespace vkglTF
     PathType path;
     Node* node;
     uint32_t samplerIndex;
+    // Key interval used by the last evaluation, the starting point for the next lookup
+    size_t cursor = 0;
   };
 
   /*
@@ -419,6 +563,94 @@ namespace vkglTF
     InterpolationType interpolation;
     std::vector<float> inputs;
     std::vector<glm::vec4> outputsVec4;
+
+    // Cubic spline samplers store an in-tangent, value and out-tangent per key
+    bool valid() const
+    {
+      const size_t stride = interpolation == CUBICSPLINE ? 3 : 1;
+      return !inputs.empty() && outputsVec4.size() >= inputs.size() * stride;
+    }
+
+    glm::vec4 value(size_t key) const
+    {
+      return interpolation == CUBICSPLINE ? outputsVec4[key * 3 + 1] : outputsVec4[key];
+    }
+
+    // Returns the key interval [i, i + 1] that contains time. Checks the cursor and the interval after it
+    // first, so monotonic playback costs O(1), and falls back to a binary search on seeks and loops.
+    size_t findInterval(float time, size_t& cursor) const
+    {
+      const size_t last = inputs.size() - 1;
+      if (cursor < last && time >= inputs[cursor])
+      {
+        if (time <= inputs[cursor + 1])
+        {
+          return cursor;
+        }
+        if (cursor + 1 < last && time <= inputs[cursor + 2])
+        {
+          return ++cursor;
+        }
+      }
+      const size_t upper = static_cast<size_t>(std::upper_bound(inputs.begin(), inputs.end(), time) - inputs.begin());
+      cursor = std::min(upper > 0 ? upper - 1 : 0, last - 1);
+      return cursor;
+    }
+
+    // Evaluates the sampler at time, clamping to the first and last key. Rotations are returned as
+    // normalized (x, y, z, w) quaternions.
+    glm::vec4 evaluate(float time, size_t& cursor, bool rotation) const
+    {
+      if (inputs.size() == 1 || time <= inputs.front())
+      {
+        return value(0);
+      }
+      if (time >= inputs.back())
+      {
+        return value(inputs.size() - 1);
+      }
+
+      const size_t i = findInterval(time, cursor);
+      const float delta = inputs[i + 1] - inputs[i];
+      const float u = delta > 0.0f ? (time - inputs[i]) / delta : 0.0f;
+
+      switch (interpolation)
+      {
+      case STEP:
+        return value(i);
+      case CUBICSPLINE:
+      {
+        // Hermite spline, tangents are scaled by the key interval
+        const float u2 = u * u;
+        const float u3 = u2 * u;
+        const glm::vec4 result = (2.0f * u3 - 3.0f * u2 + 1.0f) * outputsVec4[i * 3 + 1]
+                               + (u3 - 2.0f * u2 + u) * delta * outputsVec4[i * 3 + 2]
+                               + (-2.0f * u3 + 3.0f * u2) * outputsVec4[(i + 1) * 3 + 1]
+                               + (u3 - u2) * delta * outputsVec4[(i + 1) * 3];
+        return rotation ? glm::normalize(result) : result;
+      }
+      case LINEAR:
+      default:
+      {
+        if (!rotation)
+        {
+          return glm::mix(outputsVec4[i], outputsVec4[i + 1], u);
+        }
+        const glm::quat q = glm::normalize(glm::slerp(toQuat(outputsVec4[i]), toQuat(outputsVec4[i + 1]), u));
+        return glm::vec4(q.x, q.y, q.z, q.w);
+      }
+      }
+    }
+
+    static glm::quat toQuat(const glm::vec4& v)
+    {
+      glm::quat q;
+      q.x = v.x;
+      q.y = v.y;
+      q.z = v.z;
+      q.w = v.w;
+      return q;
+    }
   };
 
   /*
@@ -433,11 +665,45 @@ namespace vkglTF
     float end = std::numeric_limits<float>::min();
   };
 
+  /*
+    Vertex buffer layouts
+    Full keeps every attribute as 32 bit floats. Compact stores snorm16 normals, half float UVs,
+    uint16 joints and unorm8 weights. CompactStatic drops the skin attributes for meshes that are
+    never skinned. All compact formats are converted to floats by the vertex fetch, so shaders
+    written for Full work unchanged.
+  */
+  enum class VertexLayout
+  {
+    Full,
+    Compact,
+    CompactStatic
+  };
+
+  /*
+    Vertex buffer streams
+    Interleaved keeps every attribute in one buffer. PositionsInterleaved adds a tightly packed
+    position-only copy that depth-only passes bind instead. Split stores positions and the
+    remaining attributes in two buffers; lit passes bind both and depth passes only the first.
+  */
+  enum class VertexStreams
+  {
+    Interleaved,
+    PositionsInterleaved,
+    Split
+  };
+
   /*
     glTF model loading and rendering class
   */
   struct Model
   {
+    // Nodes point back at sceneGraph, so a model must stay where it was constructed
+    Model() = default;
+    Model(const Model&) = delete;
+    Model(Model&&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model& operator=(Model&&) = delete;
+
     struct Vertex
     {
       glm::vec3 pos;
@@ -448,22 +714,302 @@ namespace vkglTF
       glm::vec4 weight0;
     };
 
+    struct CompactVertex
+    {
+      glm::vec3 pos;
+      int16_t normal[4];
+      uint16_t uv0[2];
+      uint16_t uv1[2];
+      uint16_t joint0[4];
+      uint8_t weight0[4];
+    };
+
+    struct CompactStaticVertex
+    {
+      glm::vec3 pos;
+      int16_t normal[4];
+      uint16_t uv0[2];
+      uint16_t uv1[2];
+    };
+
+    // Write cursors into the mapped staging buffers that loadNode decodes accessors into
+    struct LoaderInfo
+    {
+      uint32_t* indexBuffer = nullptr;
+      uint8_t* vertexBuffer = nullptr;
+      glm::vec3* positionBuffer = nullptr;
+      size_t indexPos = 0;
+      size_t vertexPos = 0;
+    };
+
+    // Host visible buffers the loader fills before they are copied to device local memory
+    struct StagingBuffer
+    {
+      VkBuffer buffer = VK_NULL_HANDLE;
+      BadgerSandbox::MemoryAllocation memory;
+      size_t size = 0;
+      void* mapped = nullptr;
+    };
+
+    struct StagingBuffers
+    {
+      StagingBuffer vertices;
+      StagingBuffer indices;
+      StagingBuffer positions;
+    };
+
+    // Upload submitted by streamFromFile, released by the pollUpload call that sees its fence signalled
+    struct PendingUpload
+    {
+      VkCommandPool commandPool = VK_NULL_HANDLE;
+      VkFence fence = VK_NULL_HANDLE;
+      StagingBuffers staging;
+    };
+
+    // Per instance data of drawInstanced, read by the vertex shader at the instance input rate
+    struct InstanceData
+    {
+      glm::mat4 model;
+    };
+
+    // First location of the instance attributes, after the attributes of every vertex layout
+    static const uint32_t instanceLocation = 6;
+
+    // Layout the vertex buffer is written in, must be set before loadFromFile
+    VertexLayout vertexLayout = VertexLayout::Full;
+    // Buffers the vertices are split into, must be set before loadFromFile
+    VertexStreams vertexStreams = VertexStreams::Interleaved;
+    // Bake the decoded model to <file>.meshcache on the first load and map it on later loads. A cache that can not
+    // be written is only reported, the decoded model is used as is.
+    bool useMeshCache = true;
+    // Pool the vertex streams and indices are sub-allocated from, must be set before loadFromFile. Its strides have
+    // to be the model's getVertexBufferStride and getPositionBufferStride. Without one the model creates buffers of its own.
+    BadgerSandbox::GeometryPool* geometryPool = nullptr;
+    // The model's part of geometryPool, primitives have its first index and vertex added in
+    BadgerSandbox::GeometryRange geometryRange;
+
+    static uint32_t getVertexStride(VertexLayout layout)
+    {
+      switch (layout)
+      {
+      case VertexLayout::Compact:
+        return sizeof(CompactVertex);
+      case VertexLayout::CompactStatic:
+        return sizeof(CompactStaticVertex);
+      case VertexLayout::Full:
+      default:
+        return sizeof(Vertex);
+      }
+    }
+
+    // Bytes a vertex takes in the vertex buffer, Split streams keep the position in the position buffer instead
+    static uint32_t getVertexBufferStride(VertexLayout layout, VertexStreams streams)
+    {
+      return getVertexStride(layout) - (streams == VertexStreams::Split ? static_cast<uint32_t>(sizeof(glm::vec3)) : 0);
+    }
+
+    // Bytes a vertex takes in the position buffer, Interleaved streams have none
+    static uint32_t getPositionBufferStride(VertexStreams streams)
+    {
+      return streams == VertexStreams::Interleaved ? 0 : static_cast<uint32_t>(sizeof(glm::vec3));
+    }
+
+    // Attribute descriptions for pipelines reading a vertex buffer of this layout, locations match the Full layout
+    static std::vector<VkVertexInputAttributeDescription> getVertexInputAttributes(VertexLayout layout, uint32_t binding = 0)
+    {
+      switch (layout)
+      {
+      case VertexLayout::Compact:
+        return {
+          {0, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(CompactVertex, pos)},
+          {1, binding, VK_FORMAT_R16G16B16A16_SNORM, offsetof(CompactVertex, normal)},
+          {2, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, uv0)},
+          {3, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, uv1)},
+          {4, binding, VK_FORMAT_R16G16B16A16_USCALED, offsetof(CompactVertex, joint0)},
+          {5, binding, VK_FORMAT_R8G8B8A8_UNORM, offsetof(CompactVertex, weight0)}
+        };
+      case VertexLayout::CompactStatic:
+        return {
+          {0, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(CompactStaticVertex, pos)},
+          {1, binding, VK_FORMAT_R16G16B16A16_SNORM, offsetof(CompactStaticVertex, normal)},
+          {2, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactStaticVertex, uv0)},
+          {3, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactStaticVertex, uv1)}
+        };
+      case VertexLayout::Full:
+      default:
+        return {
+          {0, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
+          {1, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
+          {2, binding, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv0)},
+          {3, binding, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv1)},
+          {4, binding, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, joint0)},
+          {5, binding, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, weight0)}
+        };
+      }
+    }
+
+    // Whether every attribute of layout can be read from a vertex buffer on physicalDevice. The Compact layout's
+    // R16G16B16A16_USCALED joints are not one of the formats Vulkan requires vertex buffer support for.
+    static bool isVertexLayoutSupported(VkPhysicalDevice physicalDevice, VertexLayout layout)
+    {
+      for (const VkVertexInputAttributeDescription& attribute : getVertexInputAttributes(layout))
+      {
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, attribute.format, &formatProperties);
+        if ((formatProperties.bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT) == 0)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Vertex input of the lit passes. Split streams read positions from binding 0 and the other attributes from binding 1.
+    static std::vector<VkVertexInputBindingDescription> getVertexInputBindings(VertexLayout layout, VertexStreams streams)
+    {
+      if (streams == VertexStreams::Split)
+      {
+        return {
+          {0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX},
+          {1, getVertexStride(layout) - static_cast<uint32_t>(sizeof(glm::vec3)), VK_VERTEX_INPUT_RATE_VERTEX}
+        };
+      }
+      return {{0, getVertexStride(layout), VK_VERTEX_INPUT_RATE_VERTEX}};
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> getVertexInputAttributes(VertexLayout layout, VertexStreams streams)
+    {
+      std::vector<VkVertexInputAttributeDescription> attributes = getVertexInputAttributes(layout);
+      if (streams == VertexStreams::Split)
+      {
+        // Positions lead every layout, the attribute stream starts right after them
+        for (VkVertexInputAttributeDescription& attribute : attributes)
+        {
+          if (attribute.location != 0)
+          {
+            attribute.binding = 1;
+            attribute.offset -= static_cast<uint32_t>(sizeof(glm::vec3));
+          }
+        }
+      }
+      return attributes;
+    }
+
+    // Vertex input of depth-only passes, which read nothing but the position at location 0
+    static std::vector<VkVertexInputBindingDescription> getDepthInputBindings(VertexLayout layout, VertexStreams streams)
+    {
+      const uint32_t stride = streams == VertexStreams::Interleaved ? getVertexStride(layout) : static_cast<uint32_t>(sizeof(glm::vec3));
+      return {{0, stride, VK_VERTEX_INPUT_RATE_VERTEX}};
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> getDepthInputAttributes()
+    {
+      return {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0}};
+    }
+
+    // Binding drawInstanced reads the instance buffer from, the one after the vertex streams the pass binds
+    static uint32_t getInstanceBinding(VertexStreams streams, bool depthOnly = false)
+    {
+      return (streams == VertexStreams::Split && !depthOnly) ? 2 : 1;
+    }
+
+    static VkVertexInputBindingDescription getInstanceInputBinding(uint32_t binding)
+    {
+      return {binding, sizeof(InstanceData), VK_VERTEX_INPUT_RATE_INSTANCE};
+    }
+
+    // The model matrix of InstanceData, one column per location from instanceLocation on
+    static std::vector<VkVertexInputAttributeDescription> getInstanceInputAttributes(uint32_t binding)
+    {
+      std::vector<VkVertexInputAttributeDescription> attributes;
+      for (uint32_t column = 0; column < 4; column++)
+      {
+        attributes.push_back({instanceLocation + column, binding, VK_FORMAT_R32G32B32A32_SFLOAT,
+          static_cast<uint32_t>(offsetof(InstanceData, model) + column * sizeof(glm::vec4))});
+      }
+      return attributes;
+    }
+
+    // Quantizes weights to unorm8 while keeping their sum at exactly 255
+    static void packWeights(const glm::vec4& weights, uint8_t packed[4])
+    {
+      int total = 0;
+      int largest = 0;
+      for (int i = 0; i < 4; i++)
+      {
+        packed[i] = static_cast<uint8_t>(glm::clamp(weights[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        total += packed[i];
+        largest = packed[i] > packed[largest] ? i : largest;
+      }
+      packed[largest] = static_cast<uint8_t>(glm::clamp(packed[largest] + 255 - total, 0, 255));
+    }
+
+    // Stores vert at the cursor of the mapped vertex buffers in the model's layout and streams
+    void writeVertex(LoaderInfo& loaderInfo, const Vertex& vert)
+    {
+      const size_t index = loaderInfo.vertexPos++;
+      const void* source = &vert;
+
+      CompactVertex compact;
+      if (vertexLayout != VertexLayout::Full)
+      {
+        compact.pos = vert.pos;
+        const uint64_t normal = glm::packSnorm4x16(glm::vec4(vert.normal, 0.0f));
+        memcpy(compact.normal, &normal, sizeof(compact.normal));
+        const uint32_t uv0 = glm::packHalf2x16(vert.uv0);
+        const uint32_t uv1 = glm::packHalf2x16(vert.uv1);
+        memcpy(compact.uv0, &uv0, sizeof(compact.uv0));
+        memcpy(compact.uv1, &uv1, sizeof(compact.uv1));
+        // CompactStaticVertex is the leading part of CompactVertex
+        if (vertexLayout == VertexLayout::Compact)
+        {
+          for (int i = 0; i < 4; i++)
+          {
+            compact.joint0[i] = static_cast<uint16_t>(vert.joint0[i]);
+          }
+          packWeights(vert.weight0, compact.weight0);
+        }
+        source = &compact;
+      }
+
+      if (vertexStreams != VertexStreams::Interleaved)
+      {
+        loaderInfo.positionBuffer[index] = vert.pos;
+      }
+      const size_t skip = vertexStreams == VertexStreams::Split ? sizeof(glm::vec3) : 0;
+      const size_t stride = getVertexStride(vertexLayout) - skip;
+      memcpy(loaderInfo.vertexBuffer + index * stride, static_cast<const uint8_t*>(source) + skip, stride);
+    }
+
     struct Vertices
     {
       VkBuffer buffer = VK_NULL_HANDLE;
-      VkDeviceMemory memory;
+      BadgerSandbox::MemoryAllocation memory;
     } vertices;
+    // Position-only stream, only created when vertexStreams is not Interleaved
+    struct Positions
+    {
+      VkBuffer buffer = VK_NULL_HANDLE;
+      BadgerSandbox::MemoryAllocation memory;
+    } positions;
     struct Indices
     {
       int count;
       VkBuffer buffer = VK_NULL_HANDLE;
-      VkDeviceMemory memory;
+      BadgerSandbox::MemoryAllocation memory;
     } indices;
 
+    PendingUpload pendingUpload;
+    // Published by the loading thread once pendingUpload has been submitted
+    std::atomic<bool> uploadSubmitted{false};
+    // Set once the device local buffers hold the model, it must not be drawn before
+    bool uploadComplete = false;
+
     glm::mat4 aabb;
 
     std::vector<Node*> nodes;
     std::vector<Node*> linearNodes;
+    SceneGraph sceneGraph;
 
     std::vector<Skin*> skins;
 
@@ -478,16 +1024,34 @@ namespace vkglTF
 
     void destroy(VkDevice device)
     {
+      if (uploadSubmitted.load(std::memory_order_acquire) && !uploadComplete)
+      {
+        RapidVulkan::CheckError(vkWaitForFences(device, 1, &pendingUpload.fence, VK_TRUE, UINT64_MAX));
+        releasePendingUpload();
+      }
+      uploadSubmitted.store(false, std::memory_order_relaxed);
+      uploadComplete = false;
+      if (geometryPool != nullptr)
+      {
+        // The buffers belong to the pool, only the model's range of them is returned
+        geometryPool->Free(geometryRange);
+        vertices.buffer = VK_NULL_HANDLE;
+        positions.buffer = VK_NULL_HANDLE;
+        indices.buffer = VK_NULL_HANDLE;
+      }
       if (vertices.buffer != VK_NULL_HANDLE)
       {
-        vkDestroyBuffer(device, vertices.buffer, nullptr);
-        vkFreeMemory(device, vertices.memory, nullptr);
+        gltfMemoryAllocator->DestroyBuffer(vertices.buffer, vertices.memory);
+      }
+      if (positions.buffer != VK_NULL_HANDLE)
+      {
+        gltfMemoryAllocator->DestroyBuffer(positions.buffer, positions.memory);
       }
       if (indices.buffer != VK_NULL_HANDLE)
       {
-        vkDestroyBuffer(device, indices.buffer, nullptr);
-        vkFreeMemory(device, indices.memory, nullptr);
+        gltfMemoryAllocator->DestroyBuffer(indices.buffer, indices.memory);
       }
+      sceneGraph.clear();
       for (auto node : nodes)
       {
         delete node;
@@ -504,8 +1068,29 @@ namespace vkglTF
       skins.resize(0);
     };
 
+    // Accumulates the vertex and index counts of node and its children so buffers can be sized up front
+    void getNodeProps(const tinygltf::Node& node, const tinygltf::Model& model, size_t& vertexCount, size_t& indexCount)
+    {
+      for (size_t i = 0; i < node.children.size(); i++)
+      {
+        getNodeProps(model.nodes[node.children[i]], model, vertexCount, indexCount);
+      }
+      if (node.mesh > -1)
+      {
+        const tinygltf::Mesh& mesh = model.meshes[node.mesh];
+        for (const tinygltf::Primitive& primitive : mesh.primitives)
+        {
+          vertexCount += model.accessors[primitive.attributes.find("POSITION")->second].count;
+          if (primitive.indices > -1)
+          {
+            indexCount += model.accessors[primitive.indices].count;
+          }
+        }
+      }
+    }
+
     void loadNode(vkglTF::Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model,
-                  std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer, float globalscale)
+                  LoaderInfo& loaderInfo, float globalscale)
     {
       vkglTF::Node* newNode = new Node{};
       newNode->index = nodeIndex;
@@ -543,20 +1128,20 @@ namespace vkglTF
       {
         for (size_t i = 0; i < node.children.size(); i++)
         {
-          loadNode(newNode, model.nodes[node.children[i]], node.children[i], model, indexBuffer, vertexBuffer, globalscale);
+          loadNode(newNode, model.nodes[node.children[i]], node.children[i], model, loaderInfo, globalscale);
         }
       }
 
       // Node contains mesh data
       if (node.mesh > -1)
       {
-        const tinygltf::Mesh mesh = model.meshes[node.mesh];
+        const tinygltf::Mesh& mesh = model.meshes[node.mesh];
         Mesh* newMesh = new Mesh(newNode->matrix);
         for (size_t j = 0; j < mesh.primitives.size(); j++)
         {
           const tinygltf::Primitive& primitive = mesh.primitives[j];
-          uint32_t indexStart = static_cast<uint32_t>(indexBuffer.size());
-          uint32_t vertexStart = static_cast<uint32_t>(vertexBuffer.size());
+          uint32_t indexStart = static_cast<uint32_t>(loaderInfo.indexPos);
+          uint32_t vertexStart = static_cast<uint32_t>(loaderInfo.vertexPos);
           uint32_t indexCount = 0;
           uint32_t vertexCount = 0;
           glm::vec3 posMin{};
@@ -656,7 +1241,7 @@ namespace vkglTF
               {
                 vert.weight0 = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
               }
-              vertexBuffer.push_back(vert);
+              writeVertex(loaderInfo, vert);
             }
           }
           // Indices
@@ -676,7 +1261,7 @@ namespace vkglTF
               const uint32_t* buf = static_cast<const uint32_t*>(dataPtr);
               for (size_t index = 0; index < accessor.count; index++)
               {
-                indexBuffer.push_back(buf[index] + vertexStart);
+                loaderInfo.indexBuffer[loaderInfo.indexPos++] = buf[index] + vertexStart;
               }
               break;
             }
@@ -685,7 +1270,7 @@ namespace vkglTF
               const uint16_t* buf = static_cast<const uint16_t*>(dataPtr);
               for (size_t index = 0; index < accessor.count; index++)
               {
-                indexBuffer.push_back(buf[index] + vertexStart);
+                loaderInfo.indexBuffer[loaderInfo.indexPos++] = buf[index] + vertexStart;
               }
               break;
             }
@@ -694,7 +1279,7 @@ namespace vkglTF
               const uint8_t* buf = static_cast<const uint8_t*>(dataPtr);
               for (size_t index = 0; index < accessor.count; index++)
               {
-                indexBuffer.push_back(buf[index] + vertexStart);
+                loaderInfo.indexBuffer[loaderInfo.indexPos++] = buf[index] + vertexStart;
               }
               break;
             }
@@ -707,17 +1292,7 @@ namespace vkglTF
           newPrimitive->setBoundingBox(posMin, posMax);
           newMesh->primitives.push_back(newPrimitive);
         }
-        // Mesh BB from BBs of primitives
-        for (auto p : newMesh->primitives)
-        {
-          if (p->bb.valid && !newMesh->bb.valid)
-          {
-            newMesh->bb = p->bb;
-            newMesh->bb.valid = true;
-          }
-          newMesh->bb.min = glm::min(newMesh->bb.min, p->bb.min);
-          newMesh->bb.max = glm::max(newMesh->bb.max, p->bb.max);
-        }
+        newMesh->updateBoundingBox();
         newNode->mesh = newMesh;
       }
       if (parent)
@@ -903,128 +1478,886 @@ namespace vkglTF
       }
     }
 
-    void loadFromFile(std::string filename, VkPhysicalDevice physicalDevice, VkDevice device, VkQueue transferQueue, VkCommandPool commandPool, float scale = 1.0f)
-    {
-      tinygltf::Model gltfModel;
-      tinygltf::TinyGLTF gltfContext;
-      std::string error;
-      std::string warning;
+    /*
+      Mesh cache
+      The first load bakes the decoded vertex and index streams, the node table, skins, animation keys
+      and primitive bounds next to the glTF file. Later loads map the cache and copy the streams straight
+      into the staging buffers, skipping the JSON parse and the accessor decoding. The cache is rebaked
+      when the glTF file or one of its buffers changes, or when the vertex layout or streams differ.
+    */
+    static constexpr uint32_t meshCacheVersion = 1;
 
-      gltfPhysicalDevice = physicalDevice;
-      gltfLogicalDevice = device;
-      gltfCommandPool = commandPool;
-      vkGetPhysicalDeviceMemoryProperties(gltfPhysicalDevice, &glTFMemoryProperties);
+    enum MeshCacheSectionId : uint32_t
+    {
+      MeshCacheVertices = 1,
+      MeshCachePositions,
+      MeshCacheIndices,
+      MeshCacheStrings,
+      MeshCacheSources,
+      MeshCacheExtensions,
+      MeshCacheNodes,
+      MeshCachePrimitives,
+      MeshCacheSkins,
+      MeshCacheJoints,
+      MeshCacheInverseBindMatrices,
+      MeshCacheAnimations,
+      MeshCacheSamplers,
+      MeshCacheChannels,
+      MeshCacheInputs,
+      MeshCacheOutputs
+    };
 
-      bool binary = false;
-      size_t extpos = filename.rfind('.', filename.length());
-      if (extpos != std::string::npos)
-      {
-        binary = (filename.substr(extpos + 1, filename.length() - extpos) == "glb");
-      }
+    // Range in the string section
+    struct CachedString
+    {
+      uint32_t offset;
+      uint32_t length;
+    };
 
-      bool fileLoaded = binary ? gltfContext.LoadBinaryFromFile(&gltfModel, &error, &warning, filename.c_str())
-                               : gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, filename.c_str());
+    // Nodes are stored depth first, so a parent always precedes its children
+    struct CachedNode
+    {
+      int32_t parent;
+      uint32_t index;
+      int32_t skinIndex;
+      uint32_t hasMesh;
+      uint32_t firstPrimitive;
+      uint32_t primitiveCount;
+      CachedString name;
+      glm::mat4 matrix;
+      glm::quat rotation;
+      glm::vec3 translation;
+      glm::vec3 scale;
+    };
 
-      std::vector<uint32_t> indexBuffer;
-      std::vector<Vertex> vertexBuffer;
+    struct CachedPrimitive
+    {
+      uint32_t firstIndex;
+      uint32_t indexCount;
+      uint32_t vertexCount;
+      uint32_t hasBounds;
+      glm::vec3 min;
+      glm::vec3 max;
+    };
 
-      if (fileLoaded)
+    // Joints and the skeleton root are glTF node indices
+    struct CachedSkin
+    {
+      CachedString name;
+      int32_t skeletonRoot;
+      uint32_t firstJoint;
+      uint32_t jointCount;
+      uint32_t firstInverseBindMatrix;
+      uint32_t inverseBindMatrixCount;
+    };
+
+    struct CachedAnimation
+    {
+      CachedString name;
+      float start;
+      float end;
+      uint32_t firstSampler;
+      uint32_t samplerCount;
+      uint32_t firstChannel;
+      uint32_t channelCount;
+    };
+
+    struct CachedSampler
+    {
+      uint32_t interpolation;
+      uint32_t firstInput;
+      uint32_t inputCount;
+      uint32_t firstOutput;
+      uint32_t outputCount;
+    };
+
+    struct CachedChannel
+    {
+      uint32_t path;
+      uint32_t node;
+      uint32_t sampler;
+    };
+
+    // Identifies the settings a cache was baked with
+    uint64_t getMeshCacheKey() const
+    {
+      const uint32_t settings[3] = {meshCacheVersion, static_cast<uint32_t>(vertexLayout), static_cast<uint32_t>(vertexStreams)};
+      return BadgerSandbox::HashBytes(settings, sizeof(settings));
+    }
+
+    // The glTF file followed by its external buffers, which are given relative to it
+    static std::vector<std::string> getSourceFiles(const std::string& filename, const std::vector<std::string>& uris)
+    {
+      std::vector<std::string> sources{filename};
+      const size_t separator = filename.find_last_of("/\\");
+      const std::string directory = separator == std::string::npos ? std::string() : filename.substr(0, separator + 1);
+      for (const std::string& uri : uris)
       {
-        // TODO: scene handling with no default scene
-        const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
-        for (size_t i = 0; i < scene.nodes.size(); i++)
+        sources.push_back(directory + uri);
+      }
+      return sources;
+    }
+
+    static bool hashSourceFiles(const std::vector<std::string>& sources, uint64_t& hash)
+    {
+      const uint64_t count = sources.size();
+      hash = BadgerSandbox::HashBytes(&count, sizeof(count));
+      for (const std::string& source : sources)
+      {
+        if (!BadgerSandbox::HashFile(source, hash))
         {
-          const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
-          loadNode(nullptr, node, scene.nodes[i], gltfModel, indexBuffer, vertexBuffer, scale);
+          return false;
         }
-        if (gltfModel.animations.size() > 0)
+      }
+      return true;
+    }
+
+    static bool inRange(uint64_t first, uint64_t count, uint64_t size)
+    {
+      return first <= size && count <= size - first;
+    }
+
+    void createStagingBuffer(size_t size, StagingBuffer& staging)
+    {
+      staging.size = size;
+      if (size > 0)
+      {
+        RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, size,
+                                                   &staging.buffer, &staging.memory));
+        staging.mapped = staging.memory.mapped;
+      }
+    }
+
+    // Sizes the staging buffers for the model's layout and streams and points loaderInfo at them
+    void createStagingBuffers(size_t vertexCount, size_t indexCount, StagingBuffers& staging, LoaderInfo& loaderInfo)
+    {
+      const size_t positionSize = vertexStreams == VertexStreams::Interleaved ? 0 : sizeof(glm::vec3);
+      const size_t vertexBufferSize = vertexCount * (getVertexStride(vertexLayout) - (vertexStreams == VertexStreams::Split ? positionSize : 0));
+
+      assert(vertexBufferSize > 0);
+
+      createStagingBuffer(vertexBufferSize, staging.vertices);
+      createStagingBuffer(indexCount * sizeof(uint32_t), staging.indices);
+      createStagingBuffer(vertexCount * positionSize, staging.positions);
+      loaderInfo.vertexBuffer = static_cast<uint8_t*>(staging.vertices.mapped);
+      loaderInfo.indexBuffer = static_cast<uint32_t*>(staging.indices.mapped);
+      loaderInfo.positionBuffer = static_cast<glm::vec3*>(staging.positions.mapped);
+    }
+
+    // Reserves the model's range of geometryPool and moves the primitives into it. The staged indices stay relative
+    // to the model's first vertex, so only the draws change.
+    void placeInGeometryPool(const StagingBuffers& staging)
+    {
+      if (geometryPool->VertexStride() != getVertexBufferStride(vertexLayout, vertexStreams) ||
+          geometryPool->PositionStride() != getPositionBufferStride(vertexStreams))
+      {
+        throw std::runtime_error("The geometry pool strides do not match the vertex layout and streams of the model");
+      }
+      const uint32_t vertexCount = static_cast<uint32_t>(staging.vertices.size / geometryPool->VertexStride());
+      const uint32_t indexCount = static_cast<uint32_t>(staging.indices.size / sizeof(uint32_t));
+      if (!geometryPool->Allocate(vertexCount, indexCount, geometryRange))
+      {
+        throw std::runtime_error("Could not fit the model in the geometry pool");
+      }
+      vertices.buffer = geometryPool->VertexBuffer();
+      positions.buffer = geometryPool->PositionBuffer();
+      indices.buffer = indexCount > 0 ? geometryPool->IndexBuffer() : VK_NULL_HANDLE;
+
+      for (Node* node : linearNodes)
+      {
+        if (node->mesh)
         {
-          loadAnimations(gltfModel);
+          for (Primitive* primitive : node->mesh->primitives)
+          {
+            primitive->firstIndex += geometryRange.firstIndex;
+            primitive->vertexOffset = static_cast<int32_t>(geometryRange.firstVertex);
+          }
         }
-        loadSkins(gltfModel);
+      }
+    }
+
+    // Creates the device local buffers the staging buffers are copied to
+    void createDeviceBuffers(StagingBuffers& staging)
+    {
+      if (geometryPool != nullptr)
+      {
+        placeInGeometryPool(staging);
+        return;
+      }
+      // Create device local buffers
+      // Vertex buffer
+      RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, staging.vertices.size, &vertices.buffer, &vertices.memory));
+      // Index buffer
+      if (staging.indices.size > 0)
+      {
+        RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, staging.indices.size, &indices.buffer, &indices.memory));
+      }
+      // Position buffer
+      if (staging.positions.size > 0)
+      {
+        RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, staging.positions.size, &positions.buffer, &positions.memory));
+      }
+    }
+
+    void recordUploadCommands(VkCommandBuffer copyCmd, const StagingBuffers& staging)
+    {
+      // Models that own their buffers have an empty geometryRange, so their copies start at 0
+      VkBufferCopy copyRegion = {};
+
+      copyRegion.dstOffset = VkDeviceSize(geometryRange.firstVertex) * getVertexBufferStride(vertexLayout, vertexStreams);
+      copyRegion.size = staging.vertices.size;
+      vkCmdCopyBuffer(copyCmd, staging.vertices.buffer, vertices.buffer, 1, &copyRegion);
+
+      if (staging.indices.size > 0)
+      {
+        copyRegion.dstOffset = VkDeviceSize(geometryRange.firstIndex) * sizeof(uint32_t);
+        copyRegion.size = staging.indices.size;
+        vkCmdCopyBuffer(copyCmd, staging.indices.buffer, indices.buffer, 1, &copyRegion);
+      }
+
+      if (staging.positions.size > 0)
+      {
+        copyRegion.dstOffset = VkDeviceSize(geometryRange.firstVertex) * getPositionBufferStride(vertexStreams);
+        copyRegion.size = staging.positions.size;
+        vkCmdCopyBuffer(copyCmd, staging.positions.buffer, positions.buffer, 1, &copyRegion);
+      }
+    }
+
+    // Releases the staging buffers, their copies must have completed
+    void destroyStagingBuffers(StagingBuffers& staging)
+    {
+      StagingBuffer* stagingBuffers[3] = {&staging.vertices, &staging.indices, &staging.positions};
+      for (StagingBuffer* stagingBuffer : stagingBuffers)
+      {
+        if (stagingBuffer->size > 0)
+        {
+          gltfMemoryAllocator->DestroyBuffer(stagingBuffer->buffer, stagingBuffer->memory);
+        }
+        *stagingBuffer = StagingBuffer{};
+      }
+    }
+
+    // Copies the staging buffers to new device local buffers, waits for the copies and releases them
+    void uploadStagingBuffers(StagingBuffers& staging, VkQueue transferQueue)
+    {
+      createDeviceBuffers(staging);
+
+      VkCommandBuffer copyCmd = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+      recordUploadCommands(copyCmd, staging);
+      flushCommandBuffer(copyCmd, transferQueue, true);
 
-        for (auto node : linearNodes)
+      destroyStagingBuffers(staging);
+    }
+
+    // Submits the copies of the staging buffers without waiting for them. Command pools are externally
+    // synchronized, so the upload records into a transient pool of its own; the queue is shared with
+    // the render thread and only submitted to while holding queueMutex.
+    void submitStagingBuffers(StagingBuffers& staging, VkQueue transferQueue, std::mutex& queueMutex, uint32_t queueFamilyIndex)
+    {
+      createDeviceBuffers(staging);
+
+      VkCommandPoolCreateInfo commandPoolInfo{};
+      commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+      commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+      commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+      RapidVulkan::CheckError(vkCreateCommandPool(gltfLogicalDevice, &commandPoolInfo, nullptr, &pendingUpload.commandPool));
+
+      VkCommandBuffer copyCmd = createCommandBuffer(pendingUpload.commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+      recordUploadCommands(copyCmd, staging);
+      RapidVulkan::CheckError(vkEndCommandBuffer(copyCmd));
+
+      VkFenceCreateInfo fenceInfo{};
+      fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+      RapidVulkan::CheckError(vkCreateFence(gltfLogicalDevice, &fenceInfo, nullptr, &pendingUpload.fence));
+
+      VkSubmitInfo submitInfo{};
+      submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+      submitInfo.commandBufferCount = 1;
+      submitInfo.pCommandBuffers = &copyCmd;
+      {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        RapidVulkan::CheckError(vkQueueSubmit(transferQueue, 1, &submitInfo, pendingUpload.fence));
+      }
+
+      pendingUpload.staging = staging;
+      staging = StagingBuffers{};
+      uploadSubmitted.store(true, std::memory_order_release);
+    }
+
+    // Destroying the pool also frees the command buffer recorded into it
+    void releasePendingUpload()
+    {
+      destroyStagingBuffers(pendingUpload.staging);
+      vkDestroyFence(gltfLogicalDevice, pendingUpload.fence, nullptr);
+      vkDestroyCommandPool(gltfLogicalDevice, pendingUpload.commandPool, nullptr);
+      pendingUpload = PendingUpload{};
+    }
+
+    // Collects nodes children first, the order loadNode appends them to linearNodes
+    void addLinearNodes(Node* node)
+    {
+      for (auto& child : node->children)
+      {
+        addLinearNodes(child);
+      }
+      linearNodes.push_back(node);
+    }
+
+    // Bakes the loaded model, the vertex and index streams are read from the still mapped staging buffers
+    bool writeMeshCache(const std::string& cacheFile, const std::string& filename, const tinygltf::Model& gltfModel, const StagingBuffers& staging)
+    {
+      std::vector<std::string> uris;
+      for (const tinygltf::Buffer& buffer : gltfModel.buffers)
+      {
+        if (!buffer.uri.empty() && buffer.uri.compare(0, 5, "data:") != 0)
         {
-          // Assign skins
-          if (node->skinIndex > -1)
+          uris.push_back(buffer.uri);
+        }
+      }
+      uint64_t sourceHash;
+      if (!hashSourceFiles(getSourceFiles(filename, uris), sourceHash))
+      {
+        return false;
+      }
+
+      std::string strings;
+      auto addString = [&strings](const std::string& value) {
+        CachedString cached{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size())};
+        strings += value;
+        return cached;
+      };
+
+      std::vector<CachedString> cachedSources;
+      for (const std::string& uri : uris)
+      {
+        cachedSources.push_back(addString(uri));
+      }
+      std::vector<CachedString> cachedExtensions;
+      for (const std::string& extension : extensions)
+      {
+        cachedExtensions.push_back(addString(extension));
+      }
+
+      // Depth first walk that records each node's parent as a slot in the table
+      std::vector<CachedNode> cachedNodes;
+      std::vector<CachedPrimitive> cachedPrimitives;
+      std::vector<std::pair<Node*, int32_t>> stack;
+      for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+      {
+        stack.push_back({*it, -1});
+      }
+      while (!stack.empty())
+      {
+        Node* node = stack.back().first;
+        CachedNode cached{};
+        cached.parent = stack.back().second;
+        stack.pop_back();
+        cached.index = node->index;
+        cached.skinIndex = node->skinIndex;
+        cached.name = addString(node->name);
+        cached.matrix = node->matrix;
+        cached.rotation = node->rotation;
+        cached.translation = node->translation;
+        cached.scale = node->scale;
+        if (node->mesh)
+        {
+          cached.hasMesh = 1;
+          cached.firstPrimitive = static_cast<uint32_t>(cachedPrimitives.size());
+          cached.primitiveCount = static_cast<uint32_t>(node->mesh->primitives.size());
+          for (Primitive* primitive : node->mesh->primitives)
           {
-            node->skin = skins[node->skinIndex];
+            cachedPrimitives.push_back({primitive->firstIndex, primitive->indexCount, primitive->vertexCount, primitive->bb.valid ? 1u : 0u,
+                                        primitive->bb.min, primitive->bb.max});
           }
-          // Initial pose
-          if (node->mesh)
+        }
+        const int32_t slot = static_cast<int32_t>(cachedNodes.size());
+        cachedNodes.push_back(cached);
+        for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+        {
+          stack.push_back({*it, slot});
+        }
+      }
+
+      std::vector<CachedSkin> cachedSkins;
+      std::vector<uint32_t> joints;
+      std::vector<glm::mat4> inverseBindMatrices;
+      for (Skin* skin : skins)
+      {
+        CachedSkin cached{};
+        cached.name = addString(skin->name);
+        cached.skeletonRoot = skin->skeletonRoot ? static_cast<int32_t>(skin->skeletonRoot->index) : -1;
+        cached.firstJoint = static_cast<uint32_t>(joints.size());
+        cached.jointCount = static_cast<uint32_t>(skin->joints.size());
+        for (Node* joint : skin->joints)
+        {
+          joints.push_back(joint->index);
+        }
+        cached.firstInverseBindMatrix = static_cast<uint32_t>(inverseBindMatrices.size());
+        cached.inverseBindMatrixCount = static_cast<uint32_t>(skin->inverseBindMatrices.size());
+        inverseBindMatrices.insert(inverseBindMatrices.end(), skin->inverseBindMatrices.begin(), skin->inverseBindMatrices.end());
+        cachedSkins.push_back(cached);
+      }
+
+      std::vector<CachedAnimation> cachedAnimations;
+      std::vector<CachedSampler> cachedSamplers;
+      std::vector<CachedChannel> cachedChannels;
+      std::vector<float> inputs;
+      std::vector<glm::vec4> outputs;
+      for (const Animation& animation : animations)
+      {
+        CachedAnimation cached{};
+        cached.name = addString(animation.name);
+        cached.start = animation.start;
+        cached.end = animation.end;
+        cached.firstSampler = static_cast<uint32_t>(cachedSamplers.size());
+        cached.samplerCount = static_cast<uint32_t>(animation.samplers.size());
+        cached.firstChannel = static_cast<uint32_t>(cachedChannels.size());
+        cached.channelCount = static_cast<uint32_t>(animation.channels.size());
+        for (const AnimationSampler& sampler : animation.samplers)
+        {
+          cachedSamplers.push_back({static_cast<uint32_t>(sampler.interpolation), static_cast<uint32_t>(inputs.size()),
+                                    static_cast<uint32_t>(sampler.inputs.size()), static_cast<uint32_t>(outputs.size()),
+                                    static_cast<uint32_t>(sampler.outputsVec4.size())});
+          inputs.insert(inputs.end(), sampler.inputs.begin(), sampler.inputs.end());
+          outputs.insert(outputs.end(), sampler.outputsVec4.begin(), sampler.outputsVec4.end());
+        }
+        for (const AnimationChannel& channel : animation.channels)
+        {
+          cachedChannels.push_back({static_cast<uint32_t>(channel.path), channel.node->index, channel.samplerIndex});
+        }
+        cachedAnimations.push_back(cached);
+      }
+
+      BadgerSandbox::MeshCacheWriter writer;
+      writer.Add(MeshCacheVertices, staging.vertices.mapped, staging.vertices.size);
+      writer.Add(MeshCachePositions, staging.positions.mapped, staging.positions.size);
+      writer.Add(MeshCacheIndices, staging.indices.mapped, static_cast<size_t>(indices.count) * sizeof(uint32_t));
+      writer.Add(MeshCacheStrings, strings.data(), strings.size());
+      writer.Add(MeshCacheSources, cachedSources);
+      writer.Add(MeshCacheExtensions, cachedExtensions);
+      writer.Add(MeshCacheNodes, cachedNodes);
+      writer.Add(MeshCachePrimitives, cachedPrimitives);
+      writer.Add(MeshCacheSkins, cachedSkins);
+      writer.Add(MeshCacheJoints, joints);
+      writer.Add(MeshCacheInverseBindMatrices, inverseBindMatrices);
+      writer.Add(MeshCacheAnimations, cachedAnimations);
+      writer.Add(MeshCacheSamplers, cachedSamplers);
+      writer.Add(MeshCacheChannels, cachedChannels);
+      writer.Add(MeshCacheInputs, inputs);
+      writer.Add(MeshCacheOutputs, outputs);
+      return writer.Write(cacheFile, sourceHash, getMeshCacheKey());
+    }
+
+    // Rebuilds the model from a baked cache. Returns false, with the model untouched, if the cache is
+    // missing, stale or malformed.
+    bool loadMeshCache(const std::string& cacheFile, const std::string& filename, StagingBuffers& staging)
+    {
+      BadgerSandbox::MappedFile file;
+      BadgerSandbox::MeshCacheReader cache;
+      if (!file.Open(cacheFile) || !cache.Open(file.Data(), file.Size()) || cache.Key() != getMeshCacheKey())
+      {
+        return false;
+      }
+
+      const uint8_t* vertexData;
+      const glm::vec3* positionData;
+      const uint32_t* indexData;
+      const char* strings;
+      const CachedString* cachedSources;
+      const CachedString* cachedExtensions;
+      const CachedNode* cachedNodes;
+      const CachedPrimitive* cachedPrimitives;
+      const CachedSkin* cachedSkins;
+      const uint32_t* joints;
+      const glm::mat4* inverseBindMatrices;
+      const CachedAnimation* cachedAnimations;
+      const CachedSampler* cachedSamplers;
+      const CachedChannel* cachedChannels;
+      const float* inputs;
+      const glm::vec4* outputs;
+      size_t vertexSize, positionCount, indexCount, stringsSize, sourceCount, extensionCount, nodeCount, primitiveCount, skinCount, jointCount,
+        inverseBindMatrixCount, animationCount, samplerCount, channelCount, inputCount, outputCount;
+      if (!cache.Get(MeshCacheVertices, vertexData, vertexSize) || !cache.Get(MeshCachePositions, positionData, positionCount) ||
+          !cache.Get(MeshCacheIndices, indexData, indexCount) || !cache.Get(MeshCacheStrings, strings, stringsSize) ||
+          !cache.Get(MeshCacheSources, cachedSources, sourceCount) || !cache.Get(MeshCacheExtensions, cachedExtensions, extensionCount) ||
+          !cache.Get(MeshCacheNodes, cachedNodes, nodeCount) || !cache.Get(MeshCachePrimitives, cachedPrimitives, primitiveCount) ||
+          !cache.Get(MeshCacheSkins, cachedSkins, skinCount) || !cache.Get(MeshCacheJoints, joints, jointCount) ||
+          !cache.Get(MeshCacheInverseBindMatrices, inverseBindMatrices, inverseBindMatrixCount) ||
+          !cache.Get(MeshCacheAnimations, cachedAnimations, animationCount) || !cache.Get(MeshCacheSamplers, cachedSamplers, samplerCount) ||
+          !cache.Get(MeshCacheChannels, cachedChannels, channelCount) || !cache.Get(MeshCacheInputs, inputs, inputCount) ||
+          !cache.Get(MeshCacheOutputs, outputs, outputCount))
+      {
+        return false;
+      }
+
+      const size_t vertexStride = getVertexStride(vertexLayout) - (vertexStreams == VertexStreams::Split ? sizeof(glm::vec3) : 0);
+      const size_t vertexCount = vertexSize / vertexStride;
+      if (vertexSize == 0 || vertexSize % vertexStride != 0 || positionCount != (vertexStreams == VertexStreams::Interleaved ? 0 : vertexCount))
+      {
+        return false;
+      }
+
+      auto validString = [stringsSize](const CachedString& cached) { return inRange(cached.offset, cached.length, stringsSize); };
+      auto getString = [strings](const CachedString& cached) { return std::string(strings + cached.offset, cached.length); };
+
+      // Stale when a source changed
+      std::vector<std::string> uris;
+      for (size_t i = 0; i < sourceCount; i++)
+      {
+        if (!validString(cachedSources[i]))
+        {
+          return false;
+        }
+        uris.push_back(getString(cachedSources[i]));
+      }
+      uint64_t sourceHash;
+      if (!hashSourceFiles(getSourceFiles(filename, uris), sourceHash) || sourceHash != cache.SourceHash())
+      {
+        return false;
+      }
+
+      // Check every reference before anything is created
+      for (size_t i = 0; i < extensionCount; i++)
+      {
+        if (!validString(cachedExtensions[i]))
+        {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < indexCount; i++)
+      {
+        if (indexData[i] >= vertexCount)
+        {
+          return false;
+        }
+      }
+      std::unordered_set<uint32_t> nodeIndices;
+      for (size_t i = 0; i < nodeCount; i++)
+      {
+        const CachedNode& cached = cachedNodes[i];
+        nodeIndices.insert(cached.index);
+        if (cached.parent < -1 || cached.parent >= static_cast<int64_t>(i) || cached.skinIndex < -1 || cached.skinIndex >= static_cast<int64_t>(skinCount) ||
+            !inRange(cached.firstPrimitive, cached.primitiveCount, primitiveCount) || !validString(cached.name))
+        {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < primitiveCount; i++)
+      {
+        const CachedPrimitive& cached = cachedPrimitives[i];
+        if (!inRange(cached.firstIndex, cached.indexCount, indexCount) || cached.vertexCount > vertexCount)
+        {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < skinCount; i++)
+      {
+        const CachedSkin& cached = cachedSkins[i];
+        if (!inRange(cached.firstJoint, cached.jointCount, jointCount) ||
+            !inRange(cached.firstInverseBindMatrix, cached.inverseBindMatrixCount, inverseBindMatrixCount) || !validString(cached.name) ||
+            (cached.skeletonRoot > -1 && !nodeIndices.count(static_cast<uint32_t>(cached.skeletonRoot))))
+        {
+          return false;
+        }
+        for (uint32_t j = 0; j < cached.jointCount; j++)
+        {
+          if (!nodeIndices.count(joints[cached.firstJoint + j]))
           {
-            node->update();
+            return false;
           }
         }
       }
-      else
+      for (size_t i = 0; i < animationCount; i++)
       {
-          throw std::runtime_error("COULD NOT LOAD glTF MODEL");
+        const CachedAnimation& cached = cachedAnimations[i];
+        if (!inRange(cached.firstSampler, cached.samplerCount, samplerCount) || !inRange(cached.firstChannel, cached.channelCount, channelCount) ||
+            !validString(cached.name))
+        {
+          return false;
+        }
+        for (uint32_t c = 0; c < cached.channelCount; c++)
+        {
+          const CachedChannel& channel = cachedChannels[cached.firstChannel + c];
+          if (channel.sampler >= cached.samplerCount || channel.path > AnimationChannel::PathType::SCALE)
+          {
+            return false;
+          }
+        }
+      }
+      for (size_t i = 0; i < samplerCount; i++)
+      {
+        const CachedSampler& cached = cachedSamplers[i];
+        // Cubic spline samplers store an in-tangent, value and out-tangent per key
+        const size_t outputsPerInput = cached.interpolation == AnimationSampler::InterpolationType::CUBICSPLINE ? 3 : 1;
+        if (!inRange(cached.firstInput, cached.inputCount, inputCount) || !inRange(cached.firstOutput, cached.outputCount, outputCount) ||
+            cached.interpolation > AnimationSampler::InterpolationType::CUBICSPLINE || cached.outputCount < cached.inputCount * outputsPerInput)
+        {
+          return false;
+        }
       }
 
-      extensions = gltfModel.extensionsUsed;
-
-      size_t vertexBufferSize = vertexBuffer.size() * sizeof(Vertex);
-      size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
-      indices.count = static_cast<uint32_t>(indexBuffer.size());
+      LoaderInfo loaderInfo{};
+      createStagingBuffers(vertexCount, indexCount, staging, loaderInfo);
+      memcpy(staging.vertices.mapped, vertexData, staging.vertices.size);
+      memcpy(staging.indices.mapped, indexData, staging.indices.size);
+      memcpy(staging.positions.mapped, positionData, staging.positions.size);
+      indices.count = static_cast<uint32_t>(indexCount);
+
+      // Nodes
+      std::vector<Node*> slots(nodeCount);
+      std::unordered_map<uint32_t, Node*> nodesByIndex;
+      for (size_t i = 0; i < nodeCount; i++)
+      {
+        const CachedNode& cached = cachedNodes[i];
+        Node* newNode = new Node{};
+        newNode->index = cached.index;
+        newNode->parent = cached.parent > -1 ? slots[cached.parent] : nullptr;
+        newNode->name = getString(cached.name);
+        newNode->skinIndex = cached.skinIndex;
+        newNode->matrix = cached.matrix;
+        newNode->rotation = cached.rotation;
+        newNode->translation = cached.translation;
+        newNode->scale = cached.scale;
+        if (cached.hasMesh)
+        {
+          Mesh* newMesh = new Mesh(newNode->matrix);
+          for (uint32_t p = 0; p < cached.primitiveCount; p++)
+          {
+            const CachedPrimitive& primitive = cachedPrimitives[cached.firstPrimitive + p];
+            Primitive* newPrimitive = new Primitive(primitive.firstIndex, primitive.indexCount, primitive.vertexCount);
+            if (primitive.hasBounds)
+            {
+              newPrimitive->setBoundingBox(primitive.min, primitive.max);
+            }
+            newMesh->primitives.push_back(newPrimitive);
+          }
+          newMesh->updateBoundingBox();
+          newNode->mesh = newMesh;
+        }
+        if (newNode->parent)
+        {
+          newNode->parent->children.push_back(newNode);
+        }
+        else
+        {
+          nodes.push_back(newNode);
+        }
+        slots[i] = newNode;
+        nodesByIndex[newNode->index] = newNode;
+      }
+      for (auto node : nodes)
+      {
+        addLinearNodes(node);
+      }
+      auto findCachedNode = [&nodesByIndex](uint32_t index) {
+        auto it = nodesByIndex.find(index);
+        return it != nodesByIndex.end() ? it->second : nullptr;
+      };
 
-      assert(vertexBufferSize > 0);
+      // Skins
+      for (size_t i = 0; i < skinCount; i++)
+      {
+        const CachedSkin& cached = cachedSkins[i];
+        Skin* newSkin = new Skin{};
+        newSkin->name = getString(cached.name);
+        if (cached.skeletonRoot > -1)
+        {
+          newSkin->skeletonRoot = findCachedNode(static_cast<uint32_t>(cached.skeletonRoot));
+        }
+        for (uint32_t j = 0; j < cached.jointCount; j++)
+        {
+          newSkin->joints.push_back(findCachedNode(joints[cached.firstJoint + j]));
+        }
+        newSkin->inverseBindMatrices.assign(inverseBindMatrices + cached.firstInverseBindMatrix,
+                                            inverseBindMatrices + cached.firstInverseBindMatrix + cached.inverseBindMatrixCount);
+        skins.push_back(newSkin);
+      }
 
-      struct StagingBuffer
+      // Animations
+      for (size_t i = 0; i < animationCount; i++)
       {
-        VkBuffer buffer;
-        VkDeviceMemory memory;
-      } vertexStaging, indexStaging;
+        const CachedAnimation& cached = cachedAnimations[i];
+        vkglTF::Animation animation{};
+        animation.name = getString(cached.name);
+        animation.start = cached.start;
+        animation.end = cached.end;
+        for (uint32_t s = 0; s < cached.samplerCount; s++)
+        {
+          const CachedSampler& source = cachedSamplers[cached.firstSampler + s];
+          vkglTF::AnimationSampler sampler{};
+          sampler.interpolation = static_cast<AnimationSampler::InterpolationType>(source.interpolation);
+          sampler.inputs.assign(inputs + source.firstInput, inputs + source.firstInput + source.inputCount);
+          sampler.outputsVec4.assign(outputs + source.firstOutput, outputs + source.firstOutput + source.outputCount);
+          animation.samplers.push_back(sampler);
+        }
+        for (uint32_t c = 0; c < cached.channelCount; c++)
+        {
+          const CachedChannel& source = cachedChannels[cached.firstChannel + c];
+          vkglTF::AnimationChannel channel{};
+          channel.path = static_cast<AnimationChannel::PathType>(source.path);
+          channel.samplerIndex = source.sampler;
+          channel.node = findCachedNode(source.node);
+          if (!channel.node)
+          {
+            continue;
+          }
+          animation.channels.push_back(channel);
+        }
+        animations.push_back(animation);
+      }
 
-      // Create staging buffers
-      // Vertex data
-      RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBufferSize,
-                                                   &vertexStaging.buffer, &vertexStaging.memory, vertexBuffer.data()));
-      // Index data
-      if (indexBufferSize > 0)
+      for (size_t i = 0; i < extensionCount; i++)
       {
-        RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, indexBufferSize,
-                                                     &indexStaging.buffer, &indexStaging.memory, indexBuffer.data()));
+        extensions.push_back(getString(cachedExtensions[i]));
       }
+      return true;
+    }
 
-      // Create device local buffers
-      // Vertex buffer
-      RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBufferSize, &vertices.buffer, &vertices.memory));
-      // Index buffer
-      if (indexBufferSize > 0)
+    // Resolves skins and poses the model
+    void prepareScene()
+    {
+      // Assign skins
+      for (auto node : linearNodes)
       {
-        RapidVulkan::CheckError(createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBufferSize, &indices.buffer, &indices.memory));
+        if (node->skinIndex > -1)
+        {
+          node->skin = skins[node->skinIndex];
+        }
+      }
+      // Initial pose
+      sceneGraph.build(nodes);
+      for (auto skin : skins)
+      {
+        skin->jointIndices.clear();
+        for (auto joint : skin->joints)
+        {
+          skin->jointIndices.push_back(joint->graphIndex);
+        }
+        // glTF defaults missing inverse bind matrices to identity
+        skin->inverseBindMatrices.resize(skin->joints.size(), glm::mat4(1.0f));
+        skin->inverseBindTransforms.clear();
+        for (const auto& inverseBindMatrix : skin->inverseBindMatrices)
+        {
+          skin->inverseBindTransforms.push_back(toAffineTransform(inverseBindMatrix));
+        }
       }
+      updateNodes();
+    }
 
-      // Copy from staging buffers
-      VkCommandBuffer copyCmd = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+    // Resolves skins, poses the model and moves the staging buffers to device local memory
+    void finishLoading(StagingBuffers& staging, VkQueue transferQueue)
+    {
+      prepareScene();
 
-      VkBufferCopy copyRegion = {};
+      uploadStagingBuffers(staging, transferQueue);
 
-      copyRegion.size = vertexBufferSize;
-      vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, vertices.buffer, 1, &copyRegion);
+      getSceneDimensions();
+    }
 
-      if (indexBufferSize > 0)
+    // Fills the scene and the staging buffers from the mesh cache, or from the glTF file when the cache is missing or stale
+    void decodeFile(const std::string& filename, StagingBuffers& staging, float scale)
+    {
+      const std::string cacheFile = filename + ".meshcache";
+      if (useMeshCache && loadMeshCache(cacheFile, filename, staging))
       {
-        copyRegion.size = indexBufferSize;
-        vkCmdCopyBuffer(copyCmd, indexStaging.buffer, indices.buffer, 1, &copyRegion);
+        return;
       }
 
-      flushCommandBuffer(copyCmd, transferQueue, true);
+      tinygltf::Model gltfModel;
+      tinygltf::TinyGLTF gltfContext;
+      std::string error;
+      std::string warning;
 
-      vkDestroyBuffer(gltfLogicalDevice, vertexStaging.buffer, nullptr);
-      vkFreeMemory(gltfLogicalDevice, vertexStaging.memory, nullptr);
-      if (indexBufferSize > 0)
+      bool binary = false;
+      size_t extpos = filename.rfind('.', filename.length());
+      if (extpos != std::string::npos)
       {
-        vkDestroyBuffer(gltfLogicalDevice, indexStaging.buffer, nullptr);
-        vkFreeMemory(gltfLogicalDevice, indexStaging.memory, nullptr);
+        binary = (filename.substr(extpos + 1, filename.length() - extpos) == "glb");
       }
 
+      bool fileLoaded = binary ? gltfContext.LoadBinaryFromFile(&gltfModel, &error, &warning, filename.c_str())
+                               : gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, filename.c_str());
+
+      if (fileLoaded)
+      {
+        // TODO: scene handling with no default scene
+        const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
+
+        // Size the staging buffers from the accessor counts and decode the accessors straight into mapped memory
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        for (size_t i = 0; i < scene.nodes.size(); i++)
+        {
+          getNodeProps(gltfModel.nodes[scene.nodes[i]], gltfModel, vertexCount, indexCount);
+        }
+
+        LoaderInfo loaderInfo{};
+        createStagingBuffers(vertexCount, indexCount, staging, loaderInfo);
+
+        for (size_t i = 0; i < scene.nodes.size(); i++)
+        {
+          const tinygltf::Node& node = gltfModel.nodes[scene.nodes[i]];
+          loadNode(nullptr, node, scene.nodes[i], gltfModel, loaderInfo, scale);
+        }
+        indices.count = static_cast<uint32_t>(loaderInfo.indexPos);
+
+        if (gltfModel.animations.size() > 0)
+        {
+          loadAnimations(gltfModel);
+        }
+        loadSkins(gltfModel);
+        extensions = gltfModel.extensionsUsed;
+
+        if (useMeshCache && !writeMeshCache(cacheFile, filename, gltfModel, staging))
+        {
+          std::cout << "Could not write mesh cache " << cacheFile << ", loading without it" << std::endl;
+        }
+      }
+      else
+      {
+          throw std::runtime_error("COULD NOT LOAD glTF MODEL");
+      }
+    }
+
+    void loadFromFile(std::string filename, VkPhysicalDevice physicalDevice, VkDevice device, BadgerSandbox::DeviceMemoryAllocator& memoryAllocator,
+                      VkQueue transferQueue, VkCommandPool commandPool, float scale = 1.0f)
+    {
+      setDevice(physicalDevice, device, memoryAllocator);
+      gltfCommandPool = commandPool;
+
+      StagingBuffers staging;
+      decodeFile(filename, staging, scale);
+      finishLoading(staging, transferQueue);
+      uploadComplete = true;
+    }
+
+    // Decodes filename on the calling thread and submits its upload without waiting for it, so a worker
+    // can stream the model in while another thread keeps rendering. The model may only be drawn once
+    // pollUpload has returned true.
+    void streamFromFile(std::string filename, VkQueue transferQueue, std::mutex& queueMutex, uint32_t queueFamilyIndex, float scale = 1.0f)
+    {
+      StagingBuffers staging;
+      decodeFile(filename, staging, scale);
+      prepareScene();
       getSceneDimensions();
+      submitStagingBuffers(staging, transferQueue, queueMutex, queueFamilyIndex);
+    }
+
+    // Called by the render thread, returns true once the model can be drawn. The first call that sees the
+    // upload fence signalled releases the staging buffers, fence and command pool of the upload.
+    bool pollUpload()
+    {
+      if (!uploadComplete && uploadSubmitted.load(std::memory_order_acquire)
+          && vkGetFenceStatus(gltfLogicalDevice, pendingUpload.fence) == VK_SUCCESS)
+      {
+        releasePendingUpload();
+        uploadComplete = true;
+      }
+      return uploadComplete;
     }
 
     void drawNode(Node* node, VkCommandBuffer commandBuffer)
@@ -1033,7 +2366,7 @@ namespace vkglTF
       {
         for (Primitive* primitive : node->mesh->primitives)
         {
-          vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+          vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, primitive->vertexOffset, 0);
         }
       }
       for (auto& child : node->children)
@@ -1042,17 +2375,78 @@ namespace vkglTF
       }
     }
 
+    // Binds the vertex streams a lit pass, or a depth-only pass, reads and the index buffer. Every model of a
+    // GeometryPool binds the pool's buffers, so one bind covers the draws of all of them.
+    void bindBuffers(VkCommandBuffer commandBuffer, bool depthOnly = false)
+    {
+      const VkDeviceSize offsets[2] = {0, 0};
+      if (vertexStreams == VertexStreams::Interleaved || (!depthOnly && vertexStreams == VertexStreams::PositionsInterleaved))
+      {
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, offsets);
+      }
+      else if (depthOnly)
+      {
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &positions.buffer, offsets);
+      }
+      else
+      {
+        const VkBuffer buffers[2] = {positions.buffer, vertices.buffer};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+      }
+      if (indices.buffer != VK_NULL_HANDLE)
+      {
+        vkCmdBindIndexBuffer(commandBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+      }
+    }
+
     void draw(VkCommandBuffer commandBuffer)
     {
-      const VkDeviceSize offsets[1] = {0};
-      vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, offsets);
-      vkCmdBindIndexBuffer(commandBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+      bindBuffers(commandBuffer);
       for (auto& node : nodes)
       {
         drawNode(node, commandBuffer);
       }
     }
 
+    void drawNodeInstanced(Node* node, VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance)
+    {
+      if (node->mesh)
+      {
+        for (Primitive* primitive : node->mesh->primitives)
+        {
+          if (primitive->hasIndices)
+          {
+            vkCmdDrawIndexed(commandBuffer, primitive->indexCount, instanceCount, primitive->firstIndex, primitive->vertexOffset, firstInstance);
+          }
+          else
+          {
+            vkCmdDraw(commandBuffer, primitive->vertexCount, instanceCount, static_cast<uint32_t>(primitive->vertexOffset), firstInstance);
+          }
+        }
+      }
+      for (auto& child : node->children)
+      {
+        drawNodeInstanced(child, commandBuffer, instanceCount, firstInstance);
+      }
+    }
+
+    // Draws instanceCount copies of the model with a single draw per primitive. instanceBuffer holds an InstanceData
+    // for every instance from instanceOffset on and is bound at getInstanceBinding(vertexStreams, depthOnly), so the
+    // pipeline has to read it through getInstanceInputBinding and getInstanceInputAttributes.
+    void drawInstanced(VkCommandBuffer commandBuffer, VkBuffer instanceBuffer, VkDeviceSize instanceOffset, uint32_t instanceCount, uint32_t firstInstance = 0, bool depthOnly = false)
+    {
+      if (instanceCount == 0)
+      {
+        return;
+      }
+      bindBuffers(commandBuffer, depthOnly);
+      vkCmdBindVertexBuffers(commandBuffer, getInstanceBinding(vertexStreams, depthOnly), 1, &instanceBuffer, &instanceOffset);
+      for (auto& node : nodes)
+      {
+        drawNodeInstanced(node, commandBuffer, instanceCount, firstInstance);
+      }
+    }
+
     void calculateBoundingBox(Node* node, Node* parent)
     {
       BoundingBox parentBvh = parent ? parent->bvh : BoundingBox(dimensions.min, dimensions.max);
@@ -1125,61 +2519,87 @@ namespace vkglTF
       bool updated = false;
       for (auto& channel : animation.channels)
       {
-        vkglTF::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
-        if (sampler.inputs.size() > sampler.outputsVec4.size())
+        const vkglTF::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+        if (!sampler.valid())
         {
           continue;
         }
 
-        for (size_t i = 0; i < sampler.inputs.size() - 1; i++)
+        const bool rotation = channel.path == vkglTF::AnimationChannel::PathType::ROTATION;
+        const glm::vec4 value = sampler.evaluate(time, channel.cursor, rotation);
+        switch (channel.path)
         {
-          if ((time >= sampler.inputs[i]) && (time <= sampler.inputs[i + 1]))
-          {
-            float u = std::max(0.0f, time - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
-            if (u <= 1.0f)
-            {
-              switch (channel.path)
-              {
-              case vkglTF::AnimationChannel::PathType::TRANSLATION:
-              {
-                glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-                channel.node->translation = glm::vec3(trans);
-                break;
-              }
-              case vkglTF::AnimationChannel::PathType::SCALE:
-              {
-                glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-                channel.node->scale = glm::vec3(trans);
-                break;
-              }
-              case vkglTF::AnimationChannel::PathType::ROTATION:
-              {
-                glm::quat q1;
-                q1.x = sampler.outputsVec4[i].x;
-                q1.y = sampler.outputsVec4[i].y;
-                q1.z = sampler.outputsVec4[i].z;
-                q1.w = sampler.outputsVec4[i].w;
-                glm::quat q2;
-                q2.x = sampler.outputsVec4[i + 1].x;
-                q2.y = sampler.outputsVec4[i + 1].y;
-                q2.z = sampler.outputsVec4[i + 1].z;
-                q2.w = sampler.outputsVec4[i + 1].w;
-                channel.node->rotation = glm::normalize(glm::slerp(q1, q2, u));
-                break;
-              }
-              }
-              updated = true;
-            }
-          }
+        case vkglTF::AnimationChannel::PathType::TRANSLATION:
+          channel.node->translation = glm::vec3(value);
+          break;
+        case vkglTF::AnimationChannel::PathType::SCALE:
+          channel.node->scale = glm::vec3(value);
+          break;
+        case vkglTF::AnimationChannel::PathType::ROTATION:
+          channel.node->rotation = vkglTF::AnimationSampler::toQuat(value);
+          break;
         }
+        sceneGraph.markDirty(channel.node);
+        updated = true;
       }
       if (updated)
       {
-        for (auto& node : nodes)
+        updateNodes();
+      }
+    }
+
+    // Propagates dirty transforms through the scene graph and refreshes the mesh uniforms that depend on them
+    void updateNodes()
+    {
+      sceneGraph.update();
+      for (size_t i = 0; i < sceneGraph.nodes.size(); i++)
+      {
+        Node* node = sceneGraph.nodes[i];
+        if (!node->mesh)
         {
-          node->update();
+          continue;
         }
+        if (node->skin)
+        {
+          updateSkin(*node, sceneGraph.changed[i] != 0);
+        }
+        else if (sceneGraph.changed[i])
+        {
+          node->updateMesh();
+        }
+      }
+    }
+
+    // Rebuilds the joint matrices of a skinned mesh from the cached joint world matrices.
+    // Skipped entirely when neither the mesh node nor any of its joints moved.
+    void updateSkin(Node& node, bool nodeChanged)
+    {
+      Mesh* mesh = node.mesh;
+      Skin* skin = node.skin;
+      const size_t numJoints = std::min((uint32_t)skin->jointIndices.size(), MAX_NUM_JOINTS);
+
+      bool jointsChanged = nodeChanged;
+      for (size_t i = 0; i < numJoints && !jointsChanged; i++)
+      {
+        jointsChanged = sceneGraph.changed[skin->jointIndices[i]] != 0;
+      }
+      if (!jointsChanged)
+      {
+        return;
+      }
+
+      if (nodeChanged)
+      {
+        mesh->uniformBlock.matrix = sceneGraph.worldMatrices[node.graphIndex];
+        mesh->inverseTransform = BadgerSandbox::Inverse(toAffineTransform(mesh->uniformBlock.matrix));
+      }
+      for (size_t i = 0; i < numJoints; i++)
+      {
+        const BadgerSandbox::AffineTransform jointTransform = toAffineTransform(sceneGraph.worldMatrices[skin->jointIndices[i]]);
+        mesh->uniformBlock.jointMatrix[i] = toMat4(mesh->inverseTransform * jointTransform * skin->inverseBindTransforms[i]);
       }
+      mesh->uniformBlock.jointcount = (float)numJoints;
+      memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
     }
 
     /*
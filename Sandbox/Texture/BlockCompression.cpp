@@ -0,0 +1,410 @@
+#include "BlockCompression.hpp"
+#include <cstring>
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  // The 16 texels of a block, RGBA8 in row order
+	  typedef uint8_t Block[16][4];
+
+	  uint32_t Squared(int32_t value)
+	  {
+		  return (static_cast<uint32_t>(value * value));
+	  }
+
+	  // Little endian bit packing of a 64 or 128 bit block
+	  class BitWriter
+	  {
+	  private:
+	    uint8_t* bytes;
+	    uint32_t position;
+	  public:
+		  explicit BitWriter(uint8_t* bytes, size_t size) : bytes(bytes), position(0) { memset(bytes, 0, size); }
+
+		  void Write(uint32_t value, uint32_t bitCount)
+		  {
+			  for (uint32_t i = 0; i < bitCount; i++, position++)
+			  {
+				  bytes[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (position & 7));
+			  }
+		  }
+	  };
+
+	  // Principal axis of the first channelCount channels of the block, by power iteration on their covariance.
+	  // Returns false for a flat block. mean receives the block average.
+	  bool PrincipalAxis(const Block& block, int channelCount, float mean[4], float axis[4])
+	  {
+		  for (int c = 0; c < 4; c++)
+		  {
+			  mean[c] = 0.0f;
+			  axis[c] = 0.0f;
+		  }
+		  for (int i = 0; i < 16; i++)
+		  {
+			  for (int c = 0; c < channelCount; c++)
+			  {
+				  mean[c] += block[i][c];
+			  }
+		  }
+		  for (int c = 0; c < channelCount; c++)
+		  {
+			  mean[c] /= 16.0f;
+		  }
+		  float covariance[4][4] = {};
+		  for (int i = 0; i < 16; i++)
+		  {
+			  for (int a = 0; a < channelCount; a++)
+			  {
+				  for (int b = 0; b < channelCount; b++)
+				  {
+					  covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+				  }
+			  }
+		  }
+		  int widest = 0;
+		  for (int c = 1; c < channelCount; c++)
+		  {
+			  widest = covariance[c][c] > covariance[widest][widest] ? c : widest;
+		  }
+		  if (covariance[widest][widest] <= 0.0f)
+		  {
+			  return (false);
+		  }
+		  // Start from the diagonal, which keeps blocks whose channels vary independently (gradients along x and y)
+		  // on a line through all of them. Should it be orthogonal to every principal axis, restart from the widest channel
+		  for (int c = 0; c < channelCount; c++)
+		  {
+			  axis[c] = 1.0f;
+		  }
+		  for (int iteration = 0; iteration < 8; iteration++)
+		  {
+			  float next[4] = {};
+			  float largest = 0.0f;
+			  for (int a = 0; a < channelCount; a++)
+			  {
+				  for (int b = 0; b < channelCount; b++)
+				  {
+					  next[a] += covariance[a][b] * axis[b];
+				  }
+				  largest = next[a] > largest ? next[a] : (-next[a] > largest ? -next[a] : largest);
+			  }
+			  if (largest <= 0.0f)
+			  {
+				  for (int c = 0; c < channelCount; c++)
+				  {
+					  axis[c] = c == widest ? 1.0f : 0.0f;
+				  }
+				  continue;
+			  }
+			  for (int c = 0; c < channelCount; c++)
+			  {
+				  axis[c] = next[c] / largest;
+			  }
+		  }
+		  return (true);
+	  }
+
+	  // Block texels projected on axis through mean, as the two extreme points of the line
+	  void AxisEndpoints(const Block& block, int channelCount, const float mean[4], const float axis[4], float low[4], float high[4])
+	  {
+		  float axisLength = 0.0f;
+		  for (int c = 0; c < channelCount; c++)
+		  {
+			  axisLength += axis[c] * axis[c];
+		  }
+		  float minimum = 0.0f;
+		  float maximum = 0.0f;
+		  for (int i = 0; i < 16; i++)
+		  {
+			  float t = 0.0f;
+			  for (int c = 0; c < channelCount; c++)
+			  {
+				  t += (block[i][c] - mean[c]) * axis[c];
+			  }
+			  minimum = t < minimum ? t : minimum;
+			  maximum = t > maximum ? t : maximum;
+		  }
+		  for (int c = 0; c < 4; c++)
+		  {
+			  low[c] = mean[c] + axis[c] * minimum / axisLength;
+			  high[c] = mean[c] + axis[c] * maximum / axisLength;
+		  }
+	  }
+
+	  int32_t ClampByte(float value)
+	  {
+		  return (value <= 0.0f ? 0 : (value >= 255.0f ? 255 : static_cast<int32_t>(value + 0.5f)));
+	  }
+
+	  uint16_t Pack565(const float colour[4])
+	  {
+		  const uint32_t r = (ClampByte(colour[0]) * 31 + 127) / 255;
+		  const uint32_t g = (ClampByte(colour[1]) * 63 + 127) / 255;
+		  const uint32_t b = (ClampByte(colour[2]) * 31 + 127) / 255;
+		  return (static_cast<uint16_t>((r << 11) | (g << 5) | b));
+	  }
+
+	  void Unpack565(uint16_t packed, int32_t colour[3])
+	  {
+		  const int32_t r = (packed >> 11) & 31;
+		  const int32_t g = (packed >> 5) & 63;
+		  const int32_t b = packed & 31;
+		  colour[0] = (r << 3) | (r >> 2);
+		  colour[1] = (g << 2) | (g >> 4);
+		  colour[2] = (b << 3) | (b >> 2);
+	  }
+
+	  // Four colour BC1 block, colour0 > colour1 so BC3 decodes it the same way
+	  void CompressColourBlock(const Block& block, uint8_t* destination)
+	  {
+		  float mean[4], axis[4], low[4], high[4];
+		  uint16_t colour0, colour1;
+		  if (PrincipalAxis(block, 3, mean, axis))
+		  {
+			  AxisEndpoints(block, 3, mean, axis, low, high);
+			  colour0 = Pack565(high);
+			  colour1 = Pack565(low);
+		  }
+		  else
+		  {
+			  colour0 = colour1 = Pack565(mean);
+		  }
+		  if (colour0 < colour1)
+		  {
+			  const uint16_t swap = colour0;
+			  colour0 = colour1;
+			  colour1 = swap;
+		  }
+
+		  uint32_t indices = 0;
+		  if (colour0 != colour1)
+		  {
+			  int32_t palette[4][3];
+			  Unpack565(colour0, palette[0]);
+			  Unpack565(colour1, palette[1]);
+			  for (int c = 0; c < 3; c++)
+			  {
+				  palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				  palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			  }
+			  for (int i = 0; i < 16; i++)
+			  {
+				  uint32_t best = 0;
+				  uint32_t bestError = UINT32_MAX;
+				  for (uint32_t p = 0; p < 4; p++)
+				  {
+					  const uint32_t error = Squared(block[i][0] - palette[p][0]) + Squared(block[i][1] - palette[p][1]) + Squared(block[i][2] - palette[p][2]);
+					  if (error < bestError)
+					  {
+						  best = p;
+						  bestError = error;
+					  }
+				  }
+				  indices |= best << (i * 2);
+			  }
+		  }
+		  destination[0] = static_cast<uint8_t>(colour0);
+		  destination[1] = static_cast<uint8_t>(colour0 >> 8);
+		  destination[2] = static_cast<uint8_t>(colour1);
+		  destination[3] = static_cast<uint8_t>(colour1 >> 8);
+		  memcpy(destination + 4, &indices, sizeof(indices));
+	  }
+
+	  // Eight value BC4 block of one channel, also the alpha half of BC3 and both halves of BC5
+	  void CompressChannelBlock(const Block& block, int channel, uint8_t* destination)
+	  {
+		  int32_t high = 0;
+		  int32_t low = 255;
+		  for (int i = 0; i < 16; i++)
+		  {
+			  high = block[i][channel] > high ? block[i][channel] : high;
+			  low = block[i][channel] < low ? block[i][channel] : low;
+		  }
+		  BitWriter writer(destination, 8);
+		  writer.Write(static_cast<uint32_t>(high), 8);
+		  writer.Write(static_cast<uint32_t>(low), 8);
+		  if (high == low)
+		  {
+			  return;
+		  }
+		  int32_t palette[8] = { high, low };
+		  for (int p = 1; p < 7; p++)
+		  {
+			  palette[p + 1] = ((7 - p) * high + p * low) / 7;
+		  }
+		  for (int i = 0; i < 16; i++)
+		  {
+			  uint32_t best = 0;
+			  uint32_t bestError = UINT32_MAX;
+			  for (uint32_t p = 0; p < 8; p++)
+			  {
+				  const uint32_t error = Squared(block[i][channel] - palette[p]);
+				  if (error < bestError)
+				  {
+					  best = p;
+					  bestError = error;
+				  }
+			  }
+			  writer.Write(best, 3);
+		  }
+	  }
+
+	  const int32_t kBC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	  // 7 bit endpoint and shared p-bit closest to an RGBA colour, the decoded endpoint is (value << 1) | pBit
+	  void QuantizeBC7Endpoint(const float colour[4], uint32_t quantized[4], uint32_t& pBit)
+	  {
+		  uint32_t bestError = UINT32_MAX;
+		  for (uint32_t p = 0; p < 2; p++)
+		  {
+			  uint32_t candidate[4];
+			  uint32_t error = 0;
+			  for (int c = 0; c < 4; c++)
+			  {
+				  const int32_t target = ClampByte(colour[c]);
+				  int32_t value = (target - static_cast<int32_t>(p) + 1) >> 1;
+				  value = value < 0 ? 0 : (value > 127 ? 127 : value);
+				  candidate[c] = static_cast<uint32_t>(value);
+				  error += Squared(target - ((value << 1) | static_cast<int32_t>(p)));
+			  }
+			  if (error < bestError)
+			  {
+				  bestError = error;
+				  pBit = p;
+				  memcpy(quantized, candidate, sizeof(candidate));
+			  }
+		  }
+	  }
+
+	  // BC7 mode 6: a single subset with RGBA endpoints and 16 interpolation steps
+	  void CompressBC7Block(const Block& block, uint8_t* destination)
+	  {
+		  float mean[4], axis[4], low[4], high[4];
+		  if (PrincipalAxis(block, 4, mean, axis))
+		  {
+			  AxisEndpoints(block, 4, mean, axis, low, high);
+		  }
+		  else
+		  {
+			  memcpy(low, mean, sizeof(mean));
+			  memcpy(high, mean, sizeof(mean));
+		  }
+		  uint32_t endpoints[2][4];
+		  uint32_t pBits[2];
+		  QuantizeBC7Endpoint(low, endpoints[0], pBits[0]);
+		  QuantizeBC7Endpoint(high, endpoints[1], pBits[1]);
+
+		  int32_t palette[16][4];
+		  for (int c = 0; c < 4; c++)
+		  {
+			  const int32_t e0 = static_cast<int32_t>((endpoints[0][c] << 1) | pBits[0]);
+			  const int32_t e1 = static_cast<int32_t>((endpoints[1][c] << 1) | pBits[1]);
+			  for (int p = 0; p < 16; p++)
+			  {
+				  palette[p][c] = ((64 - kBC7Weights4[p]) * e0 + kBC7Weights4[p] * e1 + 32) >> 6;
+			  }
+		  }
+		  uint32_t indices[16];
+		  for (int i = 0; i < 16; i++)
+		  {
+			  uint32_t bestError = UINT32_MAX;
+			  for (uint32_t p = 0; p < 16; p++)
+			  {
+				  uint32_t error = 0;
+				  for (int c = 0; c < 4; c++)
+				  {
+					  error += Squared(block[i][c] - palette[p][c]);
+				  }
+				  if (error < bestError)
+				  {
+					  indices[i] = p;
+					  bestError = error;
+				  }
+			  }
+		  }
+		  // The most significant bit of the first index is implied zero, swap the endpoints to make it so
+		  if (indices[0] >= 8)
+		  {
+			  for (int c = 0; c < 4; c++)
+			  {
+				  const uint32_t swap = endpoints[0][c];
+				  endpoints[0][c] = endpoints[1][c];
+				  endpoints[1][c] = swap;
+			  }
+			  const uint32_t swap = pBits[0];
+			  pBits[0] = pBits[1];
+			  pBits[1] = swap;
+			  for (int i = 0; i < 16; i++)
+			  {
+				  indices[i] = 15 - indices[i];
+			  }
+		  }
+
+		  BitWriter writer(destination, 16);
+		  writer.Write(1 << 6, 7);
+		  for (int c = 0; c < 4; c++)
+		  {
+			  writer.Write(endpoints[0][c], 7);
+			  writer.Write(endpoints[1][c], 7);
+		  }
+		  writer.Write(pBits[0], 1);
+		  writer.Write(pBits[1], 1);
+		  writer.Write(indices[0], 3);
+		  for (int i = 1; i < 16; i++)
+		  {
+			  writer.Write(indices[i], 4);
+		  }
+	  }
+  }
+
+  size_t CompressedLevelSize(BlockFormat format, uint32_t width, uint32_t height)
+  {
+	  return (static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format));
+  }
+
+  void CompressBlockRow(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockRow, uint8_t* destination)
+  {
+	  const uint32_t blockCount = (width + 3) / 4;
+	  for (uint32_t blockX = 0; blockX < blockCount; blockX++)
+	  {
+		  Block block;
+		  for (uint32_t y = 0; y < 4; y++)
+		  {
+			  const uint32_t sourceY = blockRow * 4 + y < height ? blockRow * 4 + y : height - 1;
+			  for (uint32_t x = 0; x < 4; x++)
+			  {
+				  const uint32_t sourceX = blockX * 4 + x < width ? blockX * 4 + x : width - 1;
+				  memcpy(block[y * 4 + x], rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+			  }
+		  }
+		  uint8_t* out = destination + blockX * BlockBytes(format);
+		  switch (format)
+		  {
+		  case BlockFormat::BC1:
+			  CompressColourBlock(block, out);
+			  break;
+		  case BlockFormat::BC3:
+			  CompressChannelBlock(block, 3, out);
+			  CompressColourBlock(block, out + 8);
+			  break;
+		  case BlockFormat::BC5:
+			  CompressChannelBlock(block, 0, out);
+			  CompressChannelBlock(block, 1, out + 8);
+			  break;
+		  case BlockFormat::BC7:
+			  CompressBC7Block(block, out);
+			  break;
+		  }
+	  }
+  }
+
+  void CompressRGBA(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* destination)
+  {
+	  const size_t rowBytes = static_cast<size_t>((width + 3) / 4) * BlockBytes(format);
+	  for (uint32_t blockRow = 0; blockRow < (height + 3) / 4; blockRow++)
+	  {
+		  CompressBlockRow(format, rgba, width, height, blockRow, destination + blockRow * rowBytes);
+	  }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace BadgerSandbox
+{
+	// Block compressed formats the encoders below produce, all in 4x4 texel blocks
+	enum class BlockFormat : uint32_t
+	{
+		BC1,  // RGB, 8 bytes per block
+		BC3,  // RGBA, BC1 colour with a BC4 alpha block, 16 bytes per block
+		BC5,  // Two channels (red and green) as two BC4 blocks, 16 bytes per block, meant for normal maps
+		BC7   // RGBA, 16 bytes per block
+	};
+
+	inline size_t BlockBytes(BlockFormat format) { return (format == BlockFormat::BC1 ? 8 : 16); }
+	// Bytes of one width x height level, partial blocks at the edges count as whole ones.
+	size_t CompressedLevelSize(BlockFormat format, uint32_t width, uint32_t height);
+
+	// Encodes the 4x4 blocks of block row blockRow of an RGBA8 image into destination, which receives
+	// (width + 3) / 4 blocks. Texels outside the image repeat the last row and column. Rows are
+	// independent, so a level can be compressed in parallel a row at a time.
+	void CompressBlockRow(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockRow, uint8_t* destination);
+	// Encodes a whole RGBA8 level into CompressedLevelSize bytes at destination.
+	void CompressRGBA(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* destination);
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "DdsFile.hpp"
+#include "TextureProcessing.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  const uint32_t Magic = 0x20534444;  // "DDS "
+	  const uint32_t PixelFormatFourCC = 0x4;
+	  const uint32_t HeaderCaps = 0x1, HeaderHeight = 0x2, HeaderWidth = 0x4, HeaderPixelFormat = 0x1000, HeaderMipMapCount = 0x20000,
+		  HeaderLinearSize = 0x80000;
+	  const uint32_t CapsComplex = 0x8, CapsTexture = 0x1000, CapsMipMap = 0x400000;
+	  const uint32_t ResourceDimensionTexture2D = 3;
+
+	  struct DdsPixelFormat
+	  {
+		  uint32_t size;
+		  uint32_t flags;
+		  uint32_t fourCC;
+		  uint32_t rgbBitCount;
+		  uint32_t bitMasks[4];
+	  };
+
+	  struct DdsHeader
+	  {
+		  uint32_t size;
+		  uint32_t flags;
+		  uint32_t height;
+		  uint32_t width;
+		  uint32_t pitchOrLinearSize;
+		  uint32_t depth;
+		  uint32_t mipMapCount;
+		  uint32_t reserved1[11];
+		  DdsPixelFormat pixelFormat;
+		  uint32_t caps[4];
+		  uint32_t reserved2;
+	  };
+	  static_assert(sizeof(DdsHeader) == 124, "DDS_HEADER is 124 bytes");
+
+	  struct DdsHeaderDX10
+	  {
+		  uint32_t dxgiFormat;
+		  uint32_t resourceDimension;
+		  uint32_t miscFlag;
+		  uint32_t arraySize;
+		  uint32_t miscFlags2;
+	  };
+
+	  constexpr uint32_t FourCC(char a, char b, char c, char d)
+	  {
+		  return (uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24);
+	  }
+
+	  // DXGI_FORMAT values of the UNORM variants
+	  const uint32_t DxgiFormats[] = { 71, 77, 83, 98 };
+
+	  bool FormatFromFourCC(uint32_t fourCC, BlockFormat& format)
+	  {
+		  switch (fourCC)
+		  {
+		  case FourCC('D', 'X', 'T', '1'):
+			  format = BlockFormat::BC1;
+			  return (true);
+		  case FourCC('D', 'X', 'T', '5'):
+			  format = BlockFormat::BC3;
+			  return (true);
+		  case FourCC('A', 'T', 'I', '2'):
+		  case FourCC('B', 'C', '5', 'U'):
+			  format = BlockFormat::BC5;
+			  return (true);
+		  default:
+			  return (false);
+		  }
+	  }
+
+	  bool FormatFromDxgi(uint32_t dxgiFormat, BlockFormat& format)
+	  {
+		  for (uint32_t i = 0; i < sizeof(DxgiFormats) / sizeof(DxgiFormats[0]); i++)
+		  {
+			  if (DxgiFormats[i] == dxgiFormat)
+			  {
+				  format = static_cast<BlockFormat>(i);
+				  return (true);
+			  }
+		  }
+		  return (false);
+	  }
+  }
+
+  size_t CompressedChainSize(BlockFormat format, uint32_t width, uint32_t height, uint32_t levelCount)
+  {
+	  size_t size = 0;
+	  for (uint32_t level = 0; level < levelCount; level++)
+	  {
+		  size += CompressedLevelSize(format, MipExtent(width, level), MipExtent(height, level));
+	  }
+	  return (size);
+  }
+
+  bool ReadDds(const uint8_t* bytes, size_t size, CompressedTexture& texture)
+  {
+	  uint32_t magic;
+	  DdsHeader header;
+	  if (size < sizeof(magic) + sizeof(header))
+	  {
+		  return (false);
+	  }
+	  memcpy(&magic, bytes, sizeof(magic));
+	  memcpy(&header, bytes + sizeof(magic), sizeof(header));
+	  size_t offset = sizeof(magic) + sizeof(header);
+	  if (magic != Magic || header.size != sizeof(DdsHeader) || header.pixelFormat.size != sizeof(DdsPixelFormat) ||
+		  (header.pixelFormat.flags & PixelFormatFourCC) == 0 || (header.caps[1] != 0) || header.width == 0 || header.height == 0)
+	  {
+		  return (false);
+	  }
+
+	  if (header.pixelFormat.fourCC == FourCC('D', 'X', '1', '0'))
+	  {
+		  DdsHeaderDX10 extension;
+		  if (size < offset + sizeof(extension))
+		  {
+			  return (false);
+		  }
+		  memcpy(&extension, bytes + offset, sizeof(extension));
+		  offset += sizeof(extension);
+		  if (!FormatFromDxgi(extension.dxgiFormat, texture.format) || extension.resourceDimension != ResourceDimensionTexture2D ||
+			  extension.arraySize != 1)
+		  {
+			  return (false);
+		  }
+	  }
+	  else if (!FormatFromFourCC(header.pixelFormat.fourCC, texture.format))
+	  {
+		  return (false);
+	  }
+
+	  texture.width = header.width;
+	  texture.height = header.height;
+	  texture.mipLevels = (header.flags & HeaderMipMapCount) != 0 && header.mipMapCount > 0 ? header.mipMapCount : 1;
+	  if (texture.mipLevels > MipLevelCount(texture.width, texture.height))
+	  {
+		  return (false);
+	  }
+	  texture.size = CompressedChainSize(texture.format, texture.width, texture.height, texture.mipLevels);
+	  if (size - offset < texture.size)
+	  {
+		  return (false);
+	  }
+	  texture.data = bytes + offset;
+	  return (true);
+  }
+
+  bool WriteDds(const std::string& path, const CompressedTexture& texture)
+  {
+	  DdsHeader header = {};
+	  header.size = sizeof(DdsHeader);
+	  header.flags = HeaderCaps | HeaderHeight | HeaderWidth | HeaderPixelFormat | HeaderMipMapCount | HeaderLinearSize;
+	  header.height = texture.height;
+	  header.width = texture.width;
+	  header.pitchOrLinearSize = static_cast<uint32_t>(CompressedLevelSize(texture.format, texture.width, texture.height));
+	  header.mipMapCount = texture.mipLevels;
+	  header.pixelFormat.size = sizeof(DdsPixelFormat);
+	  header.pixelFormat.flags = PixelFormatFourCC;
+	  header.pixelFormat.fourCC = FourCC('D', 'X', '1', '0');
+	  header.caps[0] = CapsTexture | (texture.mipLevels > 1 ? CapsComplex | CapsMipMap : 0);
+
+	  DdsHeaderDX10 extension = {};
+	  extension.dxgiFormat = DxgiFormats[static_cast<uint32_t>(texture.format)];
+	  extension.resourceDimension = ResourceDimensionTexture2D;
+	  extension.arraySize = 1;
+
+	  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	  if (!file)
+	  {
+		  return (false);
+	  }
+	  file.write(reinterpret_cast<const char*>(&Magic), sizeof(Magic));
+	  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	  file.write(reinterpret_cast<const char*>(&extension), sizeof(extension));
+	  file.write(reinterpret_cast<const char*>(texture.data), static_cast<std::streamsize>(texture.size));
+	  if (!file)
+	  {
+		  file.close();
+		  std::remove(path.c_str());
+		  return (false);
+	  }
+	  return (true);
+  }
+}
\ No newline at end of file
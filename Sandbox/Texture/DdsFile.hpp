@@ -0,0 +1,29 @@
+#pragma once
+#include "BlockCompression.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace BadgerSandbox
+{
+	// A block compressed texture and its mip chain, levels stored largest first one after the other.
+	struct CompressedTexture
+	{
+		BlockFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+		const uint8_t* data;
+		size_t size;
+	};
+
+	// Bytes of the first levelCount levels of a chain.
+	size_t CompressedChainSize(BlockFormat format, uint32_t width, uint32_t height, uint32_t levelCount);
+
+	// Parses a 2D DDS file held in memory, texture.data points into bytes. Understands the legacy DXT1, DXT5
+	// and ATI2 codes and the DX10 header with the BC1, BC3, BC5 and BC7 UNORM formats. Fails on anything
+	// else or if the levels do not fit in size.
+	bool ReadDds(const uint8_t* bytes, size_t size, CompressedTexture& texture);
+	// Writes texture with a DX10 header, which every format above needs for BC7 anyway.
+	bool WriteDds(const std::string& path, const CompressedTexture& texture);
+}
\ No newline at end of file
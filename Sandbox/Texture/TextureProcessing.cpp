@@ -0,0 +1,145 @@
+#include "TextureProcessing.hpp"
+#include "SimdConfig.hpp"
+#include <cstring>
+#if defined(BADGER_SANDBOX_SIMD_SSE) && defined(__SSSE3__) && !defined(BADGER_SANDBOX_SIMD_AVX)
+  #include <tmmintrin.h>
+#endif
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  uint32_t Average(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+	  {
+		  return ((a + b + c + d + 2) >> 2);
+	  }
+
+	  // One destination texel from the 2x2 block at (x0, row0) - (x1, row1)
+	  void DownsampleTexel(const uint8_t* row0, const uint8_t* row1, uint32_t x0, uint32_t x1, uint8_t* destination)
+	  {
+		  for (uint32_t c = 0; c < 4; c++)
+		  {
+			  destination[c] = static_cast<uint8_t>(Average(row0[x0 * 4 + c], row0[x1 * 4 + c], row1[x0 * 4 + c], row1[x1 * 4 + c]));
+		  }
+	  }
+  }
+
+  void ExpandRGBToRGBA(const uint8_t* rgb, uint8_t* rgba, size_t pixelCount)
+  {
+	  size_t i = 0;
+#if defined(BADGER_SANDBOX_SIMD_AVX) || (defined(BADGER_SANDBOX_SIMD_SSE) && defined(__SSSE3__))
+	  // AVX targets also have SSSE3: four pixels per shuffle, reading 16 bytes for the 12 it uses, so the
+	  // last pixels are left to the loop below.
+	  const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+	  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+	  for (; i + 6 <= pixelCount; i += 4)
+	  {
+		  __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3));
+		  _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+	  }
+#elif defined(BADGER_SANDBOX_SIMD_SSE)
+	  // Plain SSE2 has no byte shuffle: pixel k starts at byte 3k, so shifting the load up by k bytes moves it
+	  // to 32-bit lane k, where a mask keeps its three bytes. Same 16 byte reads as above.
+	  const __m128i lane0 = _mm_setr_epi32(0x00FFFFFF, 0, 0, 0);
+	  const __m128i lane1 = _mm_setr_epi32(0, 0x00FFFFFF, 0, 0);
+	  const __m128i lane2 = _mm_setr_epi32(0, 0, 0x00FFFFFF, 0);
+	  const __m128i lane3 = _mm_setr_epi32(0, 0, 0, 0x00FFFFFF);
+	  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+	  for (; i + 6 <= pixelCount; i += 4)
+	  {
+		  __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3));
+		  __m128i low = _mm_or_si128(_mm_and_si128(pixels, lane0), _mm_and_si128(_mm_slli_si128(pixels, 1), lane1));
+		  __m128i high = _mm_or_si128(_mm_and_si128(_mm_slli_si128(pixels, 2), lane2), _mm_and_si128(_mm_slli_si128(pixels, 3), lane3));
+		  _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_or_si128(_mm_or_si128(low, high), alpha));
+	  }
+#endif
+	  // Whole-word reads and writes, each read takes one byte of the next pixel, so the last one is done bytewise
+	  for (; i + 1 < pixelCount; i++)
+	  {
+		  uint32_t pixel;
+		  memcpy(&pixel, rgb + i * 3, sizeof(pixel));
+		  pixel = (pixel & 0x00FFFFFFu) | 0xFF000000u;
+		  memcpy(rgba + i * 4, &pixel, sizeof(pixel));
+	  }
+	  for (; i < pixelCount; i++)
+	  {
+		  rgba[i * 4 + 0] = rgb[i * 3 + 0];
+		  rgba[i * 4 + 1] = rgb[i * 3 + 1];
+		  rgba[i * 4 + 2] = rgb[i * 3 + 2];
+		  rgba[i * 4 + 3] = 0xFF;
+	  }
+  }
+
+  uint32_t MipLevelCount(uint32_t width, uint32_t height)
+  {
+	  uint32_t extent = width > height ? width : height;
+	  uint32_t levels = 1;
+	  while (extent > 1)
+	  {
+		  extent >>= 1;
+		  levels++;
+	  }
+	  return (levels);
+  }
+
+  size_t MipChainSize(uint32_t width, uint32_t height, uint32_t levelCount)
+  {
+	  size_t size = 0;
+	  for (uint32_t level = 0; level < levelCount; level++)
+	  {
+		  size += static_cast<size_t>(MipExtent(width, level)) * MipExtent(height, level) * 4;
+	  }
+	  return (size);
+  }
+
+  void DownsampleRGBA(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination)
+  {
+	  const uint32_t destinationWidth = MipExtent(width, 1);
+	  const uint32_t destinationHeight = MipExtent(height, 1);
+	  for (uint32_t y = 0; y < destinationHeight; y++)
+	  {
+		  const uint8_t* row0 = source + static_cast<size_t>(y * 2) * width * 4;
+		  const uint8_t* row1 = height > 1 ? row0 + static_cast<size_t>(width) * 4 : row0;
+		  uint8_t* out = destination + static_cast<size_t>(y) * destinationWidth * 4;
+		  uint32_t x = 0;
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+		  // Two destination texels per iteration: widen both source rows to 16 bits, add them, add the
+		  // horizontal neighbours and round back down to 8 bits.
+		  if (width > 1)
+		  {
+			  const __m128i zero = _mm_setzero_si128();
+			  const __m128i rounding = _mm_set1_epi16(2);
+			  for (; x + 2 <= destinationWidth; x += 2)
+			  {
+				  __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+				  __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+				  __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+				  __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+				  __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+				  __m128i average = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+				  _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(average, zero));
+			  }
+		  }
+#endif
+		  for (; x < destinationWidth; x++)
+		  {
+			  const uint32_t x0 = width > 1 ? x * 2 : 0;
+			  const uint32_t x1 = width > 1 ? x0 + 1 : 0;
+			  DownsampleTexel(row0, row1, x0, x1, out + x * 4);
+		  }
+	  }
+  }
+
+  void GenerateMipChain(uint8_t* chain, uint32_t width, uint32_t height, uint32_t levelCount)
+  {
+	  uint8_t* level = chain;
+	  for (uint32_t i = 1; i < levelCount; i++)
+	  {
+		  const uint32_t levelWidth = MipExtent(width, i - 1);
+		  const uint32_t levelHeight = MipExtent(height, i - 1);
+		  uint8_t* next = level + static_cast<size_t>(levelWidth) * levelHeight * 4;
+		  DownsampleRGBA(level, levelWidth, levelHeight, next);
+		  level = next;
+	  }
+  }
+}
\ No newline at end of file
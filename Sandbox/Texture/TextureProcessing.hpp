@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace BadgerSandbox
+{
+	// Expands tightly packed 8-bit RGB pixels to RGBA with an opaque alpha. The buffers must not overlap.
+	void ExpandRGBToRGBA(const uint8_t* rgb, uint8_t* rgba, size_t pixelCount);
+
+	// Levels of a full mip chain down to 1x1.
+	uint32_t MipLevelCount(uint32_t width, uint32_t height);
+	// Size of a level, never less than one texel.
+	inline uint32_t MipExtent(uint32_t extent, uint32_t level) { return (extent >> level > 0 ? extent >> level : 1); }
+	// Bytes of the first levelCount levels of an RGBA8 chain stored level after level.
+	size_t MipChainSize(uint32_t width, uint32_t height, uint32_t levelCount);
+
+	// 2x2 box filter of an RGBA8 level into the next, smaller one. A dimension that is already one texel
+	// stays one texel, the last row or column of an odd dimension is dropped like a 2:1 blit would.
+	void DownsampleRGBA(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination);
+	// Fills levels 1 to levelCount - 1 of an RGBA8 chain (laid out as MipChainSize describes) from its first level.
+	void GenerateMipChain(uint8_t* chain, uint32_t width, uint32_t height, uint32_t levelCount);
+}
\ No newline at end of file
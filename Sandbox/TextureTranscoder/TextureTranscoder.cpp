@@ -0,0 +1,154 @@
+// Offline transcoder from PNG, JPEG and the other formats stb_image reads to block compressed DDS textures.
+// Every input is decoded to RGBA, given a full box filtered mip chain and compressed a block row at a time on a
+// thread pool. The result is written next to the input as <name>.dds, where the UdacityFinalProject glTF loader picks it up in
+// place of the source image.
+//
+//   TextureTranscoder [--format bc1|bc3|bc5|bc7] image...
+//
+// Without --format, opaque images become BC1 and images with alpha BC7.
+#include "BlockCompression.hpp"
+#include "DdsFile.hpp"
+#include "TextureProcessing.hpp"
+#include "ThreadPool.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace BadgerSandbox
+{
+namespace
+{
+	const char* kFormatNames[] = { "bc1", "bc3", "bc5", "bc7" };
+
+	bool ParseFormat(const char* name, BlockFormat& format)
+	{
+		for (uint32_t i = 0; i < sizeof(kFormatNames) / sizeof(kFormatNames[0]); i++)
+		{
+			if (strcmp(name, kFormatNames[i]) == 0)
+			{
+				format = static_cast<BlockFormat>(i);
+				return (true);
+			}
+		}
+		return (false);
+	}
+
+	bool HasAlpha(const uint8_t* rgba, size_t pixelCount)
+	{
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			if (rgba[i * 4 + 3] != 255)
+			{
+				return (true);
+			}
+		}
+		return (false);
+	}
+
+	std::string OutputPath(const std::string& input)
+	{
+		const size_t separator = input.find_last_of("/\\");
+		const size_t extension = input.rfind('.');
+		if (extension == std::string::npos || (separator != std::string::npos && extension < separator))
+		{
+			return (input + ".dds");
+		}
+		return (input.substr(0, extension) + ".dds");
+	}
+
+	bool Transcode(ThreadPool& pool, const std::string& input, bool autoFormat, BlockFormat format)
+	{
+		int width, height, components;
+		stbi_uc* pixels = stbi_load(input.c_str(), &width, &height, &components, 4);
+		if (pixels == nullptr)
+		{
+			fprintf(stderr, "%s: %s\n", input.c_str(), stbi_failure_reason());
+			return (false);
+		}
+		const uint32_t levelCount = MipLevelCount(width, height);
+		std::vector<uint8_t> chain(MipChainSize(width, height, levelCount));
+		memcpy(chain.data(), pixels, static_cast<size_t>(width) * height * 4);
+		stbi_image_free(pixels);
+		GenerateMipChain(chain.data(), width, height, levelCount);
+		if (autoFormat)
+		{
+			format = HasAlpha(chain.data(), static_cast<size_t>(width) * height) ? BlockFormat::BC7 : BlockFormat::BC1;
+		}
+
+		std::vector<uint8_t> compressed(CompressedChainSize(format, width, height, levelCount));
+		const uint8_t* level = chain.data();
+		uint8_t* destination = compressed.data();
+		for (uint32_t i = 0; i < levelCount; i++)
+		{
+			const uint32_t levelWidth = MipExtent(width, i);
+			const uint32_t levelHeight = MipExtent(height, i);
+			const size_t rowBytes = static_cast<size_t>((levelWidth + 3) / 4) * BlockBytes(format);
+			pool.ParallelFor((levelHeight + 3) / 4, [&](size_t blockRow)
+			{
+				CompressBlockRow(format, level, levelWidth, levelHeight, static_cast<uint32_t>(blockRow), destination + blockRow * rowBytes);
+			});
+			level += static_cast<size_t>(levelWidth) * levelHeight * 4;
+			destination += CompressedLevelSize(format, levelWidth, levelHeight);
+		}
+
+		const CompressedTexture texture = { format, static_cast<uint32_t>(width), static_cast<uint32_t>(height), levelCount, compressed.data(),
+		                                     compressed.size() };
+		const std::string output = OutputPath(input);
+		if (!WriteDds(output, texture))
+		{
+			fprintf(stderr, "%s: could not write\n", output.c_str());
+			return (false);
+		}
+		printf("%s -> %s (%s, %dx%d, %u levels, %zu KiB, %zu KiB as RGBA)\n", input.c_str(), output.c_str(), kFormatNames[static_cast<uint32_t>(format)],
+		       width, height, levelCount, compressed.size() / 1024, chain.size() / 1024);
+		return (true);
+	}
+}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace BadgerSandbox;
+
+	bool autoFormat = true;
+	BlockFormat format = BlockFormat::BC1;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+		{
+			if (!ParseFormat(argv[++i], format))
+			{
+				fprintf(stderr, "Unknown format %s\n", argv[i]);
+				return (1);
+			}
+			autoFormat = false;
+		}
+		else
+		{
+			inputs.push_back(argv[i]);
+		}
+	}
+	if (inputs.empty())
+	{
+		fprintf(stderr, "Usage: %s [--format bc1|bc3|bc5|bc7] image...\n", argv[0]);
+		return (1);
+	}
+
+	ThreadPool pool;
+	const auto start = std::chrono::steady_clock::now();
+	int failures = 0;
+	for (const std::string& input : inputs)
+	{
+		failures += Transcode(pool, input, autoFormat, format) ? 0 : 1;
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("%zu images in %.2f s\n", inputs.size() - failures, seconds);
+	return (failures == 0 ? 0 : 1);
+}
\ No newline at end of file
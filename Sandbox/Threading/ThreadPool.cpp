@@ -0,0 +1,136 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace BadgerSandbox
+{
+  ThreadPool::ThreadPool(size_t threadCount)
+	  : stopping(false)
+  {
+	  threadCount = std::max<size_t>(threadCount, 1);
+	  workers.reserve(threadCount);
+	  for (size_t i = 0; i < threadCount; i++)
+	  {
+		  workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	  }
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+	  {
+		  std::lock_guard<std::mutex> lock(mutex);
+		  stopping = true;
+	  }
+	  condition.notify_all();
+	  for (std::thread& worker : workers)
+	  {
+		  worker.join();
+	  }
+  }
+
+  void ThreadPool::Enqueue(std::function<void()> task)
+  {
+	  {
+		  std::lock_guard<std::mutex> lock(mutex);
+		  tasks.push(std::move(task));
+	  }
+	  condition.notify_one();
+  }
+
+  void ThreadPool::WorkerLoop()
+  {
+	  for (;;)
+	  {
+		  std::function<void()> task;
+		  {
+			  std::unique_lock<std::mutex> lock(mutex);
+			  condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			  if (tasks.empty())
+			  {
+				  return;
+			  }
+			  task = std::move(tasks.front());
+			  tasks.pop();
+		  }
+		  task();
+	  }
+  }
+
+  void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body)
+  {
+	  if (count == 0)
+	  {
+		  return;
+	  }
+	  if (count == 1)
+	  {
+		  body(0);
+		  return;
+	  }
+
+	  // Indices are claimed one at a time from a shared counter, which balances uneven work items
+	  // (characters with different joint counts, for example) across the helpers. The batch is shared
+	  // with the helpers and a helper only calls body after claiming an index, so the caller waits for
+	  // the indices being worked on rather than for every helper to start. Tasks of this pool can
+	  // therefore call ParallelFor too: helpers queued behind them find nothing left and return.
+	  struct Batch
+	  {
+		  std::atomic<size_t> next;
+		  std::atomic<size_t> remaining;
+		  std::mutex mutex;
+		  std::condition_variable finished;
+		  bool done;
+		  std::exception_ptr error;
+	  };
+	  std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+	  batch->next = 0;
+	  batch->remaining = count;
+	  batch->done = false;
+	  const std::function<void(size_t)>* work = &body;
+	  auto run = [batch, work, count]()
+	  {
+		  for (size_t i = batch->next++; i < count; i = batch->next++)
+		  {
+			  try
+			  {
+				  (*work)(i);
+			  }
+			  catch (...)
+			  {
+				  std::lock_guard<std::mutex> lock(batch->mutex);
+				  if (!batch->error)
+				  {
+					  batch->error = std::current_exception();
+				  }
+			  }
+			  if (--batch->remaining == 0)
+			  {
+				  std::lock_guard<std::mutex> lock(batch->mutex);
+				  batch->done = true;
+				  batch->finished.notify_all();
+			  }
+		  }
+	  };
+
+	  const size_t helperCount = std::min(workers.size(), count - 1);
+	  for (size_t i = 0; i < helperCount; i++)
+	  {
+		  Enqueue(run);
+	  }
+	  run();
+
+	  std::unique_lock<std::mutex> lock(batch->mutex);
+	  batch->finished.wait(lock, [&batch]() { return batch->done; });
+	  if (batch->error)
+	  {
+		  std::rethrow_exception(batch->error);
+	  }
+  }
+
+  size_t ThreadPool::DefaultThreadCount()
+  {
+	  const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	  return (hardwareThreads > 1 ? hardwareThreads - 1 : 1);
+  }
+}
\ No newline at end of file
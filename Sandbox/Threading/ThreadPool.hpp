@@ -0,0 +1,53 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace BadgerSandbox
+{
+	// Fixed set of worker threads draining a FIFO task queue. Workers are started on construction and
+	// joined on destruction after the queue has been drained.
+	class ThreadPool
+	{
+	private:
+	  std::vector<std::thread> workers;
+	  std::queue<std::function<void()>> tasks;
+	  std::mutex mutex;
+	  std::condition_variable condition;
+	  bool stopping;
+
+	  void Enqueue(std::function<void()> task);
+	  void WorkerLoop();
+	public:
+		explicit ThreadPool(size_t threadCount = DefaultThreadCount());
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Queues task and returns a future for its result. Exceptions thrown by task are rethrown by future.get().
+		template <typename Function>
+		auto Submit(Function&& task) -> std::future<decltype(task())>
+		{
+			using Result = decltype(task());
+			auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(task));
+			std::future<Result> result = packaged->get_future();
+			Enqueue([packaged]() { (*packaged)(); });
+			return (result);
+		}
+
+		// Calls body(i) for every i in [0, count) and returns once all of them have finished. The calling
+		// thread takes part in the work. The first exception thrown by body is rethrown here. Safe to call from
+		// a task running on this pool.
+		void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+		size_t Size() const { return workers.size(); }
+
+		// Hardware threads minus the one that submits work, at least one.
+		static size_t DefaultThreadCount();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include "Quaternion.hpp"
+
+namespace BadgerSandbox
+{
+	// 3x4 affine transform p' = L * p + t. The implicit bottom row is (0, 0, 0, 1), so composing two
+	// transforms is a 3x3 multiply plus a 3x3 * vector, and inverting one never needs the 4x4 path.
+	class AffineTransform
+	{
+	public:
+		Matrix3D linear;
+		Vector3D translation;
+		constexpr AffineTransform()
+		: linear()
+		, translation(0.0f, 0.0f, 0.0f)
+		{
+		}
+
+		constexpr AffineTransform(const Matrix3D& l, const Vector3D& t)
+		: linear(l)
+		, translation(t)
+		{
+		}
+
+		// Drops the bottom row of M, which must be (0, 0, 0, 1) for the result to be exact.
+		constexpr explicit AffineTransform(const Matrix4D& M)
+		: linear(M(0,0), M(0,1), M(0,2),
+		         M(1,0), M(1,1), M(1,2),
+		         M(2,0), M(2,1), M(2,2))
+		, translation(M(0,3), M(1,3), M(2,3))
+		{
+		}
+	};
+
+  // Translation * Rotation * Scale, the order glTF nodes use.
+  constexpr AffineTransform AffineTransformFromTRS(const Vector3D& t, const Quaternion& r, const Vector3D& s)
+  {
+	  const Matrix3D R = GetRotationMatrix(r);
+	  return (AffineTransform(Matrix3D(R(0,0) * s.x, R(0,1) * s.y, R(0,2) * s.z,
+	                                   R(1,0) * s.x, R(1,1) * s.y, R(1,2) * s.z,
+	                                   R(2,0) * s.x, R(2,1) * s.y, R(2,2) * s.z), t));
+  }
+
+  constexpr AffineTransform operator * (const AffineTransform& A, const AffineTransform& B)
+  {
+	  return (AffineTransform(A.linear * B.linear, A.linear * B.translation + A.translation));
+  }
+
+  constexpr Vector3D TransformPoint(const AffineTransform& A, const Vector3D& p)
+  {
+	  return (A.linear * p + A.translation);
+  }
+
+  constexpr Vector3D TransformDirection(const AffineTransform& A, const Vector3D& v)
+  {
+	  return (A.linear * v);
+  }
+
+  // General affine inverse: invert the 3x3 part and carry the translation through it.
+  constexpr AffineTransform Inverse(const AffineTransform& A)
+  {
+	  const Matrix3D inverseLinear = Inverse(A.linear);
+	  return (AffineTransform(inverseLinear, -(inverseLinear * A.translation)));
+  }
+
+  // Inverse of a rotation + translation (no scale or shear): the 3x3 inverse is its transpose.
+  constexpr AffineTransform RigidInverse(const AffineTransform& A)
+  {
+	  const Matrix3D inverseLinear = Transpose(A.linear);
+	  return (AffineTransform(inverseLinear, -(inverseLinear * A.translation)));
+  }
+
+  constexpr Matrix4D GetMatrix4D(const AffineTransform& A)
+  {
+	  return (Matrix4D(A.linear(0,0), A.linear(0,1), A.linear(0,2), A.translation.x,
+	                   A.linear(1,0), A.linear(1,1), A.linear(1,2), A.translation.y,
+	                   A.linear(2,0), A.linear(2,1), A.linear(2,2), A.translation.z,
+	                   0.0f, 0.0f, 0.0f, 1.0f));
+  }
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include "Matrix3D.hpp"
+#include "Matrix4D.hpp"
+#include <cmath>
+
+namespace BadgerSandbox
+{
+	// Rotation quaternion q = w + xi + yj + zk. Same layout as glm::quat's x, y, z, w members
+	// (and glTF's rotation arrays), so node rotations can be copied straight in.
+	class Quaternion
+	{
+	public:
+		float x, y, z, w;
+		constexpr Quaternion()
+		: x(0.0f)
+		, y(0.0f)
+		, z(0.0f)
+		, w(1.0f)
+		{
+		}
+
+		constexpr Quaternion(float a, float b, float c, float s)
+		: x(a)
+		, y(b)
+		, z(c)
+		, w(s)
+		{
+		}
+
+		constexpr Quaternion(const Vector3D& v, float s)
+		: x(v.x)
+		, y(v.y)
+		, z(v.z)
+		, w(s)
+		{
+		}
+
+		constexpr Vector3D GetVectorPart() const
+		{
+			return (Vector3D(x, y, z));
+		}
+	};
+
+  constexpr Quaternion operator * (const Quaternion& q1, const Quaternion& q2)
+  {
+	  return (Quaternion(q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y,
+	                     q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x,
+	                     q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w,
+	                     q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z));
+  }
+
+  constexpr Quaternion operator * (const Quaternion& q, float s)
+  {
+	  return (Quaternion(q.x * s, q.y * s, q.z * s, q.w * s));
+  }
+
+  constexpr Quaternion operator + (const Quaternion& a, const Quaternion& b)
+  {
+	  return (Quaternion(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w));
+  }
+
+  constexpr float Dot(const Quaternion& a, const Quaternion& b)
+  {
+	  return (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+  }
+
+  constexpr Quaternion Conjugate(const Quaternion& q)
+  {
+	  return (Quaternion(-q.x, -q.y, -q.z, q.w));
+  }
+
+  // For unit quaternions Conjugate is the inverse and is the one to use.
+  constexpr Quaternion Inverse(const Quaternion& q)
+  {
+	  return (Conjugate(q) * (1.0F / Dot(q, q)));
+  }
+
+  inline Quaternion Normalize(const Quaternion& q)
+  {
+	  return (q * (1.0F / std::sqrt(Dot(q, q))));
+  }
+
+  // Rotation of angle radians about a unit axis.
+  inline Quaternion QuaternionFromAxisAngle(const Vector3D& axis, float angle)
+  {
+	  float halfAngle = angle * 0.5f;
+	  return (Quaternion(axis * std::sin(halfAngle), std::cos(halfAngle)));
+  }
+
+  // Rotates v by the unit quaternion q: v + 2w(q x v) + 2q x (q x v), without building a matrix.
+  constexpr Vector3D Transform(const Quaternion& q, const Vector3D& v)
+  {
+	  const Vector3D b = q.GetVectorPart();
+	  const Vector3D t = Cross(b, v) * 2.0f;
+	  return (v + t * q.w + Cross(b, t));
+  }
+
+  constexpr Matrix3D GetRotationMatrix(const Quaternion& q)
+  {
+	  const float x2 = q.x * q.x;
+	  const float y2 = q.y * q.y;
+	  const float z2 = q.z * q.z;
+	  const float xy = q.x * q.y;
+	  const float xz = q.x * q.z;
+	  const float yz = q.y * q.z;
+	  const float wx = q.w * q.x;
+	  const float wy = q.w * q.y;
+	  const float wz = q.w * q.z;
+
+	  return (Matrix3D(1.0f - 2.0f * (y2 + z2), 2.0f * (xy - wz), 2.0f * (xz + wy),
+	                   2.0f * (xy + wz), 1.0f - 2.0f * (x2 + z2), 2.0f * (yz - wx),
+	                   2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (x2 + y2)));
+  }
+
+  constexpr Matrix4D GetMatrix4D(const Quaternion& q)
+  {
+	  const Matrix3D r = GetRotationMatrix(q);
+	  return (Matrix4D(r(0,0), r(0,1), r(0,2), 0.0f,
+	                   r(1,0), r(1,1), r(1,2), 0.0f,
+	                   r(2,0), r(2,1), r(2,2), 0.0f,
+	                   0.0f, 0.0f, 0.0f, 1.0f));
+  }
+
+  // Normalized linear interpolation along the shorter arc. Cheap and good enough for the small
+  // steps between animation keyframes.
+  inline Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t)
+  {
+	  float sign = Dot(a, b) < 0.0f ? -1.0f : 1.0f;
+	  return (Normalize(a * (1.0f - t) + b * (t * sign)));
+  }
+
+  // Constant angular velocity interpolation along the shorter arc; falls back to Nlerp when the
+  // inputs are nearly parallel and sin(theta) would lose precision.
+  inline Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t)
+  {
+	  float cosTheta = Dot(a, b);
+	  float sign = 1.0f;
+	  if (cosTheta < 0.0f)
+	  {
+		  cosTheta = -cosTheta;
+		  sign = -1.0f;
+	  }
+	  if (cosTheta > 0.9995f)
+	  {
+		  return (Nlerp(a, b, t));
+	  }
+	  float theta = std::acos(cosTheta);
+	  float invSinTheta = 1.0f / std::sin(theta);
+	  float wa = std::sin((1.0f - t) * theta) * invSinTheta;
+	  float wb = std::sin(t * theta) * invSinTheta * sign;
+	  return (a * wa + b * wb);
+  }
+}
\ No newline at end of file
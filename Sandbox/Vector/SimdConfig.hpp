@@ -0,0 +1,40 @@
+#pragma once
+
+// Instruction set selection for the Sandbox math library.
+// AVX kernels are compiled when the compiler targets AVX (/arch:AVX or -mavx), SSE kernels on
+// any other x86 target, and the scalar reference code everywhere else.
+// Define BADGER_SANDBOX_FORCE_SCALAR to build the scalar reference path on any target.
+#if !defined(BADGER_SANDBOX_FORCE_SCALAR)
+  #if defined(__AVX__)
+    #define BADGER_SANDBOX_SIMD_AVX 1
+    #define BADGER_SANDBOX_SIMD_SSE 1
+    #include <immintrin.h>
+  #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define BADGER_SANDBOX_SIMD_SSE 1
+    #include <emmintrin.h>
+  #endif
+#endif
+
+
+// Functions with a SIMD kernel are constexpr only when the compiler can tell constant evaluation
+// apart from a runtime call (__builtin_is_constant_evaluated is available as an extension in C++14
+// mode on GCC 9, Clang 9 and MSVC 19.25). Under constant evaluation they take the scalar path.
+#if defined(__has_builtin)
+  #if __has_builtin(__builtin_is_constant_evaluated)
+    #define BADGER_SANDBOX_HAS_IS_CONSTANT_EVALUATED 1
+  #endif
+#endif
+#if !defined(BADGER_SANDBOX_HAS_IS_CONSTANT_EVALUATED) && defined(_MSC_VER) && (_MSC_VER >= 1925)
+  #define BADGER_SANDBOX_HAS_IS_CONSTANT_EVALUATED 1
+#endif
+
+#if !defined(BADGER_SANDBOX_SIMD_SSE)
+  #define BADGER_SANDBOX_SIMD_CONSTEXPR constexpr
+  #define BADGER_SANDBOX_USE_SIMD() false
+#elif defined(BADGER_SANDBOX_HAS_IS_CONSTANT_EVALUATED)
+  #define BADGER_SANDBOX_SIMD_CONSTEXPR constexpr
+  #define BADGER_SANDBOX_USE_SIMD() (!__builtin_is_constant_evaluated())
+#else
+  #define BADGER_SANDBOX_SIMD_CONSTEXPR inline
+  #define BADGER_SANDBOX_USE_SIMD() true
+#endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include "SimdConfig.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Lane wrappers used by the batch kernels. A kernel written against one of these structs runs
+// Width floats per step; the widest one is used for the bulk of an array and ScalarLane for the tail.
+// Load and Store are unaligned so kernels also accept caller-owned arrays; LoadAligned and StoreAligned
+// need Width * sizeof(float) alignment, which Vector3DArray streams have.
+namespace BadgerSandbox
+{
+namespace detail
+{
+  struct ScalarLane
+  {
+	  typedef float Type;
+	  static const int Width = 1;
+	  static Type Load(const float* p) { return (*p); }
+	  static void Store(float* p, Type v) { *p = v; }
+	  static Type LoadAligned(const float* p) { return (*p); }
+	  static void StoreAligned(float* p, Type v) { *p = v; }
+	  static Type Set(float s) { return (s); }
+	  static Type Add(Type a, Type b) { return (a + b); }
+	  static Type Sub(Type a, Type b) { return (a - b); }
+	  static Type Mul(Type a, Type b) { return (a * b); }
+	  static Type Div(Type a, Type b) { return (a / b); }
+	  static Type Sqrt(Type a) { return (std::sqrt(a)); }
+	  static Type Min(Type a, Type b) { return (std::min(a, b)); }
+	  static Type Max(Type a, Type b) { return (std::max(a, b)); }
+	  static float ReduceMin(Type a) { return (a); }
+	  static float ReduceMax(Type a) { return (a); }
+  };
+
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+  struct SseLane
+  {
+	  typedef __m128 Type;
+	  static const int Width = 4;
+	  static Type Load(const float* p) { return (_mm_loadu_ps(p)); }
+	  static void Store(float* p, Type v) { _mm_storeu_ps(p, v); }
+	  static Type LoadAligned(const float* p) { return (_mm_load_ps(p)); }
+	  static void StoreAligned(float* p, Type v) { _mm_store_ps(p, v); }
+	  static Type Set(float s) { return (_mm_set1_ps(s)); }
+	  static Type Add(Type a, Type b) { return (_mm_add_ps(a, b)); }
+	  static Type Sub(Type a, Type b) { return (_mm_sub_ps(a, b)); }
+	  static Type Mul(Type a, Type b) { return (_mm_mul_ps(a, b)); }
+	  static Type Div(Type a, Type b) { return (_mm_div_ps(a, b)); }
+	  static Type Sqrt(Type a) { return (_mm_sqrt_ps(a)); }
+	  static Type Min(Type a, Type b) { return (_mm_min_ps(a, b)); }
+	  static Type Max(Type a, Type b) { return (_mm_max_ps(a, b)); }
+	  static float ReduceMin(Type a)
+	  {
+		  a = _mm_min_ps(a, _mm_movehl_ps(a, a));
+		  a = _mm_min_ss(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)));
+		  return (_mm_cvtss_f32(a));
+	  }
+	  static float ReduceMax(Type a)
+	  {
+		  a = _mm_max_ps(a, _mm_movehl_ps(a, a));
+		  a = _mm_max_ss(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)));
+		  return (_mm_cvtss_f32(a));
+	  }
+  };
+#endif
+
+#if defined(BADGER_SANDBOX_SIMD_AVX)
+  struct AvxLane
+  {
+	  typedef __m256 Type;
+	  static const int Width = 8;
+	  static Type Load(const float* p) { return (_mm256_loadu_ps(p)); }
+	  static void Store(float* p, Type v) { _mm256_storeu_ps(p, v); }
+	  static Type LoadAligned(const float* p) { return (_mm256_load_ps(p)); }
+	  static void StoreAligned(float* p, Type v) { _mm256_store_ps(p, v); }
+	  static Type Set(float s) { return (_mm256_set1_ps(s)); }
+	  static Type Add(Type a, Type b) { return (_mm256_add_ps(a, b)); }
+	  static Type Sub(Type a, Type b) { return (_mm256_sub_ps(a, b)); }
+	  static Type Mul(Type a, Type b) { return (_mm256_mul_ps(a, b)); }
+	  static Type Div(Type a, Type b) { return (_mm256_div_ps(a, b)); }
+	  static Type Sqrt(Type a) { return (_mm256_sqrt_ps(a)); }
+	  static Type Min(Type a, Type b) { return (_mm256_min_ps(a, b)); }
+	  static Type Max(Type a, Type b) { return (_mm256_max_ps(a, b)); }
+	  static float ReduceMin(Type a)
+	  {
+		  return (SseLane::ReduceMin(_mm_min_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1))));
+	  }
+	  static float ReduceMax(Type a)
+	  {
+		  return (SseLane::ReduceMax(_mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1))));
+	  }
+  };
+  typedef AvxLane WideLane;
+#elif defined(BADGER_SANDBOX_SIMD_SSE)
+  typedef SseLane WideLane;
+#else
+  typedef ScalarLane WideLane;
+#endif
+}
+}
\ No newline at end of file
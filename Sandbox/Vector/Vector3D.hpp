@@ -1,4 +1,5 @@
 #pragma once
+#include <cmath>
 
 namespace BadgerSandbox
 {
@@ -6,24 +7,111 @@ namespace BadgerSandbox
 	{
 	public:
 		float x, y, z;
-		Vector3D(float a, float b, float c);
-		float& operator[](int i);
-		const float& operator[](int i) const;
-		Vector3D& operator *= (float s);
-		Vector3D& operator /= (float s);
-		Vector3D& operator += (const Vector3D& v);
-		Vector3D& operator -= (const Vector3D& v);
+		constexpr Vector3D(float a, float b, float c)
+		: x(a)
+		, y(b)
+		, z(c)
+		{
+		}
+
+		float& operator[](int i)
+		{
+			return ((&x)[i]);
+		}
+
+		constexpr const float& operator[](int i) const
+		{
+			return (i == 0 ? x : (i == 1 ? y : z));
+		}
+
+		constexpr Vector3D& operator *= (float s)
+		{
+			x *= s;
+			y *= s;
+			z *= s;
+			return (*this);
+		}
+
+		constexpr Vector3D& operator /= (float s)
+		{
+			s = 1.0F / s;
+			x *= s;
+			y *= s;
+			z *= s;
+			return (*this);
+		}
+
+		constexpr Vector3D& operator += (const Vector3D& v)
+		{
+			x += v.x;
+			y += v.y;
+			z += v.z;
+			return (*this);
+		}
+
+		constexpr Vector3D& operator -= (const Vector3D& v)
+		{
+			x -= v.x;
+			y -= v.y;
+			z -= v.z;
+			return (*this);
+		}
 	};
   
-  extern Vector3D operator * (const Vector3D& v, float s);
-  extern Vector3D operator / (const Vector3D& v, float s);
-  extern Vector3D operator - (const Vector3D& v);
-  extern float Magnitude(const Vector3D& v);
-  extern Vector3D Normalize(const Vector3D& v);
-  extern Vector3D operator + (const Vector3D& a, const Vector3D& b);
-  extern Vector3D operator - (const Vector3D& a, const Vector3D& b);
-  extern float Dot(const Vector3D& a, const Vector3D& b);
-  extern Vector3D Cross(const Vector3D& a, const Vector3D& b);
-  extern Vector3D Project(const Vector3D& a, const Vector3D& b);
-  extern Vector3D Reject(const Vector3D& a, const Vector3D& b);
+  constexpr Vector3D operator * (const Vector3D& v, float s)
+  {
+	  return (Vector3D(v.x * s, v.y *s, v.z * s));
+  }
+  
+  constexpr Vector3D operator / (const Vector3D& v, float s)
+  {
+	  return (v * (1.0F / s));
+  }
+  
+  constexpr Vector3D operator - (const Vector3D& v)
+  {
+	  return (Vector3D(-v.x, -v.y, -v.z));
+  }
+
+  constexpr Vector3D operator + (const Vector3D& a, const Vector3D& b)
+  {
+	  return (Vector3D(a.x + b.x, a.y + b.y, a.z + b.z));
+  }
+
+  constexpr Vector3D operator - (const Vector3D& a, const Vector3D& b)
+  {
+	  return (Vector3D(a.x - b.x, a.y - b.y, a.z - b.z));
+  }
+
+  constexpr float Dot(const Vector3D& a, const Vector3D& b)
+  {
+	  return (a.x * b.x + a.y * b.y + a.z * b.z);
+  }
+
+  constexpr Vector3D Cross(const Vector3D& a, const Vector3D& b)
+  {
+	  return (Vector3D(a.y * b.z - a.z * b.y,
+		               a.z * b.x - a.x * b.z,
+		               a.x * b.y - a.y * b.x));
+  }
+
+  constexpr Vector3D Project(const Vector3D& a, const Vector3D& b)
+  {
+	  return (b * (Dot(a, b) / Dot(b, b)));
+  }
+
+  constexpr Vector3D Reject(const Vector3D& a, const Vector3D& b)
+  {
+	  return (a - b * (Dot(a, b) / Dot(b, b)));
+  }
+  
+  inline float Magnitude(const Vector3D& v)
+  {
+	  return (std::sqrt(Dot(v, v)));
+  }
+  
+  inline Vector3D Normalize(const Vector3D& v)
+  {
+	  return (v / Magnitude(v));
+  }
 }
\ No newline at end of file
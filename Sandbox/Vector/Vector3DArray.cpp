@@ -0,0 +1,279 @@
+#include "Vector3DArray.hpp"
+#include "SimdLane.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace BadgerSandbox
+{
+  namespace
+  {
+	  const size_t kStreamAlignment = 32;
+	  const size_t kStreamPadding = 8;
+
+	  float* AllocateStream(size_t n)
+	  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+		  return (static_cast<float*>(_mm_malloc(n * sizeof(float), kStreamAlignment)));
+#else
+		  return (static_cast<float*>(std::malloc(n * sizeof(float))));
+#endif
+	  }
+
+	  void FreeStream(float* p)
+	  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+		  _mm_free(p);
+#else
+		  std::free(p);
+#endif
+	  }
+
+	  template <class L>
+	  void NormalizeRange(const float* x, const float* y, const float* z, float* ox, float* oy, float* oz, size_t begin, size_t end)
+	  {
+		  const typename L::Type one = L::Set(1.0F);
+		  for (size_t i = begin; i < end; i += L::Width)
+		  {
+			  typename L::Type vx = L::LoadAligned(x + i);
+			  typename L::Type vy = L::LoadAligned(y + i);
+			  typename L::Type vz = L::LoadAligned(z + i);
+			  typename L::Type lengthSquared = L::Add(L::Add(L::Mul(vx, vx), L::Mul(vy, vy)), L::Mul(vz, vz));
+			  typename L::Type invLength = L::Div(one, L::Sqrt(lengthSquared));
+			  L::StoreAligned(ox + i, L::Mul(vx, invLength));
+			  L::StoreAligned(oy + i, L::Mul(vy, invLength));
+			  L::StoreAligned(oz + i, L::Mul(vz, invLength));
+		  }
+	  }
+
+	  template <class L>
+	  void DotRange(const Vector3DArray& a, const Vector3DArray& b, float* out, size_t begin, size_t end)
+	  {
+		  for (size_t i = begin; i < end; i += L::Width)
+		  {
+			  typename L::Type d = L::Mul(L::LoadAligned(a.X() + i), L::LoadAligned(b.X() + i));
+			  d = L::Add(d, L::Mul(L::LoadAligned(a.Y() + i), L::LoadAligned(b.Y() + i)));
+			  d = L::Add(d, L::Mul(L::LoadAligned(a.Z() + i), L::LoadAligned(b.Z() + i)));
+			  L::Store(out + i, d);
+		  }
+	  }
+
+	  template <class L>
+	  void CrossRange(const Vector3DArray& a, const Vector3DArray& b, Vector3DArray& out, size_t begin, size_t end)
+	  {
+		  for (size_t i = begin; i < end; i += L::Width)
+		  {
+			  typename L::Type ax = L::LoadAligned(a.X() + i), ay = L::LoadAligned(a.Y() + i), az = L::LoadAligned(a.Z() + i);
+			  typename L::Type bx = L::LoadAligned(b.X() + i), by = L::LoadAligned(b.Y() + i), bz = L::LoadAligned(b.Z() + i);
+			  L::StoreAligned(out.X() + i, L::Sub(L::Mul(ay, bz), L::Mul(az, by)));
+			  L::StoreAligned(out.Y() + i, L::Sub(L::Mul(az, bx), L::Mul(ax, bz)));
+			  L::StoreAligned(out.Z() + i, L::Sub(L::Mul(ax, by), L::Mul(ay, bx)));
+		  }
+	  }
+
+	  // Project when reject is false, Reject otherwise: out = b * (a.b / b.b), or a minus that.
+	  template <class L>
+	  void ProjectRange(const Vector3DArray& a, const Vector3DArray& b, Vector3DArray& out, bool reject, size_t begin, size_t end)
+	  {
+		  for (size_t i = begin; i < end; i += L::Width)
+		  {
+			  typename L::Type ax = L::LoadAligned(a.X() + i), ay = L::LoadAligned(a.Y() + i), az = L::LoadAligned(a.Z() + i);
+			  typename L::Type bx = L::LoadAligned(b.X() + i), by = L::LoadAligned(b.Y() + i), bz = L::LoadAligned(b.Z() + i);
+			  typename L::Type ab = L::Add(L::Add(L::Mul(ax, bx), L::Mul(ay, by)), L::Mul(az, bz));
+			  typename L::Type bb = L::Add(L::Add(L::Mul(bx, bx), L::Mul(by, by)), L::Mul(bz, bz));
+			  typename L::Type s = L::Div(ab, bb);
+			  typename L::Type px = L::Mul(bx, s), py = L::Mul(by, s), pz = L::Mul(bz, s);
+			  if (reject)
+			  {
+				  px = L::Sub(ax, px);
+				  py = L::Sub(ay, py);
+				  pz = L::Sub(az, pz);
+			  }
+			  L::StoreAligned(out.X() + i, px);
+			  L::StoreAligned(out.Y() + i, py);
+			  L::StoreAligned(out.Z() + i, pz);
+		  }
+	  }
+
+	  size_t BulkCount(size_t n)
+	  {
+		  return (n - n % detail::WideLane::Width);
+	  }
+  }
+
+  Vector3DArray::Vector3DArray()
+  : xs(nullptr)
+  , ys(nullptr)
+  , zs(nullptr)
+  , count(0)
+  , capacity(0)
+  {
+  }
+
+  Vector3DArray::Vector3DArray(size_t n)
+  : Vector3DArray()
+  {
+	  Resize(n);
+  }
+
+  Vector3DArray::Vector3DArray(const Vector3DArray& other)
+  : Vector3DArray()
+  {
+	  *this = other;
+  }
+
+  Vector3DArray::Vector3DArray(Vector3DArray&& other) noexcept
+  : Vector3DArray()
+  {
+	  *this = std::move(other);
+  }
+
+  Vector3DArray::~Vector3DArray()
+  {
+	  FreeStream(xs);
+	  FreeStream(ys);
+	  FreeStream(zs);
+  }
+
+  Vector3DArray& Vector3DArray::operator = (const Vector3DArray& other)
+  {
+	  if (this != &other)
+	  {
+		  Resize(other.count);
+		  std::memcpy(xs, other.xs, count * sizeof(float));
+		  std::memcpy(ys, other.ys, count * sizeof(float));
+		  std::memcpy(zs, other.zs, count * sizeof(float));
+	  }
+	  return (*this);
+  }
+
+  Vector3DArray& Vector3DArray::operator = (Vector3DArray&& other) noexcept
+  {
+	  std::swap(xs, other.xs);
+	  std::swap(ys, other.ys);
+	  std::swap(zs, other.zs);
+	  std::swap(count, other.count);
+	  std::swap(capacity, other.capacity);
+	  return (*this);
+  }
+
+  // Grows the streams when needed and keeps the first min(n, Size()) elements; new elements are zero.
+  void Vector3DArray::Resize(size_t n)
+  {
+	  if (n > capacity)
+	  {
+		  // Geometric growth keeps element-by-element appends amortized O(1).
+		  size_t newCapacity = (n + kStreamPadding - 1) / kStreamPadding * kStreamPadding;
+		  if (newCapacity < capacity * 2)
+		  {
+			  newCapacity = capacity * 2;
+		  }
+		  float* streams[3] = { AllocateStream(newCapacity), AllocateStream(newCapacity), AllocateStream(newCapacity) };
+		  float* old[3] = { xs, ys, zs };
+		  for (int s = 0; s < 3; s++)
+		  {
+			  std::memset(streams[s], 0, newCapacity * sizeof(float));
+			  if (count > 0)
+			  {
+				  std::memcpy(streams[s], old[s], count * sizeof(float));
+			  }
+			  FreeStream(old[s]);
+		  }
+		  xs = streams[0];
+		  ys = streams[1];
+		  zs = streams[2];
+		  capacity = newCapacity;
+	  }
+	  else if (n > count)
+	  {
+		  std::memset(xs + count, 0, (n - count) * sizeof(float));
+		  std::memset(ys + count, 0, (n - count) * sizeof(float));
+		  std::memset(zs + count, 0, (n - count) * sizeof(float));
+	  }
+	  count = n;
+  }
+
+  Vector3D Vector3DArray::Get(size_t i) const
+  {
+	  return (Vector3D(xs[i], ys[i], zs[i]));
+  }
+
+  void Vector3DArray::Set(size_t i, const Vector3D& v)
+  {
+	  xs[i] = v.x;
+	  ys[i] = v.y;
+	  zs[i] = v.z;
+  }
+
+  void Normalize(const Vector3DArray& v, Vector3DArray& out)
+  {
+	  out.Resize(v.Size());
+	  size_t bulk = BulkCount(v.Size());
+	  NormalizeRange<detail::WideLane>(v.X(), v.Y(), v.Z(), out.X(), out.Y(), out.Z(), 0, bulk);
+	  NormalizeRange<detail::ScalarLane>(v.X(), v.Y(), v.Z(), out.X(), out.Y(), out.Z(), bulk, v.Size());
+  }
+
+  void Dot(const Vector3DArray& a, const Vector3DArray& b, float* out)
+  {
+	  size_t bulk = BulkCount(a.Size());
+	  DotRange<detail::WideLane>(a, b, out, 0, bulk);
+	  DotRange<detail::ScalarLane>(a, b, out, bulk, a.Size());
+  }
+
+  void Cross(const Vector3DArray& a, const Vector3DArray& b, Vector3DArray& out)
+  {
+	  out.Resize(a.Size());
+	  size_t bulk = BulkCount(a.Size());
+	  CrossRange<detail::WideLane>(a, b, out, 0, bulk);
+	  CrossRange<detail::ScalarLane>(a, b, out, bulk, a.Size());
+  }
+
+  void Project(const Vector3DArray& a, const Vector3DArray& b, Vector3DArray& out)
+  {
+	  out.Resize(a.Size());
+	  size_t bulk = BulkCount(a.Size());
+	  ProjectRange<detail::WideLane>(a, b, out, false, 0, bulk);
+	  ProjectRange<detail::ScalarLane>(a, b, out, false, bulk, a.Size());
+  }
+
+  void Reject(const Vector3DArray& a, const Vector3DArray& b, Vector3DArray& out)
+  {
+	  out.Resize(a.Size());
+	  size_t bulk = BulkCount(a.Size());
+	  ProjectRange<detail::WideLane>(a, b, out, true, 0, bulk);
+	  ProjectRange<detail::ScalarLane>(a, b, out, true, bulk, a.Size());
+  }
+
+  void Bounds(const Vector3DArray& points, Vector3D& minimum, Vector3D& maximum)
+  {
+	  const float* streams[3] = { points.X(), points.Y(), points.Z() };
+	  size_t n = points.Size();
+	  size_t bulk = BulkCount(n);
+	  for (int s = 0; s < 3; s++)
+	  {
+		  const float* p = streams[s];
+		  float lo = p[0];
+		  float hi = p[0];
+		  if (bulk > 0)
+		  {
+			  detail::WideLane::Type wideLo = detail::WideLane::LoadAligned(p);
+			  detail::WideLane::Type wideHi = wideLo;
+			  for (size_t i = detail::WideLane::Width; i < bulk; i += detail::WideLane::Width)
+			  {
+				  detail::WideLane::Type v = detail::WideLane::LoadAligned(p + i);
+				  wideLo = detail::WideLane::Min(wideLo, v);
+				  wideHi = detail::WideLane::Max(wideHi, v);
+			  }
+			  lo = detail::WideLane::ReduceMin(wideLo);
+			  hi = detail::WideLane::ReduceMax(wideHi);
+		  }
+		  for (size_t i = bulk; i < n; i++)
+		  {
+			  lo = std::min(lo, p[i]);
+			  hi = std::max(hi, p[i]);
+		  }
+		  minimum[s] = lo;
+		  maximum[s] = hi;
+	  }
+  }
+}
\ No newline at end of file
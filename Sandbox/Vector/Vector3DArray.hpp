@@ -0,0 +1,46 @@
+#pragma once
+#include "Vector3D.hpp"
+#include <cstddef>
+
+namespace BadgerSandbox
+{
+	// Structure-of-arrays storage for large point and direction sets.
+	// The x, y and z streams are separate, 32-byte aligned and padded to a multiple of 8 floats so the
+	// batch kernels below can run full SIMD registers over them with aligned loads and stores.
+	class Vector3DArray
+	{
+	private:
+	  float* xs;
+	  float* ys;
+	  float* zs;
+	  size_t count;
+	  size_t capacity;
+	public:
+		Vector3DArray();
+		explicit Vector3DArray(size_t n);
+		Vector3DArray(const Vector3DArray& other);
+		Vector3DArray(Vector3DArray&& other) noexcept;
+		~Vector3DArray();
+		Vector3DArray& operator = (const Vector3DArray& other);
+		Vector3DArray& operator = (Vector3DArray&& other) noexcept;
+		void Resize(size_t n);
+		size_t Size() const { return count; }
+		float* X() { return xs; }
+		float* Y() { return ys; }
+		float* Z() { return zs; }
+		const float* X() const { return xs; }
+		const float* Y() const { return ys; }
+		const float* Z() const { return zs; }
+		Vector3D Get(size_t i) const;
+		void Set(size_t i, const Vector3D& v);
+	};
+
+  // Batch kernels. Each one resizes its output to the input size; out may alias an input.
+  extern void Normalize(const Vector3DArray& v, Vector3DArray& out);
+  extern void Dot(const Vector3DArray& a, const Vector3DArray& b, float* out);
+  extern void Cross(const Vector3DArray& a, const Vector3DArray& b, Vector3DArray& out);
+  extern void Project(const Vector3DArray& a, const Vector3DArray& b, Vector3DArray& out);
+  extern void Reject(const Vector3DArray& a, const Vector3DArray& b, Vector3DArray& out);
+  // Axis-aligned bounds of a non-empty point set.
+  extern void Bounds(const Vector3DArray& points, Vector3D& minimum, Vector3D& maximum);
+}
\ No newline at end of file
@@ -1,28 +1,171 @@
 #pragma once
+#include "SimdConfig.hpp"
+#include <cmath>
 
 namespace BadgerSandbox
 {
-	class Vector4D
+	// Aligned to 16 bytes so a Vector4D (and every Matrix4D column) is a single SSE load/store.
+	class alignas(16) Vector4D
 	{
 	public:
 		float x, y, z, w;
-		Vector4D(float a, float b, float c, float d);
-		float& operator[](int i);
-		const float& operator[](int i) const;
-		Vector4D& operator *= (float s);
-		Vector4D& operator /= (float s);
-		Vector4D& operator += (const Vector4D& v);
-		Vector4D& operator -= (const Vector4D& v);
+		constexpr Vector4D(float a, float b, float c, float d)
+		: x(a)
+		, y(b)
+		, z(c)
+		, w(d != 0.0f ? 1.0f : d)
+		{
+		}
+
+		float& operator[](int i)
+		{
+			return ((&x)[i]);
+		}
+
+		constexpr const float& operator[](int i) const
+		{
+			return (i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)));
+		}
+
+		constexpr Vector4D& operator *= (float s)
+		{
+			x *= s;
+			y *= s;
+			z *= s;
+			return (*this);
+		}
+
+		constexpr Vector4D& operator /= (float s)
+		{
+			s = 1.0F / s;
+			x *= s;
+			y *= s;
+			z *= s;
+			return (*this);
+		}
+
+		constexpr Vector4D& operator += (const Vector4D& v)
+		{
+			x += v.x;
+			y += v.y;
+			z += v.z;
+			return (*this);
+		}
+
+		constexpr Vector4D& operator -= (const Vector4D& v)
+		{
+			x -= v.x;
+			y -= v.y;
+			z -= v.z;
+			return (*this);
+		}
 	};
+
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+  namespace detail
+  {
+	  inline __m128 Load(const Vector4D& v)
+	  {
+		  return (_mm_load_ps(&v.x));
+	  }
+
+	  // Builds the result through the Vector4D constructor so the SIMD path keeps the exact
+	  // w handling of the scalar reference code.
+	  inline Vector4D MakeVector4D(__m128 xyz, float w)
+	  {
+		  alignas(16) float r[4];
+		  _mm_store_ps(r, xyz);
+		  return (Vector4D(r[0], r[1], r[2], w));
+	  }
+
+	  inline float HorizontalAdd(__m128 v)
+	  {
+		  __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+		  __m128 sums = _mm_add_ps(v, shuffled);
+		  shuffled = _mm_movehl_ps(shuffled, sums);
+		  sums = _mm_add_ss(sums, shuffled);
+		  return (_mm_cvtss_f32(sums));
+	  }
+  }
+#endif
+
+  BADGER_SANDBOX_SIMD_CONSTEXPR Vector4D operator * (const Vector4D& v, float s)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  return (detail::MakeVector4D(_mm_mul_ps(detail::Load(v), _mm_set1_ps(s)), v.w));
+	  }
+#endif
+	  return (Vector4D(v.x * s, v.y *s, v.z * s, v.w));
+  }
+  
+  BADGER_SANDBOX_SIMD_CONSTEXPR Vector4D operator / (const Vector4D& v, float s)
+  {
+	  return (v * (1.0F / s));
+  }
+  
+  BADGER_SANDBOX_SIMD_CONSTEXPR Vector4D operator - (const Vector4D& v)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  return (detail::MakeVector4D(_mm_sub_ps(_mm_setzero_ps(), detail::Load(v)), v.w));
+	  }
+#endif
+	  return (Vector4D(-v.x, -v.y, -v.z, v.w));
+  }
+
+  BADGER_SANDBOX_SIMD_CONSTEXPR Vector4D operator + (const Vector4D& a, const Vector4D& b)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  return (detail::MakeVector4D(_mm_add_ps(detail::Load(a), detail::Load(b)), a.w));
+	  }
+#endif
+	  return (Vector4D(a.x + b.x, a.y + b.y, a.z + b.z, a.w));
+  }
+
+  BADGER_SANDBOX_SIMD_CONSTEXPR Vector4D operator - (const Vector4D& a, const Vector4D& b)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  return (detail::MakeVector4D(_mm_sub_ps(detail::Load(a), detail::Load(b)), a.w));
+	  }
+#endif
+	  return (Vector4D(a.x - b.x, a.y - b.y, a.z - b.z, a.w));
+  }
+
+  BADGER_SANDBOX_SIMD_CONSTEXPR float Dot(const Vector4D& a, const Vector4D& b)
+  {
+#if defined(BADGER_SANDBOX_SIMD_SSE)
+	  if (BADGER_SANDBOX_USE_SIMD())
+	  {
+		  return (detail::HorizontalAdd(_mm_mul_ps(detail::Load(a), detail::Load(b))));
+	  }
+#endif
+	  return (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+  }
+
+  BADGER_SANDBOX_SIMD_CONSTEXPR Vector4D Project(const Vector4D& a, const Vector4D& b)
+  {
+	  return (b * (Dot(a, b) / Dot(b, b)));
+  }
+
+  BADGER_SANDBOX_SIMD_CONSTEXPR Vector4D Reject(const Vector4D& a, const Vector4D& b)
+  {
+	  return (a - b * (Dot(a, b) / Dot(b, b)));
+  }
+  
+  inline float Magnitude(const Vector4D& v)
+  {
+	  return (std::sqrt(Dot(v, v)));
+  }
   
-	extern Vector4D operator * (const Vector4D& v, float s);
-	extern Vector4D operator / (const Vector4D& v, float s);
-	extern Vector4D operator - (const Vector4D& v);
-	extern float Magnitude(const Vector4D& v);
-	extern Vector4D Normalize(const Vector4D& v);
-	extern Vector4D operator + (const Vector4D& a, const Vector4D& b);
-	extern Vector4D operator - (const Vector4D& a, const Vector4D& b);
-	extern float Dot(const Vector4D& a, const Vector4D& b);
-	extern Vector4D Project(const Vector4D& a, const Vector4D& b);
-	extern Vector4D Reject(const Vector4D& a, const Vector4D& b);
+  inline Vector4D Normalize(const Vector4D& v)
+  {
+	  return (v / Magnitude(v));
+  }
 }
\ No newline at end of file
@@ -484,31 +484,16 @@ namespace BadgerSandbox
 		}
 	}
 
-	/*
-  Took this function from VulkanTutorial:
-  https://vulkan-tutorial.com/
-*/
-	uint32_t VectorTestApplication::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	void VectorTestApplication::CreateMemoryAllocator()
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memProperties);
-
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-		{
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-			{
-				return i;
-			}
-		}
-
-		throw std::runtime_error("failed to find suitable memory type!");
+		memoryAllocator.reset(new DeviceMemoryAllocator(selectedPhysicalDevice, device.Get()));
 	}
 
 	/*
 	  Took this function from VulkanTutorial:
 	  https://vulkan-tutorial.com/
 	*/
-	void VectorTestApplication::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	void VectorTestApplication::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -525,23 +510,11 @@ namespace BadgerSandbox
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkCreateImage(device.Get(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateImage(imageInfo, memoryRequest, image, imageMemory) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image!");
 		}
-
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device.Get(), image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device.Get(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate image memory!");
-		}
-
-		vkBindImageMemory(device.Get(), image, imageMemory, 0);
 	}
 
 	/*
@@ -616,6 +589,13 @@ namespace BadgerSandbox
 		depthImageView = CreateImageViewVulkanTutorial(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 	}
 
+	void VectorTestApplication::DestroyDepthImage()
+	{
+		vkDestroyImageView(device.Get(), depthImageView, nullptr);
+		depthImageView = VK_NULL_HANDLE;
+		memoryAllocator->DestroyImage(depthImage, depthImageMemory);
+	}
+
 	void VectorTestApplication::CreateGraphicsCommandsBuffers()
 	{
 		VkCommandPoolCreateInfo commandPoolCreateInfo =
@@ -640,6 +620,10 @@ namespace BadgerSandbox
 
 		graphicsCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
 
+		commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		sceneCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
+		recordedSceneVersions.assign(renderResourcesCount, UINT64_MAX);
+
 		VkCommandBufferBeginInfo graphicsCommandBufferBeginInfo =
 		{
 		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,    // VkStructureType                        sType
@@ -659,8 +643,6 @@ namespace BadgerSandbox
 		VkClearValue clearValue = {
 		  { 1.0f, 0.8f, 0.4f, 0.0f },                     // VkClearColorValue              color
 		};
-
-		framebuffers.resize(renderResourcesCount);
 	}
 
 	void VectorTestApplication::CreateDescriptorSetLayout()
@@ -716,7 +698,7 @@ namespace BadgerSandbox
 		}
 	}
 
-	void VectorTestApplication::CreateBuffer(VkBuffer& buffer, VkDeviceMemory& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties)
+	void VectorTestApplication::CreateBuffer(VkBuffer& buffer, MemoryAllocation& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties)
 	{
 		VkBufferCreateInfo createInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 		createInfo.usage = usage;
@@ -725,25 +707,15 @@ namespace BadgerSandbox
 		createInfo.queueFamilyIndexCount = 0;
 		createInfo.pQueueFamilyIndices = nullptr;
 
-		vkCreateBuffer(device.Get(), &createInfo, nullptr, &buffer);
-
-		VkMemoryRequirements memoryRequirements;
-		vkGetBufferMemoryRequirements(device.Get(), buffer, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocationInfo{};
-		allocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocationInfo.allocationSize = memoryRequirements.size;
-		allocationInfo.memoryTypeIndex = FindMemoryType(memoryRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device.Get(), &allocationInfo, nullptr, &memory) != VK_SUCCESS) 
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateBuffer(createInfo, memoryRequest, buffer, memory) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to allocate buffer memory!");
 		}
 
-		vkBindBufferMemory(device.Get(), buffer, memory, 0);
-
-     	// Map the buffer so we can write on it as needed.
-		vkMapMemory(device.Get(), memory, 0, allocationInfo.allocationSize, 0, mappedMemory);
+		// Host visible memory stays mapped, so we can write on it as needed.
+		*mappedMemory = memory.mapped;
 	}
 
 	void VectorTestApplication::CreateUniformBuffers()
@@ -796,16 +768,7 @@ namespace BadgerSandbox
 		{
 			CreateBuffer(vBuffer.buffer, vBuffer.memory, &vBuffer.mapped, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(vertexData), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 			std::memcpy(vBuffer.mapped, vertexData, sizeof(vertexData));
-			VkMappedMemoryRange flushRange =
-			{
-			  VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,            // VkStructureType        sType
-			  nullptr,                                          // const void            *pNext
-			  vBuffer.memory,                                   // VkDeviceMemory         memory
-			  0,                                                // VkDeviceSize           offset
-			  VK_WHOLE_SIZE                                     // VkDeviceSize           size
-			};
-			vkFlushMappedMemoryRanges(device.Get(), 1, &flushRange);
-			vkUnmapMemory(device.Get(), vBuffer.memory);
+			memoryAllocator->Flush(vBuffer.memory);
 		}
 	}
 
@@ -1051,30 +1014,120 @@ namespace BadgerSandbox
 		graphicsPipeline.Reset(device.Get(), newCache, pipelineCreateInfo);
 	}
 
-	void VectorTestApplication::CreateJustInTimeFramebuffer(RapidVulkan::Framebuffer& framebuffer, const RapidVulkan::ImageView& imageView)
+	void VectorTestApplication::CreateFramebuffers()
 	{
-		std::array<VkImageView, 2> attachments =
+		framebuffers.resize(swapchainImageViews.size());
+		for (size_t i = 0; i < swapchainImageViews.size(); ++i)
 		{
-				imageView.Get(),
-				depthImageView
+			std::array<VkImageView, 2> attachments =
+			{
+					swapchainImageViews[i].Get(),
+					depthImageView
+			};
+			VkFramebufferCreateInfo framebufferCreateInfo =
+			{
+			  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
+			  nullptr,                                        // const void                    *pNext
+			  0,                                              // VkFramebufferCreateFlags       flags
+			  renderPass.Get(),                               // VkRenderPass                   renderPass
+			  attachments.size(),                             // uint32_t                       attachmentCount
+			  attachments.data(),                             // const VkImageView             *pAttachments
+			  swapchainExtent.width,                          // uint32_t                       width
+			  swapchainExtent.height,                         // uint32_t                       height
+			  1                                               // uint32_t                       layers
+			};
+
+			framebuffers[i].Reset(device.Get(), framebufferCreateInfo);
+		}
+	}
+
+	void VectorTestApplication::RecreateSwapchain()
+	{
+		std::array<uint32_t, 2> windowSize = window->GetWindowSize();
+		if ((windowSize[0] == 0) || (windowSize[1] == 0))
+		{
+			// Minimized, there is nothing to present to until the window comes back
+			return;
+		}
+
+		vkDeviceWaitIdle(device.Get());
+		framebuffers.clear();
+		DestroyDepthImage();
+		swapchainImageViews.clear();
+		swapchain.Reset();
+
+		CreateSwapchain();
+		CreateSwapchainImageViews();
+		CreateDepthImage();
+		CreateFramebuffers();
+		++sceneVersion;
+	}
+
+	void VectorTestApplication::RecordSceneCommandBuffer(const size_t& resourceIndex)
+	{
+		VkCommandBufferInheritanceInfo inheritanceInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,  // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  renderPass.Get(),                                   // VkRenderPass                           renderPass
+		  0,                                                  // uint32_t                               subpass
+		  VK_NULL_HANDLE,                                     // VkFramebuffer                          framebuffer
+		  VK_FALSE,                                           // VkBool32                               occlusionQueryEnable
+		  0,                                                  // VkQueryControlFlags                    queryFlags
+		  0                                                   // VkQueryPipelineStatisticFlags          pipelineStatistics
 		};
-		VkFramebufferCreateInfo framebufferCreateInfo =
+		VkCommandBufferBeginInfo commandBufferBeginInfo =
 		{
-		  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
-		  nullptr,                                        // const void                    *pNext
-		  0,                                              // VkFramebufferCreateFlags       flags
-		  renderPass.Get(),                               // VkRenderPass                   renderPass
-		  attachments.size(),                             // uint32_t                       attachmentCount
-		  attachments.data(),                             // const VkImageView             *pAttachments
-		  swapchainExtent.width,                          // uint32_t                       width
-		  swapchainExtent.height,                         // uint32_t                       height
-		  1                                               // uint32_t                       layers
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,        // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,   // VkCommandBufferUsageFlags              flags
+		  &inheritanceInfo                                    // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
 		};
+		VkCommandBuffer commandBuffer = sceneCommandBuffers[resourceIndex];
+		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
 
-		framebuffer.Reset(device.Get(), framebufferCreateInfo);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.Get());
+
+		VkViewport viewport =
+		{
+		  0.0f,                                               // float                                  x
+		  0.0f,                                               // float                                  y
+		  static_cast<float>(swapchainExtent.width),          // float                                  width
+		  static_cast<float>(swapchainExtent.height),         // float                                  height
+		  0.0f,                                               // float                                  minDepth
+		  1.0f                                                // float                                  maxDepth
+		};
+
+		VkRect2D scissor = {
+		  {                                                   // VkOffset2D                             offset
+			0,                                                  // int32_t                                x
+			0                                                   // int32_t                                y
+		  },
+		  {                                                   // VkExtent2D                             extent
+			swapchainExtent.width,                              // uint32_t                               width
+			swapchainExtent.height                             // uint32_t                               height
+		  }
+		};
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffers[resourceIndex].buffer, &offset);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
+			&(descriptorSets[resourceIndex]), 0, nullptr);
+		if (gizmoVisible)
+		{
+			vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+		}
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			std::cout << "Could not record scene command buffer!" << std::endl;
+		}
 	}
 
-	void VectorTestApplication::RecordJustInTimeCommandBuffers(const size_t& resourceIndex)
+	void VectorTestApplication::RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex)
 	{
 		VkCommandBufferBeginInfo commandBufferBeginInfo =
 		{
@@ -1104,7 +1157,7 @@ namespace BadgerSandbox
 		  VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,           // VkStructureType                        sType
 		  nullptr,                                            // const void                            *pNext
 		  renderPass.Get(),                                   // VkRenderPass                           renderPass
-		  framebuffers[resourceIndex].Get(),                  // VkFramebuffer                          framebuffer
+		  framebuffers[imageIndex].Get(),                     // VkFramebuffer                          framebuffer
 		  {                                                   // VkRect2D                               renderArea
 			{                                                 // VkOffset2D                             offset
 			  0,                                              // int32_t                                x
@@ -1117,12 +1170,14 @@ namespace BadgerSandbox
 		};
 
 		// Update UBOs
-		modelMatrix = Matrix4D(
+		// Folded at compile time: the math library is header-only and constexpr.
+		constexpr Matrix4D identityModel(
 			1.0f, 0.0f, 0.0f, 0.0f,
 			0.0f, 1.0f, 0.0f, 0.0f,
 			0.0f, 0.0f, 1.0f, 0.0f,
 			0.0f, 0.0f, 0.0f, 1.0f
 		);
+		modelMatrix = identityModel;
 		glmModelMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 1.0f, 1.0f));
 
 		viewMatrix = LookAt();
@@ -1137,7 +1192,7 @@ namespace BadgerSandbox
 		MVPMatrix = projectionMatrix * viewMatrix * modelMatrix;
 		glmMVPMatrix = glmProjectionMatrix * glmViewMatrix * glmModelMatrix;
 
-		ExtractPlanesFromProjectionMatrix(MVPMatrix, leftPlane, rightPlane, bottomPlane, topPlane, nearPlane, farPlane);
+		viewFrustum = Frustum(MVPMatrix);
 		
 		uniformBuffer currentUniformBuffer = matrixUniformBuffers[resourceIndex];
 		float* memory = (float*)currentUniformBuffer.mapped;
@@ -1145,40 +1200,22 @@ namespace BadgerSandbox
 		memory += 16;
 		memcpy((void*)memory, MVPMatrix.Data(), sizeof(float) * 16);
 
-		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		vkCmdBindPipeline(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.Get());
-
-		VkViewport viewport =
+		// The axis gizmo spans (0, 0, 0) to (0.5, 0.5, 0.5) in model space (see CreateVertexBuffer).
+		bool visible = viewFrustum.ClassifyAABB(Vector3D(0.0f, 0.0f, 0.0f), Vector3D(0.5f, 0.5f, 0.5f)) != CullResult::Outside;
+		if (visible != gizmoVisible)
 		{
-		  0.0f,                                               // float                                  x
-		  0.0f,                                               // float                                  y
-		  static_cast<float>(swapchainExtent.width),          // float                                  width
-		  static_cast<float>(swapchainExtent.height),         // float                                  height
-		  0.0f,                                               // float                                  minDepth
-		  1.0f                                                // float                                  maxDepth
-		};
-
-		VkRect2D scissor = {
-		  {                                                   // VkOffset2D                             offset
-			0,                                                  // int32_t                                x
-			0                                                   // int32_t                                y
-		  },
-		  {                                                   // VkExtent2D                             extent
-			swapchainExtent.width,                              // uint32_t                               width
-			swapchainExtent.height                             // uint32_t                               height
-		  }
-		};
-
-		vkCmdSetViewport(commandBuffers[resourceIndex], 0, 1, &viewport);
-		vkCmdSetScissor(commandBuffers[resourceIndex], 0, 1, &scissor);
-
-		VkDeviceSize offset = 0;
-		vkCmdBindVertexBuffers(commandBuffers[resourceIndex], 0, 1, &vertexBuffers[resourceIndex].buffer, &offset);
-		vkCmdBindDescriptorSets(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
-			&(descriptorSets[resourceIndex]), 0, nullptr);
-		vkCmdDraw(graphicsCommandBuffers[resourceIndex], 6, 1, 0, 0);
+			gizmoVisible = visible;
+			++sceneVersion;
+		}
+		if (recordedSceneVersions[resourceIndex] != sceneVersion)
+		{
+			RecordSceneCommandBuffer(resourceIndex);
+			recordedSceneVersions[resourceIndex] = sceneVersion;
+		}
 
+		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		VkCommandBuffer sceneCommandBuffer = sceneCommandBuffers[resourceIndex];
+		vkCmdExecuteCommands(commandBuffers[resourceIndex], 1, &sceneCommandBuffer);
 		vkCmdEndRenderPass(commandBuffers[resourceIndex]);
 
 		if (vkEndCommandBuffer(commandBuffers[resourceIndex]) != VK_SUCCESS)
@@ -1196,11 +1233,16 @@ namespace BadgerSandbox
 		{
 			std::cout << "Waiting for fence takes too long!" << std::endl;
 		}
-		vkResetFences(device.Get(), 1, &fences[resourceIndex]);
 
-		vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
-		CreateJustInTimeFramebuffer(framebuffers[resourceIndex], swapchainImageViews[imageIndex]);
-		RecordJustInTimeCommandBuffers(resourceIndex);
+		VkResult result = vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// The fence stays signaled, nothing was submitted for this resource
+			RecreateSwapchain();
+			return;
+		}
+		vkResetFences(device.Get(), 1, &fences[resourceIndex]);
+		RecordJustInTimeCommandBuffers(resourceIndex, imageIndex);
 
 		std::vector<VkCommandBuffer> commandBuffers = graphicsCommandBuffers.Get();
 
@@ -1235,9 +1277,14 @@ namespace BadgerSandbox
 		  nullptr                                                 // VkResult                    *pResults
 		};
 
-		vkQueuePresentKHR(queue, &presentInfo);
+		result = vkQueuePresentKHR(queue, &presentInfo);
 
 		resourceIndex = (resourceIndex + 1) % renderResourcesCount;
+
+		if ((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR))
+		{
+			RecreateSwapchain();
+		}
 	}
 
 	Matrix3D VectorTestApplication::Rotate(const float angle, const Vector3D axis)
@@ -1268,29 +1315,23 @@ namespace BadgerSandbox
 		Vector3D forward = Normalize(eyeDirection - eyeLocation);
 		Vector3D right = Normalize(Cross(forward, up));
 
-		Matrix4D lookAtRotation;
-
 		// Build a transformation matrix with the inverse of the rotation matrix on the camera.
 		// As rotation matrices are orthogonal, you can simply use the transpose of the camera basis vectors.
-		lookAtRotation(0, 0) = right.x;
-		lookAtRotation(0, 1) = right.y;
-		lookAtRotation(0, 2) = right.z;
-
-		lookAtRotation(1, 0) = up.x;
-		lookAtRotation(1, 1) = up.y;
-		lookAtRotation(1, 2) = up.z;
-
-		lookAtRotation(2, 0) = -forward.x;
-		lookAtRotation(2, 1) = -forward.y;
-		lookAtRotation(2, 2) = -forward.z;
+		const Matrix4D lookAtRotation(
+			right.x, right.y, right.z, 0.0f,
+			up.x, up.y, up.z, 0.0f,
+			-forward.x, -forward.y, -forward.z, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
 
-		Matrix4D lookAtTranslation;
-		lookAtTranslation(0, 3) = -eyeLocation.x;
-		lookAtTranslation(1, 3) = -eyeLocation.y;
-		lookAtTranslation(2, 3) = -eyeLocation.z;
+		const Matrix4D lookAtTranslation(
+			1.0f, 0.0f, 0.0f, -eyeLocation.x,
+			0.0f, 1.0f, 0.0f, -eyeLocation.y,
+			0.0f, 0.0f, 1.0f, -eyeLocation.z,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
 
-		Matrix4D finalLookAt;
-		finalLookAt = lookAtRotation * lookAtTranslation;
+		Matrix4D finalLookAt = lookAtRotation * lookAtTranslation;
 /*
 		lookAtRotation(0, 3) = -Dot(right, eyeLocation);
 		lookAtRotation(1, 3) = -Dot(up, eyeLocation);
@@ -1360,30 +1401,10 @@ namespace BadgerSandbox
 		up = actualUp;
 	}
 
-	void VectorTestApplication::ExtractPlanesFromProjectionMatrix(const Matrix4D& mvpMat, std::array<float, 4>& left, std::array<float, 4>& right, std::array<float, 4>& bottom, std::array<float, 4>& top, std::array<float, 4>& zNear, std::array<float, 4>& zFar)
-	{
-		left[0] = mvpMat(3, 0) + mvpMat(0, 0);
-		left[1] = mvpMat(3, 1) + mvpMat(0, 1);
-		left[2] = mvpMat(3, 2) + mvpMat(0, 2);
-		left[3] = mvpMat(3, 3) + mvpMat(0, 3);
-		/*
-		for (int i = 4; i--; ) 
-			left[i] = mvpMat(3,i) + mvpMat(0,i);
-		for (int i = 4; i--; ) 
-			right[i] = mvpMat(3,i) - mvpMat(0,i);
-		for (int i = 4; i--; ) 
-			bottom[i] = mvpMat[i][3] + mvpMat[i][1];
-		for (int i = 4; i--; ) 
-			top[i] = mvpMat[i][3] - mvpMat[i][1];
-		for (int i = 4; i--; ) 
-			zNear[i] = mvpMat[i][3] + mvpMat[i][2];
-		for (int i = 4; i--; ) 
-			zFar[i] = mvpMat[i][3] - mvpMat[i][2];
-			*/
-	}
-
 	VectorTestApplication::VectorTestApplication()
 		: renderResourcesCount(3)
+		, sceneVersion(0)
+		, gizmoVisible(true)
 		, suitablePhysicalDeviceIndex(0xFFFFFFFF)
 		, suitableQueueFamilyIndex(0xFFFFFFFF)
 		, up(0.0f, 1.0f, 0.0f)
@@ -1392,12 +1413,6 @@ namespace BadgerSandbox
 	    , initialUp(0.0f, 1.0f, 0.0f)
 	    , initialEyeLocation(0.0f, 0.0f, 3.0f)
 	    , initialEyeDirection(0.0f, 0.0f, 0.0f)
-		, leftPlane({0, 0, 0, 0})
-		, rightPlane({ 0, 0, 0, 0 })
-		, bottomPlane({ 0, 0, 0, 0 })
-		, topPlane({ 0, 0, 0, 0 })
-		, nearPlane({ 0, 0, 0, 0 })
-		, farPlane({ 0, 0, 0, 0 })
 	{
 		WindowFactory windowFactory;
 		window = windowFactory.Create(std::array<uint32_t, 2>{1920, 1080}, std::array<uint32_t, 2>{0, 0}, std::string{ "Vector Testing" });
@@ -1412,12 +1427,14 @@ namespace BadgerSandbox
 			CreateInstance();
 			CreateSurface();
 			CreateLogicalDevice();
+			CreateMemoryAllocator();
 			CreateSemaphores();
 			CreateFences();
 			CreateSwapchain();
 			CreateRenderPass();
 			CreateSwapchainImageViews();
 			CreateDepthImage();
+			CreateFramebuffers();
 			CreateGraphicsCommandsBuffers();
 			CreateDescriptorSetLayout();
 			CreateDescriptorPool();
@@ -17,9 +17,11 @@
 #include <RapidVulkan/CommandPool.hpp>
 #include <RapidVulkan/CommandBuffers.hpp>
 #include "IWindow.hpp"
+#include "DeviceMemoryAllocator.hpp"
 
 #include "Matrix4D.hpp"
 #include "Matrix3D.hpp"
+#include "Frustum.hpp"
 
 #define GLM_DEPTH_ZERO_TO_ONE   1
 #include <glm/glm.hpp>
@@ -31,7 +33,7 @@ namespace BadgerSandbox
     struct uniformBuffer
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocation memory;
         VkDescriptorBufferInfo decriptor = {};
         void* mapped = nullptr;
     };
@@ -39,7 +41,7 @@ namespace BadgerSandbox
     struct vertexBuffer
     {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        MemoryAllocation memory;
         void* mapped = nullptr;
     };
 
@@ -58,6 +60,9 @@ namespace BadgerSandbox
         RapidVulkan::Device device;
         uint32_t suitableQueueFamilyIndex;
         VkQueue queue;
+        // Buffers and images are sub-allocated from here. Declared after the device so it releases its memory
+        // before the device is destroyed.
+        std::unique_ptr<DeviceMemoryAllocator> memoryAllocator;
 
         VkSurfaceKHR surface;
         VkSurfaceFormatKHR selectedSurfaceFormat;
@@ -66,6 +71,7 @@ namespace BadgerSandbox
 
         RapidVulkan::RenderPass renderPass;
         std::vector<RapidVulkan::ImageView> swapchainImageViews;
+        // One per swapchain image, only rebuilt when the swapchain is
         std::vector<RapidVulkan::Framebuffer> framebuffers;
 
         std::vector<RapidVulkan::Semaphore> imageAvailable;
@@ -81,6 +87,13 @@ namespace BadgerSandbox
 
         RapidVulkan::CommandPool graphicsCommandPool;
         RapidVulkan::CommandBuffers graphicsCommandBuffers;
+        // The gizmo draw of each render resource, recorded once and executed from the primary command buffer every
+        // frame until sceneVersion moves on
+        RapidVulkan::CommandBuffers sceneCommandBuffers;
+        std::vector<uint64_t> recordedSceneVersions;
+        // Bumped whenever the gizmo enters or leaves the view frustum and whenever the swapchain is recreated
+        uint64_t sceneVersion;
+        bool gizmoVisible;
 
         std::vector<vertexBuffer> vertexBuffers;
 
@@ -88,7 +101,7 @@ namespace BadgerSandbox
         std::vector<VkFence> fences;
 
         VkImage depthImage;
-        VkDeviceMemory depthImageMemory;
+        MemoryAllocation depthImageMemory;
         VkImageView depthImageView;
 
         VkDescriptorSetLayout dsLayout;
@@ -121,17 +134,12 @@ namespace BadgerSandbox
         Vector3D initialEyeLocation;
         Vector3D initialEyeDirection;
 
-        std::array<float, 4> leftPlane;
-        std::array<float, 4> rightPlane;
-        
-        std::array<float, 4> bottomPlane;
-        std::array<float, 4> topPlane;
-
-        std::array<float, 4> nearPlane;
-        std::array<float, 4> farPlane;
+        // Model-space view frustum, rebuilt from MVPMatrix every frame before recording.
+        Frustum viewFrustum;
 
         void AllocateDescriptorSet();
         void CreateDepthImage();
+        void DestroyDepthImage();
         void CreateDescriptorPool();
         void CreateDescriptorSetLayout();
         void CreateFences();
@@ -139,20 +147,22 @@ namespace BadgerSandbox
         void CreateGraphicsPipeline();
         void CreateImageView(const VkImage& image, VkImageView& imageView);
         VkImageView CreateImageViewVulkanTutorial(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory);
         void CreateInstance();
-        void CreateJustInTimeFramebuffer(RapidVulkan::Framebuffer& framebuffer, const RapidVulkan::ImageView& imageView);
+        void CreateFramebuffers();
         void CreateLogicalDevice();
+        void CreateMemoryAllocator();
         void CreateRenderPass();
         void CreateSemaphores();
         void CreateSurface();
         void CreateSwapchain();
         void CreateSwapchainImageViews();
         VkFormat FindDepthFormat();
-        uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex);
-        void CreateBuffer(VkBuffer &buffer, VkDeviceMemory& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties);
+        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex);
+        void RecordSceneCommandBuffer(const size_t& resourceIndex);
+        void RecreateSwapchain();
+        void CreateBuffer(VkBuffer &buffer, MemoryAllocation& memory, void** mappedMemory, VkBufferUsageFlags usage, VkDeviceSize size, VkMemoryPropertyFlags properties);
         void CreateUniformBuffers();
         void CreateVertexBuffer();
         void UpdateDescriptorSet();
@@ -160,7 +170,6 @@ namespace BadgerSandbox
         Matrix4D LookAt();
         Matrix4D Perspective(float r, float l, float t, float b, float f, float n);
         Matrix4D Perspective(float fov, float aspect, float far, float near);
-        void ExtractPlanesFromProjectionMatrix(const Matrix4D& mvpMat, std::array<float, 4>& left, std::array<float, 4>& right, std::array<float, 4>& bottom, std::array<float, 4>& top, std::array<float, 4>& near, std::array<float, 4>& far);
 	public:
         std::shared_ptr<IWindow> window;
         VectorTestApplication();
@@ -2,11 +2,13 @@
 #include <cstring>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include "DeviceMemoryAllocator.hpp"
 
 GLFWwindow* window;
 VkInstance instance;
@@ -41,6 +43,9 @@ VkCommandPool graphicsCommandPool;
 std::vector<VkCommandBuffer> graphicsCommandBuffers;
 
 VkBuffer vertexBuffer;
+BadgerSandbox::MemoryAllocation vertexBufferMemory;
+
+std::unique_ptr<BadgerSandbox::DeviceMemoryAllocator> memoryAllocator;
 
 static const size_t renderResourcesCount = 3;
 std::vector<VkFence> fences;
@@ -839,6 +844,11 @@ void CreateGraphicsCommandsBuffers()
 	framebuffers.resize(renderResourcesCount);
 }
 
+void CreateMemoryAllocator()
+{
+	memoryAllocator.reset(new BadgerSandbox::DeviceMemoryAllocator(selectedPhysicalDevice, device));
+}
+
 void CreateVertexBuffer()
 {
   VertexData vertexData[] =
@@ -883,55 +893,21 @@ void CreateVertexBuffer()
 	VkMemoryRequirements bufferMemoryRequirements;
 	vkGetBufferMemoryRequirements(device, vertexBuffer, &bufferMemoryRequirements);
 
-	VkPhysicalDeviceMemoryProperties memoryProperties;
-	vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memoryProperties);
-
-	VkDeviceMemory vertexBufferMemory;
-
-	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) 
+	BadgerSandbox::MemoryRequest memoryRequest;
+	memoryRequest.properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	if (memoryAllocator->Allocate(bufferMemoryRequirements, memoryRequest, vertexBufferMemory) != VK_SUCCESS)
 	{
-		if ((bufferMemoryRequirements.memoryTypeBits & (1 << i)) &&
-			(memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
-		{
-			VkMemoryAllocateInfo memoryAllocateInfo = 
-			{
-			  VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,     // VkStructureType                        sType
-			  nullptr,                                    // const void                            *pNext
-			  bufferMemoryRequirements.size,              // VkDeviceSize                           allocationSize
-			  i                                           // uint32_t                               memoryTypeIndex
-			};
-
-			if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &vertexBufferMemory) != VK_SUCCESS)
-			{
-				throw std::runtime_error("Could not allocate memory");
-			}
-		}
+		throw std::runtime_error("Could not allocate memory");
 	}
 
-	if (vkBindBufferMemory(device, vertexBuffer, vertexBufferMemory, 0) != VK_SUCCESS) 
+	if (vkBindBufferMemory(device, vertexBuffer, vertexBufferMemory.memory, vertexBufferMemory.offset) != VK_SUCCESS) 
 	{
 		throw std::runtime_error("Could not bind memory to the vertex buffer");
 	}
 
-	void* bufferMemoryPointer;
-	if (vkMapMemory(device, vertexBufferMemory, 0, vertexBufferSize, 0, &bufferMemoryPointer) != VK_SUCCESS) 
-	{
-		throw std::runtime_error("Could not map user memory to the vertex buffer memory");
-	}
-
-	std::memcpy(bufferMemoryPointer, vertexData, vertexBufferSize);
-
-	VkMappedMemoryRange flushRange = 
-	{
-	  VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,            // VkStructureType        sType
-	  nullptr,                                          // const void            *pNext
-	  vertexBufferMemory,                               // VkDeviceMemory         memory
-	  0,                                                // VkDeviceSize           offset
-	  VK_WHOLE_SIZE                                     // VkDeviceSize           size
-	};
-	vkFlushMappedMemoryRanges(device, 1, &flushRange);
-
-	vkUnmapMemory(device, vertexBufferMemory);
+	// Host visible memory stays mapped while it is allocated
+	std::memcpy(vertexBufferMemory.mapped, vertexData, vertexBufferSize);
+	memoryAllocator->Flush(vertexBufferMemory);
 }
 
 void CreateJustInTimeFramebuffer(VkFramebuffer& framebuffer, const VkImageView& imageView)
@@ -1102,6 +1078,7 @@ void initVulkan()
 		CreateInstance();
 		CreateSurface();
 		CreateLogicalDevice();
+		CreateMemoryAllocator();
 		CreateSemaphores();
 		CreateFences();
 		CreateSwapchain();
@@ -1189,6 +1166,12 @@ int main()
 			vkDestroySwapchainKHR(device, swapchain, nullptr);
 		}
 
+		if (memoryAllocator)
+		{
+			memoryAllocator->DestroyBuffer(vertexBuffer, vertexBufferMemory);
+			memoryAllocator.reset();
+		}
+
 		vkDestroyDevice(device, nullptr);
 	}
 
@@ -2,11 +2,14 @@
 #include <cstring>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include "DeviceMemoryAllocator.hpp"
+#include "StagingRing.hpp"
 
 GLFWwindow* window;
 VkInstance instance;
@@ -41,7 +44,15 @@ VkCommandPool graphicsCommandPool;
 std::vector<VkCommandBuffer> graphicsCommandBuffers;
 
 VkBuffer vertexBuffer;
-VkDeviceMemory vertexBufferMemory;
+BadgerSandbox::MemoryAllocation vertexBufferMemory;
+
+std::unique_ptr<BadgerSandbox::DeviceMemoryAllocator> memoryAllocator;
+
+// Uploads recorded between BeginUploads and SubmitUploads stage their data in the ring and go to the GPU in one submission
+static const VkDeviceSize stagingRingSize = 64 * 1024;
+std::unique_ptr<BadgerSandbox::StagingRing> stagingRing;
+BadgerSandbox::StagingBatch uploadBatch;
+VkCommandBuffer uploadCommandBuffer;
 
 static const size_t renderResourcesCount = 3;
 std::vector<VkFence> fences;
@@ -840,37 +851,25 @@ void CreateGraphicsCommandsBuffers()
 	framebuffers.resize(renderResourcesCount);
 }
 
-void AllocateBufferMemory(VkBuffer& buffer, const VkMemoryPropertyFlags& memoryProperty, VkDeviceMemory& memory)
+void CreateMemoryAllocator()
+{
+	memoryAllocator.reset(new BadgerSandbox::DeviceMemoryAllocator(selectedPhysicalDevice, device));
+}
+
+void AllocateBufferMemory(const VkBuffer& buffer, const VkMemoryPropertyFlags& memoryProperty, BadgerSandbox::MemoryAllocation& memory)
 {
 	VkMemoryRequirements bufferMemoryRequirements;
 	vkGetBufferMemoryRequirements(device, buffer, &bufferMemoryRequirements);
 
-	VkPhysicalDeviceMemoryProperties memoryProperties;
-	vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memoryProperties);
-
-	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+	BadgerSandbox::MemoryRequest memoryRequest;
+	memoryRequest.properties = memoryProperty;
+	if (memoryAllocator->Allocate(bufferMemoryRequirements, memoryRequest, memory) != VK_SUCCESS)
 	{
-		if ((bufferMemoryRequirements.memoryTypeBits & (1 << i)) &&
-			((memoryProperties.memoryTypes[i].propertyFlags & memoryProperty) == memoryProperty))
-		{
-
-			VkMemoryAllocateInfo memoryAllocateInfo =
-			{
-			  VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,       // VkStructureType                sType
-			  nullptr,                                      // const void                    *pNext
-			  bufferMemoryRequirements.size,              // VkDeviceSize                   allocationSize
-			  i                                             // uint32_t                       memoryTypeIndex
-			};
-
-			if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &memory) != VK_SUCCESS)
-			{
-				throw std::runtime_error("Could not Allocate memory for the buffer");
-			}
-		}
+		throw std::runtime_error("Could not Allocate memory for the buffer");
 	}
 }
 
-void CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer& bufferToCreate, VkDeviceMemory& memory, const VkMemoryPropertyFlags& memoryProperty)
+void CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer& bufferToCreate, BadgerSandbox::MemoryAllocation& memory, const VkMemoryPropertyFlags& memoryProperty)
 {
 	VkBufferCreateInfo bufferCreateInfo = {
 	VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,             // VkStructureType                sType
@@ -890,12 +889,42 @@ void CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer&
 
 	AllocateBufferMemory(bufferToCreate, memoryProperty, memory);
 
-	if (vkBindBufferMemory(device, bufferToCreate, memory, 0) != VK_SUCCESS)
+	if (vkBindBufferMemory(device, bufferToCreate, memory.memory, memory.offset) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Could not bind memory to buffer");
 	}
 }
 
+void BeginUploads()
+{
+	stagingRing.reset(new BadgerSandbox::StagingRing(selectedPhysicalDevice, device, stagingRingSize));
+	uploadBatch = BadgerSandbox::StagingBatch();
+
+	VkCommandBufferBeginInfo commandBufferBeginInfo = 
+	{
+	  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,      // VkStructureType                        sType
+	  nullptr,                                          // const void                            *pNext
+	  VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,      // VkCommandBufferUsageFlags              flags
+	  nullptr                                           // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
+	};
+
+	uploadCommandBuffer = graphicsCommandBuffers[0];
+	vkBeginCommandBuffer(uploadCommandBuffer, &commandBufferBeginInfo);
+}
+
+void SubmitUploads()
+{
+	if (vkEndCommandBuffer(uploadCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Could not record the upload command buffer");
+	}
+
+	stagingRing->Submit(uploadBatch, queue, uploadCommandBuffer);
+
+	// The first frame re-records graphicsCommandBuffers[0]
+	stagingRing->Wait(uploadBatch);
+}
+
 void CreateVertexBuffer()
 {
   VertexData vertexData[] =
@@ -920,51 +949,21 @@ void CreateVertexBuffer()
 
 	VkDeviceSize vertexBufferSize = sizeof(vertexData);
 	CreateBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, vertexBuffer, vertexBufferMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VkBuffer stagingBuffer;
-	VkDeviceSize stagingBufferSize = 4000;
-	VkDeviceMemory stagingBufferMemory;
-	CreateBuffer(stagingBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffer, stagingBufferMemory, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-
-	void* stagingBufferMemoryPointer;
-	if (vkMapMemory(device, stagingBufferMemory, 0, vertexBufferSize, 0, &stagingBufferMemoryPointer) != VK_SUCCESS)
+	BadgerSandbox::StagingRegion stagingRegion;
+	if (!stagingRing->Allocate(uploadBatch, vertexBufferSize, 16, stagingRegion))
 	{
-		throw std::runtime_error("Could not map staging buffer memory");
+		throw std::runtime_error("Could not reserve staging memory for the vertex buffer");
 	}
 
-	std::memcpy(stagingBufferMemoryPointer, vertexData, vertexBufferSize);
-
-	VkMappedMemoryRange flushRange = 
-	{
-	  VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,            // VkStructureType                        sType
-	  nullptr,                                          // const void                            *pNext
-	  stagingBufferMemory,                              // VkDeviceMemory                         memory
-	  0,                                                // VkDeviceSize                           offset
-	  vertexBufferSize                                  // VkDeviceSize                           size
-	};
-	vkFlushMappedMemoryRanges(device, 1, &flushRange);
-
-	vkUnmapMemory(device, stagingBufferMemory);
-
-	// Prepare command buffer to copy data from staging buffer to a vertex buffer
-	VkCommandBufferBeginInfo commandBufferBeginInfo = 
-	{
-	  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,      // VkStructureType                        sType
-	  nullptr,                                          // const void                            *pNext
-	  VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,      // VkCommandBufferUsageFlags              flags
-	  nullptr                                           // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
-	};
-
-	VkCommandBuffer commandBuffer = graphicsCommandBuffers[0];
-
-	vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+	std::memcpy(stagingRegion.data, vertexData, vertexBufferSize);
 
 	VkBufferCopy bufferCopyInfo = 
 	{
-	  0,                                                // VkDeviceSize                           srcOffset
+	  stagingRegion.offset,                             // VkDeviceSize                           srcOffset
 	  0,                                                // VkDeviceSize                           dstOffset
 	  vertexBufferSize                                  // VkDeviceSize                           size
 	};
-	vkCmdCopyBuffer(commandBuffer, stagingBuffer, vertexBuffer, 1, &bufferCopyInfo);
+	vkCmdCopyBuffer(uploadCommandBuffer, stagingRegion.buffer, vertexBuffer, 1, &bufferCopyInfo);
 
 	VkBufferMemoryBarrier bufferMemoryBarrier = 
 	{
@@ -978,31 +977,7 @@ void CreateVertexBuffer()
 	  0,                                                // VkDeviceSize                           offset
 	  VK_WHOLE_SIZE                                     // VkDeviceSize                           size
 	};
-	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
-
-	vkEndCommandBuffer(commandBuffer);
-
-	// Submit command buffer and copy data from staging buffer to a vertex buffer
-	VkSubmitInfo submitInfo = 
-	{
-	  VK_STRUCTURE_TYPE_SUBMIT_INFO,                    // VkStructureType                        sType
-	  nullptr,                                          // const void                            *pNext
-	  0,                                                // uint32_t                               waitSemaphoreCount
-	  nullptr,                                          // const VkSemaphore                     *pWaitSemaphores
-	  nullptr,                                          // const VkPipelineStageFlags            *pWaitDstStageMask;
-	  1,                                                // uint32_t                               commandBufferCount
-	  & commandBuffer,                                  // const VkCommandBuffer                 *pCommandBuffers
-	  0,                                                // uint32_t                               signalSemaphoreCount
-	  nullptr                                           // const VkSemaphore                     *pSignalSemaphores
-	};
-
-	if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) 
-	{
-		throw std::runtime_error("Copy from staging to vertex buffer command failed");
-	}
-
-	vkDeviceWaitIdle(device);
-
+	vkCmdPipelineBarrier(uploadCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
 }
 
 void CreateJustInTimeFramebuffer(VkFramebuffer& framebuffer, const VkImageView& imageView)
@@ -1173,6 +1148,7 @@ void initVulkan()
 		CreateInstance();
 		CreateSurface();
 		CreateLogicalDevice();
+		CreateMemoryAllocator();
 		CreateSemaphores();
 		CreateFences();
 		CreateSwapchain();
@@ -1180,7 +1156,9 @@ void initVulkan()
 		CreateSwapchainImageViews();
 		CreateGraphicsPipeline();
 		CreateGraphicsCommandsBuffers();
+		BeginUploads();
 		CreateVertexBuffer();
+		SubmitUploads();
 	}
     catch(std::exception& e) 
     {
@@ -1260,6 +1238,14 @@ int main()
 			vkDestroySwapchainKHR(device, swapchain, nullptr);
 		}
 
+		stagingRing.reset();
+
+		if (memoryAllocator)
+		{
+			memoryAllocator->DestroyBuffer(vertexBuffer, vertexBufferMemory);
+			memoryAllocator.reset();
+		}
+
 		vkDestroyDevice(device, nullptr);
 	}
 
@@ -2,11 +2,14 @@
 #include <cstring>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include "DeviceMemoryAllocator.hpp"
+#include "StagingRing.hpp"
 #include "RenderBadger.h"
 
 GLFWwindow* window;
@@ -42,7 +45,16 @@ VkCommandPool graphicsCommandPool;
 std::vector<VkCommandBuffer> graphicsCommandBuffers;
 
 VkBuffer vertexBuffer;
-VkDeviceMemory vertexBufferMemory;
+BadgerSandbox::MemoryAllocation vertexBufferMemory;
+
+// The texture image goes to the optimally tiled pool of its memory type, the vertex buffer to the linear one
+std::unique_ptr<BadgerSandbox::DeviceMemoryAllocator> memoryAllocator;
+
+// Uploads recorded between BeginUploads and SubmitUploads stage their data in the ring and go to the GPU in one submission
+static const VkDeviceSize stagingRingSize = 4 * 1024 * 1024;
+std::unique_ptr<BadgerSandbox::StagingRing> stagingRing;
+BadgerSandbox::StagingBatch uploadBatch;
+VkCommandBuffer uploadCommandBuffer;
 
 static const size_t renderResourcesCount = 3;
 std::vector<VkFence> fences;
@@ -57,7 +69,7 @@ struct VertexData
 
 VkImage textureImage;
 VkImageView textureImageView;
-VkDeviceMemory textureMemory;
+BadgerSandbox::MemoryAllocation textureMemory;
 VkSampler textureSampler;
 
 VkDescriptorSetLayout dsLayout;
@@ -851,37 +863,25 @@ void CreateGraphicsCommandsBuffers()
 	framebuffers.resize(renderResourcesCount);
 }
 
-void AllocateBufferMemory(VkBuffer& buffer, const VkMemoryPropertyFlags& memoryProperty, VkDeviceMemory& memory)
+void CreateMemoryAllocator()
+{
+	memoryAllocator.reset(new BadgerSandbox::DeviceMemoryAllocator(selectedPhysicalDevice, device));
+}
+
+void AllocateBufferMemory(const VkBuffer& buffer, const VkMemoryPropertyFlags& memoryProperty, BadgerSandbox::MemoryAllocation& memory)
 {
 	VkMemoryRequirements bufferMemoryRequirements;
 	vkGetBufferMemoryRequirements(device, buffer, &bufferMemoryRequirements);
 
-	VkPhysicalDeviceMemoryProperties memoryProperties;
-	vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memoryProperties);
-
-	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+	BadgerSandbox::MemoryRequest memoryRequest;
+	memoryRequest.properties = memoryProperty;
+	if (memoryAllocator->Allocate(bufferMemoryRequirements, memoryRequest, memory) != VK_SUCCESS)
 	{
-		if ((bufferMemoryRequirements.memoryTypeBits & (1 << i)) &&
-			((memoryProperties.memoryTypes[i].propertyFlags & memoryProperty) == memoryProperty))
-		{
-
-			VkMemoryAllocateInfo memoryAllocateInfo =
-			{
-			  VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,       // VkStructureType                sType
-			  nullptr,                                      // const void                    *pNext
-			  bufferMemoryRequirements.size,              // VkDeviceSize                   allocationSize
-			  i                                             // uint32_t                       memoryTypeIndex
-			};
-
-			if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &memory) != VK_SUCCESS)
-			{
-				throw std::runtime_error("Could not Allocate memory for the buffer");
-			}
-		}
+		throw std::runtime_error("Could not Allocate memory for the buffer");
 	}
 }
 
-void CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer& bufferToCreate, VkDeviceMemory& memory, const VkMemoryPropertyFlags& memoryProperty)
+void CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer& bufferToCreate, BadgerSandbox::MemoryAllocation& memory, const VkMemoryPropertyFlags& memoryProperty)
 {
 	VkBufferCreateInfo bufferCreateInfo = {
 	VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,             // VkStructureType                sType
@@ -901,12 +901,42 @@ void CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer&
 
 	AllocateBufferMemory(bufferToCreate, memoryProperty, memory);
 
-	if (vkBindBufferMemory(device, bufferToCreate, memory, 0) != VK_SUCCESS)
+	if (vkBindBufferMemory(device, bufferToCreate, memory.memory, memory.offset) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Could not bind memory to buffer");
 	}
 }
 
+void BeginUploads()
+{
+	stagingRing.reset(new BadgerSandbox::StagingRing(selectedPhysicalDevice, device, stagingRingSize));
+	uploadBatch = BadgerSandbox::StagingBatch();
+
+	VkCommandBufferBeginInfo commandBufferBeginInfo = 
+	{
+	  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,      // VkStructureType                        sType
+	  nullptr,                                          // const void                            *pNext
+	  VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,      // VkCommandBufferUsageFlags              flags
+	  nullptr                                           // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
+	};
+
+	uploadCommandBuffer = graphicsCommandBuffers[0];
+	vkBeginCommandBuffer(uploadCommandBuffer, &commandBufferBeginInfo);
+}
+
+void SubmitUploads()
+{
+	if (vkEndCommandBuffer(uploadCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Could not record the upload command buffer");
+	}
+
+	stagingRing->Submit(uploadBatch, queue, uploadCommandBuffer);
+
+	// The first frame re-records graphicsCommandBuffers[0]
+	stagingRing->Wait(uploadBatch);
+}
+
 void CreateVertexBuffer()
 {
   VertexData vertexData[] =
@@ -931,51 +961,21 @@ void CreateVertexBuffer()
 
 	VkDeviceSize vertexBufferSize = sizeof(vertexData);
 	CreateBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, vertexBuffer, vertexBufferMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VkBuffer stagingBuffer;
-	VkDeviceSize stagingBufferSize = 4000;
-	VkDeviceMemory stagingBufferMemory;
-	CreateBuffer(stagingBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffer, stagingBufferMemory, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-
-	void* stagingBufferMemoryPointer;
-	if (vkMapMemory(device, stagingBufferMemory, 0, vertexBufferSize, 0, &stagingBufferMemoryPointer) != VK_SUCCESS)
+	BadgerSandbox::StagingRegion stagingRegion;
+	if (!stagingRing->Allocate(uploadBatch, vertexBufferSize, 16, stagingRegion))
 	{
-		throw std::runtime_error("Could not map staging buffer memory");
+		throw std::runtime_error("Could not reserve staging memory for the vertex buffer");
 	}
 
-	std::memcpy(stagingBufferMemoryPointer, vertexData, vertexBufferSize);
-
-	VkMappedMemoryRange flushRange = 
-	{
-	  VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,            // VkStructureType                        sType
-	  nullptr,                                          // const void                            *pNext
-	  stagingBufferMemory,                              // VkDeviceMemory                         memory
-	  0,                                                // VkDeviceSize                           offset
-	  vertexBufferSize                                  // VkDeviceSize                           size
-	};
-	vkFlushMappedMemoryRanges(device, 1, &flushRange);
-
-	vkUnmapMemory(device, stagingBufferMemory);
-
-	// Prepare command buffer to copy data from staging buffer to a vertex buffer
-	VkCommandBufferBeginInfo commandBufferBeginInfo = 
-	{
-	  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,      // VkStructureType                        sType
-	  nullptr,                                          // const void                            *pNext
-	  VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,      // VkCommandBufferUsageFlags              flags
-	  nullptr                                           // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
-	};
-
-	VkCommandBuffer commandBuffer = graphicsCommandBuffers[0];
-
-	vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+	std::memcpy(stagingRegion.data, vertexData, vertexBufferSize);
 
 	VkBufferCopy bufferCopyInfo = 
 	{
-	  0,                                                // VkDeviceSize                           srcOffset
+	  stagingRegion.offset,                             // VkDeviceSize                           srcOffset
 	  0,                                                // VkDeviceSize                           dstOffset
 	  vertexBufferSize                                  // VkDeviceSize                           size
 	};
-	vkCmdCopyBuffer(commandBuffer, stagingBuffer, vertexBuffer, 1, &bufferCopyInfo);
+	vkCmdCopyBuffer(uploadCommandBuffer, stagingRegion.buffer, vertexBuffer, 1, &bufferCopyInfo);
 
 	VkBufferMemoryBarrier bufferMemoryBarrier = 
 	{
@@ -989,31 +989,7 @@ void CreateVertexBuffer()
 	  0,                                                // VkDeviceSize                           offset
 	  VK_WHOLE_SIZE                                     // VkDeviceSize                           size
 	};
-	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
-
-	vkEndCommandBuffer(commandBuffer);
-
-	// Submit command buffer and copy data from staging buffer to a vertex buffer
-	VkSubmitInfo submitInfo = 
-	{
-	  VK_STRUCTURE_TYPE_SUBMIT_INFO,                    // VkStructureType                        sType
-	  nullptr,                                          // const void                            *pNext
-	  0,                                                // uint32_t                               waitSemaphoreCount
-	  nullptr,                                          // const VkSemaphore                     *pWaitSemaphores
-	  nullptr,                                          // const VkPipelineStageFlags            *pWaitDstStageMask;
-	  1,                                                // uint32_t                               commandBufferCount
-	  & commandBuffer,                                  // const VkCommandBuffer                 *pCommandBuffers
-	  0,                                                // uint32_t                               signalSemaphoreCount
-	  nullptr                                           // const VkSemaphore                     *pSignalSemaphores
-	};
-
-	if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) 
-	{
-		throw std::runtime_error("Copy from staging to vertex buffer command failed");
-	}
-
-	vkDeviceWaitIdle(device);
-
+	vkCmdPipelineBarrier(uploadCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
 }
 
 void CreateJustInTimeFramebuffer(VkFramebuffer& framebuffer, const VkImageView& imageView)
@@ -1159,37 +1135,18 @@ void CreateImage(uint32_t width, uint32_t height, VkImage& image)
 	}
 }
 
-void AllocateImageMemory(const VkImage& image, VkDeviceMemory& memory, const VkMemoryPropertyFlags& memoryProperty)
+void AllocateImageMemory(const VkImage& image, BadgerSandbox::MemoryAllocation& memory, const VkMemoryPropertyFlags& memoryProperty)
 {
 	VkMemoryRequirements imageMemoryRequirements;
 	vkGetImageMemoryRequirements(device, image, &imageMemoryRequirements);
 
-	VkPhysicalDeviceMemoryProperties memoryProperties;
-	vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memoryProperties);
-
-	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) 
+	BadgerSandbox::MemoryRequest memoryRequest;
+	memoryRequest.properties = memoryProperty;
+	// CreateImage uses VK_IMAGE_TILING_OPTIMAL
+	memoryRequest.optimalTiling = true;
+	if (memoryAllocator->Allocate(imageMemoryRequirements, memoryRequest, memory) != VK_SUCCESS)
 	{
-		if ((imageMemoryRequirements.memoryTypeBits & (1 << i)) &&
-			(memoryProperties.memoryTypes[i].propertyFlags & memoryProperty)) 
-		{
-
-			VkMemoryAllocateInfo memory_allocate_info = 
-			{
-			  VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, // VkStructureType  sType
-			  nullptr,                                // const void      *pNext
-			  imageMemoryRequirements.size,           // VkDeviceSize     allocationSize
-			  i                                       // uint32_t         memoryTypeIndex
-			};
-
-			if (vkAllocateMemory(device, &memory_allocate_info, nullptr, &memory) != VK_SUCCESS) 
-			{
-				throw std::runtime_error("Couldn't Allocate Memory for the image");
-			}
-			else
-			{
-				break;
-			}
-		}
+		throw std::runtime_error("Couldn't Allocate Memory for the image");
 	}
 }
 
@@ -1258,7 +1215,7 @@ void CreateTexture()
 {
 	CreateImage(720, 720, textureImage);
 	AllocateImageMemory(textureImage, textureMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	if(vkBindImageMemory(device, textureImage, textureMemory, 0) != VK_SUCCESS)
+	if(vkBindImageMemory(device, textureImage, textureMemory.memory, textureMemory.offset) != VK_SUCCESS)
 	{
 	  throw std::runtime_error("Couldn't bind memory to texture");
 	}
@@ -1266,44 +1223,14 @@ void CreateTexture()
 	CreateImageView(textureImage, textureImageView);
 	CreateSampler(textureSampler);
 	
-	VkBuffer stagingBuffer;
-	VkDeviceSize stagingBufferSize = 720*720*4;
-	VkDeviceMemory stagingBufferMemory;
-
-	CreateBuffer(stagingBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffer, stagingBufferMemory, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-
-	void* stagingBufferMemoryPointer;
-
-	if (vkMapMemory(device, stagingBufferMemory, 0, stagingBufferSize, 0, &stagingBufferMemoryPointer) != VK_SUCCESS)
+	VkDeviceSize imageSize = 720*720*4;
+	BadgerSandbox::StagingRegion stagingRegion;
+	if (!stagingRing->Allocate(uploadBatch, imageSize, 16, stagingRegion))
 	{
-		throw std::runtime_error("Couldn't map memory to the Image staging buffer");
+		throw std::runtime_error("Could not reserve staging memory for the texture");
 	}
 
-	std::memcpy(stagingBufferMemoryPointer, ImageData, stagingBufferSize);
-
-	VkMappedMemoryRange flushRange = 
-	{
-	  VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,              // VkStructureType                        sType
-	  nullptr,                                            // const void                            *pNext
-	  stagingBufferMemory,                                // VkDeviceMemory                         memory
-	  0,                                                  // VkDeviceSize                           offset
-	  stagingBufferSize                                   // VkDeviceSize                           size
-	};
-	vkFlushMappedMemoryRanges(device, 1, &flushRange);
-	vkUnmapMemory(device, stagingBufferMemory);
-
-	// Prepare command buffer to copy data from staging buffer to a vertex buffer
-	VkCommandBufferBeginInfo commandBufferBeginInfo = 
-	{
-	  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,        // VkStructureType                        sType
-	  nullptr,                                            // const void                            *pNext
-	  VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,        // VkCommandBufferUsageFlags              flags
-	  nullptr                                             // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
-	};
-
-	VkCommandBuffer commandBuffer = graphicsCommandBuffers[0];
-
-	vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+	std::memcpy(stagingRegion.data, ImageData, imageSize);
 
 	VkImageSubresourceRange imageSubResourceRange = 
 	{
@@ -1327,11 +1254,11 @@ void CreateTexture()
 	  textureImage,                                // VkImage                                image
 	  imageSubResourceRange                             // VkImageSubresourceRange                subresourceRange
 	};
-	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrierFromUndefinedToTransferDst);
+	vkCmdPipelineBarrier(uploadCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrierFromUndefinedToTransferDst);
 
 	VkBufferImageCopy bufferImageCopyInfo = 
 	{
-	  0,                                                  // VkDeviceSize                           bufferOffset
+	  stagingRegion.offset,                               // VkDeviceSize                           bufferOffset
 	  0,                                                  // uint32_t                               bufferRowLength
 	  0,                                                  // uint32_t                               bufferImageHeight
 	  {                                                   // VkImageSubresourceLayers               imageSubresource
@@ -1351,7 +1278,7 @@ void CreateTexture()
 		1                                                   // uint32_t                               depth
 	  }
 	};
-	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopyInfo);
+	vkCmdCopyBufferToImage(uploadCommandBuffer, stagingRegion.buffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopyInfo);
 
 	VkImageMemoryBarrier imageMemoryBarrierFromTransferToShaderRead = 
 	{
@@ -1366,30 +1293,7 @@ void CreateTexture()
 	  textureImage,                                       // VkImage                                image
 	  imageSubResourceRange                               // VkImageSubresourceRange                subresourceRange
 	};
-	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrierFromTransferToShaderRead);
-
-	vkEndCommandBuffer(commandBuffer);
-
-	// Submit command buffer and copy data from staging buffer to a vertex buffer
-	VkSubmitInfo submitInfo = 
-	{
-	  VK_STRUCTURE_TYPE_SUBMIT_INFO,                      // VkStructureType                        sType
-	  nullptr,                                            // const void                            *pNext
-	  0,                                                  // uint32_t                               waitSemaphoreCount
-	  nullptr,                                            // const VkSemaphore                     *pWaitSemaphores
-	  nullptr,                                            // const VkPipelineStageFlags            *pWaitDstStageMask;
-	  1,                                                  // uint32_t                               commandBufferCount
-	  &commandBuffer,                                     // const VkCommandBuffer                 *pCommandBuffers
-	  0,                                                  // uint32_t                               signalSemaphoreCount
-	  nullptr                                             // const VkSemaphore                     *pSignalSemaphores
-	};
-
-	if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) 
-	{
-		throw std::runtime_error("Command Buffer to copy from staging buffer to Image buffer memory failed");
-	}
-
-	vkDeviceWaitIdle(device);
+	vkCmdPipelineBarrier(uploadCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrierFromTransferToShaderRead);
 }
 
 void CreateDescriptorSetLayout()
@@ -1543,14 +1447,17 @@ void initVulkan()
 		CreateInstance();
 		CreateSurface();
 		CreateLogicalDevice();
+		CreateMemoryAllocator();
 		CreateSemaphores();
 		CreateFences();
 		CreateSwapchain();
 		CreateRenderPass();
 		CreateSwapchainImageViews();
 		CreateGraphicsCommandsBuffers();
+		BeginUploads();
 		CreateVertexBuffer();
 		CreateTexture();
+		SubmitUploads();
 		CreateDescriptorSetLayout();
 		CreateDescriptorPool();
 		AllocateDescriptorSet();
@@ -1635,6 +1542,15 @@ int main()
 			vkDestroySwapchainKHR(device, swapchain, nullptr);
 		}
 
+		stagingRing.reset();
+
+		if (memoryAllocator)
+		{
+			memoryAllocator->DestroyBuffer(vertexBuffer, vertexBufferMemory);
+			memoryAllocator->DestroyImage(textureImage, textureMemory);
+			memoryAllocator.reset();
+		}
+
 		vkDestroyDevice(device, nullptr);
 	}
 
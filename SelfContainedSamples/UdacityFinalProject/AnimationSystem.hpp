@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "ThreadPool.hpp"
+#include "VulkanglTFModel.hpp"
+
+namespace BadgerSandbox
+{
+	// Advances the animations of many vkglTF::Model instances on a worker pool. Every instance owns its
+	// scene graph and mesh uniform blocks, so instances are evaluated independently and their results
+	// published into the per-frame uniform buffers of the frame about to be recorded
+	// (see vkglTF::Model::createFrameBuffers).
+	class AnimationSystem
+	{
+	public:
+		struct Instance
+		{
+			vkglTF::Model* model;
+			uint32_t animationIndex;
+			float time;
+			float speed;
+			bool playing;
+		};
+
+		explicit AnimationSystem(ThreadPool& pool)
+			: pool(pool)
+		{
+		}
+
+		size_t Add(vkglTF::Model* model, uint32_t animationIndex = 0)
+		{
+			instances.push_back({ model, animationIndex, 0.0f, 1.0f, true });
+			return instances.size() - 1;
+		}
+
+		Instance& Get(size_t handle) { return instances[handle]; }
+		size_t Size() const { return instances.size(); }
+		void Clear() { instances.clear(); }
+
+		// Must be called once per frame, after the fence of frameIndex has been waited on.
+		void Update(float deltaTime, uint32_t frameIndex)
+		{
+			pool.ParallelFor(instances.size(), [this, deltaTime, frameIndex](size_t i)
+			{
+				Instance& instance = instances[i];
+				vkglTF::Model& model = *instance.model;
+				if (instance.playing && instance.animationIndex < model.animations.size())
+				{
+					const vkglTF::Animation& animation = model.animations[instance.animationIndex];
+					instance.time += deltaTime * instance.speed;
+					if (animation.end > 0.0f && instance.time > animation.end)
+					{
+						instance.time = std::fmod(instance.time, animation.end);
+					}
+					model.updateAnimation(instance.animationIndex, instance.time);
+				}
+				model.publish(frameIndex);
+			});
+		}
+
+	private:
+		ThreadPool& pool;
+		std::vector<Instance> instances;
+	};
+}
\ No newline at end of file
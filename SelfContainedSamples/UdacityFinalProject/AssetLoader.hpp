@@ -0,0 +1,103 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "StagingRing.hpp"
+#include "ThreadPool.hpp"
+#include "VulkanDevice.hpp"
+#include "VulkanglTFModel.hpp"
+
+namespace BadgerSandbox
+{
+	// Loads vkglTF models on a worker pool. Vulkan requires command pools and queues to be externally
+	// synchronized, so every load records into a command pool of its own, borrowed from a set of worker
+	// contexts, and submits through the queue mutex of the device it was created with. The models keep that
+	// device, the contexts are only used while a load runs, so models may outlive the loader. Each load waits
+	// on its own fence, which lets the uploads of different models overlap. Uploads are staged in a ring shared
+	// by all loads, so loading doesn't create a staging buffer per model.
+	class AssetLoader
+	{
+	private:
+	  ThreadPool& pool;
+	  vks::VulkanDevice& device;
+	  VkQueue queue;
+	  uint32_t queueFamilyIndex;
+	  std::mutex contextMutex;
+	  std::vector<std::unique_ptr<vks::VulkanDevice>> contexts;
+	  std::vector<vks::VulkanDevice*> idleContexts;
+	  StagingRing stagingRing;
+
+	  // A device sharing the logical device, queue mutex and memory allocator of device, with a command pool of its own
+	  vks::VulkanDevice* AcquireContext()
+	  {
+		  std::lock_guard<std::mutex> lock(contextMutex);
+		  if (idleContexts.empty())
+		  {
+			  std::unique_ptr<vks::VulkanDevice> context(new vks::VulkanDevice(device.physicalDevice, device.logicalDevice, VK_NULL_HANDLE));
+			  context->commandPool = context->createCommandPool(queueFamilyIndex, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+			  context->queueMutex = device.queueMutex;
+			  context->memoryAllocator = device.memoryAllocator;
+			  idleContexts.push_back(context.get());
+			  contexts.push_back(std::move(context));
+		  }
+		  vks::VulkanDevice* context = idleContexts.back();
+		  idleContexts.pop_back();
+		  return (context);
+	  }
+
+	  void ReleaseContext(vks::VulkanDevice* context)
+	  {
+		  std::lock_guard<std::mutex> lock(contextMutex);
+		  idleContexts.push_back(context);
+	  }
+	public:
+		// Every other thread submitting to queue must hold device.queueMutex while doing so. Models whose uploads don't
+		// fit in stagingSize next to the ones of other loads fall back to staging buffers of their own.
+		AssetLoader(ThreadPool& pool, vks::VulkanDevice& device, VkQueue queue, uint32_t queueFamilyIndex, VkDeviceSize stagingSize = 64 * 1024 * 1024)
+			: pool(pool)
+			, device(device)
+			, queue(queue)
+			, queueFamilyIndex(queueFamilyIndex)
+			, stagingRing(device.physicalDevice, device.logicalDevice, stagingSize)
+		{
+		}
+
+		// Loads must have completed before the loader is destroyed.
+		~AssetLoader()
+		{
+			for (auto& context : contexts)
+			{
+				vkDestroyCommandPool(context->logicalDevice, context->commandPool, nullptr);
+			}
+		}
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+
+		// Queues a load of filename into model, which must not be used until the returned future is
+		// ready. Its images are decoded on the pool as well. Errors of the load are rethrown by future.get().
+		std::future<void> Load(vkglTF::Model& model, const std::string& filename, float scale = 1.0f)
+		{
+			return pool.Submit([this, &model, filename, scale]()
+			{
+				vks::VulkanDevice* context = AcquireContext();
+				model.workerPool = &pool;
+				model.stagingRing = &stagingRing;
+				try
+				{
+					model.loadFromFile(filename, &device, queue, scale, context);
+				}
+				catch (...)
+				{
+					ReleaseContext(context);
+					throw;
+				}
+				ReleaseContext(context);
+			});
+		}
+	};
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <array>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -10,12 +11,16 @@
 #include "UdacityFinalProject.hpp"
 #include "VulkanUtils.hpp"
 #include "VulkanglTFModel.hpp"
+#include "AnimationSystem.hpp"
+#include "AssetLoader.hpp"
 
 namespace BadgerSandbox
 {
 	struct Models
 	{
 		vkglTF::Model scene;
+		// Set by the render thread once the model has finished streaming in
+		bool drawable = false;
 	};
 
 	struct UniformBufferSet
@@ -61,7 +66,10 @@ namespace BadgerSandbox
 
 	/////////////////////////////
 	//Models g_models;
-	std::vector<Models> g_models;
+	// Fixed storage, a model can not be moved once its nodes point at its scene graph
+	std::array<Models, 3> g_models;
+	// Every model shares the pipeline, the skinned compact layout halves the vertex size on devices that can read it
+	vkglTF::VertexLayout g_vertexLayout = vkglTF::VertexLayout::Compact;
 	UBOMatrices g_shaderValuesScene;
 	shaderValuesParams g_shaderParams;
 	VkPipelineLayout g_pipelineLayout;
@@ -72,30 +80,36 @@ namespace BadgerSandbox
 	LightSource g_lightSource;
 
 	int32_t animationIndex = 0;
-	float animationTimer = 0.0f;
 	bool animate = true;
+	// Every loaded model is animated each frame, the selected one is also drawn
+	ThreadPool g_threadPool;
+	AnimationSystem g_animationSystem(g_threadPool);
 
 	void SetupNodeDescriptorSet(vkglTF::Node* node, const VkDescriptorPool& descriptorPool, const DescriptorSetLayouts& descriptorSetLayouts,
 		const VkDevice& device)
 	{
 		if (node->mesh)
 		{
-			VkDescriptorSetAllocateInfo descriptorSetAllocInfo{};
-			descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			descriptorSetAllocInfo.descriptorPool = descriptorPool;
-			descriptorSetAllocInfo.pSetLayouts = &descriptorSetLayouts.node;
-			descriptorSetAllocInfo.descriptorSetCount = 1;
-			RapidVulkan::CheckError(vkAllocateDescriptorSets(device, &descriptorSetAllocInfo, &node->mesh->uniformBuffer.descriptorSet));
-
-			VkWriteDescriptorSet writeDescriptorSet{};
-			writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			writeDescriptorSet.descriptorCount = 1;
-			writeDescriptorSet.dstSet = node->mesh->uniformBuffer.descriptorSet;
-			writeDescriptorSet.dstBinding = 0;
-			writeDescriptorSet.pBufferInfo = &node->mesh->uniformBuffer.descriptor;
-
-			vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+			// One set per frame in flight, each pointing at that frame's copy of the mesh uniform block
+			for (auto& frameBuffer : node->mesh->frameUniformBuffers)
+			{
+				VkDescriptorSetAllocateInfo descriptorSetAllocInfo{};
+				descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+				descriptorSetAllocInfo.descriptorPool = descriptorPool;
+				descriptorSetAllocInfo.pSetLayouts = &descriptorSetLayouts.node;
+				descriptorSetAllocInfo.descriptorSetCount = 1;
+				RapidVulkan::CheckError(vkAllocateDescriptorSets(device, &descriptorSetAllocInfo, &frameBuffer.descriptorSet));
+
+				VkWriteDescriptorSet writeDescriptorSet{};
+				writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+				writeDescriptorSet.descriptorCount = 1;
+				writeDescriptorSet.dstSet = frameBuffer.descriptorSet;
+				writeDescriptorSet.dstBinding = 0;
+				writeDescriptorSet.pBufferInfo = &frameBuffer.descriptor;
+
+				vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+			}
 		}
 		for (auto& child : node->children)
 		{
@@ -115,7 +129,7 @@ namespace BadgerSandbox
 					const std::vector<VkDescriptorSet> descriptorsets = 
 					{
 					  g_descriptorSets[cbIndex].scene,
-					  node.mesh->uniformBuffer.descriptorSet,
+					  node.mesh->frameUniformBuffers[cbIndex].descriptorSet,
 					};
 					vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0,
 						static_cast<uint32_t>(descriptorsets.size()), descriptorsets.data(), 0, NULL);
@@ -268,6 +282,12 @@ namespace BadgerSandbox
 
 		selectedPhysicalDevice = physicalDevices[suitablePhysicalDeviceIndex];
 
+		// The compact joint indices use a vertex format without mandatory support, fall back to the full layout
+		if (!vkglTF::Model::isVertexLayoutSupported(selectedPhysicalDevice, g_vertexLayout))
+		{
+			g_vertexLayout = vkglTF::VertexLayout::Full;
+		}
+
 		std::vector<float> queuePriorities = { 1.0f };
 
 		VkDeviceQueueCreateInfo queueCreateInfo = {
@@ -281,6 +301,10 @@ namespace BadgerSandbox
 
 		std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
+		// Block compressed textures are loaded when the device has them
+		VkPhysicalDeviceFeatures enabledFeatures = {};
+		enabledFeatures.textureCompressionBC = deviceFeatures[suitablePhysicalDeviceIndex].textureCompressionBC;
+
 		VkDeviceCreateInfo deviceCreateInfo = {
 		  VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,           // VkStructureType                    sType
 		  nullptr,                                        // const void                        *pNext
@@ -291,7 +315,7 @@ namespace BadgerSandbox
 		  nullptr,                                        // const char * const                *ppEnabledLayerNames
 		  deviceExtensions.size(),                        // uint32_t                           enabledExtensionCount
 		  deviceExtensions.data(),                        // const char * const                *ppEnabledExtensionNames
-		  nullptr                                         // const VkPhysicalDeviceFeatures    *pEnabledFeatures
+		  &enabledFeatures                                // const VkPhysicalDeviceFeatures    *pEnabledFeatures
 		};
 
 		device.Reset(selectedPhysicalDevice, deviceCreateInfo);
@@ -689,20 +713,12 @@ namespace BadgerSandbox
 		{
 		  {
 			0,                                                          // uint32_t                                       binding
-			sizeof(vkglTF::Model::Vertex),                              // uint32_t                                       stride
+			vkglTF::Model::getVertexStride(g_vertexLayout),             // uint32_t                                       stride
 			VK_VERTEX_INPUT_RATE_VERTEX                                 // VkVertexInputRate                              inputRate
 		  }
 		};
 
-		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions =
-		{
-		  {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
-		  {1, 0, VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3},
-		  {2, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 6},
-		  {3, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(float) * 8},
-		  {4, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 10},
-		  {5, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 14}
-		};
+		std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions = vkglTF::Model::getVertexInputAttributes(g_vertexLayout);
 
 		VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {
 		  VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,      // VkStructureType                                sType
@@ -886,6 +902,10 @@ namespace BadgerSandbox
 
 		graphicsCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
 
+		commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		sceneCommandBuffers.Reset(device.Get(), commandBufferAllocateInfo);
+		recordedSceneVersions.assign(renderResourcesCount, UINT64_MAX);
+
 		VkCommandBufferBeginInfo graphicsCommandBufferBeginInfo =
 		{
 		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,    // VkStructureType                        sType
@@ -905,41 +925,22 @@ namespace BadgerSandbox
 		VkClearValue clearValue = {
 		  { 1.0f, 0.8f, 0.4f, 0.0f },                     // VkClearColorValue              color
 		};
-
-		framebuffers.resize(renderResourcesCount);
 	}
 
-	void SandboxApplication::AllocateBufferMemory(VkBuffer& buffer, const VkMemoryPropertyFlags& memoryProperty, VkDeviceMemory& memory)
+	void SandboxApplication::AllocateBufferMemory(VkBuffer& buffer, const VkMemoryPropertyFlags& memoryProperty, MemoryAllocation& memory)
 	{
 		VkMemoryRequirements bufferMemoryRequirements;
 		vkGetBufferMemoryRequirements(device.Get(), buffer, &bufferMemoryRequirements);
 
-		VkPhysicalDeviceMemoryProperties memoryProperties;
-		vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memoryProperties);
-
-		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = memoryProperty;
+		if (memoryAllocator->Allocate(bufferMemoryRequirements, memoryRequest, memory) != VK_SUCCESS)
 		{
-			if ((bufferMemoryRequirements.memoryTypeBits & (1 << i)) &&
-				((memoryProperties.memoryTypes[i].propertyFlags & memoryProperty) == memoryProperty))
-			{
-
-				VkMemoryAllocateInfo memoryAllocateInfo =
-				{
-				  VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,       // VkStructureType                sType
-				  nullptr,                                      // const void                    *pNext
-				  bufferMemoryRequirements.size,              // VkDeviceSize                   allocationSize
-				  i                                             // uint32_t                       memoryTypeIndex
-				};
-
-				if (vkAllocateMemory(device.Get(), &memoryAllocateInfo, nullptr, &memory) != VK_SUCCESS)
-				{
-					throw std::runtime_error("Could not Allocate memory for the buffer");
-				}
-			}
+			throw std::runtime_error("Could not Allocate memory for the buffer");
 		}
 	}
 
-	void SandboxApplication::CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer& bufferToCreate, VkDeviceMemory& memory, const VkMemoryPropertyFlags& memoryProperty)
+	void SandboxApplication::CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer& bufferToCreate, MemoryAllocation& memory, const VkMemoryPropertyFlags& memoryProperty)
 	{
 		VkBufferCreateInfo bufferCreateInfo = {
 		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,             // VkStructureType                sType
@@ -959,36 +960,140 @@ namespace BadgerSandbox
 
 		AllocateBufferMemory(bufferToCreate, memoryProperty, memory);
 
-		if (vkBindBufferMemory(device.Get(), bufferToCreate, memory, 0) != VK_SUCCESS)
+		if (vkBindBufferMemory(device.Get(), bufferToCreate, memory.memory, memory.offset) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Could not bind memory to buffer");
 		}
 	}
 
-	void SandboxApplication::CreateJustInTimeFramebuffer(RapidVulkan::Framebuffer& framebuffer, const RapidVulkan::ImageView& imageView)
+	void SandboxApplication::CreateFramebuffers()
+	{
+		framebuffers.resize(swapchainImageViews.size());
+		for (size_t i = 0; i < swapchainImageViews.size(); ++i)
+		{
+			std::array<VkImageView, 2> attachments = 
+			{
+					swapchainImageViews[i].Get(),
+					depthImageView
+			};
+			VkFramebufferCreateInfo framebufferCreateInfo =
+			{
+			  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
+			  nullptr,                                        // const void                    *pNext
+			  0,                                              // VkFramebufferCreateFlags       flags
+			  renderPass.Get(),                               // VkRenderPass                   renderPass
+			  attachments.size(),                             // uint32_t                       attachmentCount
+			  attachments.data(),                             // const VkImageView             *pAttachments
+			  swapchainExtent.width,                          // uint32_t                       width
+			  swapchainExtent.height,                         // uint32_t                       height
+			  1                                               // uint32_t                       layers
+			};
+
+			framebuffers[i].Reset(device.Get(), framebufferCreateInfo);
+		}
+	}
+
+	void SandboxApplication::RecreateSwapchain()
 	{
-		std::array<VkImageView, 2> attachments = 
+		int width = 0;
+		int height = 0;
+		glfwGetWindowSize(window.get(), &width, &height);
+		if ((width == 0) || (height == 0))
+		{
+			// Minimized, there is nothing to present to until the window comes back
+			return;
+		}
+
 		{
-				imageView.Get(),
-				depthImageView
+			std::lock_guard<std::mutex> queueLock(queueMutex);
+			vkDeviceWaitIdle(device.Get());
+		}
+		framebuffers.clear();
+		DestroyDepthImage();
+		swapchainImageViews.clear();
+		swapchain.Reset();
+
+		CreateSwapchain();
+		CreateSwapchainImageViews();
+		CreateDepthImage();
+		CreateFramebuffers();
+		++sceneVersion;
+	}
+
+	void SandboxApplication::RecordSceneCommandBuffer(const size_t& resourceIndex)
+	{
+		VkCommandBufferInheritanceInfo inheritanceInfo =
+		{
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,  // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  renderPass.Get(),                                   // VkRenderPass                           renderPass
+		  0,                                                  // uint32_t                               subpass
+		  VK_NULL_HANDLE,                                     // VkFramebuffer                          framebuffer
+		  VK_FALSE,                                           // VkBool32                               occlusionQueryEnable
+		  0,                                                  // VkQueryControlFlags                    queryFlags
+		  0                                                   // VkQueryPipelineStatisticFlags          pipelineStatistics
 		};
-		VkFramebufferCreateInfo framebufferCreateInfo =
+		VkCommandBufferBeginInfo commandBufferBeginInfo =
 		{
-		  VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,      // VkStructureType                sType
-		  nullptr,                                        // const void                    *pNext
-		  0,                                              // VkFramebufferCreateFlags       flags
-		  renderPass.Get(),                               // VkRenderPass                   renderPass
-		  attachments.size(),                             // uint32_t                       attachmentCount
-		  attachments.data(),                             // const VkImageView             *pAttachments
-		  swapchainExtent.width,                          // uint32_t                       width
-		  swapchainExtent.height,                         // uint32_t                       height
-		  1                                               // uint32_t                       layers
+		  VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,        // VkStructureType                        sType
+		  nullptr,                                            // const void                            *pNext
+		  VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,   // VkCommandBufferUsageFlags              flags
+		  &inheritanceInfo                                    // const VkCommandBufferInheritanceInfo  *pInheritanceInfo
 		};
+		VkCommandBuffer commandBuffer = sceneCommandBuffers[resourceIndex];
+		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
 
-		framebuffer.Reset(device.Get(), framebufferCreateInfo);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.Get());
+
+		VkViewport viewport =
+		{
+		  0.0f,                                               // float                                  x
+		  0.0f,                                               // float                                  y
+		  static_cast<float>(swapchainExtent.width),          // float                                  width
+		  static_cast<float>(swapchainExtent.height),         // float                                  height
+		  0.0f,                                               // float                                  minDepth
+		  1.0f                                                // float                                  maxDepth
+		};
+
+		VkRect2D scissor = {
+		  {                                                   // VkOffset2D                             offset
+			0,                                                  // int32_t                                x
+			0                                                   // int32_t                                y
+		  },
+		  {                                                   // VkExtent2D                             extent
+			swapchainExtent.width,                              // uint32_t                               width
+			swapchainExtent.height                             // uint32_t                               height
+		  }
+		};
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		VkDeviceSize offset = 0;
+		//vkglTF::Model& model = g_models.scene;
+		vkglTF::Model& model = g_models[currentSelectedModel].scene;
+		if (g_models[currentSelectedModel].drawable)
+		{
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &model.vertices.buffer, &offset);
+			if (model.indices.buffer != VK_NULL_HANDLE)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, model.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			}
+
+			// Opaque primitives first
+			for (auto node : model.nodes)
+			{
+				RenderNode(*node, resourceIndex, vkglTF::Material::ALPHAMODE_OPAQUE, commandBuffer, pipelineLayout);
+			}
+		}
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			std::cout << "Could not record scene command buffer!" << std::endl;
+		}
 	}
 
-	void SandboxApplication::RecordJustInTimeCommandBuffers(const size_t& resourceIndex)
+	void SandboxApplication::RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex)
 	{
 		VkCommandBufferBeginInfo commandBufferBeginInfo =
 		{
@@ -1018,7 +1123,7 @@ namespace BadgerSandbox
 		  VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,           // VkStructureType                        sType
 		  nullptr,                                            // const void                            *pNext
 		  renderPass.Get(),                                   // VkRenderPass                           renderPass
-		  framebuffers[resourceIndex].Get(),                  // VkFramebuffer                          framebuffer
+		  framebuffers[imageIndex].Get(),                     // VkFramebuffer                          framebuffer
 		  {                                                   // VkRect2D                               renderArea
 			{                                                 // VkOffset2D                             offset
 			  0,                                              // int32_t                                x
@@ -1042,49 +1147,15 @@ namespace BadgerSandbox
 		memcpy(currentUB.scene.mapped, &g_shaderValuesScene, sizeof(g_shaderValuesScene));
 		memcpy(currentUB.params.mapped, &g_shaderParams, sizeof(shaderValuesParams));
 
-		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		vkCmdBindPipeline(commandBuffers[resourceIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.Get());
-
-		VkViewport viewport =
-		{
-		  0.0f,                                               // float                                  x
-		  0.0f,                                               // float                                  y
-		  static_cast<float>(swapchainExtent.width),          // float                                  width
-		  static_cast<float>(swapchainExtent.height),         // float                                  height
-		  0.0f,                                               // float                                  minDepth
-		  1.0f                                                // float                                  maxDepth
-		};
-
-		VkRect2D scissor = {
-		  {                                                   // VkOffset2D                             offset
-			0,                                                  // int32_t                                x
-			0                                                   // int32_t                                y
-		  },
-		  {                                                   // VkExtent2D                             extent
-			swapchainExtent.width,                              // uint32_t                               width
-			swapchainExtent.height                             // uint32_t                               height
-		  }
-		};
-
-		vkCmdSetViewport(commandBuffers[resourceIndex], 0, 1, &viewport);
-		vkCmdSetScissor(commandBuffers[resourceIndex], 0, 1, &scissor);
-
-		VkDeviceSize offset = 0;
-		//vkglTF::Model& model = g_models.scene;
-		vkglTF::Model& model = g_models[currentSelectedModel].scene;
-		vkCmdBindVertexBuffers(commandBuffers[resourceIndex], 0, 1, &model.vertices.buffer, &offset);
-		if (model.indices.buffer != VK_NULL_HANDLE)
+		if (recordedSceneVersions[resourceIndex] != sceneVersion)
 		{
-			vkCmdBindIndexBuffer(commandBuffers[resourceIndex], model.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
-		}
-
-		// Opaque primitives first
-		for (auto node : model.nodes)
-		{
-			RenderNode(*node, resourceIndex, vkglTF::Material::ALPHAMODE_OPAQUE, commandBuffers[resourceIndex], pipelineLayout);
+			RecordSceneCommandBuffer(resourceIndex);
+			recordedSceneVersions[resourceIndex] = sceneVersion;
 		}
 
+		vkCmdBeginRenderPass(commandBuffers[resourceIndex], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		VkCommandBuffer sceneCommandBuffer = sceneCommandBuffers[resourceIndex];
+		vkCmdExecuteCommands(commandBuffers[resourceIndex], 1, &sceneCommandBuffer);
 		vkCmdEndRenderPass(commandBuffers[resourceIndex]);
 
 		if (vkEndCommandBuffer(commandBuffers[resourceIndex]) != VK_SUCCESS)
@@ -1179,28 +1250,15 @@ namespace BadgerSandbox
 		RapidVulkan::CheckError(vkCreateDescriptorSetLayout(device.Get(), &descriptorSetLayoutCreateInfo, nullptr, &g_descriptorSetLayouts.node));
 	}
 
+	// Scene sets only, the node sets come from nodeDescriptorPool once the selected model has streamed in
 	void SandboxApplication::CreateDescriptorPool()
 	{
-		uint32_t meshCount = 0;
-		//std::vector<vkglTF::Model*> modellist = { &g_models.scene };
-		std::vector<vkglTF::Model*> modellist = { &g_models[currentSelectedModel].scene };
-		for (auto& model : modellist)
-		{
-			for (auto node : model->linearNodes)
-			{
-				if (node->mesh)
-				{
-					meshCount++;
-				}
-			}
-		}
-
-		std::vector<VkDescriptorPoolSize> poolSizes = { {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, (4 + meshCount) * (uint32_t)renderResourcesCount} };
+		std::vector<VkDescriptorPoolSize> poolSizes = { {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4 * (uint32_t)renderResourcesCount} };
 		VkDescriptorPoolCreateInfo descriptorPoolCI{};
 		descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		descriptorPoolCI.poolSizeCount = poolSizes.size();
 		descriptorPoolCI.pPoolSizes = poolSizes.data();
-		descriptorPoolCI.maxSets = (2 + meshCount) * renderResourcesCount;
+		descriptorPoolCI.maxSets = 2 * renderResourcesCount;
 		
 		RapidVulkan::CheckError(vkCreateDescriptorPool(device.Get(), &descriptorPoolCI, nullptr, &dPool));
 	}
@@ -1223,10 +1281,32 @@ namespace BadgerSandbox
 
 	void SandboxApplication::AllocateDescriptorSetNode()
 	{
+		uint32_t meshCount = 0;
+		for (auto node : g_models[currentSelectedModel].scene.linearNodes)
+		{
+			if (node->mesh)
+			{
+				meshCount++;
+			}
+		}
+		if (meshCount == 0)
+		{
+			return;
+		}
+
+		std::vector<VkDescriptorPoolSize> poolSizes = { {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, meshCount * (uint32_t)renderResourcesCount} };
+		VkDescriptorPoolCreateInfo descriptorPoolCI{};
+		descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolCI.poolSizeCount = poolSizes.size();
+		descriptorPoolCI.pPoolSizes = poolSizes.data();
+		descriptorPoolCI.maxSets = meshCount * renderResourcesCount;
+
+		RapidVulkan::CheckError(vkCreateDescriptorPool(device.Get(), &descriptorPoolCI, nullptr, &nodeDescriptorPool));
+
 		//for (auto& node : g_models.scene.nodes)
 		for (auto& node : g_models[currentSelectedModel].scene.nodes)
 		{
-			SetupNodeDescriptorSet(node, dPool, g_descriptorSetLayouts, device.Get());
+			SetupNodeDescriptorSet(node, nodeDescriptorPool, g_descriptorSetLayouts, device.Get());
 		}
 	}
 
@@ -1254,31 +1334,16 @@ namespace BadgerSandbox
 		}
 	}
 
-	/*
-      Took this function from VulkanTutorial:
-      https://vulkan-tutorial.com/
-    */
-	uint32_t SandboxApplication::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	void SandboxApplication::CreateMemoryAllocator()
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(selectedPhysicalDevice, &memProperties);
-
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-		{
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-			{
-				return i;
-			}
-		}
-
-		throw std::runtime_error("failed to find suitable memory type!");
+		memoryAllocator.reset(new DeviceMemoryAllocator(selectedPhysicalDevice, device.Get()));
 	}
 
 	/*
 	  Took this function from VulkanTutorial:
 	  https://vulkan-tutorial.com/
 	*/
-	void SandboxApplication::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	void SandboxApplication::CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1295,23 +1360,11 @@ namespace BadgerSandbox
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkCreateImage(device.Get(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+		MemoryRequest memoryRequest;
+		memoryRequest.properties = properties;
+		if (memoryAllocator->CreateImage(imageInfo, memoryRequest, image, imageMemory) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image!");
 		}
-
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device.Get(), image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device.Get(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate image memory!");
-		}
-
-		vkBindImageMemory(device.Get(), image, imageMemory, 0);
 	}
 
 	/*
@@ -1386,36 +1439,20 @@ namespace BadgerSandbox
 		depthImageView = CreateImageViewVulkanTutorial(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 	}
 
-	void SandboxApplication::LoadModel1()
-	{
-		// Rubric 3: The program reads data from a file
-		g_models[0].scene.destroy(device.Get());
-		g_models[0].scene.loadFromFile(std::string(UDACITY_FINAL_PROJECT_CONTENT) + "JillHipHop.gltf", &saschaDevice, queue);
-		std::cout << "Loaded Model 1" << std::endl;
-	}
-
-	void SandboxApplication::LoadModel2()
+	void SandboxApplication::DestroyDepthImage()
 	{
-		// Rubric 3: The program reads data from a file
-		g_models[1].scene.destroy(device.Get());
-		g_models[1].scene.loadFromFile(std::string(UDACITY_FINAL_PROJECT_CONTENT) + "JillDance.gltf", &saschaDevice, queue);
-		std::cout << "Loaded Model 2" << std::endl;
-	}
-
-	void SandboxApplication::LoadModel3()
-	{
-		// Rubric 3: The program reads data from a file
-		g_models[2].scene.destroy(device.Get());
-		g_models[2].scene.loadFromFile(std::string(UDACITY_FINAL_PROJECT_CONTENT) + "JillDance2.gltf", &saschaDevice, queue);
-		std::cout << "Loaded Model 3" << std::endl;
+		vkDestroyImageView(device.Get(), depthImageView, nullptr);
+		depthImageView = VK_NULL_HANDLE;
+		memoryAllocator->DestroyImage(depthImage, depthImageMemory);
 	}
 
 	void SandboxApplication::PopulateSaschaWillemsStructures()
 	{
 		saschaDevice.Reset(selectedPhysicalDevice, device.Get(), graphicsCommandPool.Get());
+		saschaDevice.queueMutex = &queueMutex;
+		saschaDevice.memoryAllocator = memoryAllocator.get();
 		g_uniformBuffers.resize(renderResourcesCount);
 		g_descriptorSets.resize(renderResourcesCount);
-		g_models.resize(3);
 		saschaCamera.type = Camera::CameraType::lookat;
 		saschaCamera.setPerspective(45.0f, 1920.0 / 1080.0, 0.1f, 256.0f);
 		saschaCamera.rotationSpeed = 0.25f;
@@ -1439,31 +1476,54 @@ namespace BadgerSandbox
 				-saschaCamera.position.z * sin(glm::radians(saschaCamera.rotation.x)),
 				saschaCamera.position.z * cos(glm::radians(saschaCamera.rotation.y)) * cos(glm::radians(saschaCamera.rotation.x)));
 
-		// Rubric 6: Concurrency, each model is loaded in a new thread
-		std::vector<std::thread> threads;
-		threads.emplace_back(std::thread(&SandboxApplication::LoadModel1, this));
-		threads.emplace_back(std::thread(&SandboxApplication::LoadModel2, this));
-		threads.emplace_back(std::thread(&SandboxApplication::LoadModel3, this));
-		
-		// Wait until all models have been loaded
-		for (auto& t : threads)
-			t.join();
-		
-		
+		// Rubric 6: Concurrency, the models are streamed in parallel on the loader pool while Draw keeps presenting.
+		// The loader has a pool of its own so the animation system's ParallelFor never queues behind a load.
+		// Rubric 3: The program reads data from a file
+		const char* modelFiles[] = { "JillHipHop.gltf", "JillDance.gltf", "JillDance2.gltf" };
+		assetLoader.reset(new AssetLoader(loaderPool, saschaDevice, queue, suitableQueueFamilyIndex));
+		for (size_t i = 0; i < g_models.size(); i++)
+		{
+			g_models[i].scene.destroy(device.Get());
+			g_models[i].scene.vertexLayout = g_vertexLayout;
+			modelLoads.push_back(assetLoader->Load(g_models[i].scene, std::string(UDACITY_FINAL_PROJECT_CONTENT) + modelFiles[i]));
+		}
 	}
 
-	void SandboxApplication::Draw()
+	// A load's future becomes ready once the worker has seen its upload fence signal. From then on the model
+	// is owned by the render thread, which gives it per-frame uniform buffers and starts animating it.
+	void SandboxApplication::UpdateStreamedModels()
 	{
-		if ((animate) && (g_models[currentSelectedModel].scene.animations.size() > 0))
+		for (size_t i = 0; i < modelLoads.size(); i++)
 		{
-			animationTimer += 0.0016;
-			if (animationTimer > g_models[currentSelectedModel].scene.animations[animationIndex].end)
+			if (!modelLoads[i].valid() || modelLoads[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
 			{
-				animationTimer -= g_models[currentSelectedModel].scene.animations[animationIndex].end;
+				continue;
+			}
+			try
+			{
+				modelLoads[i].get();
+			}
+			catch (std::exception& e)
+			{
+				std::cout << e.what() << std::endl;
+				continue;
 			}
-			g_models[currentSelectedModel].scene.updateAnimation(animationIndex, animationTimer);
+			std::cout << "Loaded Model " << i + 1 << std::endl;
+
+			vkglTF::Model& model = g_models[i].scene;
+			model.createFrameBuffers(static_cast<uint32_t>(renderResourcesCount));
+			g_animationSystem.Add(&model, animationIndex);
+			if (i == currentSelectedModel)
+			{
+				AllocateDescriptorSetNode();
+				++sceneVersion;
+			}
+			g_models[i].drawable = true;
 		}
-		
+	}
+
+	void SandboxApplication::Draw()
+	{
 		static size_t resourceIndex = 0;
 		uint32_t imageIndex;
 
@@ -1471,11 +1531,22 @@ namespace BadgerSandbox
 		{
 			std::cout << "Waiting for fence takes too long!" << std::endl;
 		}
+
+		VkResult result = vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// The fence stays signaled, nothing was submitted for this resource
+			RecreateSwapchain();
+			return;
+		}
 		vkResetFences(device.Get(), 1, &fences[resourceIndex]);
 
-		vkAcquireNextImageKHR(device.Get(), swapchain.Get(), UINT64_MAX, imageAvailable[resourceIndex].Get(), VK_NULL_HANDLE, &imageIndex);
-		CreateJustInTimeFramebuffer(framebuffers[resourceIndex], swapchainImageViews[imageIndex]);
-		RecordJustInTimeCommandBuffers(resourceIndex);
+		UpdateStreamedModels();
+
+		// The GPU is done with this frame's uniform buffers, animate every model into them
+		g_animationSystem.Update(animate ? 0.0016f : 0.0f, static_cast<uint32_t>(resourceIndex));
+
+		RecordJustInTimeCommandBuffers(resourceIndex, imageIndex);
 
 		std::vector<VkCommandBuffer> commandBuffers = graphicsCommandBuffers.Get();
 
@@ -1493,6 +1564,8 @@ namespace BadgerSandbox
 		  renderingFinished[resourceIndex].GetPointer()                  // const VkSemaphore           *pSignalSemaphores
 		};
 
+		// Other threads may submit uploads to the same queue
+		std::unique_lock<std::mutex> queueLock(queueMutex);
 		if (vkQueueSubmit(queue, 1, &submitInfo, fences[resourceIndex]) != VK_SUCCESS)
 		{
 			std::cout << "Error while submitting queue" << std::endl;
@@ -1510,9 +1583,15 @@ namespace BadgerSandbox
 		  nullptr                                                 // VkResult                    *pResults
 		};
 
-		vkQueuePresentKHR(queue, &presentInfo);
+		result = vkQueuePresentKHR(queue, &presentInfo);
+		queueLock.unlock();
 
 		resourceIndex = (resourceIndex + 1) % renderResourcesCount;
+
+		if ((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR))
+		{
+			RecreateSwapchain();
+		}
 	}
 
 	std::unique_ptr<GLFWwindow, DestroyGLFWwindow> SandboxApplication::CreateVulkanWindow()
@@ -1531,7 +1610,9 @@ namespace BadgerSandbox
 		: renderResourcesCount(3)
 		, suitablePhysicalDeviceIndex(0xFFFFFFFF)
 		, suitableQueueFamilyIndex(0xFFFFFFFF)
+		, nodeDescriptorPool(VK_NULL_HANDLE)
 		, currentSelectedModel(1)
+		, sceneVersion(0)
 	{
 		window = CreateVulkanWindow();
 		try
@@ -1539,19 +1620,20 @@ namespace BadgerSandbox
 			CreateInstance();
 			CreateSurface();
 			CreateLogicalDevice();
+			CreateMemoryAllocator();
 			CreateSemaphores();
 			CreateFences();
 			CreateSwapchain();
 			CreateRenderPass();
 			CreateSwapchainImageViews();
 			CreateDepthImage();
+			CreateFramebuffers();
 			CreateGraphicsCommandsBuffers();
 			PopulateSaschaWillemsStructures();
 			CreateDescriptorSetLayoutScene();
 			CreateDescriptorSetLayoutNode();
 			CreateDescriptorPool();
 			AllocateDescriptorSetScene();
-			AllocateDescriptorSetNode();
 			UpdateDescriptorSetScene();
 			CreateGraphicsPipeline();
 		}
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "Window.hpp"
+#include "ThreadPool.hpp"
 
 // Rubric 5: Memory Management:
 // Rapid Vulkan wraps Vulkan Objects and eases RAII implementation
@@ -24,12 +27,14 @@
 
 // Sascha Willems's helper files to load glTF models
 #include "VulkanDevice.hpp"
+#include "DeviceMemoryAllocator.hpp"
 #include "camera.hpp"
 
 
 namespace BadgerSandbox
 {
-    
+    class AssetLoader;
+
     struct DestroyGLFWwindow
     {
         // Rubric 5: Memory Management: I wrapped a GLFWwindow* pointer in a smart pointer to ensure it is destroyed when the class is destroyed.
@@ -57,6 +62,11 @@ namespace BadgerSandbox
         RapidVulkan::Device device;
         uint32_t suitableQueueFamilyIndex;
         VkQueue queue;
+        // Guards queue, which the frame loop and the asset loader's workers submit to
+        std::mutex queueMutex;
+        // Buffers and images, the models' included, are sub-allocated from here. Declared after the device so it
+        // releases its memory before the device is destroyed, and before the loader so it outlives the loads.
+        std::unique_ptr<DeviceMemoryAllocator> memoryAllocator;
 
         VkSurfaceKHR surface;
         VkSurfaceFormatKHR selectedSurfaceFormat;
@@ -65,6 +75,7 @@ namespace BadgerSandbox
 
         RapidVulkan::RenderPass renderPass;
         std::vector<RapidVulkan::ImageView> swapchainImageViews;
+        // One per swapchain image, only rebuilt when the swapchain is
         std::vector<RapidVulkan::Framebuffer> framebuffers;
 
         std::vector<RapidVulkan::Semaphore> imageAvailable;
@@ -77,19 +88,27 @@ namespace BadgerSandbox
 
         RapidVulkan::CommandPool graphicsCommandPool;
         RapidVulkan::CommandBuffers graphicsCommandBuffers;
+        // The model draws of each render resource, recorded once and executed from the primary command buffer every
+        // frame until sceneVersion moves on. Animation only changes uniform buffers, so it never has them recorded again.
+        RapidVulkan::CommandBuffers sceneCommandBuffers;
+        std::vector<uint64_t> recordedSceneVersions;
+        // Bumped whenever the selected model becomes drawable and whenever the swapchain is recreated
+        uint64_t sceneVersion;
 
         VkBuffer vertexBuffer;
-        VkDeviceMemory vertexBufferMemory;
+        MemoryAllocation vertexBufferMemory;
 
         const size_t renderResourcesCount;
         std::vector<VkFence> fences;
 
         VkImage depthImage;
-        VkDeviceMemory depthImageMemory;
+        MemoryAllocation depthImageMemory;
         VkImageView depthImageView;
 
         VkDescriptorSetLayout dsLayout;
         VkDescriptorPool dPool;
+        // Sized from the selected model's meshes once it has been streamed in
+        VkDescriptorPool nodeDescriptorPool;
         VkDescriptorSet ds;
         VkPipelineLayout pipelineLayout;
 
@@ -99,11 +118,18 @@ namespace BadgerSandbox
 
         uint32_t currentSelectedModel;
 
-        void AllocateBufferMemory(VkBuffer& buffer, const VkMemoryPropertyFlags& memoryProperty, VkDeviceMemory& memory);
+        // Models are streamed in while Draw keeps presenting. The pool is declared after the loader and the
+        // devices its workers use, so the workers are joined before any of them is destroyed.
+        std::unique_ptr<AssetLoader> assetLoader;
+        std::vector<std::future<void>> modelLoads;
+        ThreadPool loaderPool;
+
+        void AllocateBufferMemory(VkBuffer& buffer, const VkMemoryPropertyFlags& memoryProperty, MemoryAllocation& memory);
         void AllocateDescriptorSetNode();
         void AllocateDescriptorSetScene();
-        void CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer& bufferToCreate, VkDeviceMemory& memory, const VkMemoryPropertyFlags& memoryProperty);
+        void CreateBuffer(const VkDeviceSize& size, VkBufferUsageFlags usage, VkBuffer& bufferToCreate, MemoryAllocation& memory, const VkMemoryPropertyFlags& memoryProperty);
         void CreateDepthImage();
+        void DestroyDepthImage();
         void CreateDescriptorPool();
         void CreateDescriptorSetLayoutNode();
         void CreateDescriptorSetLayoutScene();
@@ -112,10 +138,11 @@ namespace BadgerSandbox
         void CreateGraphicsPipeline();
         void CreateImageView(const VkImage& image, VkImageView& imageView);
         VkImageView CreateImageViewVulkanTutorial(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+        void CreateImageVulkanTutorial(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory);
         void CreateInstance();
-        void CreateJustInTimeFramebuffer(RapidVulkan::Framebuffer& framebuffer, const RapidVulkan::ImageView& imageView);
+        void CreateFramebuffers();
         void CreateLogicalDevice();
+        void CreateMemoryAllocator();
         void CreateRenderPass();
         void CreateSemaphores();
         void CreateSurface();
@@ -123,14 +150,13 @@ namespace BadgerSandbox
         void CreateSwapchainImageViews();
         std::unique_ptr<GLFWwindow, DestroyGLFWwindow> CreateVulkanWindow();
         VkFormat FindDepthFormat();
-        uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-        void LoadModel1();
-        void LoadModel2();
-        void LoadModel3();
         void PopulateSaschaWillemsStructures();
-        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex);
+        void RecordJustInTimeCommandBuffers(const size_t& resourceIndex, uint32_t imageIndex);
+        void RecordSceneCommandBuffer(const size_t& resourceIndex);
+        void RecreateSwapchain();
         void UpdateDescriptorSetScene();
+        void UpdateStreamedModels();
 
 	public:
         SandboxApplication();
@@ -14,9 +14,11 @@
 #include <assert.h>
 #include <algorithm>
 #include <cstring>
+#include <mutex>
 #include <vector>
 #include "vulkan/vulkan.h"
 #include <RapidVulkan/Check.hpp>
+#include "DeviceMemoryAllocator.hpp"
 
 namespace vks
 {
@@ -30,6 +32,10 @@ namespace vks
     VkPhysicalDeviceMemoryProperties memoryProperties;
     std::vector<VkQueueFamilyProperties> queueFamilyProperties;
     VkCommandPool commandPool = VK_NULL_HANDLE;
+    // Held while submitting when several threads share a queue, owned by whoever owns the queue
+    std::mutex* queueMutex = nullptr;
+    // Buffers and images created through the device take their memory from here, owned by whoever owns the device
+    BadgerSandbox::DeviceMemoryAllocator* memoryAllocator = nullptr;
 
     struct
     {
@@ -268,54 +274,34 @@ namespace vks
      * @param memoryPropertyFlags Memory properties for this buffer (i.e. device local, host visible, coherent)
      * @param size Size of the buffer in byes
      * @param buffer Pointer to the buffer handle acquired by the function
-     * @param memory Pointer to the memory handle acquired by the function
+     * @param memory Pointer to the allocation of memoryAllocator the buffer is bound to
      * @param data Pointer to the data that should be copied to the buffer after creation (optional, if not set, no data is copied over)
      *
+     * @note Host visible allocations stay mapped, memory->mapped points at the start of the buffer
+     *
      * @return VK_SUCCESS if buffer handle and memory have been created and (optionally passed) data has been copied
      */
     VkResult createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer* buffer,
-                          VkDeviceMemory* memory, void* data = nullptr)
+                          BadgerSandbox::MemoryAllocation* memory, void* data = nullptr)
     {
-      // Create the buffer handle
+      // Create the buffer handle and bind it to memory of a memory type that fits the properties of the buffer
       VkBufferCreateInfo bufferCreateInfo{};
       bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
       bufferCreateInfo.usage = usageFlags;
       bufferCreateInfo.size = size;
       bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      RapidVulkan::CheckError(vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, buffer));
-
-      // Create the memory backing up the buffer handle
-      VkMemoryRequirements memReqs;
-      VkMemoryAllocateInfo memAlloc{};
-      memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-      vkGetBufferMemoryRequirements(logicalDevice, *buffer, &memReqs);
-      memAlloc.allocationSize = memReqs.size;
-      // Find a memory type index that fits the properties of the buffer
-      memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-      RapidVulkan::CheckError(vkAllocateMemory(logicalDevice, &memAlloc, nullptr, memory));
-
-      // If a pointer to the buffer data has been passed, map the buffer and copy over the data
+      BadgerSandbox::MemoryRequest memoryRequest;
+      memoryRequest.properties = memoryPropertyFlags;
+      RapidVulkan::CheckError(memoryAllocator->CreateBuffer(bufferCreateInfo, memoryRequest, *buffer, *memory));
+
+      // If a pointer to the buffer data has been passed, copy it over
       if (data != nullptr)
       {
-        void* mapped;
-        RapidVulkan::CheckError(vkMapMemory(logicalDevice, *memory, 0, size, 0, &mapped));
-        memcpy(mapped, data, size);
-        // If host coherency hasn't been requested, do a manual flush to make writes visible
-        if ((memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
-        {
-          VkMappedMemoryRange mappedRange{};
-          mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-          mappedRange.memory = *memory;
-          mappedRange.offset = 0;
-          mappedRange.size = size;
-          vkFlushMappedMemoryRanges(logicalDevice, 1, &mappedRange);
-        }
-        vkUnmapMemory(logicalDevice, *memory);
+        memcpy(memory->mapped, data, size);
+        // Does nothing if host coherency has been requested
+        memoryAllocator->Flush(*memory, 0, size);
       }
 
-      // Attach the memory to the buffer object
-      RapidVulkan::CheckError(vkBindBufferMemory(logicalDevice, *buffer, *memory, 0));
-
       return VK_SUCCESS;
     }
 
@@ -403,7 +389,14 @@ namespace vks
       RapidVulkan::CheckError(vkCreateFence(logicalDevice, &fenceInfo, nullptr, &fence));
 
       // Submit to the queue
-      RapidVulkan::CheckError(vkQueueSubmit(queue, 1, &submitInfo, fence));
+      {
+        std::unique_lock<std::mutex> lock;
+        if (queueMutex)
+        {
+          lock = std::unique_lock<std::mutex>(*queueMutex);
+        }
+        RapidVulkan::CheckError(vkQueueSubmit(queue, 1, &submitInfo, fence));
+      }
       // Wait for the fence to signal that command buffer has finished executing
       RapidVulkan::CheckError(vkWaitForFences(logicalDevice, 1, &fence, VK_TRUE, 100000000000));
 
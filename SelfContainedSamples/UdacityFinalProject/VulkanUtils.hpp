@@ -29,44 +29,33 @@ namespace vkbuffer
 		Vulkan buffer object
 	*/
 	struct Buffer {
-		VkDevice device;
+		BadgerSandbox::DeviceMemoryAllocator* memoryAllocator;
 		VkBuffer buffer = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
+		BadgerSandbox::MemoryAllocation memory;
 		VkDescriptorBufferInfo descriptor;
 		int32_t count = 0;
 		void* mapped = nullptr;
 		void create(vks::VulkanDevice* device, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, bool map = true) {
-			this->device = device->logicalDevice;
+			this->memoryAllocator = device->memoryAllocator;
 			device->createBuffer(usageFlags, memoryPropertyFlags, size, &buffer, &memory);
 			descriptor = { buffer, 0, size };
 			if (map) {
-				RapidVulkan::CheckError(vkMapMemory(device->logicalDevice, memory, 0, size, 0, &mapped));
+				this->map();
 			}
 		}
 		void destroy() {
-			if (mapped) {
-				unmap();
-			}
-			vkDestroyBuffer(device, buffer, nullptr);
-			vkFreeMemory(device, memory, nullptr);
-			buffer = VK_NULL_HANDLE;
-			memory = VK_NULL_HANDLE;
+			unmap();
+			memoryAllocator->DestroyBuffer(buffer, memory);
 		}
+		// Host visible memory is mapped for as long as it is allocated
 		void map() {
-			RapidVulkan::CheckError(vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+			mapped = memory.mapped;
 		}
 		void unmap() {
-			if (mapped) {
-				vkUnmapMemory(device, memory);
-				mapped = nullptr;
-			}
+			mapped = nullptr;
 		}
 		void flush(VkDeviceSize size = VK_WHOLE_SIZE) {
-			VkMappedMemoryRange mappedRange{};
-			mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-			mappedRange.memory = memory;
-			mappedRange.size = size;
-			RapidVulkan::CheckError(vkFlushMappedMemoryRanges(device, 1, &mappedRange));
+			memoryAllocator->Flush(memory, 0, size);
 		}
 	};
 }
\ No newline at end of file
@@ -9,17 +9,24 @@
 #pragma once
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <string>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 
 #include "vulkan/vulkan.h"
 #include "VulkanDevice.hpp"
+#include "DdsFile.hpp"
+#include "StagingRing.hpp"
+#include "TextureProcessing.hpp"
+#include "ThreadPool.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
@@ -30,7 +37,9 @@
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_MSC_SECURE_CRT
 #include "tiny_gltf.h"
+#include "stb_image.h"
 #include <RapidVulkan/Check.hpp>
+#include "AffineTransform.hpp"
 
 // Changing this value here also requires changing it in the vertex shader
 constexpr uint32_t MAX_NUM_JOINTS = 512u;
@@ -39,6 +48,24 @@ namespace vkglTF
 {
   struct Node;
 
+  // glTF node, joint and inverse bind matrices are affine, so skinning composes them as 3x4 transforms
+  inline BadgerSandbox::AffineTransform toAffineTransform(const glm::mat4& m)
+  {
+    return BadgerSandbox::AffineTransform(BadgerSandbox::Matrix3D(BadgerSandbox::Vector3D(m[0][0], m[0][1], m[0][2]),
+                                                                  BadgerSandbox::Vector3D(m[1][0], m[1][1], m[1][2]),
+                                                                  BadgerSandbox::Vector3D(m[2][0], m[2][1], m[2][2])),
+                                          BadgerSandbox::Vector3D(m[3][0], m[3][1], m[3][2]));
+  }
+
+  inline glm::mat4 toMat4(const BadgerSandbox::AffineTransform& a)
+  {
+    const BadgerSandbox::Matrix3D& l = a.linear;
+    return glm::mat4(glm::vec4(l(0, 0), l(1, 0), l(2, 0), 0.0f),
+                     glm::vec4(l(0, 1), l(1, 1), l(2, 1), 0.0f),
+                     glm::vec4(l(0, 2), l(1, 2), l(2, 2), 0.0f),
+                     glm::vec4(a.translation.x, a.translation.y, a.translation.z, 1.0f));
+  }
+
   struct BoundingBox
   {
     glm::vec3 min;
@@ -90,6 +117,45 @@ namespace vkglTF
     VkSamplerAddressMode addressModeW;
   };
 
+  /*
+    Vulkan format of a block compressed texture
+  */
+  inline VkFormat getVkFormat(BadgerSandbox::BlockFormat format)
+  {
+    switch (format)
+    {
+    case BadgerSandbox::BlockFormat::BC1:
+      return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case BadgerSandbox::BlockFormat::BC3:
+      return VK_FORMAT_BC3_UNORM_BLOCK;
+    case BadgerSandbox::BlockFormat::BC5:
+      return VK_FORMAT_BC5_UNORM_BLOCK;
+    case BadgerSandbox::BlockFormat::BC7:
+    default:
+      return VK_FORMAT_BC7_UNORM_BLOCK;
+    }
+  }
+
+  /*
+    Bytes of one level of a texture in RGBA8 or one of the block compressed formats above
+  */
+  inline VkDeviceSize getLevelSize(VkFormat format, uint32_t width, uint32_t height)
+  {
+    switch (format)
+    {
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+      return BadgerSandbox::CompressedLevelSize(BadgerSandbox::BlockFormat::BC1, width, height);
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+      return BadgerSandbox::CompressedLevelSize(BadgerSandbox::BlockFormat::BC3, width, height);
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+      return BadgerSandbox::CompressedLevelSize(BadgerSandbox::BlockFormat::BC5, width, height);
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+      return BadgerSandbox::CompressedLevelSize(BadgerSandbox::BlockFormat::BC7, width, height);
+    default:
+      return VkDeviceSize(width) * height * 4;
+    }
+  }
+
   /*
     glTF texture loading class
   */
@@ -98,11 +164,12 @@ namespace vkglTF
     vks::VulkanDevice* device;
     VkImage image;
     VkImageLayout imageLayout;
-    VkDeviceMemory deviceMemory;
+    BadgerSandbox::MemoryAllocation deviceMemory;
     VkImageView view;
     uint32_t width, height;
     uint32_t mipLevels;
     uint32_t layerCount;
+    VkFormat format;
     VkDescriptorImageInfo descriptor;
     VkSampler sampler;
 
@@ -116,83 +183,21 @@ namespace vkglTF
     void destroy()
     {
       vkDestroyImageView(device->logicalDevice, view, nullptr);
-      vkDestroyImage(device->logicalDevice, image, nullptr);
-      vkFreeMemory(device->logicalDevice, deviceMemory, nullptr);
+      device->memoryAllocator->DestroyImage(image, deviceMemory);
       vkDestroySampler(device->logicalDevice, sampler, nullptr);
     }
 
     /*
-      Load a texture from a glTF image (stored as vector of chars loaded via stb_image)
-      Also generates the mip chain as glTF images are stored as jpg or png without any mips
+      Create an image of mipLevels levels with its view and sampler, the contents are written by recordUpload
     */
-    void fromglTfImage(tinygltf::Image& gltfimage, TextureSampler textureSampler, vks::VulkanDevice* device, VkQueue copyQueue)
+    void create(vks::VulkanDevice* device, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels, TextureSampler textureSampler)
     {
       this->device = device;
-
-      unsigned char* buffer = nullptr;
-      VkDeviceSize bufferSize = 0;
-      bool deleteBuffer = false;
-      if (gltfimage.component == 3)
-      {
-        // Most devices don't support RGB only on Vulkan so convert if necessary
-        // TODO: Check actual format support and transform only if required
-        bufferSize = gltfimage.width * gltfimage.height * 4;
-        buffer = new unsigned char[bufferSize];
-        unsigned char* rgba = buffer;
-        unsigned char* rgb = &gltfimage.image[0];
-        for (int32_t i = 0; i < gltfimage.width * gltfimage.height; ++i)
-        {
-          for (int32_t j = 0; j < 3; ++j)
-          {
-            rgba[j] = rgb[j];
-          }
-          rgba += 4;
-          rgb += 3;
-        }
-        deleteBuffer = true;
-      }
-      else
-      {
-        buffer = &gltfimage.image[0];
-        bufferSize = gltfimage.image.size();
-      }
-
-      VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
-
-      VkFormatProperties formatProperties;
-
-      width = gltfimage.width;
-      height = gltfimage.height;
-      mipLevels = static_cast<uint32_t>(floor(log2(std::max(width, height))) + 1.0);
-
-      vkGetPhysicalDeviceFormatProperties(device->physicalDevice, format, &formatProperties);
-      assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT);
-      assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT);
-
-      VkMemoryAllocateInfo memAllocInfo{};
-      memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-      VkMemoryRequirements memReqs{};
-
-      VkBuffer stagingBuffer;
-      VkDeviceMemory stagingMemory;
-
-      VkBufferCreateInfo bufferCreateInfo{};
-      bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-      bufferCreateInfo.size = bufferSize;
-      bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-      bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      RapidVulkan::CheckError(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-      vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-      memAllocInfo.allocationSize = memReqs.size;
-      memAllocInfo.memoryTypeIndex =
-        device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-      RapidVulkan::CheckError(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-      RapidVulkan::CheckError(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-      uint8_t* data;
-      RapidVulkan::CheckError(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void**)&data));
-      memcpy(data, buffer, bufferSize);
-      vkUnmapMemory(device->logicalDevice, stagingMemory);
+      this->format = format;
+      this->width = width;
+      this->height = height;
+      this->mipLevels = mipLevels;
+      layerCount = 1;
 
       VkImageCreateInfo imageCreateInfo{};
       imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -202,23 +207,55 @@ namespace vkglTF
       imageCreateInfo.arrayLayers = 1;
       imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
       imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-      imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
       imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
       imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
       imageCreateInfo.extent = {width, height, 1};
       imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-      RapidVulkan::CheckError(vkCreateImage(device->logicalDevice, &imageCreateInfo, nullptr, &image));
-      vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
-      memAllocInfo.allocationSize = memReqs.size;
-      memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-      RapidVulkan::CheckError(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
-      RapidVulkan::CheckError(vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
+      BadgerSandbox::MemoryRequest memoryRequest;
+      memoryRequest.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+      RapidVulkan::CheckError(device->memoryAllocator->CreateImage(imageCreateInfo, memoryRequest, image, deviceMemory));
 
-      VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+      VkSamplerCreateInfo samplerInfo{};
+      samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+      samplerInfo.magFilter = textureSampler.magFilter;
+      samplerInfo.minFilter = textureSampler.minFilter;
+      samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+      samplerInfo.addressModeU = textureSampler.addressModeU;
+      samplerInfo.addressModeV = textureSampler.addressModeV;
+      samplerInfo.addressModeW = textureSampler.addressModeW;
+      samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+      samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+      samplerInfo.maxLod = (float)mipLevels;
+      samplerInfo.maxAnisotropy = 8.0f;
+      samplerInfo.anisotropyEnable = VK_TRUE;
+      RapidVulkan::CheckError(vkCreateSampler(device->logicalDevice, &samplerInfo, nullptr, &sampler));
 
+      VkImageViewCreateInfo viewInfo{};
+      viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      viewInfo.image = image;
+      viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+      viewInfo.format = format;
+      viewInfo.components = {VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A};
+      viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      viewInfo.subresourceRange.layerCount = 1;
+      viewInfo.subresourceRange.levelCount = mipLevels;
+      RapidVulkan::CheckError(vkCreateImageView(device->logicalDevice, &viewInfo, nullptr, &view));
+
+      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      updateDescriptor();
+    }
+
+    /*
+      Record the upload of the image from staging at offset into copyCmd, leaving it ready for sampling.
+      With mipsInStaging every level is stored there one after the other, otherwise only the first one is and
+      the mip chain is blitted from it (glTF uses jpg and png, so it has to be created). Block compressed
+      images can't be blitted to and always have their levels staged
+    */
+    void recordUpload(VkCommandBuffer copyCmd, VkBuffer staging, VkDeviceSize offset, bool mipsInStaging)
+    {
       VkImageSubresourceRange subresourceRange = {};
       subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      subresourceRange.levelCount = 1;
+      subresourceRange.levelCount = mipLevels;
       subresourceRange.layerCount = 1;
 
       {
@@ -230,147 +267,96 @@ namespace vkglTF
         imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         imageMemoryBarrier.image = image;
         imageMemoryBarrier.subresourceRange = subresourceRange;
-        vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+        vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
                              &imageMemoryBarrier);
       }
 
-      VkBufferImageCopy bufferCopyRegion = {};
-      bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      bufferCopyRegion.imageSubresource.mipLevel = 0;
-      bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-      bufferCopyRegion.imageSubresource.layerCount = 1;
-      bufferCopyRegion.imageExtent.width = width;
-      bufferCopyRegion.imageExtent.height = height;
-      bufferCopyRegion.imageExtent.depth = 1;
-
-      vkCmdCopyBufferToImage(copyCmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
-
+      std::vector<VkBufferImageCopy> bufferCopyRegions(mipsInStaging ? mipLevels : 1);
+      for (uint32_t i = 0; i < bufferCopyRegions.size(); i++)
       {
-        VkImageMemoryBarrier imageMemoryBarrier{};
-        imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        imageMemoryBarrier.image = image;
-        imageMemoryBarrier.subresourceRange = subresourceRange;
-        vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                             &imageMemoryBarrier);
+        VkBufferImageCopy& bufferCopyRegion = bufferCopyRegions[i];
+        bufferCopyRegion = {};
+        bufferCopyRegion.bufferOffset = offset;
+        bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        bufferCopyRegion.imageSubresource.mipLevel = i;
+        bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+        bufferCopyRegion.imageSubresource.layerCount = 1;
+        bufferCopyRegion.imageExtent.width = BadgerSandbox::MipExtent(width, i);
+        bufferCopyRegion.imageExtent.height = BadgerSandbox::MipExtent(height, i);
+        bufferCopyRegion.imageExtent.depth = 1;
+        offset += getLevelSize(format, bufferCopyRegion.imageExtent.width, bufferCopyRegion.imageExtent.height);
       }
+      vkCmdCopyBufferToImage(copyCmd, staging, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(bufferCopyRegions.size()),
+                             bufferCopyRegions.data());
 
-      device->flushCommandBuffer(copyCmd, copyQueue, true);
-
-      vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-      vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
-
-      // Generate the mip chain (glTF uses jpg and png, so we need to create this manually)
-      VkCommandBuffer blitCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-      for (uint32_t i = 1; i < mipLevels; i++)
+      VkImageLayout uploadedLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      if (!mipsInStaging)
       {
-        VkImageBlit imageBlit{};
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(device->physicalDevice, VK_FORMAT_R8G8B8A8_UNORM, &formatProperties);
+        assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT);
+        assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT);
 
-        imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBlit.srcSubresource.layerCount = 1;
-        imageBlit.srcSubresource.mipLevel = i - 1;
-        imageBlit.srcOffsets[1].x = int32_t(width >> (i - 1));
-        imageBlit.srcOffsets[1].y = int32_t(height >> (i - 1));
-        imageBlit.srcOffsets[1].z = 1;
+        // Each level turns into a blit source once it has been written, the last one for the final transition
+        for (uint32_t i = 1; i <= mipLevels; i++)
+        {
+          VkImageSubresourceRange mipSubRange = {};
+          mipSubRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          mipSubRange.baseMipLevel = i - 1;
+          mipSubRange.levelCount = 1;
+          mipSubRange.layerCount = 1;
 
-        imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBlit.dstSubresource.layerCount = 1;
-        imageBlit.dstSubresource.mipLevel = i;
-        imageBlit.dstOffsets[1].x = int32_t(width >> i);
-        imageBlit.dstOffsets[1].y = int32_t(height >> i);
-        imageBlit.dstOffsets[1].z = 1;
+          {
+            VkImageMemoryBarrier imageMemoryBarrier{};
+            imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            imageMemoryBarrier.image = image;
+            imageMemoryBarrier.subresourceRange = mipSubRange;
+            vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                                 &imageMemoryBarrier);
+          }
+          if (i == mipLevels)
+          {
+            break;
+          }
 
-        VkImageSubresourceRange mipSubRange = {};
-        mipSubRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        mipSubRange.baseMipLevel = i;
-        mipSubRange.levelCount = 1;
-        mipSubRange.layerCount = 1;
+          VkImageBlit imageBlit{};
 
-        {
-          VkImageMemoryBarrier imageMemoryBarrier{};
-          imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-          imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-          imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-          imageMemoryBarrier.srcAccessMask = 0;
-          imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-          imageMemoryBarrier.image = image;
-          imageMemoryBarrier.subresourceRange = mipSubRange;
-          vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                               &imageMemoryBarrier);
-        }
+          imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          imageBlit.srcSubresource.layerCount = 1;
+          imageBlit.srcSubresource.mipLevel = i - 1;
+          imageBlit.srcOffsets[1].x = int32_t(BadgerSandbox::MipExtent(width, i - 1));
+          imageBlit.srcOffsets[1].y = int32_t(BadgerSandbox::MipExtent(height, i - 1));
+          imageBlit.srcOffsets[1].z = 1;
 
-        vkCmdBlitImage(blitCmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit,
-                       VK_FILTER_LINEAR);
+          imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          imageBlit.dstSubresource.layerCount = 1;
+          imageBlit.dstSubresource.mipLevel = i;
+          imageBlit.dstOffsets[1].x = int32_t(BadgerSandbox::MipExtent(width, i));
+          imageBlit.dstOffsets[1].y = int32_t(BadgerSandbox::MipExtent(height, i));
+          imageBlit.dstOffsets[1].z = 1;
 
-        {
-          VkImageMemoryBarrier imageMemoryBarrier{};
-          imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-          imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-          imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-          imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-          imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-          imageMemoryBarrier.image = image;
-          imageMemoryBarrier.subresourceRange = mipSubRange;
-          vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                               &imageMemoryBarrier);
+          vkCmdBlitImage(copyCmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit,
+                         VK_FILTER_LINEAR);
         }
+        uploadedLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
       }
 
-      subresourceRange.levelCount = mipLevels;
-      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
       {
         VkImageMemoryBarrier imageMemoryBarrier{};
         imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageMemoryBarrier.oldLayout = uploadedLayout;
         imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
         imageMemoryBarrier.image = image;
         imageMemoryBarrier.subresourceRange = subresourceRange;
-        vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+        vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
                              &imageMemoryBarrier);
       }
-
-      device->flushCommandBuffer(blitCmd, copyQueue, true);
-
-      VkSamplerCreateInfo samplerInfo{};
-      samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-      samplerInfo.magFilter = textureSampler.magFilter;
-      samplerInfo.minFilter = textureSampler.minFilter;
-      samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-      samplerInfo.addressModeU = textureSampler.addressModeU;
-      samplerInfo.addressModeV = textureSampler.addressModeV;
-      samplerInfo.addressModeW = textureSampler.addressModeW;
-      samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
-      samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-      samplerInfo.maxAnisotropy = 1.0;
-      samplerInfo.anisotropyEnable = VK_FALSE;
-      samplerInfo.maxLod = (float)mipLevels;
-      samplerInfo.maxAnisotropy = 8.0f;
-      samplerInfo.anisotropyEnable = VK_TRUE;
-      RapidVulkan::CheckError(vkCreateSampler(device->logicalDevice, &samplerInfo, nullptr, &sampler));
-
-      VkImageViewCreateInfo viewInfo{};
-      viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-      viewInfo.image = image;
-      viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-      viewInfo.format = format;
-      viewInfo.components = {VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A};
-      viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      viewInfo.subresourceRange.layerCount = 1;
-      viewInfo.subresourceRange.levelCount = mipLevels;
-      RapidVulkan::CheckError(vkCreateImageView(device->logicalDevice, &viewInfo, nullptr, &view));
-
-      descriptor.sampler = sampler;
-      descriptor.imageView = view;
-      descriptor.imageLayout = imageLayout;
-
-      if (deleteBuffer)
-        delete[] buffer;
     }
   };
 
@@ -465,7 +451,7 @@ namespace vkglTF
     struct UniformBuffer
     {
       VkBuffer buffer;
-      VkDeviceMemory memory;
+      BadgerSandbox::MemoryAllocation memory;
       VkDescriptorBufferInfo descriptor;
       VkDescriptorSet descriptorSet;
       void* mapped;
@@ -478,6 +464,14 @@ namespace vkglTF
       float jointcount{0};
     } uniformBlock;
 
+    // Affine inverse of uniformBlock.matrix, only recomputed when the owning node moves
+    BadgerSandbox::AffineTransform inverseTransform;
+
+    // Optional per-frame copies of the uniform block. When present, changes are published into the
+    // copy of the frame being recorded, so the buffers of frames still in flight are never overwritten.
+    std::vector<UniformBuffer> frameUniformBuffers;
+    uint32_t staleFrames = 0;
+
     Mesh(vks::VulkanDevice* device, glm::mat4 matrix)
     {
       this->device = device;
@@ -485,14 +479,17 @@ namespace vkglTF
       RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(uniformBlock),
                                                    &uniformBuffer.buffer, &uniformBuffer.memory, &uniformBlock));
-      RapidVulkan::CheckError(vkMapMemory(device->logicalDevice, uniformBuffer.memory, 0, sizeof(uniformBlock), 0, &uniformBuffer.mapped));
+      uniformBuffer.mapped = uniformBuffer.memory.mapped;
       uniformBuffer.descriptor = {uniformBuffer.buffer, 0, sizeof(uniformBlock)};
     };
 
     ~Mesh()
     {
-      vkDestroyBuffer(device->logicalDevice, uniformBuffer.buffer, nullptr);
-      vkFreeMemory(device->logicalDevice, uniformBuffer.memory, nullptr);
+      device->memoryAllocator->DestroyBuffer(uniformBuffer.buffer, uniformBuffer.memory);
+      for (UniformBuffer& frameBuffer : frameUniformBuffers)
+      {
+        device->memoryAllocator->DestroyBuffer(frameBuffer.buffer, frameBuffer.memory);
+      }
       for (Primitive* p : primitives)
         delete p;
     }
@@ -503,6 +500,44 @@ namespace vkglTF
       bb.max = max;
       bb.valid = true;
     }
+
+    void createFrameBuffers(uint32_t frameCount)
+    {
+      frameUniformBuffers.resize(frameCount);
+      for (UniformBuffer& frameBuffer : frameUniformBuffers)
+      {
+        RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(uniformBlock),
+                                                     &frameBuffer.buffer, &frameBuffer.memory, &uniformBlock));
+        frameBuffer.mapped = frameBuffer.memory.mapped;
+        frameBuffer.descriptor = {frameBuffer.buffer, 0, sizeof(uniformBlock)};
+      }
+      staleFrames = 0;
+    }
+
+    // Called after uniformBlock changed, size is the number of leading bytes that changed
+    void upload(size_t size)
+    {
+      if (frameUniformBuffers.empty())
+      {
+        memcpy(uniformBuffer.mapped, &uniformBlock, size);
+      }
+      else
+      {
+        staleFrames = static_cast<uint32_t>(frameUniformBuffers.size());
+      }
+    }
+
+    // Copies the uniform block into the buffer of frame. Frames must be published once each, in
+    // round-robin order, so a change reaches every frame buffer exactly once.
+    void publish(uint32_t frame)
+    {
+      if (staleFrames > 0 && frame < frameUniformBuffers.size())
+      {
+        memcpy(frameUniformBuffers[frame].mapped, &uniformBlock, sizeof(uniformBlock));
+        staleFrames--;
+      }
+    }
   };
 
   /*
@@ -513,7 +548,36 @@ namespace vkglTF
     std::string name;
     Node* skeletonRoot = nullptr;
     std::vector<glm::mat4> inverseBindMatrices;
+    // inverseBindMatrices as affine transforms, filled once the skin's joints are resolved
+    std::vector<BadgerSandbox::AffineTransform> inverseBindTransforms;
     std::vector<Node*> joints;
+    // Scene graph slot of each joint, used to read cached world matrices
+    std::vector<uint32_t> jointIndices;
+  };
+
+  /*
+    Flattened scene hierarchy
+    Nodes are stored depth first, so every parent precedes its children and world matrices can be
+    propagated in a single linear pass. Only nodes whose local transform was marked dirty, and the
+    subtrees below them, are recomputed.
+  */
+  struct SceneGraph
+  {
+    std::vector<Node*> nodes;
+    std::vector<int32_t> parents;
+    std::vector<glm::mat4> localMatrices;
+    std::vector<glm::mat4> worldMatrices;
+    // Local transform changed since the last update
+    std::vector<uint8_t> dirty;
+    // World matrix was recomputed by the last update
+    std::vector<uint8_t> changed;
+    size_t firstDirty = 0;
+
+    void build(const std::vector<Node*>& roots);
+    void markDirty(const Node* node);
+    void markAllDirty();
+    void update();
+    void clear();
   };
 
   /*
@@ -534,51 +598,31 @@ namespace vkglTF
     glm::quat rotation{};
     BoundingBox bvh;
     BoundingBox aabb;
+    SceneGraph* graph = nullptr;
+    uint32_t graphIndex = 0;
 
     glm::mat4 localMatrix()
     {
       return glm::translate(glm::mat4(1.0f), translation) * glm::mat4(rotation) * glm::scale(glm::mat4(1.0f), scale) * matrix;
     }
 
-    glm::mat4 getMatrix()
+    glm::mat4 getMatrix();
+
+    // Uploads the world matrix of an unskinned mesh. Skinned meshes are updated by Model::updateSkin, from the
+    // cached joint world matrices and the mesh's cached inverse transform.
+    void updateMesh()
     {
-      glm::mat4 m = localMatrix();
-      vkglTF::Node* p = parent;
-      while (p)
+      if (mesh && !skin)
       {
-        m = p->localMatrix() * m;
-        p = p->parent;
+        glm::mat4 m = getMatrix();
+        mesh->uniformBlock.matrix = m;
+        mesh->upload(sizeof(glm::mat4));
       }
-      return m;
     }
 
     void update()
     {
-      if (mesh)
-      {
-        glm::mat4 m = getMatrix();
-        if (skin)
-        {
-          mesh->uniformBlock.matrix = m;
-          // Update join matrices
-          glm::mat4 inverseTransform = glm::inverse(m);
-          size_t numJoints = std::min((uint32_t)skin->joints.size(), MAX_NUM_JOINTS);
-          for (size_t i = 0; i < numJoints; i++)
-          {
-            vkglTF::Node* jointNode = skin->joints[i];
-            glm::mat4 jointMat = jointNode->getMatrix() * skin->inverseBindMatrices[i];
-            jointMat = inverseTransform * jointMat;
-            mesh->uniformBlock.jointMatrix[i] = jointMat;
-          }
-          mesh->uniformBlock.jointcount = (float)numJoints;
-          memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
-        }
-        else
-        {
-          memcpy(mesh->uniformBuffer.mapped, &m, sizeof(glm::mat4));
-        }
-      }
-
+      updateMesh();
       for (auto& child : children)
       {
         child->update();
@@ -598,6 +642,97 @@ namespace vkglTF
     }
   };
 
+  inline void SceneGraph::build(const std::vector<Node*>& roots)
+  {
+    clear();
+    std::vector<Node*> stack(roots.rbegin(), roots.rend());
+    while (!stack.empty())
+    {
+      Node* node = stack.back();
+      stack.pop_back();
+      node->graph = this;
+      node->graphIndex = static_cast<uint32_t>(nodes.size());
+      nodes.push_back(node);
+      parents.push_back(node->parent ? static_cast<int32_t>(node->parent->graphIndex) : -1);
+      for (auto child = node->children.rbegin(); child != node->children.rend(); ++child)
+      {
+        stack.push_back(*child);
+      }
+    }
+    localMatrices.resize(nodes.size());
+    worldMatrices.resize(nodes.size());
+    dirty.resize(nodes.size());
+    changed.resize(nodes.size());
+    markAllDirty();
+  }
+
+  inline void SceneGraph::markDirty(const Node* node)
+  {
+    dirty[node->graphIndex] = 1;
+    firstDirty = std::min(firstDirty, static_cast<size_t>(node->graphIndex));
+  }
+
+  inline void SceneGraph::markAllDirty()
+  {
+    std::fill(dirty.begin(), dirty.end(), uint8_t(1));
+    firstDirty = 0;
+  }
+
+  inline void SceneGraph::update()
+  {
+    // Nothing before the first dirty node can change, parents always precede their children
+    const size_t count = nodes.size();
+    const size_t first = std::min(firstDirty, count);
+    std::fill(changed.begin(), changed.begin() + first, uint8_t(0));
+    for (size_t i = first; i < count; i++)
+    {
+      const int32_t parent = parents[i];
+      const bool parentChanged = parent >= 0 && changed[parent];
+      if (dirty[i])
+      {
+        localMatrices[i] = nodes[i]->localMatrix();
+      }
+      changed[i] = dirty[i] || parentChanged;
+      if (changed[i])
+      {
+        worldMatrices[i] = parent >= 0 ? worldMatrices[parent] * localMatrices[i] : localMatrices[i];
+      }
+      dirty[i] = 0;
+    }
+    firstDirty = count;
+  }
+
+  inline void SceneGraph::clear()
+  {
+    for (Node* node : nodes)
+    {
+      node->graph = nullptr;
+    }
+    nodes.clear();
+    parents.clear();
+    localMatrices.clear();
+    worldMatrices.clear();
+    dirty.clear();
+    changed.clear();
+    firstDirty = 0;
+  }
+
+  inline glm::mat4 Node::getMatrix()
+  {
+    if (graph)
+    {
+      return graph->worldMatrices[graphIndex];
+    }
+    glm::mat4 m = localMatrix();
+    vkglTF::Node* p = parent;
+    while (p)
+    {
+      m = p->localMatrix() * m;
+      p = p->parent;
+    }
+    return m;
+  }
+
   /*
     glTF animation channel
   */
@@ -612,6 +747,8 @@ namespace vkglTF
     PathType path;
     Node* node;
     uint32_t samplerIndex;
+    // Key interval used by the last evaluation, the starting point for the next lookup
+    size_t cursor = 0;
   };
 
   /*
@@ -628,6 +765,94 @@ namespace vkglTF
     InterpolationType interpolation;
     std::vector<float> inputs;
     std::vector<glm::vec4> outputsVec4;
+
+    // Cubic spline samplers store an in-tangent, value and out-tangent per key
+    bool valid() const
+    {
+      const size_t stride = interpolation == CUBICSPLINE ? 3 : 1;
+      return !inputs.empty() && outputsVec4.size() >= inputs.size() * stride;
+    }
+
+    glm::vec4 value(size_t key) const
+    {
+      return interpolation == CUBICSPLINE ? outputsVec4[key * 3 + 1] : outputsVec4[key];
+    }
+
+    // Returns the key interval [i, i + 1] that contains time. Checks the cursor and the interval after it
+    // first, so monotonic playback costs O(1), and falls back to a binary search on seeks and loops.
+    size_t findInterval(float time, size_t& cursor) const
+    {
+      const size_t last = inputs.size() - 1;
+      if (cursor < last && time >= inputs[cursor])
+      {
+        if (time <= inputs[cursor + 1])
+        {
+          return cursor;
+        }
+        if (cursor + 1 < last && time <= inputs[cursor + 2])
+        {
+          return ++cursor;
+        }
+      }
+      const size_t upper = static_cast<size_t>(std::upper_bound(inputs.begin(), inputs.end(), time) - inputs.begin());
+      cursor = std::min(upper > 0 ? upper - 1 : 0, last - 1);
+      return cursor;
+    }
+
+    // Evaluates the sampler at time, clamping to the first and last key. Rotations are returned as
+    // normalized (x, y, z, w) quaternions.
+    glm::vec4 evaluate(float time, size_t& cursor, bool rotation) const
+    {
+      if (inputs.size() == 1 || time <= inputs.front())
+      {
+        return value(0);
+      }
+      if (time >= inputs.back())
+      {
+        return value(inputs.size() - 1);
+      }
+
+      const size_t i = findInterval(time, cursor);
+      const float delta = inputs[i + 1] - inputs[i];
+      const float u = delta > 0.0f ? (time - inputs[i]) / delta : 0.0f;
+
+      switch (interpolation)
+      {
+      case STEP:
+        return value(i);
+      case CUBICSPLINE:
+      {
+        // Hermite spline, tangents are scaled by the key interval
+        const float u2 = u * u;
+        const float u3 = u2 * u;
+        const glm::vec4 result = (2.0f * u3 - 3.0f * u2 + 1.0f) * outputsVec4[i * 3 + 1]
+                               + (u3 - 2.0f * u2 + u) * delta * outputsVec4[i * 3 + 2]
+                               + (-2.0f * u3 + 3.0f * u2) * outputsVec4[(i + 1) * 3 + 1]
+                               + (u3 - u2) * delta * outputsVec4[(i + 1) * 3];
+        return rotation ? glm::normalize(result) : result;
+      }
+      case LINEAR:
+      default:
+      {
+        if (!rotation)
+        {
+          return glm::mix(outputsVec4[i], outputsVec4[i + 1], u);
+        }
+        const glm::quat q = glm::normalize(glm::slerp(toQuat(outputsVec4[i]), toQuat(outputsVec4[i + 1]), u));
+        return glm::vec4(q.x, q.y, q.z, q.w);
+      }
+      }
+    }
+
+    static glm::quat toQuat(const glm::vec4& v)
+    {
+      glm::quat q;
+      q.x = v.x;
+      q.y = v.y;
+      q.z = v.z;
+      q.w = v.w;
+      return q;
+    }
   };
 
   /*
@@ -642,6 +867,32 @@ namespace vkglTF
     float end = std::numeric_limits<float>::min();
   };
 
+  /*
+    Vertex buffer layouts
+    Full keeps every attribute as 32 bit floats. Compact stores snorm16 normals, half float UVs,
+    uint16 joints and unorm8 weights. CompactStatic drops the skin attributes for meshes that are
+    never skinned. All compact formats are converted to floats by the vertex fetch, so shaders
+    written for Full work unchanged.
+  */
+  enum class VertexLayout
+  {
+    Full,
+    Compact,
+    CompactStatic
+  };
+
+  /*
+    tinygltf image loader that leaves images encoded, marked by a component count of 0, for Model::loadTextures to decode
+  */
+  inline bool keepImageEncoded(tinygltf::Image* image, const int, std::string*, std::string*, int, int, const unsigned char* bytes, int size, void*)
+  {
+    image->image.assign(bytes, bytes + size);
+    image->width = 0;
+    image->height = 0;
+    image->component = 0;
+    return true;
+  }
+
   /*
     glTF model loading and rendering class
   */
@@ -649,6 +900,13 @@ namespace vkglTF
   {
     vks::VulkanDevice* device;
 
+    // Nodes point back at sceneGraph, so a model must stay where it was constructed
+    Model() = default;
+    Model(const Model&) = delete;
+    Model(Model&&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model& operator=(Model&&) = delete;
+
     struct Vertex
     {
       glm::vec3 pos;
@@ -659,22 +917,189 @@ namespace vkglTF
       glm::vec4 weight0;
     };
 
+    struct CompactVertex
+    {
+      glm::vec3 pos;
+      int16_t normal[4];
+      uint16_t uv0[2];
+      uint16_t uv1[2];
+      uint16_t joint0[4];
+      uint8_t weight0[4];
+    };
+
+    struct CompactStaticVertex
+    {
+      glm::vec3 pos;
+      int16_t normal[4];
+      uint16_t uv0[2];
+      uint16_t uv1[2];
+    };
+
+    // Write cursors into the mapped staging buffers that loadNode decodes accessors into
+    struct LoaderInfo
+    {
+      uint32_t* indexBuffer = nullptr;
+      uint8_t* vertexBuffer = nullptr;
+      size_t indexPos = 0;
+      size_t vertexPos = 0;
+    };
+
+    // Layout the vertex buffer is written in, must be set before loadFromFile
+    VertexLayout vertexLayout = VertexLayout::Full;
+    // Pool the images are decoded on, the loading thread takes part. Without one they are decoded on the loading thread alone
+    BadgerSandbox::ThreadPool* workerPool = nullptr;
+    // Build the mip chains while decoding instead of blitting them on the GPU
+    bool generateMipsOnCpu = false;
+    // Ring the uploads are staged in. Without one, or when it has no room, each upload creates a staging buffer of its own
+    BadgerSandbox::StagingRing* stagingRing = nullptr;
+
+    // Staging memory of one upload, in stagingRing unless memory is set
+    struct StagingSpace
+    {
+      VkBuffer buffer = VK_NULL_HANDLE;
+      BadgerSandbox::MemoryAllocation memory;
+      VkDeviceSize offset = 0;
+      uint8_t* data = nullptr;
+    };
+
+    // Everything loadFromFile uploads is recorded into copyCmd and submitted once
+    struct UploadContext
+    {
+      // Owns the command pool copyCmd is allocated from, only used for the duration of the load
+      vks::VulkanDevice* commands = nullptr;
+      VkCommandBuffer copyCmd = VK_NULL_HANDLE;
+      BadgerSandbox::StagingBatch batch;
+      std::vector<StagingSpace> dedicated;
+    };
+
+    static uint32_t getVertexStride(VertexLayout layout)
+    {
+      switch (layout)
+      {
+      case VertexLayout::Compact:
+        return sizeof(CompactVertex);
+      case VertexLayout::CompactStatic:
+        return sizeof(CompactStaticVertex);
+      case VertexLayout::Full:
+      default:
+        return sizeof(Vertex);
+      }
+    }
+
+    // Attribute descriptions for pipelines reading a vertex buffer of this layout, locations match the Full layout
+    static std::vector<VkVertexInputAttributeDescription> getVertexInputAttributes(VertexLayout layout, uint32_t binding = 0)
+    {
+      switch (layout)
+      {
+      case VertexLayout::Compact:
+        return {
+          {0, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(CompactVertex, pos)},
+          {1, binding, VK_FORMAT_R16G16B16A16_SNORM, offsetof(CompactVertex, normal)},
+          {2, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, uv0)},
+          {3, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, uv1)},
+          {4, binding, VK_FORMAT_R16G16B16A16_USCALED, offsetof(CompactVertex, joint0)},
+          {5, binding, VK_FORMAT_R8G8B8A8_UNORM, offsetof(CompactVertex, weight0)}
+        };
+      case VertexLayout::CompactStatic:
+        return {
+          {0, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(CompactStaticVertex, pos)},
+          {1, binding, VK_FORMAT_R16G16B16A16_SNORM, offsetof(CompactStaticVertex, normal)},
+          {2, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactStaticVertex, uv0)},
+          {3, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactStaticVertex, uv1)}
+        };
+      case VertexLayout::Full:
+      default:
+        return {
+          {0, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
+          {1, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
+          {2, binding, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv0)},
+          {3, binding, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv1)},
+          {4, binding, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, joint0)},
+          {5, binding, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, weight0)}
+        };
+      }
+    }
+
+    // Whether every attribute of layout can be read from a vertex buffer on physicalDevice. The Compact layout's
+    // R16G16B16A16_USCALED joints are not one of the formats Vulkan requires vertex buffer support for.
+    static bool isVertexLayoutSupported(VkPhysicalDevice physicalDevice, VertexLayout layout)
+    {
+      for (const VkVertexInputAttributeDescription& attribute : getVertexInputAttributes(layout))
+      {
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, attribute.format, &formatProperties);
+        if ((formatProperties.bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT) == 0)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Quantizes weights to unorm8 while keeping their sum at exactly 255
+    static void packWeights(const glm::vec4& weights, uint8_t packed[4])
+    {
+      int total = 0;
+      int largest = 0;
+      for (int i = 0; i < 4; i++)
+      {
+        packed[i] = static_cast<uint8_t>(glm::clamp(weights[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        total += packed[i];
+        largest = packed[i] > packed[largest] ? i : largest;
+      }
+      packed[largest] = static_cast<uint8_t>(glm::clamp(packed[largest] + 255 - total, 0, 255));
+    }
+
+    // Stores vert at the cursor of the mapped vertex buffer in the model's layout
+    void writeVertex(LoaderInfo& loaderInfo, const Vertex& vert)
+    {
+      uint8_t* destination = loaderInfo.vertexBuffer + loaderInfo.vertexPos * getVertexStride(vertexLayout);
+      loaderInfo.vertexPos++;
+      if (vertexLayout == VertexLayout::Full)
+      {
+        memcpy(destination, &vert, sizeof(Vertex));
+        return;
+      }
+
+      CompactVertex compact;
+      compact.pos = vert.pos;
+      const uint64_t normal = glm::packSnorm4x16(glm::vec4(vert.normal, 0.0f));
+      memcpy(compact.normal, &normal, sizeof(compact.normal));
+      const uint32_t uv0 = glm::packHalf2x16(vert.uv0);
+      const uint32_t uv1 = glm::packHalf2x16(vert.uv1);
+      memcpy(compact.uv0, &uv0, sizeof(compact.uv0));
+      memcpy(compact.uv1, &uv1, sizeof(compact.uv1));
+      if (vertexLayout == VertexLayout::CompactStatic)
+      {
+        // CompactStaticVertex is the leading part of CompactVertex
+        memcpy(destination, &compact, sizeof(CompactStaticVertex));
+        return;
+      }
+      for (int i = 0; i < 4; i++)
+      {
+        compact.joint0[i] = static_cast<uint16_t>(vert.joint0[i]);
+      }
+      packWeights(vert.weight0, compact.weight0);
+      memcpy(destination, &compact, sizeof(CompactVertex));
+    }
+
     struct Vertices
     {
       VkBuffer buffer = VK_NULL_HANDLE;
-      VkDeviceMemory memory;
+      BadgerSandbox::MemoryAllocation memory;
     } vertices;
     struct Indices
     {
       int count;
       VkBuffer buffer = VK_NULL_HANDLE;
-      VkDeviceMemory memory;
+      BadgerSandbox::MemoryAllocation memory;
     } indices;
 
     glm::mat4 aabb;
 
     std::vector<Node*> nodes;
     std::vector<Node*> linearNodes;
+    SceneGraph sceneGraph;
 
     std::vector<Skin*> skins;
 
@@ -694,13 +1119,11 @@ namespace vkglTF
     {
       if (vertices.buffer != VK_NULL_HANDLE)
       {
-        vkDestroyBuffer(device, vertices.buffer, nullptr);
-        vkFreeMemory(device, vertices.memory, nullptr);
+        this->device->memoryAllocator->DestroyBuffer(vertices.buffer, vertices.memory);
       }
       if (indices.buffer != VK_NULL_HANDLE)
       {
-        vkDestroyBuffer(device, indices.buffer, nullptr);
-        vkFreeMemory(device, indices.memory, nullptr);
+        this->device->memoryAllocator->DestroyBuffer(indices.buffer, indices.memory);
       }
       for (auto texture : textures)
       {
@@ -708,6 +1131,7 @@ namespace vkglTF
       }
       textures.resize(0);
       textureSamplers.resize(0);
+      sceneGraph.clear();
       for (auto node : nodes)
       {
         delete node;
@@ -724,8 +1148,29 @@ namespace vkglTF
       skins.resize(0);
     };
 
+    // Accumulates the vertex and index counts of node and its children so buffers can be sized up front
+    void getNodeProps(const tinygltf::Node& node, const tinygltf::Model& model, size_t& vertexCount, size_t& indexCount)
+    {
+      for (size_t i = 0; i < node.children.size(); i++)
+      {
+        getNodeProps(model.nodes[node.children[i]], model, vertexCount, indexCount);
+      }
+      if (node.mesh > -1)
+      {
+        const tinygltf::Mesh& mesh = model.meshes[node.mesh];
+        for (const tinygltf::Primitive& primitive : mesh.primitives)
+        {
+          vertexCount += model.accessors[primitive.attributes.find("POSITION")->second].count;
+          if (primitive.indices > -1)
+          {
+            indexCount += model.accessors[primitive.indices].count;
+          }
+        }
+      }
+    }
+
     void loadNode(vkglTF::Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model,
-                  std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer, float globalscale)
+                  LoaderInfo& loaderInfo, float globalscale)
     {
       vkglTF::Node* newNode = new Node{};
       newNode->index = nodeIndex;
@@ -763,20 +1208,20 @@ namespace vkglTF
       {
         for (size_t i = 0; i < node.children.size(); i++)
         {
-          loadNode(newNode, model.nodes[node.children[i]], node.children[i], model, indexBuffer, vertexBuffer, globalscale);
+          loadNode(newNode, model.nodes[node.children[i]], node.children[i], model, loaderInfo, globalscale);
         }
       }
 
       // Node contains mesh data
       if (node.mesh > -1)
       {
-        const tinygltf::Mesh mesh = model.meshes[node.mesh];
+        const tinygltf::Mesh& mesh = model.meshes[node.mesh];
         Mesh* newMesh = new Mesh(device, newNode->matrix);
         for (size_t j = 0; j < mesh.primitives.size(); j++)
         {
           const tinygltf::Primitive& primitive = mesh.primitives[j];
-          uint32_t indexStart = static_cast<uint32_t>(indexBuffer.size());
-          uint32_t vertexStart = static_cast<uint32_t>(vertexBuffer.size());
+          uint32_t indexStart = static_cast<uint32_t>(loaderInfo.indexPos);
+          uint32_t vertexStart = static_cast<uint32_t>(loaderInfo.vertexPos);
           uint32_t indexCount = 0;
           uint32_t vertexCount = 0;
           glm::vec3 posMin{};
@@ -876,7 +1321,7 @@ namespace vkglTF
               {
                 vert.weight0 = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
               }
-              vertexBuffer.push_back(vert);
+              writeVertex(loaderInfo, vert);
             }
           }
           // Indices
@@ -896,7 +1341,7 @@ namespace vkglTF
               const uint32_t* buf = static_cast<const uint32_t*>(dataPtr);
               for (size_t index = 0; index < accessor.count; index++)
               {
-                indexBuffer.push_back(buf[index] + vertexStart);
+                loaderInfo.indexBuffer[loaderInfo.indexPos++] = buf[index] + vertexStart;
               }
               break;
             }
@@ -905,7 +1350,7 @@ namespace vkglTF
               const uint16_t* buf = static_cast<const uint16_t*>(dataPtr);
               for (size_t index = 0; index < accessor.count; index++)
               {
-                indexBuffer.push_back(buf[index] + vertexStart);
+                loaderInfo.indexBuffer[loaderInfo.indexPos++] = buf[index] + vertexStart;
               }
               break;
             }
@@ -914,7 +1359,7 @@ namespace vkglTF
               const uint8_t* buf = static_cast<const uint8_t*>(dataPtr);
               for (size_t index = 0; index < accessor.count; index++)
               {
-                indexBuffer.push_back(buf[index] + vertexStart);
+                loaderInfo.indexBuffer[loaderInfo.indexPos++] = buf[index] + vertexStart;
               }
               break;
             }
@@ -989,11 +1434,212 @@ namespace vkglTF
       }
     }
 
-    void loadTextures(tinygltf::Model& gltfModel, vks::VulkanDevice* device, VkQueue transferQueue)
+    /*
+      Read the DDS file TextureTranscoder writes next to a glTF image (textures/albedo.dds for textures/albedo.png) if
+      there is one in a format the device can sample. texture points into file
+    */
+    bool loadCompressedImage(vks::VulkanDevice* device, const std::string& directory, const tinygltf::Image& image, std::vector<uint8_t>& file,
+                             BadgerSandbox::CompressedTexture& texture)
     {
+      if (image.uri.empty() || image.uri.compare(0, 5, "data:") == 0 || !device->features.textureCompressionBC)
+      {
+        return false;
+      }
+      std::ifstream stream(directory + image.uri.substr(0, image.uri.rfind('.')) + ".dds", std::ios::binary | std::ios::ate);
+      if (!stream)
+      {
+        return false;
+      }
+      file.resize(static_cast<size_t>(stream.tellg()));
+      stream.seekg(0);
+      if (!stream.read(reinterpret_cast<char*>(file.data()), file.size()) || !BadgerSandbox::ReadDds(file.data(), file.size(), texture))
+      {
+        std::cout << "Ignoring unreadable compressed texture for " << image.uri << std::endl;
+        return false;
+      }
+      VkFormatProperties formatProperties;
+      vkGetPhysicalDeviceFormatProperties(device->physicalDevice, getVkFormat(texture.format), &formatProperties);
+      return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+    }
+
+    StagingSpace allocateStaging(UploadContext& upload, VkDeviceSize size)
+    {
+      StagingSpace space;
+      BadgerSandbox::StagingRegion region;
+      // 16 keeps block compressed copies aligned to their block size
+      if (stagingRing != nullptr && stagingRing->Allocate(upload.batch, size, 16, region))
+      {
+        space.buffer = region.buffer;
+        space.offset = region.offset;
+        space.data = static_cast<uint8_t*>(region.data);
+        return space;
+      }
+      RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                   size, &space.buffer, &space.memory));
+      space.data = static_cast<uint8_t*>(space.memory.mapped);
+      upload.dedicated.push_back(space);
+      return space;
+    }
+
+    void releaseStaging(UploadContext& upload)
+    {
+      for (StagingSpace& space : upload.dedicated)
+      {
+        device->memoryAllocator->DestroyBuffer(space.buffer, space.memory);
+      }
+      upload.dedicated.clear();
+    }
+
+    // Submits copyCmd and waits for it, the staging memory of the upload is released afterwards
+    void submitUpload(UploadContext& upload, VkQueue transferQueue)
+    {
+      if (stagingRing != nullptr)
+      {
+        RapidVulkan::CheckError(vkEndCommandBuffer(upload.copyCmd));
+        stagingRing->Submit(upload.batch, transferQueue, upload.copyCmd, device->queueMutex);
+        stagingRing->Wait(upload.batch);
+        vkFreeCommandBuffers(upload.commands->logicalDevice, upload.commands->commandPool, 1, &upload.copyCmd);
+      }
+      else
+      {
+        upload.commands->flushCommandBuffer(upload.copyCmd, transferQueue, true);
+      }
+      releaseStaging(upload);
+    }
+
+    void discardUpload(UploadContext& upload)
+    {
+      if (stagingRing != nullptr)
+      {
+        stagingRing->Abandon(upload.batch);
+      }
+      vkFreeCommandBuffers(upload.commands->logicalDevice, upload.commands->commandPool, 1, &upload.copyCmd);
+      releaseStaging(upload);
+    }
+
+    /*
+      Decode the images of all textures into one staging region, in parallel on workerPool, and record their upload into upload.copyCmd.
+      Each image is decoded once, textures sharing an image copy it from the same staging region. Images with a block compressed
+      version next to them (see loadCompressedImage) are copied with all their levels instead
+    */
+    void loadTextures(tinygltf::Model& gltfModel, vks::VulkanDevice* device, UploadContext& upload, const std::string& directory)
+    {
+      struct StagedImage
+      {
+        bool used = false;
+        int component = 0;
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 1;
+        VkDeviceSize offset = 0;
+        std::vector<uint8_t> compressedFile;
+        BadgerSandbox::CompressedTexture compressed;
+      };
+      std::vector<StagedImage> stagedImages(gltfModel.images.size());
+      std::vector<int> decodedImages;
+      VkDeviceSize stagingSize = 0;
+      for (tinygltf::Texture& tex : gltfModel.textures)
+      {
+        StagedImage& staged = stagedImages[tex.source];
+        if (staged.used)
+        {
+          continue;
+        }
+        const tinygltf::Image& image = gltfModel.images[tex.source];
+        // Copy offsets have to be a multiple of the block size
+        stagingSize = (stagingSize + 15) & ~VkDeviceSize(15);
+        staged.used = true;
+        staged.offset = stagingSize;
+        decodedImages.push_back(tex.source);
+        if (loadCompressedImage(device, directory, image, staged.compressedFile, staged.compressed))
+        {
+          staged.format = getVkFormat(staged.compressed.format);
+          staged.width = staged.compressed.width;
+          staged.height = staged.compressed.height;
+          staged.mipLevels = staged.compressed.mipLevels;
+          stagingSize += staged.compressed.size;
+          continue;
+        }
+        int width = image.width;
+        int height = image.height;
+        staged.component = image.component;
+        if (image.component == 0 &&
+            !stbi_info_from_memory(image.image.data(), static_cast<int>(image.image.size()), &width, &height, &staged.component))
+        {
+          throw std::runtime_error("COULD NOT DECODE glTF IMAGE " + image.uri);
+        }
+        staged.width = static_cast<uint32_t>(width);
+        staged.height = static_cast<uint32_t>(height);
+        staged.mipLevels = BadgerSandbox::MipLevelCount(staged.width, staged.height);
+        stagingSize += BadgerSandbox::MipChainSize(staged.width, staged.height, generateMipsOnCpu ? staged.mipLevels : 1);
+      }
+      if (decodedImages.empty())
+      {
+        return;
+      }
+
+      const StagingSpace staging = allocateStaging(upload, stagingSize);
+
+      // Most devices don't support RGB only on Vulkan, so everything is staged as RGBA. stb_image converts grey
+      // images itself, RGB ones are requested as they are and expanded here
+      auto decodeImage = [&](size_t i)
+      {
+        const tinygltf::Image& image = gltfModel.images[decodedImages[i]];
+        const StagedImage& staged = stagedImages[decodedImages[i]];
+        uint8_t* pixels = staging.data + staged.offset;
+        const size_t pixelCount = size_t(staged.width) * staged.height;
+        if (staged.format != VK_FORMAT_R8G8B8A8_UNORM)
+        {
+          memcpy(pixels, staged.compressed.data, staged.compressed.size);
+          return;
+        }
+        if (image.component == 0)
+        {
+          int width, height, component;
+          const int requested = staged.component == 3 ? 3 : 4;
+          stbi_uc* decoded = stbi_load_from_memory(image.image.data(), static_cast<int>(image.image.size()), &width, &height, &component, requested);
+          if (decoded == nullptr)
+          {
+            throw std::runtime_error("COULD NOT DECODE glTF IMAGE " + image.uri);
+          }
+          if (requested == 3)
+          {
+            BadgerSandbox::ExpandRGBToRGBA(decoded, pixels, pixelCount);
+          }
+          else
+          {
+            memcpy(pixels, decoded, pixelCount * 4);
+          }
+          stbi_image_free(decoded);
+        }
+        else if (image.component == 3)
+        {
+          BadgerSandbox::ExpandRGBToRGBA(image.image.data(), pixels, pixelCount);
+        }
+        else
+        {
+          memcpy(pixels, image.image.data(), pixelCount * 4);
+        }
+        if (generateMipsOnCpu)
+        {
+          BadgerSandbox::GenerateMipChain(pixels, staged.width, staged.height, staged.mipLevels);
+        }
+      };
+      if (workerPool != nullptr)
+      {
+        workerPool->ParallelFor(decodedImages.size(), decodeImage);
+      }
+      else
+      {
+        for (size_t i = 0; i < decodedImages.size(); i++)
+        {
+          decodeImage(i);
+        }
+      }
+
       for (tinygltf::Texture& tex : gltfModel.textures)
       {
-        tinygltf::Image image = gltfModel.images[tex.source];
         vkglTF::TextureSampler textureSampler;
         if (tex.sampler == -1)
         {
@@ -1008,8 +1654,11 @@ namespace vkglTF
         {
           textureSampler = textureSamplers[tex.sampler];
         }
+        const StagedImage& staged = stagedImages[tex.source];
         vkglTF::Texture texture;
-        texture.fromglTfImage(image, textureSampler, device, transferQueue);
+        texture.create(device, staged.format, staged.width, staged.height, staged.mipLevels, textureSampler);
+        texture.recordUpload(upload.copyCmd, staging.buffer, staging.offset + staged.offset,
+                             generateMipsOnCpu || staged.format != VK_FORMAT_R8G8B8A8_UNORM);
         textures.push_back(texture);
       }
     }
@@ -1304,7 +1953,10 @@ namespace vkglTF
       }
     }
 
-    void loadFromFile(std::string filename, vks::VulkanDevice* device, VkQueue transferQueue, float scale = 1.0f)
+    // The model keeps device for as long as it lives. The upload is recorded from uploadDevice's command pool, device's
+    // by default, which only has to outlive the call so a loader thread can pass a context with a pool of its own.
+    void loadFromFile(std::string filename, vks::VulkanDevice* device, VkQueue transferQueue, float scale = 1.0f,
+                      vks::VulkanDevice* uploadDevice = nullptr)
     {
       tinygltf::Model gltfModel;
       tinygltf::TinyGLTF gltfContext;
@@ -1312,6 +1964,7 @@ namespace vkglTF
       std::string warning;
 
       this->device = device;
+      gltfContext.SetImageLoader(keepImageEncoded, nullptr);
 
       bool binary = false;
       size_t extpos = filename.rfind('.', filename.length());
@@ -1323,107 +1976,123 @@ namespace vkglTF
       bool fileLoaded = binary ? gltfContext.LoadBinaryFromFile(&gltfModel, &error, &warning, filename.c_str())
                                : gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, filename.c_str());
 
-      std::vector<uint32_t> indexBuffer;
-      std::vector<Vertex> vertexBuffer;
+      if (!fileLoaded)
+      {
+          throw std::runtime_error("COULD NOT LOAD glTF MODEL");
+      }
 
-      if (fileLoaded)
+      UploadContext upload;
+      upload.commands = uploadDevice != nullptr ? uploadDevice : device;
+      upload.copyCmd = upload.commands->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+      StagingSpace vertexStaging, indexStaging;
+      size_t vertexBufferSize = 0;
+      size_t indexBufferSize = 0;
+
+      try
       {
         loadTextureSamplers(gltfModel);
-        loadTextures(gltfModel, device, transferQueue);
+        const size_t separator = filename.find_last_of("/\\");
+        loadTextures(gltfModel, device, upload, separator == std::string::npos ? std::string() : filename.substr(0, separator + 1));
         loadMaterials(gltfModel);
         // TODO: scene handling with no default scene
         const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
+
+        // Size the staging buffers from the accessor counts and decode the accessors straight into mapped memory
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
         for (size_t i = 0; i < scene.nodes.size(); i++)
         {
-          const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
-          loadNode(nullptr, node, scene.nodes[i], gltfModel, indexBuffer, vertexBuffer, scale);
+          getNodeProps(gltfModel.nodes[scene.nodes[i]], gltfModel, vertexCount, indexCount);
         }
+        vertexBufferSize = vertexCount * getVertexStride(vertexLayout);
+        indexBufferSize = indexCount * sizeof(uint32_t);
+
+        assert(vertexBufferSize > 0);
+
+        LoaderInfo loaderInfo{};
+        vertexStaging = allocateStaging(upload, vertexBufferSize);
+        loaderInfo.vertexBuffer = vertexStaging.data;
+        if (indexBufferSize > 0)
+        {
+          indexStaging = allocateStaging(upload, indexBufferSize);
+          loaderInfo.indexBuffer = reinterpret_cast<uint32_t*>(indexStaging.data);
+        }
+
+        for (size_t i = 0; i < scene.nodes.size(); i++)
+        {
+          const tinygltf::Node& node = gltfModel.nodes[scene.nodes[i]];
+          loadNode(nullptr, node, scene.nodes[i], gltfModel, loaderInfo, scale);
+        }
+
+        indices.count = static_cast<uint32_t>(loaderInfo.indexPos);
+
         if (gltfModel.animations.size() > 0)
         {
           loadAnimations(gltfModel);
         }
         loadSkins(gltfModel);
 
+        // Assign skins
         for (auto node : linearNodes)
         {
-          // Assign skins
           if (node->skinIndex > -1)
           {
             node->skin = skins[node->skinIndex];
           }
-          // Initial pose
-          if (node->mesh)
+        }
+        // Initial pose
+        sceneGraph.build(nodes);
+        for (auto skin : skins)
+        {
+          skin->jointIndices.clear();
+          for (auto joint : skin->joints)
+          {
+            skin->jointIndices.push_back(joint->graphIndex);
+          }
+          // glTF defaults missing inverse bind matrices to identity
+          skin->inverseBindMatrices.resize(skin->joints.size(), glm::mat4(1.0f));
+          skin->inverseBindTransforms.clear();
+          for (const auto& inverseBindMatrix : skin->inverseBindMatrices)
           {
-            node->update();
+            skin->inverseBindTransforms.push_back(toAffineTransform(inverseBindMatrix));
           }
         }
+        updateNodes();
+
+        // Create device local buffers
+        // Vertex buffer
+        RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBufferSize, &vertices.buffer, &vertices.memory));
+        // Index buffer
+        if (indexBufferSize > 0)
+        {
+          RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBufferSize, &indices.buffer, &indices.memory));
+        }
       }
-      else
+      catch (...)
       {
-          throw std::runtime_error("COULD NOT LOAD glTF MODEL");
+        discardUpload(upload);
+        throw;
       }
 
       extensions = gltfModel.extensionsUsed;
 
-      size_t vertexBufferSize = vertexBuffer.size() * sizeof(Vertex);
-      size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
-      indices.count = static_cast<uint32_t>(indexBuffer.size());
-
-      assert(vertexBufferSize > 0);
-
-      struct StagingBuffer
-      {
-        VkBuffer buffer;
-        VkDeviceMemory memory;
-      } vertexStaging, indexStaging;
-
-      // Create staging buffers
-      // Vertex data
-      RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBufferSize,
-                                                   &vertexStaging.buffer, &vertexStaging.memory, vertexBuffer.data()));
-      // Index data
-      if (indexBufferSize > 0)
-      {
-        RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, indexBufferSize,
-                                                     &indexStaging.buffer, &indexStaging.memory, indexBuffer.data()));
-      }
-
-      // Create device local buffers
-      // Vertex buffer
-      RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBufferSize, &vertices.buffer, &vertices.memory));
-      // Index buffer
-      if (indexBufferSize > 0)
-      {
-        RapidVulkan::CheckError(device->createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBufferSize, &indices.buffer, &indices.memory));
-      }
-
-      // Copy from staging buffers
-      VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
+      // Copy from staging, in the same submission as the textures
       VkBufferCopy copyRegion = {};
 
+      copyRegion.srcOffset = vertexStaging.offset;
       copyRegion.size = vertexBufferSize;
-      vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, vertices.buffer, 1, &copyRegion);
+      vkCmdCopyBuffer(upload.copyCmd, vertexStaging.buffer, vertices.buffer, 1, &copyRegion);
 
       if (indexBufferSize > 0)
       {
+        copyRegion.srcOffset = indexStaging.offset;
         copyRegion.size = indexBufferSize;
-        vkCmdCopyBuffer(copyCmd, indexStaging.buffer, indices.buffer, 1, &copyRegion);
+        vkCmdCopyBuffer(upload.copyCmd, indexStaging.buffer, indices.buffer, 1, &copyRegion);
       }
 
-      device->flushCommandBuffer(copyCmd, transferQueue, true);
-
-      vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-      vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-      if (indexBufferSize > 0)
-      {
-        vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-        vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
-      }
+      submitUpload(upload, transferQueue);
 
       getSceneDimensions();
     }
@@ -1526,59 +2195,108 @@ namespace vkglTF
       bool updated = false;
       for (auto& channel : animation.channels)
       {
-        vkglTF::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
-        if (sampler.inputs.size() > sampler.outputsVec4.size())
+        const vkglTF::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+        if (!sampler.valid())
         {
           continue;
         }
 
-        for (size_t i = 0; i < sampler.inputs.size() - 1; i++)
+        const bool rotation = channel.path == vkglTF::AnimationChannel::PathType::ROTATION;
+        const glm::vec4 value = sampler.evaluate(time, channel.cursor, rotation);
+        switch (channel.path)
         {
-          if ((time >= sampler.inputs[i]) && (time <= sampler.inputs[i + 1]))
-          {
-            float u = std::max(0.0f, time - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
-            if (u <= 1.0f)
-            {
-              switch (channel.path)
-              {
-              case vkglTF::AnimationChannel::PathType::TRANSLATION:
-              {
-                glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-                channel.node->translation = glm::vec3(trans);
-                break;
-              }
-              case vkglTF::AnimationChannel::PathType::SCALE:
-              {
-                glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-                channel.node->scale = glm::vec3(trans);
-                break;
-              }
-              case vkglTF::AnimationChannel::PathType::ROTATION:
-              {
-                glm::quat q1;
-                q1.x = sampler.outputsVec4[i].x;
-                q1.y = sampler.outputsVec4[i].y;
-                q1.z = sampler.outputsVec4[i].z;
-                q1.w = sampler.outputsVec4[i].w;
-                glm::quat q2;
-                q2.x = sampler.outputsVec4[i + 1].x;
-                q2.y = sampler.outputsVec4[i + 1].y;
-                q2.z = sampler.outputsVec4[i + 1].z;
-                q2.w = sampler.outputsVec4[i + 1].w;
-                channel.node->rotation = glm::normalize(glm::slerp(q1, q2, u));
-                break;
-              }
-              }
-              updated = true;
-            }
-          }
+        case vkglTF::AnimationChannel::PathType::TRANSLATION:
+          channel.node->translation = glm::vec3(value);
+          break;
+        case vkglTF::AnimationChannel::PathType::SCALE:
+          channel.node->scale = glm::vec3(value);
+          break;
+        case vkglTF::AnimationChannel::PathType::ROTATION:
+          channel.node->rotation = vkglTF::AnimationSampler::toQuat(value);
+          break;
         }
+        sceneGraph.markDirty(channel.node);
+        updated = true;
       }
       if (updated)
       {
-        for (auto& node : nodes)
+        updateNodes();
+      }
+    }
+
+    // Propagates dirty transforms through the scene graph and refreshes the mesh uniforms that depend on them
+    void updateNodes()
+    {
+      sceneGraph.update();
+      for (size_t i = 0; i < sceneGraph.nodes.size(); i++)
+      {
+        Node* node = sceneGraph.nodes[i];
+        if (!node->mesh)
+        {
+          continue;
+        }
+        if (node->skin)
+        {
+          updateSkin(*node, sceneGraph.changed[i] != 0);
+        }
+        else if (sceneGraph.changed[i])
+        {
+          node->updateMesh();
+        }
+      }
+    }
+
+    // Rebuilds the joint matrices of a skinned mesh from the cached joint world matrices.
+    // Skipped entirely when neither the mesh node nor any of its joints moved.
+    void updateSkin(Node& node, bool nodeChanged)
+    {
+      Mesh* mesh = node.mesh;
+      Skin* skin = node.skin;
+      const size_t numJoints = std::min((uint32_t)skin->jointIndices.size(), MAX_NUM_JOINTS);
+
+      bool jointsChanged = nodeChanged;
+      for (size_t i = 0; i < numJoints && !jointsChanged; i++)
+      {
+        jointsChanged = sceneGraph.changed[skin->jointIndices[i]] != 0;
+      }
+      if (!jointsChanged)
+      {
+        return;
+      }
+
+      if (nodeChanged)
+      {
+        mesh->uniformBlock.matrix = sceneGraph.worldMatrices[node.graphIndex];
+        mesh->inverseTransform = BadgerSandbox::Inverse(toAffineTransform(mesh->uniformBlock.matrix));
+      }
+      for (size_t i = 0; i < numJoints; i++)
+      {
+        const BadgerSandbox::AffineTransform jointTransform = toAffineTransform(sceneGraph.worldMatrices[skin->jointIndices[i]]);
+        mesh->uniformBlock.jointMatrix[i] = toMat4(mesh->inverseTransform * jointTransform * skin->inverseBindTransforms[i]);
+      }
+      mesh->uniformBlock.jointcount = (float)numJoints;
+      mesh->upload(sizeof(mesh->uniformBlock));
+    }
+
+    // Gives every mesh one uniform buffer per frame in flight, see Mesh::frameUniformBuffers
+    void createFrameBuffers(uint32_t frameCount)
+    {
+      for (auto node : linearNodes)
+      {
+        if (node->mesh)
+        {
+          node->mesh->createFrameBuffers(frameCount);
+        }
+      }
+    }
+
+    void publish(uint32_t frame)
+    {
+      for (auto node : linearNodes)
+      {
+        if (node->mesh)
         {
-          node->update();
+          node->mesh->publish(frame);
         }
       }
     }